@@ -0,0 +1,393 @@
+#pragma once
+#include<cstdint>
+#include<limits>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<functional>
+#include<concepts>
+#include<bit>
+#include<stdexcept>
+#if defined(__SSE2__)
+#include<emmintrin.h>
+#endif
+
+
+// ************************************************************************************ //
+// Open addressing hashmap in the style of SwissTable (abseil::flat_hash_map).
+//
+// Each slot has one control byte :
+// * 0x80        = empty
+// * 0xFE        = deleted (tombstone)
+// * 0x00 - 0x7F = full, storing the lowest 7 bits of hash (H2)
+//
+// Control bytes are grouped by 16, each group is probed by one SSE2 compare :
+// * H1 = hash >> 7    picks the starting group
+// * H2 = hash &  0x7F filters candidate slots inside the group, false positive 1/128
+// * keys are compared only for slots whose H2 matches
+// * probing stops once the group contains an empty slot
+// * groups are probed in triangular sequence, which visits all groups for power-of-2 size
+//
+// Unlike std::unordered_map, there is no node allocation and no pointer chasing.
+// Max load factor is 7/8, tombstones count towards load and are purged on rehash.
+// Slots are indexed by 32 bits, capacity is at most 2^31, beyond which std::length_error
+// is thrown, instead of letting the capacity wrap to 0.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename K>
+    struct flat_hash
+    {
+        std::uint64_t operator()(const K& key) const noexcept
+        {
+            std::uint64_t x;
+            if constexpr (std::is_integral_v<K>) x = static_cast<std::uint64_t>(key);
+            else                                 x = std::hash<K>{}(key);
+
+            // murmur3 finalizer, std::hash of integer is identity, which leaves H2 badly distributed
+            x ^= x >> 33;
+            x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33;
+            x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return x;
+        }
+    };
+
+    class flat_hash_group
+    {
+    public:
+        static constexpr std::uint32_t size = 16;
+        static constexpr std::int8_t empty   = -128; // 0x80
+        static constexpr std::int8_t deleted = -2;   // 0xFE
+
+        explicit flat_hash_group(const std::int8_t* ctrl) noexcept : m_ctrl(ctrl)
+        {
+        }
+
+        // Bitmask of slots whose control byte equals h2
+        std::uint32_t match(std::int8_t h2) const noexcept
+        {
+#if defined(__SSE2__)
+            __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_ctrl));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl));
+#else
+            std::uint32_t mask = 0;
+            for(std::uint32_t n=0; n!=size; ++n) if (m_ctrl[n] == h2) mask |= 1u << n;
+            return mask;
+#endif
+        }
+
+        std::uint32_t match_empty() const noexcept
+        {
+            return match(empty);
+        }
+
+        // Both empty and deleted are less than -1, while full is 0 - 127
+        std::uint32_t match_empty_or_deleted() const noexcept
+        {
+#if defined(__SSE2__)
+            __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_ctrl));
+            return _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl));
+#else
+            std::uint32_t mask = 0;
+            for(std::uint32_t n=0; n!=size; ++n) if (m_ctrl[n] < -1) mask |= 1u << n;
+            return mask;
+#endif
+        }
+
+    private:
+        const std::int8_t* m_ctrl;
+    };
+}
+
+
+namespace alg
+{
+    template<typename K, typename V, typename HASH = flat_hash<K>>
+    class flat_hash_map
+    {
+    public:
+        using key_type    = K;
+        using mapped_type = V;
+        using group       = flat_hash_group;
+
+        explicit flat_hash_map(std::uint32_t capacity = group::size)
+        {
+            allocate(capacity_for(capacity));
+        }
+
+    public:
+        V* find(const K& key) noexcept
+        {
+            std::uint32_t index = find_index(key, HASH{}(key));
+            if (index == npos) return nullptr;
+            return &m_slots[index].second;
+        }
+
+        const V* find(const K& key) const noexcept
+        {
+            return const_cast<flat_hash_map*>(this)->find(key);
+        }
+
+        bool contains(const K& key) const noexcept
+        {
+            return find(key) != nullptr;
+        }
+
+        V& operator[](const K& key)
+        {
+            auto [index, inserted] = find_or_prepare_insert(key);
+            if (inserted) m_slots[index] = std::make_pair(key, V{});
+            return m_slots[index].second;
+        }
+
+        // Like std::unordered_map::insert, existing value is not overwritten
+        bool insert(const K& key, const V& value)
+        {
+            auto [index, inserted] = find_or_prepare_insert(key);
+            if (inserted) m_slots[index] = std::make_pair(key, value);
+            return inserted;
+        }
+
+        bool erase(const K& key)
+        {
+            std::uint32_t index = find_index(key, HASH{}(key));
+            if (index == npos) return false;
+
+            m_ctrl[index] = group::deleted;
+            --m_size;
+            ++m_deleted;
+            return true;
+        }
+
+        void reserve(std::uint32_t num_keys)
+        {
+            if (num_keys > m_growth_limit) rehash(capacity_for(num_keys));
+        }
+
+        void clear() noexcept
+        {
+            std::fill(m_ctrl.begin(), m_ctrl.end(), group::empty);
+            m_size = 0;
+            m_deleted = 0;
+        }
+
+        template<typename F>
+        void for_each(F&& fct) const
+        {
+            for(std::uint32_t n=0; n!=m_ctrl.size(); ++n)
+            {
+                if (m_ctrl[n] >= 0) fct(m_slots[n].first, m_slots[n].second);
+            }
+        }
+
+        std::uint32_t size()     const noexcept { return m_size;         }
+        bool          empty()    const noexcept { return m_size == 0;    }
+        std::uint32_t capacity() const noexcept { return m_ctrl.size();  }
+
+    private:
+        using slot = std::pair<K,V>;
+
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+        static constexpr std::uint64_t max_capacity = 1ULL << 31;
+
+        std::uint32_t find_index(const K& key, std::uint64_t hash) const noexcept
+        {
+            std::int8_t   h2   = hash & 0x7F;
+            std::uint32_t g    = (hash >> 7) & m_group_mask;
+
+            for(std::uint32_t i=1; ; ++i) // always terminates, as load factor < 1 ensures an empty slot
+            {
+                group grp(&m_ctrl[g * group::size]);
+                for(std::uint32_t mask=grp.match(h2); mask!=0; mask&=mask-1)
+                {
+                    std::uint32_t index = g * group::size + std::countr_zero(mask);
+                    if (m_slots[index].first == key) return index;
+                }
+                if (grp.match_empty()) return npos;
+                g = (g + i) & m_group_mask;
+            }
+        }
+
+        // Smallest power-of-2 multiple of group size, with num_keys under 7/8 load
+        static std::uint64_t capacity_for(std::uint64_t num_keys) noexcept
+        {
+            std::uint64_t capacity = std::max<std::uint64_t>(group::size, (std::uint64_t)num_keys * 8 / 7 + 1);
+            return std::bit_ceil(capacity);
+        }
+
+        static void check_capacity(std::uint64_t capacity)
+        {
+            if (capacity > max_capacity) throw std::length_error("flat_hash_map : capacity exceeds 2^31 slots");
+        }
+
+        void allocate(std::uint64_t capacity)
+        {
+            check_capacity(capacity);
+            m_ctrl.assign(capacity, group::empty);
+            m_slots.assign(capacity, slot{});
+            m_group_mask   = capacity / group::size - 1;
+            m_growth_limit = capacity / 8 * 7;
+            m_size         = 0;
+            m_deleted      = 0;
+        }
+
+        // Checked before moving out, so that the map is intact if it throws
+        void rehash(std::uint64_t capacity)
+        {
+            check_capacity(capacity);
+            std::vector<std::int8_t> old_ctrl (std::move(m_ctrl));
+            std::vector<slot>        old_slots(std::move(m_slots));
+            allocate(capacity);
+
+            for(std::uint32_t n=0; n!=old_ctrl.size(); ++n)
+            {
+                if (old_ctrl[n] >= 0)
+                {
+                    std::uint64_t hash  = HASH{}(old_slots[n].first);
+                    std::uint32_t index = find_first_free(hash);
+                    m_ctrl [index] = hash & 0x7F;
+                    m_slots[index] = std::move(old_slots[n]);
+                    ++m_size;
+                }
+            }
+        }
+
+        std::uint32_t find_first_free(std::uint64_t hash) const noexcept
+        {
+            std::uint32_t g = (hash >> 7) & m_group_mask;
+            for(std::uint32_t i=1; ; ++i)
+            {
+                group grp(&m_ctrl[g * group::size]);
+                if (std::uint32_t mask=grp.match_empty_or_deleted(); mask!=0)
+                {
+                    return g * group::size + std::countr_zero(mask);
+                }
+                g = (g + i) & m_group_mask;
+            }
+        }
+
+        // Return {index, true} if a new slot is claimed, {index, false} if key exists
+        std::pair<std::uint32_t, bool> find_or_prepare_insert(const K& key)
+        {
+            std::uint64_t hash = HASH{}(key);
+            if (std::uint32_t index=find_index(key, hash); index!=npos) 
+            {
+                return std::make_pair(index, false);
+            }
+
+            // Key is absent, grow (or purge tombstones) before claiming a slot
+            if (m_size + m_deleted >= m_growth_limit)
+            {
+                if (m_size >= m_growth_limit / 2) rehash((std::uint64_t)capacity() * 2);
+                else                              rehash(capacity());
+            }
+
+            std::uint32_t index = find_first_free(hash);
+            if (m_ctrl[index] == group::deleted) --m_deleted;
+            m_ctrl[index] = hash & 0x7F;
+            ++m_size;
+            return std::make_pair(index, true);
+        }
+
+    private:
+        std::vector<std::int8_t> m_ctrl;
+        std::vector<slot>        m_slots;
+        std::uint32_t            m_group_mask   = 0;
+        std::uint32_t            m_growth_limit = 0;
+        std::uint32_t            m_size         = 0;
+        std::uint32_t            m_deleted      = 0;
+    };
+}
+
+
+// ************************************************************************************ //
+// Dense array keyed by integer in range [min, max], with the same interface as above.
+// When key range is small, lookup is one subtraction plus one array access, which is
+// faster than any hashmap. A slot holding EMPTY is treated as absent, hence EMPTY must
+// never be stored as a real value (e.g. 0 for histogram, INT_MIN for index map).
+// ************************************************************************************ //
+namespace alg
+{
+    template<std::integral K, typename V>
+    requires (sizeof(K) <= 4)
+    class dense_map
+    {
+    public:
+        using key_type    = K;
+        using mapped_type = V;
+
+        dense_map(K min, K max, V empty = V{})
+            : m_min(min),
+              m_empty(empty),
+              m_impl((std::int64_t)max - (std::int64_t)min + 1, empty)
+        {
+        }
+
+    public:
+        V* find(const K& key) noexcept
+        {
+            std::uint64_t offset = (std::int64_t)key - (std::int64_t)m_min;
+            if (offset >= m_impl.size())   return nullptr; // negative offset wraps to huge
+            if (m_impl[offset] == m_empty) return nullptr;
+            return &m_impl[offset];
+        }
+
+        const V* find(const K& key) const noexcept
+        {
+            return const_cast<dense_map*>(this)->find(key);
+        }
+
+        bool contains(const K& key) const noexcept
+        {
+            return find(key) != nullptr;
+        }
+
+        // Key must be inside [min, max]
+        V& operator[](const K& key) noexcept
+        {
+            return m_impl[(std::int64_t)key - (std::int64_t)m_min];
+        }
+
+        bool insert(const K& key, const V& value) noexcept
+        {
+            V& x = operator[](key);
+            if (x != m_empty) return false;
+            x = value;
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            std::fill(m_impl.begin(), m_impl.end(), m_empty);
+        }
+
+        std::uint64_t range() const noexcept
+        {
+            return m_impl.size();
+        }
+
+    private:
+        K              m_min;
+        V              m_empty;
+        std::vector<V> m_impl;
+    };
+
+
+    // Dense array is preferred when key range is comparable to number of keys,
+    // so that it does not cost more memory (and cache) than a hashmap.
+    inline bool prefer_dense_map(std::uint64_t key_range, std::uint64_t num_keys) noexcept
+    {
+        return key_range <= std::max<std::uint64_t>(4 * num_keys, 1 << 16) &&
+               key_range <= (1ULL << 26);
+    }
+
+    template<std::integral T>
+    std::pair<T,T> value_range(const std::vector<T>& vec) noexcept
+    {
+        if (vec.empty()) return std::make_pair(T{0}, T{0});
+        auto [min_iter, max_iter] = std::minmax_element(vec.begin(), vec.end());
+        return std::make_pair(*min_iter, *max_iter);
+    }
+}
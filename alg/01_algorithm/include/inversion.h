@@ -0,0 +1,310 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include<thread>
+#include<utility>
+#include<algorithm>
+#include<type_traits>
+#include<flat_hash_map.h>
+
+
+// ************************************************************************************ //
+// Inversion = pair (i,j) with i < j and v[i] > v[j], equal values are not inversions.
+// Number of inversions = min number of adjacent swaps to sort the vector.
+//
+// Backends :
+// 1. fenwick    - scan left to right, count elements seen so far that are larger,
+//                 values are mapped to dense ranks (coordinate compression) or, when
+//                 value range is small, offset by min directly, O(N log D)
+// 2. merge_sort - bottom-up merge sort, when right element is taken first, it jumps
+//                 over all remaining left elements, O(N log N)
+// 3. parallel   - each thread merge-sorts one chunk, then chunks are merged pairwise,
+//                 level by level, the pairs of one level are merged concurrently
+//
+// Fenwick backend also gives per-element rank statistics, i.e. for each n :
+// * larger_on_left [n] = #{m < n : v[m] > v[n]}
+// * smaller_on_right[n] = #{m > n : v[m] < v[n]}
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename T = std::uint32_t>
+    class fenwick_tree
+    {
+    public:
+        explicit fenwick_tree(std::uint32_t size) : m_impl(size+1, T{0})
+        {
+        }
+
+        void add(std::uint32_t index, T delta) noexcept
+        {
+            for(++index; index < m_impl.size(); index += index & (~index+1)) m_impl[index] += delta;
+        }
+
+        // Sum of [0, end)
+        T prefix_sum(std::uint32_t end) const noexcept
+        {
+            T sum{0};
+            for(; end > 0; end &= end-1) sum += m_impl[end];
+            return sum;
+        }
+
+        std::uint32_t size() const noexcept
+        {
+            return m_impl.size()-1;
+        }
+
+    private:
+        std::vector<T> m_impl;
+    };
+
+
+    // Map values to dense ranks [0, D), equal values share the same rank, return {ranks, D}
+    template<typename T>
+    std::pair<std::vector<std::uint32_t>, std::uint32_t> coordinate_compress(const std::vector<T>& vec)
+    {
+        std::vector<std::uint32_t> ranks(vec.size());
+        if constexpr (std::is_integral_v<T>)
+        {
+            auto [min, max] = value_range(vec);
+            std::uint64_t range = (std::uint64_t)((std::int64_t)max - (std::int64_t)min) + 1;
+            if (prefer_dense_map(range, vec.size())) // order preserving, no need to be dense
+            {
+                for(std::uint32_t n=0; n!=vec.size(); ++n) ranks[n] = (std::int64_t)vec[n] - (std::int64_t)min;
+                return std::make_pair(std::move(ranks), (std::uint32_t)range);
+            }
+        }
+
+        // Sort packed (value, index) once, then assign ranks by one sweep, avoiding N binary searches
+        if constexpr (std::is_integral_v<T> && sizeof(T) <= 4)
+        {
+            std::vector<std::uint64_t> keys(vec.size());
+            for(std::uint32_t n=0; n!=vec.size(); ++n)
+            {
+                std::uint32_t biased = (std::uint32_t)vec[n] ^ (std::is_signed_v<T> ? 0x80000000u : 0u); // order preserving
+                keys[n] = ((std::uint64_t)biased << 32) | n;
+            }
+            std::sort(keys.begin(), keys.end());
+
+            std::uint32_t rank = 0;
+            for(std::uint32_t n=0; n!=keys.size(); ++n)
+            {
+                if (n > 0 && (keys[n] >> 32) != (keys[n-1] >> 32)) ++rank;
+                ranks[(std::uint32_t)keys[n]] = rank;
+            }
+            return std::make_pair(std::move(ranks), keys.empty()? 0u : rank+1);
+        }
+
+        std::vector<T> sorted(vec);
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        for(std::uint32_t n=0; n!=vec.size(); ++n)
+        {
+            ranks[n] = std::lower_bound(sorted.begin(), sorted.end(), vec[n]) - sorted.begin();
+        }
+        return std::make_pair(std::move(ranks), (std::uint32_t)sorted.size());
+    }
+
+    // Ranks must be inside [0, num_ranks)
+    inline std::vector<std::uint32_t> larger_on_left(const std::vector<std::uint32_t>& ranks, std::uint32_t num_ranks)
+    {
+        std::vector<std::uint32_t> ans(ranks.size());
+        fenwick_tree<std::uint32_t> tree(num_ranks);
+        for(std::uint32_t n=0; n!=ranks.size(); ++n)
+        {
+            ans[n] = n - tree.prefix_sum(ranks[n]+1);
+            tree.add(ranks[n], 1);
+        }
+        return ans;
+    }
+
+    inline std::vector<std::uint32_t> smaller_on_right(const std::vector<std::uint32_t>& ranks, std::uint32_t num_ranks)
+    {
+        std::vector<std::uint32_t> ans(ranks.size());
+        fenwick_tree<std::uint32_t> tree(num_ranks);
+        for(std::uint32_t n=ranks.size(); n!=0; --n)
+        {
+            ans[n-1] = tree.prefix_sum(ranks[n-1]);
+            tree.add(ranks[n-1], 1);
+        }
+        return ans;
+    }
+
+    template<typename T>
+    std::uint64_t count_inversions_fenwick(const std::vector<T>& vec)
+    {
+        auto [ranks, num_ranks] = coordinate_compress(vec);
+        fenwick_tree<std::uint32_t> tree(num_ranks);
+
+        std::uint64_t count = 0;
+        for(std::uint32_t n=0; n!=ranks.size(); ++n)
+        {
+            count += n - tree.prefix_sum(ranks[n]+1);
+            tree.add(ranks[n], 1);
+        }
+        return count;
+    }
+
+    // Number of strictly decreasing triplets v[i] > v[j] > v[k] with i < j < k,
+    // it exceeds 2^64 for random input of size 5M, hence 128 bits.
+    template<typename T>
+    unsigned __int128 count_decreasing_triplets(const std::vector<T>& vec)
+    {
+        auto [ranks, num_ranks] = coordinate_compress(vec);
+        auto lhs = larger_on_left(ranks, num_ranks);
+
+        unsigned __int128 count = 0;
+        fenwick_tree<std::uint32_t> tree(num_ranks);
+        for(std::uint32_t n=ranks.size(); n!=0; --n)
+        {
+            std::uint64_t rhs = tree.prefix_sum(ranks[n-1]);
+            tree.add(ranks[n-1], 1);
+            count += (std::uint64_t)lhs[n-1] * rhs;
+        }
+        return count;
+    }
+}
+
+
+namespace alg
+{
+    namespace inversion_detail
+    {
+        inline constexpr std::uint32_t leaf_size = 16;
+
+        template<typename T>
+        std::uint64_t insert_sort_count(T* data, std::uint32_t size) noexcept
+        {
+            std::uint64_t count = 0;
+            for(std::uint32_t n=1; n<size; ++n)
+            {
+                T x = data[n];
+                std::uint32_t m = n;
+                for(; m!=0 && x < data[m-1]; --m) data[m] = data[m-1];
+                data[m] = x;
+                count += n-m;
+            }
+            return count;
+        }
+
+        template<typename T>
+        std::uint64_t merge_count(const T* lhs, std::uint32_t lhs_size,
+                                  const T* rhs, std::uint32_t rhs_size, T* out) noexcept
+        {
+            std::uint64_t count = 0;
+            std::uint32_t i = 0;
+            std::uint32_t j = 0;
+            while(i!=lhs_size && j!=rhs_size)
+            {
+                if (rhs[j] < lhs[i])
+                {
+                    count += lhs_size - i;
+                    *out++ = rhs[j++];
+                }
+                else
+                {
+                    *out++ = lhs[i++];
+                }
+            }
+            out = std::copy(lhs+i, lhs+lhs_size, out);
+            std::copy(rhs+j, rhs+rhs_size, out);
+            return count;
+        }
+
+        // Sort data in place, buffer has the same size
+        template<typename T>
+        std::uint64_t sort_count(T* data, T* buffer, std::uint32_t size) noexcept
+        {
+            std::uint64_t count = 0;
+            for(std::uint32_t n=0; n<size; n+=leaf_size)
+            {
+                count += insert_sort_count(data+n, std::min(leaf_size, size-n));
+            }
+
+            T* src = data;
+            T* dst = buffer;
+            for(std::uint64_t width=leaf_size; width<size; width*=2)
+            {
+                for(std::uint64_t n=0; n<size; n+=2*width)
+                {
+                    std::uint32_t mid = std::min<std::uint64_t>(n+width,   size);
+                    std::uint32_t end = std::min<std::uint64_t>(n+2*width, size);
+                    count += merge_count(src+n, mid-n, src+mid, end-mid, dst+n);
+                }
+                std::swap(src, dst);
+            }
+            if (src != data) std::copy(src, src+size, data);
+            return count;
+        }
+    }
+
+    template<typename T>
+    std::uint64_t count_inversions_merge_sort(const std::vector<T>& vec)
+    {
+        std::vector<T> data(vec);
+        std::vector<T> buffer(vec.size());
+        return inversion_detail::sort_count(data.data(), buffer.data(), data.size());
+    }
+
+    template<typename T>
+    std::uint64_t count_inversions_parallel(const std::vector<T>& vec, std::uint32_t num_threads)
+    {
+        std::uint32_t size = vec.size();
+        num_threads = std::max(1u, std::min(num_threads, size / (1u << 12)));
+        if (num_threads == 1) return count_inversions_merge_sort(vec);
+
+        std::vector<T> data(vec);
+        std::vector<T> buffer(size);
+        std::vector<std::uint32_t>  bounds(num_threads+1);
+        std::vector<std::uint64_t>  counts(num_threads, 0);
+        for(std::uint32_t t=0; t<=num_threads; ++t) bounds[t] = (std::uint64_t)size * t / num_threads;
+
+        // Stage 1 : sort each chunk
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=0; t!=num_threads; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                counts[t] += inversion_detail::sort_count(data.data()   + bounds[t],
+                                                          buffer.data() + bounds[t], bounds[t+1] - bounds[t]);
+            });
+        }
+        for(auto& x:threads) x.join();
+
+        // Stage 2 : merge chunk t with chunk t+step, cross inversions go to counts[t]
+        for(std::uint32_t step=1; step<num_threads; step*=2)
+        {
+            threads.clear();
+            for(std::uint32_t t=0; t+step<num_threads; t+=2*step)
+            {
+                threads.emplace_back([&, t, step]()
+                {
+                    std::uint32_t begin = bounds[t];
+                    std::uint32_t mid   = bounds[t+step];
+                    std::uint32_t end   = bounds[std::min(t+2*step, num_threads)];
+                    counts[t] += inversion_detail::merge_count(data.data()+begin, mid-begin,
+                                                               data.data()+mid,   end-mid, buffer.data()+begin);
+                    std::copy(buffer.data()+begin, buffer.data()+end, data.data()+begin);
+                });
+            }
+            for(auto& x:threads) x.join();
+        }
+
+        std::uint64_t count = 0;
+        for(const auto& x:counts) count += x;
+        return count;
+    }
+
+    // Fenwick tree wins when values need no compression, otherwise sorting dominates both backends
+    template<typename T>
+    std::uint64_t count_inversions(const std::vector<T>& vec, std::uint32_t num_threads = 1)
+    {
+        if (num_threads > 1) return count_inversions_parallel(vec, num_threads);
+        if constexpr (std::is_integral_v<T>)
+        {
+            auto [min, max] = value_range(vec);
+            std::uint64_t range = (std::uint64_t)((std::int64_t)max - (std::int64_t)min) + 1;
+            if (range <= vec.size()) return count_inversions_fenwick(vec);
+        }
+        return count_inversions_merge_sort(vec);
+    }
+}
@@ -0,0 +1,393 @@
+#pragma once
+#include<cstdint>
+#include<limits>
+#include<vector>
+#include<thread>
+#include<barrier>
+#include<algorithm>
+#include<type_traits>
+#include<immintrin.h>
+
+
+// ************************************************************************************ //
+// Prefix scan with user supplied associative operator, in 3 tiers :
+//
+// 1. scalar   - any associative OP, any T
+// 2. SIMD     - scan_plus / scan_max / scan_min on 32-bit integer, 4 lanes per step
+// 3. parallel - cache-blocked reduce-then-scan over threads, each block runs tier 1 or 2
+//
+// In-register scan of 4 lanes (Hillis-Steele), then add carry from previous register :
+//
+//   x                   = [a,     b,     c,     d    ]
+//   x = op(x<<1 lane,x) = [a,     ab,    bc,    cd   ]
+//   x = op(x<<2 lane,x) = [a,     ab,    abc,   abcd ]
+//   out = op(carry, x)
+//   carry = op(carry, broadcast(x[3]))
+//
+// where shifted-in lanes are filled by OP::identity.
+//
+// Parallel tier processes the input in super-blocks of (num_threads x block_size) :
+//   pass 1 : each thread reduces its block                  <--- block is pulled into L2
+//   barrier: one thread scans the block totals into carries
+//   pass 2 : each thread scans its block with its carry     <--- block is re-read from L2
+// so input is read from memory once, output is written once.
+//
+// Reverse scan runs from the last element to the first, e.g. suffix max.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename T>
+    struct scan_plus
+    {
+        static constexpr T identity = T{0};
+        T operator()(const T& x, const T& y) const noexcept { return x + y; }
+    };
+
+    template<typename T>
+    struct scan_max
+    {
+        static constexpr T identity = std::numeric_limits<T>::lowest();
+        T operator()(const T& x, const T& y) const noexcept { return std::max(x, y); }
+    };
+
+    template<typename T>
+    struct scan_min
+    {
+        static constexpr T identity = std::numeric_limits<T>::max();
+        T operator()(const T& x, const T& y) const noexcept { return std::min(x, y); }
+    };
+
+
+    // *************************************************************** //
+    // SIMD form of the operators, only for 32-bit integer (SSE4.1).
+    // Operator without specialization falls back to scalar tier.
+    // *************************************************************** //
+    template<typename OP>
+    struct scan_simd
+    {
+        static constexpr bool enable = false;
+    };
+
+    template<typename T> requires (std::is_integral_v<T> && sizeof(T) == 4)
+    struct scan_simd<scan_plus<T>>
+    {
+        static constexpr bool enable = true;
+        __attribute__((target("sse4.1"))) static __m128i apply(__m128i x, __m128i y) noexcept { return _mm_add_epi32(x, y); }
+    };
+
+    template<typename T> requires (std::is_integral_v<T> && sizeof(T) == 4)
+    struct scan_simd<scan_max<T>>
+    {
+        static constexpr bool enable = true;
+        __attribute__((target("sse4.1"))) static __m128i apply(__m128i x, __m128i y) noexcept
+        {
+            if constexpr (std::is_signed_v<T>) return _mm_max_epi32(x, y);
+            else                               return _mm_max_epu32(x, y);
+        }
+    };
+
+    template<typename T> requires (std::is_integral_v<T> && sizeof(T) == 4)
+    struct scan_simd<scan_min<T>>
+    {
+        static constexpr bool enable = true;
+        __attribute__((target("sse4.1"))) static __m128i apply(__m128i x, __m128i y) noexcept
+        {
+            if constexpr (std::is_signed_v<T>) return _mm_min_epi32(x, y);
+            else                               return _mm_min_epu32(x, y);
+        }
+    };
+
+    inline bool scan_simd_supported() noexcept
+    {
+        static const bool ans = __builtin_cpu_supports("sse4.1");
+        return ans;
+    }
+}
+
+
+// **************************** //
+// *** Tier 1 : scalar scan *** //
+// **************************** //
+namespace alg
+{
+    // Return the carry after the block. Without carry, the first element starts the scan.
+    template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+    T scan_block_scalar(const T* in, T* out, std::size_t size, const OP& op, const T* carry)
+    {
+        T acc = carry ? *carry : T{};
+        bool has_acc = (carry != nullptr);
+
+        for(std::size_t n=0; n!=size; ++n)
+        {
+            std::size_t i = REVERSE ? size-1-n : n;
+            T x = in[i]; // read before write, support in == out
+            if constexpr (INCLUSIVE)
+            {
+                acc = has_acc ? op(acc, x) : x;
+                has_acc = true;
+                out[i] = acc;
+            }
+            else
+            {
+                out[i] = acc;
+                acc = op(acc, x);
+            }
+        }
+        return acc;
+    }
+
+    template<bool REVERSE, typename T, typename OP>
+    T reduce_block_scalar(const T* in, std::size_t size, const OP& op)
+    {
+        T acc = REVERSE ? in[size-1] : in[0];
+        for(std::size_t n=1; n!=size; ++n)
+        {
+            acc = op(acc, REVERSE ? in[size-1-n] : in[n]);
+        }
+        return acc;
+    }
+}
+
+
+// ************************** //
+// *** Tier 2 : SIMD scan *** //
+// ************************** //
+namespace alg
+{
+    template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+    __attribute__((target("sse4.1")))
+    T scan_block_simd(const T* in, T* out, std::size_t size, const OP& op, const T* carry)
+    {
+        using simd = scan_simd<OP>;
+        const __m128i id1 = _mm_setr_epi32(OP::identity, 0, 0, 0);
+        const __m128i id2 = _mm_setr_epi32(OP::identity, OP::identity, 0, 0);
+        __m128i c = _mm_set1_epi32(carry ? *carry : OP::identity);
+
+        std::size_t n = 0;
+        for(; n+4 <= size; n+=4)
+        {
+            std::size_t i = REVERSE ? size-n-4 : n;
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            if constexpr (REVERSE) x = _mm_shuffle_epi32(x, 0x1B); // reverse lanes
+
+            x = simd::apply(_mm_or_si128(_mm_slli_si128(x, 4), id1), x);
+            x = simd::apply(_mm_or_si128(_mm_slli_si128(x, 8), id2), x);
+
+            __m128i y;
+            if constexpr (INCLUSIVE) y = simd::apply(c, x);
+            else                     y = simd::apply(c, _mm_or_si128(_mm_slli_si128(x, 4), id1));
+            c = simd::apply(c, _mm_shuffle_epi32(x, 0xFF));
+
+            if constexpr (REVERSE) y = _mm_shuffle_epi32(y, 0x1B);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), y);
+        }
+
+        // Tail, the carry is always valid now (identity if nothing scanned)
+        T acc = static_cast<T>(_mm_cvtsi128_si32(c));
+        if (REVERSE) return scan_block_scalar<INCLUSIVE, REVERSE>(in,     out,     size-n, op, &acc);
+        else         return scan_block_scalar<INCLUSIVE, REVERSE>(in + n, out + n, size-n, op, &acc);
+    }
+
+    template<bool REVERSE, typename T, typename OP>
+    __attribute__((target("sse4.1")))
+    T reduce_block_simd(const T* in, std::size_t size, const OP& op)
+    {
+        using simd = scan_simd<OP>;
+        __m128i acc = _mm_set1_epi32(OP::identity);
+
+        std::size_t n = 0;
+        for(; n+4 <= size; n+=4)
+        {
+            acc = simd::apply(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + n)));
+        }
+        acc = simd::apply(acc, _mm_shuffle_epi32(acc, 0x4E)); // OP is commutative for all SIMD operators
+        acc = simd::apply(acc, _mm_shuffle_epi32(acc, 0xB1));
+
+        T ans = static_cast<T>(_mm_cvtsi128_si32(acc));
+        for(; n!=size; ++n) ans = op(ans, in[n]);
+        return ans;
+    }
+
+
+    // *** Dispatch between tier 1 and tier 2 *** //
+    template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+    T scan_block(const T* in, T* out, std::size_t size, const OP& op, const T* carry)
+    {
+        if constexpr (scan_simd<OP>::enable)
+        {
+            if (scan_simd_supported()) return scan_block_simd<INCLUSIVE, REVERSE>(in, out, size, op, carry);
+        }
+        return scan_block_scalar<INCLUSIVE, REVERSE>(in, out, size, op, carry);
+    }
+
+    template<bool REVERSE, typename T, typename OP>
+    T reduce_block(const T* in, std::size_t size, const OP& op)
+    {
+        if constexpr (scan_simd<OP>::enable)
+        {
+            if (scan_simd_supported()) return reduce_block_simd<REVERSE>(in, size, op);
+        }
+        return reduce_block_scalar<REVERSE>(in, size, op);
+    }
+}
+
+
+// ************************************** //
+// *** Tier 3 : cache-blocked threads *** //
+// ************************************** //
+namespace alg
+{
+    // 64K elements per thread per super-block, i.e. 256KB for 32-bit T, fits in L2
+    constexpr std::size_t scan_block_size = 1 << 16;
+
+    template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+    void scan_parallel(const T* in, T* out, std::size_t size, const OP& op, const T* init, std::uint32_t num_threads)
+    {
+        const std::size_t super_size = scan_block_size * num_threads;
+        const std::size_t num_super  = (size + super_size - 1) / super_size;
+
+        std::vector<T>    totals (num_threads);
+        std::vector<T>    carries(num_threads);
+        std::vector<bool> has_carries(num_threads);
+        T    running     = init ? *init : T{};
+        bool has_running = (init != nullptr);
+
+        // Block t of super-block s covers [begin, end) counted in scan order
+        auto block_range = [&](std::size_t s, std::uint32_t t)
+        {
+            std::size_t begin = std::min(size, s * super_size + t * scan_block_size);
+            std::size_t end   = std::min(size, begin + scan_block_size);
+            return std::make_pair(begin, end);
+        };
+        auto physical = [&](std::size_t begin, std::size_t end)
+        {
+            return REVERSE ? size - end : begin;
+        };
+
+        std::size_t super_index = 0;
+        auto on_completion = [&]() noexcept
+        {
+            for(std::uint32_t t=0; t!=num_threads; ++t)
+            {
+                auto [begin, end] = block_range(super_index, t);
+                carries[t]     = running;
+                has_carries[t] = has_running;
+                if (begin != end)
+                {
+                    running     = has_running ? op(running, totals[t]) : totals[t];
+                    has_running = true;
+                }
+            }
+        };
+        std::barrier sync(num_threads, on_completion);
+
+        auto thread_fct = [&](std::uint32_t t)
+        {
+            for(std::size_t s=0; s!=num_super; ++s)
+            {
+                auto [begin, end] = block_range(s, t);
+                std::size_t offset = physical(begin, end);
+
+                // pass 1
+                if (begin != end) totals[t] = reduce_block<REVERSE>(in + offset, end - begin, op);
+                if (t == 0) super_index = s;
+                sync.arrive_and_wait();
+
+                // pass 2
+                if (begin != end)
+                {
+                    const T* carry = has_carries[t] ? &carries[t] : nullptr;
+                    scan_block<INCLUSIVE, REVERSE>(in + offset, out + offset, end - begin, op, carry);
+                }
+                // No barrier needed here, next pass 1 reads another super-block, and
+                // carries are overwritten only after all threads arrive at next barrier.
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t!=num_threads; ++t) threads.emplace_back(thread_fct, t);
+        thread_fct(0);
+        for(auto& x:threads) x.join();
+    }
+
+    template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+    void scan(const T* in, T* out, std::size_t size, const OP& op, const T* init, std::uint32_t num_threads)
+    {
+        if (num_threads > 1 && size >= 2 * scan_block_size)
+        {
+            num_threads = std::min<std::size_t>(num_threads, size / scan_block_size);
+            scan_parallel<INCLUSIVE, REVERSE>(in, out, size, op, init, num_threads);
+        }
+        else
+        {
+            scan_block<INCLUSIVE, REVERSE>(in, out, size, op, init);
+        }
+    }
+}
+
+
+// ********************** //
+// *** User interface *** //
+// ********************** //
+namespace alg
+{
+    // out[n] = in[0] op in[1] op ... op in[n]
+    template<typename T, typename OP>
+    void inclusive_scan(const T* in, T* out, std::size_t size, const OP& op, std::uint32_t num_threads = 1)
+    {
+        scan<true, false>(in, out, size, op, static_cast<const T*>(nullptr), num_threads);
+    }
+
+    // out[n] = init op in[0] op ... op in[n-1]
+    template<typename T, typename OP>
+    void exclusive_scan(const T* in, T* out, std::size_t size, T init, const OP& op, std::uint32_t num_threads = 1)
+    {
+        scan<false, false>(in, out, size, op, &init, num_threads);
+    }
+
+    // out[n] = in[n] op in[n+1] op ... op in[N-1]
+    template<typename T, typename OP>
+    void inclusive_scan_reverse(const T* in, T* out, std::size_t size, const OP& op, std::uint32_t num_threads = 1)
+    {
+        scan<true, true>(in, out, size, op, static_cast<const T*>(nullptr), num_threads);
+    }
+
+    // out[n] = init op in[n+1] op ... op in[N-1]
+    template<typename T, typename OP>
+    void exclusive_scan_reverse(const T* in, T* out, std::size_t size, T init, const OP& op, std::uint32_t num_threads = 1)
+    {
+        scan<false, true>(in, out, size, op, &init, num_threads);
+    }
+
+    template<typename T, typename OP>
+    std::vector<T> inclusive_scan(const std::vector<T>& vec, const OP& op, std::uint32_t num_threads = 1)
+    {
+        std::vector<T> ans(vec.size());
+        inclusive_scan(vec.data(), ans.data(), vec.size(), op, num_threads);
+        return ans;
+    }
+
+    template<typename T, typename OP>
+    std::vector<T> exclusive_scan(const std::vector<T>& vec, T init, const OP& op, std::uint32_t num_threads = 1)
+    {
+        std::vector<T> ans(vec.size());
+        exclusive_scan(vec.data(), ans.data(), vec.size(), init, op, num_threads);
+        return ans;
+    }
+
+    template<typename T, typename OP>
+    std::vector<T> inclusive_scan_reverse(const std::vector<T>& vec, const OP& op, std::uint32_t num_threads = 1)
+    {
+        std::vector<T> ans(vec.size());
+        inclusive_scan_reverse(vec.data(), ans.data(), vec.size(), op, num_threads);
+        return ans;
+    }
+
+    template<typename T, typename OP>
+    std::vector<T> exclusive_scan_reverse(const std::vector<T>& vec, T init, const OP& op, std::uint32_t num_threads = 1)
+    {
+        std::vector<T> ans(vec.size());
+        exclusive_scan_reverse(vec.data(), ans.data(), vec.size(), init, op, num_threads);
+        return ans;
+    }
+}
@@ -0,0 +1,267 @@
+#pragma once
+#include<cstdint>
+#include<cmath>
+#include<vector>
+#include<utility>
+#include<algorithm>
+#include<iterator>
+#include<functional>
+#include<bit>
+
+
+// ************************************************************************************ //
+// Selection of the k-th smallest element, all algorithms work in place on random access
+// iterators and leave the range partitioned like std::nth_element, i.e.
+// * *nth is the element that would be there if the range were sorted
+// * elements before nth are not greater than *nth
+// * elements after  nth are not less    than *nth
+//
+// 1. median_of_medians_select - deterministic O(N) worst case, but large constant
+// 2. introselect              - median-of-3 quickselect, switch to median-of-medians pivot
+//                               once recursion depth exceeds 2*log2(N), hence O(N) worst case
+// 3. floyd_rivest_select      - recursively selects from a small sample to pick two pivots
+//                               that bracket k tightly, about N + min(k,N-k) comparisons
+// 4. multi_select             - select many ranks, each partition serves all ranks on
+//                               its side, cost O(N log K) for K ranks instead of O(NK)
+//
+// Partition is 3-way (less / equal / greater), so that input with many duplicated
+// values (like latency samples) does not degrade to quadratic time.
+// ************************************************************************************ //
+namespace alg
+{
+    namespace selection_detail
+    {
+        inline constexpr std::ptrdiff_t small_size = 16;
+
+        template<typename ITER, typename CMP>
+        void insert_sort(ITER begin, ITER end, CMP& cmp)
+        {
+            for(ITER i=begin; i!=end; ++i)
+            {
+                auto x = std::move(*i);
+                ITER j = i;
+                for(; j!=begin && cmp(x, *(j-1)); --j) *j = std::move(*(j-1));
+                *j = std::move(x);
+            }
+        }
+
+        // Return [lt, gt) holding elements equal to pivot
+        template<typename ITER, typename T, typename CMP>
+        std::pair<ITER,ITER> partition3(ITER begin, ITER end, const T& pivot, CMP& cmp)
+        {
+            ITER lt = begin;
+            ITER i  = begin;
+            ITER gt = end;
+            while(i!=gt)
+            {
+                if      (cmp(*i, pivot)) std::iter_swap(lt++, i++);
+                else if (cmp(pivot, *i)) std::iter_swap(i, --gt);
+                else                     ++i;
+            }
+            return std::make_pair(lt, gt);
+        }
+
+        template<typename ITER, typename CMP>
+        ITER median_of_3(ITER a, ITER b, ITER c, CMP& cmp)
+        {
+            if (cmp(*a, *b))
+            {
+                if (cmp(*b, *c)) return b;
+                return cmp(*a, *c) ? c : a;
+            }
+            else
+            {
+                if (cmp(*a, *c)) return a;
+                return cmp(*b, *c) ? c : b;
+            }
+        }
+
+        template<typename ITER, typename CMP>
+        ITER median_of_medians_pivot(ITER begin, ITER end, CMP& cmp);
+
+        // Narrow [begin, end) until it is small or nth hits the equal range
+        template<bool INTRO, typename ITER, typename CMP>
+        void select(ITER begin, ITER nth, ITER end, CMP& cmp)
+        {
+            std::uint32_t depth = 2 * std::bit_width((std::uint64_t)(end-begin));
+            while(end - begin > small_size)
+            {
+                ITER pivot_iter;
+                if (INTRO && depth > 0)
+                {
+                    --depth;
+                    pivot_iter = median_of_3(begin, begin + (end-begin)/2, end-1, cmp);
+                }
+                else
+                {
+                    pivot_iter = median_of_medians_pivot(begin, end, cmp);
+                }
+
+                auto pivot = *pivot_iter; // copy, as partition moves it
+                auto [lt, gt] = partition3(begin, end, pivot, cmp);
+                if      (nth <  lt) end   = lt;
+                else if (nth >= gt) begin = gt;
+                else return;
+            }
+            insert_sort(begin, end, cmp);
+        }
+
+        // Move median of each group of 5 to the front, then select median of these medians
+        template<typename ITER, typename CMP>
+        ITER median_of_medians_pivot(ITER begin, ITER end, CMP& cmp)
+        {
+            ITER medians = begin;
+            for(ITER i=begin; i<end; i+=5)
+            {
+                ITER j = (end-i > 5) ? i+5 : end;
+                insert_sort(i, j, cmp);
+                std::iter_swap(medians++, i + (j-i)/2);
+            }
+            ITER mid = begin + (medians-begin)/2;
+            select<false>(begin, mid, medians, cmp);
+            return mid;
+        }
+
+        template<typename ITER, typename CMP>
+        void floyd_rivest(ITER begin, std::ptrdiff_t left, std::ptrdiff_t right, std::ptrdiff_t k, CMP& cmp)
+        {
+            // Sampling pays off for big range only, bound number of rounds as in introselect
+            std::uint32_t depth = 2 * std::bit_width((std::uint64_t)(right-left+1));
+            while(right > left)
+            {
+                if (depth-- == 0)
+                {
+                    select<true>(begin+left, begin+k, begin+right+1, cmp);
+                    return;
+                }
+                if (right - left > 600)
+                {
+                    double n  = right - left + 1;
+                    double i  = k - left + 1;
+                    double z  = std::log(n);
+                    double s  = 0.5 * std::exp(2.0 * z / 3.0);
+                    double sd = 0.5 * std::sqrt(z * s * (n-s) / n) * (i < n/2 ? -1.0 : +1.0);
+                    std::ptrdiff_t new_left  = std::max(left,  (std::ptrdiff_t)(k - i*s/n + sd));
+                    std::ptrdiff_t new_right = std::min(right, (std::ptrdiff_t)(k + (n-i)*s/n + sd));
+                    floyd_rivest(begin, new_left, new_right, k, cmp);
+                }
+
+                // Partition [left, right] around t = a[k], which sits at either end after the swaps
+                auto t = begin[k];
+                std::ptrdiff_t i = left;
+                std::ptrdiff_t j = right;
+                std::iter_swap(begin+left, begin+k);
+                if (cmp(t, begin[right])) std::iter_swap(begin+right, begin+left);
+                while(i < j)
+                {
+                    std::iter_swap(begin+i, begin+j);
+                    ++i;
+                    --j;
+                    while(cmp(begin[i], t)) ++i;
+                    while(cmp(t, begin[j])) --j;
+                }
+                if (!cmp(begin[left], t) && !cmp(t, begin[left]))
+                {
+                    std::iter_swap(begin+left, begin+j);
+                }
+                else
+                {
+                    ++j;
+                    std::iter_swap(begin+j, begin+right);
+                }
+                if (j <= k) left  = j+1;
+                if (k <= j) right = j-1;
+            }
+        }
+
+        // Ranks in [rank_begin, rank_end) are sorted, unique and inside [begin, end)
+        template<typename ITER, typename CMP>
+        void multi_select(ITER origin, ITER begin, ITER end,
+                          const std::uint32_t* rank_begin,
+                          const std::uint32_t* rank_end, CMP& cmp)
+        {
+            while(rank_begin != rank_end)
+            {
+                if (end - begin <= small_size)
+                {
+                    insert_sort(begin, end, cmp);
+                    return;
+                }
+
+                const std::uint32_t* rank_mid = rank_begin + (rank_end-rank_begin)/2;
+                ITER nth = origin + *rank_mid;
+                select<true>(begin, nth, end, cmp);
+
+                // Recurse into smaller half of ranks, iterate on the other
+                if (rank_mid - rank_begin < rank_end - rank_mid - 1)
+                {
+                    multi_select(origin, begin, nth, rank_begin, rank_mid, cmp);
+                    begin = nth + 1;
+                    rank_begin = rank_mid + 1;
+                }
+                else
+                {
+                    multi_select(origin, nth + 1, end, rank_mid + 1, rank_end, cmp);
+                    end = nth;
+                    rank_end = rank_mid;
+                }
+            }
+        }
+    }
+
+
+    template<typename ITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void median_of_medians_select(ITER begin, ITER nth, ITER end, CMP cmp = CMP{})
+    {
+        if (nth == end) return;
+        selection_detail::select<false>(begin, nth, end, cmp);
+    }
+
+    template<typename ITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void introselect(ITER begin, ITER nth, ITER end, CMP cmp = CMP{})
+    {
+        if (nth == end) return;
+        selection_detail::select<true>(begin, nth, end, cmp);
+    }
+
+    template<typename ITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void floyd_rivest_select(ITER begin, ITER nth, ITER end, CMP cmp = CMP{})
+    {
+        if (nth == end) return;
+        selection_detail::floyd_rivest(begin, 0, end-begin-1, nth-begin, cmp);
+    }
+
+    // After return, begin[r] holds the value of rank r for every r in ranks.
+    // Ranks can be in any order, with duplicates, but must be less than end-begin.
+    template<typename ITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void multi_select(ITER begin, ITER end, std::vector<std::uint32_t> ranks, CMP cmp = CMP{})
+    {
+        std::sort(ranks.begin(), ranks.end());
+        ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+        selection_detail::multi_select(begin, begin, end, ranks.data(), ranks.data() + ranks.size(), cmp);
+    }
+
+    // Partition vec in place (no copy), return value of each rank in the requested order
+    template<typename T>
+    std::vector<T> multi_select(std::vector<T>& vec, const std::vector<std::uint32_t>& ranks)
+    {
+        multi_select(vec.begin(), vec.end(), ranks);
+
+        std::vector<T> ans;
+        ans.reserve(ranks.size());
+        for(const auto& r:ranks) ans.push_back(vec[r]);
+        return ans;
+    }
+
+    // Rank of quantile r is floor((N-1) * r), same as alg::statistics::get_percentile
+    template<typename T>
+    std::vector<T> quantiles(std::vector<T>& vec, const std::vector<double>& rs)
+    {
+        if (vec.empty()) return std::vector<T>(rs.size(), T{});
+
+        std::vector<std::uint32_t> ranks;
+        ranks.reserve(rs.size());
+        for(const auto& r:rs) ranks.push_back(std::min<std::uint32_t>((vec.size()-1) * std::clamp(r, 0.0, 1.0), vec.size()-1));
+        return multi_select(vec, ranks);
+    }
+}
@@ -0,0 +1,135 @@
+#include<iostream>
+#include<cassert>
+#include<unordered_map>
+#include<flat_hash_map.h>
+#include<utility.h>
+
+
+// ************************************************************ //
+// Apply the same random insert / increment / erase sequence to
+// alg::flat_hash_map (or alg::dense_map) and std::unordered_map,
+// then compare every key in the range.
+// ************************************************************ //
+template<typename MAP>
+bool compare_with_unordered_map(MAP& map, std::int32_t min, std::int32_t max, bool support_erase)
+{
+    std::unordered_map<std::int32_t, std::uint32_t> ref;
+    for(std::uint32_t n=0; n!=2000; ++n)
+    {
+        std::int32_t key = min + std::rand() % (max-min+1);
+        std::uint32_t op = std::rand() % 4;
+        if (op == 0)
+        {
+            std::uint32_t value = 1 + std::rand() % 100;
+            bool inserted0 = map.insert(key, value);
+            bool inserted1 = ref.insert(std::make_pair(key, value)).second;
+            if (inserted0 != inserted1) return false;
+        }
+        else if (op == 1 && support_erase)
+        {
+            if constexpr (requires { map.erase(key); })
+            {
+                bool erased0 = map.erase(key);
+                bool erased1 = ref.erase(key) > 0;
+                if (erased0 != erased1) return false;
+            }
+        }
+        else
+        {
+            ++map[key];
+            ++ref[key];
+        }
+    }
+
+    for(std::int32_t key=min-10; key<=max+10; ++key)
+    {
+        auto ptr  = map.find(key);
+        auto iter = ref.find(key);
+        if ((ptr != nullptr) != (iter != ref.end())) return false;
+        if (ptr != nullptr && *ptr != iter->second)  return false;
+    }
+    return true;
+}
+
+void test_flat_hash_map_correctness()
+{
+    std::uint32_t trial = 1000;
+    std::uint32_t error = 0;
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        std::int32_t range = 1 + std::rand() % 3000;
+        alg::flat_hash_map<std::int32_t, std::uint32_t> map;
+        if (!compare_with_unordered_map(map, -range, +range, true)) ++error;
+    }
+    print_summary("flat_hash_map vs std::unordered_map", error, trial);
+
+    error = 0;
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        std::int32_t range = 1 + std::rand() % 3000;
+        alg::dense_map<std::int32_t, std::uint32_t> map(-range, +range);
+        if (!compare_with_unordered_map(map, -range, +range, false)) ++error;
+    }
+    print_summary("dense_map vs std::unordered_map", error, trial);
+}
+
+void test_flat_hash_map_rehash()
+{
+    alg::flat_hash_map<std::uint64_t, std::uint64_t> map;
+    for(std::uint64_t n=0; n!=100000; ++n) map[n * 7919] = n;
+    for(std::uint64_t n=0; n!=100000; n+=2) assert(map.erase(n * 7919));
+    for(std::uint64_t n=0; n!=100000; ++n) map.insert(n * 7919 + 1, n);
+    assert(map.size() == 150000);
+
+    for(std::uint64_t n=0; n!=100000; ++n)
+    {
+        auto ptr0 = map.find(n * 7919);
+        auto ptr1 = map.find(n * 7919 + 1);
+        assert(n%2 == 0? ptr0 == nullptr : (ptr0 != nullptr && *ptr0 == n));
+        assert(ptr1 != nullptr && *ptr1 == n);
+    }
+
+    std::uint64_t count = 0;
+    map.for_each([&count](const auto&, const auto&) { ++count; });
+    assert(count == map.size());
+    map.clear();
+    assert(map.empty() && map.find(7919) == nullptr);
+
+    // Capacity beyond 2^31 slots throws, before any allocation
+    bool thrown = false;
+    try { map.reserve(3000000000u); } catch(const std::length_error&) { thrown = true; }
+    assert(thrown && map.capacity() > 0);
+    print_summary("flat_hash_map rehash and tombstone", "succeeded");
+}
+
+void test_flat_hash_map_timing()
+{
+    // Histogram of prefix sum, as in count_target_subseq_sum
+    auto vec = gen_random_vec<std::int32_t>(1000000, -1000, +1000);
+
+    alg::timer timer;
+    timer.click();
+    alg::flat_hash_map<std::int32_t, std::uint32_t> hist0(vec.size());
+    std::int32_t cum = 0;
+    for(const auto& x:vec) { cum += x; ++hist0[cum]; }
+    timer.click();
+    auto time0 = timer.time_elapsed_in_nsec();
+
+    timer.click();
+    std::unordered_map<std::int32_t, std::uint32_t> hist1;
+    cum = 0;
+    for(const auto& x:vec) { cum += x; ++hist1[cum]; }
+    timer.click();
+    auto time1 = timer.time_elapsed_in_nsec();
+
+    assert(hist0.size() == hist1.size());
+    print_summary("flat_hash_map vs std::unordered_map, 1M prefix sums",
+                  "time = " + std::to_string(time0/1000) + "/" + std::to_string(time1/1000) + " us");
+}
+
+void test_flat_hash_map()
+{
+    test_flat_hash_map_correctness();
+    test_flat_hash_map_rehash();
+    test_flat_hash_map_timing();
+}
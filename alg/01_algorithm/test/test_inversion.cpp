@@ -0,0 +1,99 @@
+#include<iostream>
+#include<cassert>
+#include<inversion.h>
+#include<utility.h>
+
+
+template<typename T>
+std::uint64_t count_inversions_bmk(const std::vector<T>& vec)
+{
+    std::uint64_t count = 0;
+    for(std::uint32_t n=0; n<vec.size(); ++n)
+    {
+        for(std::uint32_t m=n+1; m<vec.size(); ++m) 
+        {
+            if (vec[m] < vec[n]) ++count;
+        }
+    }
+    return count;
+}
+
+void test_inversion_correctness()
+{
+    std::uint32_t trial = 300;
+    std::uint32_t error0 = 0;
+    std::uint32_t error1 = 0;
+    std::uint32_t error2 = 0;
+    std::uint32_t error3 = 0;
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        // narrow range (dense ranks, many duplicates) and wide range (sorted compression)
+        std::uint32_t size = std::rand() % 2000;
+        auto vec = t%2==0? gen_random_vec<std::int32_t>(size, -5, 5) :
+                           gen_random_vec<std::int32_t>(size, -100000000, 100000000);
+        auto ans = count_inversions_bmk(vec);
+
+        if (alg::count_inversions_fenwick   (vec)         != ans) ++error0;
+        if (alg::count_inversions_merge_sort(vec)         != ans) ++error1;
+        if (alg::count_inversions_parallel  (vec, 1+t%5)  != ans) ++error2;
+
+        auto [ranks, num_ranks] = alg::coordinate_compress(vec);
+        auto lhs = alg::larger_on_left  (ranks, num_ranks);
+        auto rhs = alg::smaller_on_right(ranks, num_ranks);
+        std::uint64_t sum_lhs = 0;
+        std::uint64_t sum_rhs = 0;
+        for(const auto& x:lhs) sum_lhs += x;
+        for(const auto& x:rhs) sum_rhs += x;
+        if (sum_lhs != ans || sum_rhs != ans) ++error3;
+    }
+
+    // Parallel path needs size >= 2 * 4096, sizes are mostly not a multiple of num_threads
+    std::uint32_t trial_parallel = 20;
+    for(std::uint32_t t=0; t!=trial_parallel; ++t)
+    {
+        std::uint32_t size = t==0? 3 * 4096 + 1 : 2 * 4096 + std::rand() % 12000;
+        auto vec = t%2==0? gen_random_vec<std::int32_t>(size, -5, 5) :
+                           gen_random_vec<std::int32_t>(size, -100000000, 100000000);
+        auto ans = count_inversions_bmk(vec);
+
+        if (alg::count_inversions_parallel(vec, 2+t%4) != ans) ++error2;
+    }
+    print_summary("count_inversions_fenwick",            error0, trial);
+    print_summary("count_inversions_merge_sort",         error1, trial);
+    print_summary("count_inversions_parallel",           error2, trial + trial_parallel);
+    print_summary("larger_on_left and smaller_on_right", error3, trial);
+}
+
+void test_inversion_timing()
+{
+    std::uint32_t size = 10000000;
+    auto vec = gen_random_vec<std::uint32_t>(size, 0, 4000000000u);
+
+    alg::timer timer;
+    timer.click();
+    auto ans0 = alg::count_inversions_fenwick(vec);
+    timer.click();
+    auto time0 = timer.time_elapsed_in_nsec();
+
+    timer.click();
+    auto ans1 = alg::count_inversions_merge_sort(vec);
+    timer.click();
+    auto time1 = timer.time_elapsed_in_nsec();
+
+    timer.click();
+    auto ans2 = alg::count_inversions_parallel(vec, 4);
+    timer.click();
+    auto time2 = timer.time_elapsed_in_nsec();
+
+    assert(ans0 == ans1 && ans1 == ans2);
+    print_summary("count_inversions fenwick/merge_sort/parallel(4), 10M",
+                  "time = " + std::to_string(time0/1000000) + "/" 
+                            + std::to_string(time1/1000000) + "/" 
+                            + std::to_string(time2/1000000) + " ms");
+}
+
+void test_inversion()
+{
+    test_inversion_correctness();
+    test_inversion_timing();
+}
@@ -0,0 +1,127 @@
+#include<iostream>
+#include<cassert>
+#include<sstream>
+#include<numeric>
+#include<scan.h>
+#include<utility.h>
+
+
+// Affine map x -> a*x+b, composition is associative but not commutative,
+// hence it catches any misordering of op(carry, x) in the scalar tier.
+struct affine
+{
+    std::uint64_t a;
+    std::uint64_t b;
+    bool operator==(const affine& rhs) const = default;
+};
+
+struct affine_compose
+{
+    affine operator()(const affine& f, const affine& g) const noexcept // apply f then g
+    {
+        return affine{ g.a * f.a, g.a * f.b + g.b };
+    }
+};
+
+template<bool INCLUSIVE, bool REVERSE, typename T, typename OP>
+std::vector<T> scan_reference(const std::vector<T>& vec, const OP& op, const T& init)
+{
+    std::vector<T> ans(vec.size());
+    T acc = init;
+    bool has_acc = !INCLUSIVE;
+    for(std::uint32_t n=0; n!=vec.size(); ++n)
+    {
+        std::uint32_t i = REVERSE ? vec.size()-1-n : n;
+        if constexpr (INCLUSIVE)
+        {
+            acc = has_acc ? op(acc, vec[i]) : vec[i];
+            has_acc = true;
+            ans[i] = acc;
+        }
+        else
+        {
+            ans[i] = acc;
+            acc = op(acc, vec[i]);
+        }
+    }
+    return ans;
+}
+
+template<typename T, typename OP>
+bool check_all_scans(const std::vector<T>& vec, const OP& op, const T& init, std::uint32_t num_threads)
+{
+    if (alg::inclusive_scan        (vec,       op, num_threads) != scan_reference<true,  false>(vec, op, init)) return false;
+    if (alg::exclusive_scan        (vec, init, op, num_threads) != scan_reference<false, false>(vec, op, init)) return false;
+    if (alg::inclusive_scan_reverse(vec,       op, num_threads) != scan_reference<true,  true >(vec, op, init)) return false;
+    if (alg::exclusive_scan_reverse(vec, init, op, num_threads) != scan_reference<false, true >(vec, op, init)) return false;
+
+    // in place
+    auto tmp = vec;
+    alg::inclusive_scan(tmp.data(), tmp.data(), tmp.size(), op, num_threads);
+    return tmp == scan_reference<true, false>(vec, op, init);
+}
+
+void test_scan_correctness()
+{
+    std::uint32_t trial = 200;
+    std::uint32_t error = 0;
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        std::uint32_t size = std::rand() % 50;
+        std::uint32_t num_threads = 1 + std::rand() % 4;
+        auto vec0 = gen_random_vec<std::int32_t> (size, -1000, +1000);
+        auto vec1 = gen_random_vec<std::uint32_t>(size, 0, 1000);
+
+        if (!check_all_scans(vec0, alg::scan_plus<std::int32_t>{},  7,          num_threads)) ++error;
+        if (!check_all_scans(vec0, alg::scan_max<std::int32_t>{},  -5,          num_threads)) ++error;
+        if (!check_all_scans(vec0, alg::scan_min<std::int32_t>{},  +5,          num_threads)) ++error;
+        if (!check_all_scans(vec1, alg::scan_max<std::uint32_t>{}, 500u,        num_threads)) ++error;
+        if (!check_all_scans(vec1, alg::scan_min<std::uint32_t>{}, 500u,        num_threads)) ++error;
+        if (!check_all_scans(vec1, std::plus<std::uint32_t>{},     0u,          num_threads)) ++error; // scalar tier
+    }
+    print_summary("scan - small vec, all tiers vs reference", error, trial);
+
+    // Large enough for the parallel tier, size not multiple of block
+    error = 0;
+    trial = 6;
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        std::uint32_t size = 5 * alg::scan_block_size + std::rand() % 1000;
+        std::uint32_t num_threads = 2 + t;
+        auto vec0 = gen_random_vec<std::int32_t>(size, -1000, +1000);
+        std::vector<affine> vec1;
+        for(std::uint32_t n=0; n!=size; ++n) vec1.push_back(affine{1 + 2 * (std::uint64_t)(std::rand() % 5), (std::uint64_t)(std::rand() % 7)});
+
+        if (!check_all_scans(vec0, alg::scan_plus<std::int32_t>{}, 7,  num_threads)) ++error;
+        if (!check_all_scans(vec0, alg::scan_max<std::int32_t>{}, -5,  num_threads)) ++error;
+        if (!check_all_scans(vec1, affine_compose{}, affine{1,0},      num_threads)) ++error;
+    }
+    print_summary("scan - large vec, parallel tier vs reference", error, trial);
+}
+
+void test_scan_throughput()
+{
+    std::uint32_t size = 1 << 24;
+    auto vec = gen_random_vec<std::uint32_t>(size, 0, 1000);
+    std::vector<std::uint32_t> out(size);
+
+    for(std::uint32_t num_threads : {1, 2, 4, 8})
+    {
+        alg::timer timer;
+        timer.click();
+        alg::inclusive_scan(vec.data(), out.data(), size, alg::scan_plus<std::uint32_t>{}, num_threads);
+        timer.click();
+        assert(out.back() == std::accumulate(vec.begin(), vec.end(), 0u));
+
+        double GBps = 2.0 * size * sizeof(std::uint32_t) / timer.time_elapsed_in_nsec(); // read + write
+        std::stringstream ss;
+        ss << std::setprecision(3) << GBps << " GB/s";
+        print_summary("scan - inclusive_scan 16M uint32, threads = " + std::to_string(num_threads), ss.str());
+    }
+}
+
+void test_scan()
+{
+    test_scan_correctness();
+    test_scan_throughput();
+}
@@ -0,0 +1,129 @@
+#include<iostream>
+#include<cassert>
+#include<selection.h>
+#include<utility.h>
+
+
+// Check the std::nth_element post-condition, not just the value at nth
+bool is_selected(const std::vector<std::uint32_t>& vec, const std::vector<std::uint32_t>& sorted, std::uint32_t k)
+{
+    if (vec[k] != sorted[k]) return false;
+    for(std::uint32_t n=0; n!=k; ++n)          if (vec[n] > vec[k]) return false;
+    for(std::uint32_t n=k+1; n<vec.size(); ++n) if (vec[n] < vec[k]) return false;
+    return true;
+}
+
+std::vector<std::uint32_t> gen_adversarial_vec(std::uint32_t size, std::uint32_t type)
+{
+    std::vector<std::uint32_t> vec(size);
+    for(std::uint32_t n=0; n!=size; ++n)
+    {
+        if      (type == 0) vec[n] = n;                             // sorted
+        else if (type == 1) vec[n] = size - n;                      // reverse sorted
+        else if (type == 2) vec[n] = 7;                             // all equal
+        else if (type == 3) vec[n] = n < size/2 ? n : size - n;     // organ pipe
+        else                vec[n] = std::rand() % 4;               // few distinct values
+    }
+    return vec;
+}
+
+void test_selection_correctness()
+{
+    std::uint32_t trial = 2000;
+    std::uint32_t error0 = 0;
+    std::uint32_t error1 = 0;
+    std::uint32_t error2 = 0;
+    std::uint32_t error3 = 0;
+
+    for(std::uint32_t t=0; t!=trial; ++t)
+    {
+        std::uint32_t size = 1 + std::rand() % (t%2==0? 100 : 5000); // Floyd-Rivest samples above 600
+        auto vec = t%4==3? gen_adversarial_vec(size, std::rand() % 5) : gen_random_vec<std::uint32_t>(size, 0, 1000);
+        auto sorted{vec};
+        std::sort(sorted.begin(), sorted.end());
+        std::uint32_t k = std::rand() % size;
+
+        auto vec0{vec};
+        alg::introselect(vec0.begin(), vec0.begin()+k, vec0.end());
+        if (!is_selected(vec0, sorted, k)) ++error0;
+
+        auto vec1{vec};
+        alg::floyd_rivest_select(vec1.begin(), vec1.begin()+k, vec1.end());
+        if (!is_selected(vec1, sorted, k)) ++error1;
+
+        auto vec2{vec};
+        alg::median_of_medians_select(vec2.begin(), vec2.begin()+k, vec2.end());
+        if (!is_selected(vec2, sorted, k)) ++error2;
+
+        std::vector<std::uint32_t> ranks;
+        for(std::uint32_t n=std::rand()%20; n!=0; --n) ranks.push_back(std::rand() % size);
+        auto vec3{vec};
+        auto ans = alg::multi_select(vec3, ranks);
+        for(std::uint32_t n=0; n!=ranks.size(); ++n)
+        {
+            if (ans[n] != sorted[ranks[n]] || vec3[ranks[n]] != sorted[ranks[n]]) { ++error3; break; }
+        }
+    }
+    print_summary("introselect",              error0, trial);
+    print_summary("floyd_rivest_select",      error1, trial);
+    print_summary("median_of_medians_select", error2, trial);
+    print_summary("multi_select",             error3, trial);
+
+    // Descending order by comparator
+    auto vec = gen_random_vec<std::uint32_t>(1000, 0, 100);
+    auto sorted{vec};
+    std::sort(sorted.begin(), sorted.end(), std::greater<>{});
+    alg::introselect(vec.begin(), vec.begin()+10, vec.end(), std::greater<>{});
+    assert(vec[10] == sorted[10]);
+    print_summary("introselect with comparator", "succeeded");
+}
+
+void test_selection_timing()
+{
+    std::uint32_t size = 1 << 22;
+    auto vec = gen_random_vec<std::uint32_t>(size, 0, 1000000);
+    std::vector<double> rs{0.5, 0.9, 0.99, 0.999};
+
+    // Quantiles by one multi_select vs one full sort
+    auto vec0{vec};
+    alg::timer timer;
+    timer.click();
+    auto ans0 = alg::quantiles(vec0, rs);
+    timer.click();
+    auto time0 = timer.time_elapsed_in_nsec();
+
+    auto vec1{vec};
+    timer.click();
+    std::sort(vec1.begin(), vec1.end());
+    timer.click();
+    auto time1 = timer.time_elapsed_in_nsec();
+
+    for(std::uint32_t n=0; n!=rs.size(); ++n) assert(ans0[n] == vec1[(std::uint32_t)((size-1) * rs[n])]);
+    print_summary("quantiles p50/p90/p99/p999 vs std::sort, 4M",
+                  "time = " + std::to_string(time0/1000) + "/" + std::to_string(time1/1000) + " us");
+
+    for(std::uint32_t type : {0, 2, 4})
+    {
+        auto vec2 = gen_adversarial_vec(size, type);
+        timer.click();
+        alg::introselect(vec2.begin(), vec2.begin() + size/3, vec2.end());
+        timer.click();
+        auto time2 = timer.time_elapsed_in_nsec();
+
+        auto vec3 = gen_adversarial_vec(size, type);
+        timer.click();
+        alg::floyd_rivest_select(vec3.begin(), vec3.begin() + size/3, vec3.end());
+        timer.click();
+        auto time3 = timer.time_elapsed_in_nsec();
+
+        assert(vec2[size/3] == vec3[size/3]);
+        print_summary("introselect / floyd_rivest, adversarial type " + std::to_string(type),
+                      "time = " + std::to_string(time2/1000) + "/" + std::to_string(time3/1000) + " us");
+    }
+}
+
+void test_selection()
+{
+    test_selection_correctness();
+    test_selection_timing();
+}
@@ -1,6 +1,7 @@
 #include<iostream>
 #include<cassert>
 #include<sorting.h>
+#include<corpus.h>
 #include<utility.h>
 
 
@@ -15,10 +16,13 @@ void test_sorting()
     std::uint32_t error4 = 0;
     std::uint32_t error5 = 0;
 
+    // Inputs are generated once, and mapped from cache afterwards
+    auto corpus = alg::load_or_generate_corpus<std::uint32_t>("vec", 1, trial, gen_random_vec<std::uint32_t>, 200, 0, 200);
+
     print_summary("all_sorting", "running ");
     for(std::uint32_t t=0; t!=trial; ++t)
     {
-        auto vec = gen_random_vec<std::uint32_t>(200, 0, 200);
+        auto vec = std::vector<std::uint32_t>(corpus[t].begin(), corpus[t].end());
         auto ans{vec};
         std::sort(ans.begin(), ans.end());
 
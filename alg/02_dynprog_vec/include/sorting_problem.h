@@ -1,18 +1,55 @@
 #include<iostream>
 #include<vector>
 #include<algorithm>
+#include<selection.h>
+#include<inversion.h>
 
 
 namespace alg
 {  
+    // ********************************************************** //
+    // Using introselect :
+    // 1. median-of-3 quickselect with 3-way partition
+    // 2. median-of-medians pivot once depth exceeds 2*log2(N)
+    //
+    // cost = O(N) worst case, including sorted and all-equal input
+    // ********************************************************** //
+    std::uint32_t order_statistics(const std::vector<std::uint32_t>& vec, std::uint32_t kth_order)
+    {
+        if (kth_order >= vec.size()) return 0;
+
+        std::vector<std::uint32_t> v(vec);
+        introselect(v.begin(), v.begin() + kth_order, v.end());
+        return v[kth_order];
+    }
+
+    // No copy, vec is left partitioned around kth_order
+    std::uint32_t order_statistics_inplace(std::vector<std::uint32_t>& vec, std::uint32_t kth_order)
+    {
+        if (kth_order >= vec.size()) return 0;
+
+        introselect(vec.begin(), vec.begin() + kth_order, vec.end());
+        return vec[kth_order];
+    }
+
+    std::uint32_t order_statistics_floyd_rivest(const std::vector<std::uint32_t>& vec, std::uint32_t kth_order)
+    {
+        if (kth_order >= vec.size()) return 0;
+
+        std::vector<std::uint32_t> v(vec);
+        floyd_rivest_select(v.begin(), v.begin() + kth_order, v.end());
+        return v[kth_order];
+    }
+
     // ****************************************** //
     // Using combination of :
     // 1. inner loop - quick sort 
     // 2. outer loop - bisection
     //
     // cost = O(N + N/2 + N/4 + N/8 ...) = O(2N)
+    // cost = O(N^2) for sorted input, as pivot is always the first element
     // ****************************************** //
-    std::uint32_t order_statistics(const std::vector<std::uint32_t>& vec, std::uint32_t kth_order)
+    std::uint32_t order_statistics_partition(const std::vector<std::uint32_t>& vec, std::uint32_t kth_order)
     {
         if (kth_order >= vec.size()) return 0;
 
@@ -53,14 +90,28 @@ namespace alg
         return v[lower];
     }
 
+    // ********************************************************* //
+    // Min number of adjacent swap = number of inversions, using :
+    // 1. fenwick tree, as orig_pos is a permutation
+    // 2. parallel merge sort, for multithread
+    //
+    // cost = O(N log N)
+    // ********************************************************* //
+    std::uint64_t min_number_adjacent_swap(const std::vector<std::uint32_t>& orig_pos, std::uint32_t num_threads = 1)
+    {
+        return count_inversions(orig_pos, num_threads);
+    }
+
     // *********************************** //
     // Using : 
     // 1. bubble sort
     // 2. logic to skip useless comparison
+    //
+    // valid only if no element moved forward by more than 2, as from gen_random_swapped_order
     // *********************************** //
-    std::uint32_t min_number_adjacent_swap(const std::vector<std::uint32_t>& orig_pos)
+    std::uint64_t min_number_adjacent_swap_local(const std::vector<std::uint32_t>& orig_pos)
     {
-        std::uint32_t num_swap = 0;
+        std::uint64_t num_swap = 0;
         for(std::uint32_t n=0; n!=orig_pos.size(); ++n)
         {
             std::uint32_t m0 = 0;
@@ -91,9 +142,9 @@ namespace alg
         return sorted_vec[kth_order];
     }
 
-    std::uint32_t min_number_adjacent_swap_bmk_UL(const std::vector<std::uint32_t>& orig_pos)
+    std::uint64_t min_number_adjacent_swap_bmk_UL(const std::vector<std::uint32_t>& orig_pos)
     {
-        std::uint32_t num_swap = 0;
+        std::uint64_t num_swap = 0;
         for(std::uint32_t n=0; n!=orig_pos.size(); ++n)
         {
             for(std::uint32_t m=0; m!=n; ++m) // m < n, i.e. orig_pos[m] overtook orig_pos[n]
@@ -107,9 +158,9 @@ namespace alg
         return num_swap;
     }
 
-    std::uint32_t min_number_adjacent_swap_bmk_UR(const std::vector<std::uint32_t>& orig_pos)
+    std::uint64_t min_number_adjacent_swap_bmk_UR(const std::vector<std::uint32_t>& orig_pos)
     {
-        std::uint32_t num_swap = 0;
+        std::uint64_t num_swap = 0;
         for(std::uint32_t n=0; n!=orig_pos.size(); ++n)
         {
             for(std::uint32_t m=n+1; m!=orig_pos.size(); ++m) // m > n, i.e. orig_pos[n] overtook orig_pos[m] 
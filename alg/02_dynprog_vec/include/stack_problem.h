@@ -1,8 +1,168 @@
 #include<iostream>
 #include<limits>
 #include<stack>
+#include<span>
 #include<vector>
 #include<algorithm>
+#include<scan.h>
+
+
+// ************************************************************************************ //
+// *** Streaming engines, fed by blocks of arbitrary size, answer is queryable after  *** //
+// *** any block. Monotonic stack is a std::vector (contiguous), not a std::stack.    *** //
+// ************************************************************************************ //
+namespace alg
+{
+    // ********************************************************************************* //
+    // Forward pass of shortest_unsorted_subseq() :
+    // * m_stack keeps the sorted prefix, once sortedness breaks, push stops and incoming
+    //   value pops all larger values, remaining size is begin of the unsorted subseq
+    // * backward pass is replaced by running max, last value less than running max is
+    //   the last of the unsorted subseq
+    // ********************************************************************************* //
+    class unsorted_subseq_stream
+    {
+    public:
+        void reset() noexcept
+        {
+            m_stack.clear();
+            m_pos = 0;
+            m_max = 0;
+            m_last = 0;
+            m_sorted = true;
+        }
+
+        void feed(std::span<const std::uint32_t> block)
+        {
+            for(const auto& x:block)
+            {
+                while(!m_stack.empty() && x < m_stack.back())
+                {
+                    m_sorted = false;
+                    m_stack.pop_back();
+                }
+                if (m_sorted) m_stack.push_back(x);
+                
+                if (m_pos > 0 && x < m_max) m_last = m_pos;
+                m_max = std::max(m_max, x);
+                ++m_pos;
+            }
+        }
+
+        std::uint64_t answer() const noexcept
+        {
+            if (m_sorted) return 0;
+            return m_last + 1 - m_stack.size();
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return m_pos;
+        }
+
+    private:
+        std::vector<std::uint32_t> m_stack;
+        std::uint64_t m_pos    = 0;
+        std::uint32_t m_max    = 0;
+        std::uint64_t m_last   = 0;
+        bool          m_sorted = true;
+    };
+
+    // ********************************************************************************* //
+    // In count_stroke_in_histogram(), only top of stack is read, and it is always the
+    // last value, hence stack reduces to previous value, i.e. ans = sum of rises.
+    // ********************************************************************************* //
+    class stroke_stream
+    {
+    public:
+        void reset() noexcept
+        {
+            m_prev = 0;
+            m_ans = 0;
+        }
+
+        void feed(std::span<const std::uint32_t> block) noexcept
+        {
+            for(const auto& x:block)
+            {
+                m_ans += x > m_prev? x - m_prev : 0;
+                m_prev = x;
+            }
+        }
+
+        std::uint64_t answer() const noexcept
+        {
+            return m_ans;
+        }
+
+    private:
+        std::uint32_t m_prev = 0;
+        std::uint64_t m_ans  = 0;
+    };
+
+    // ********************************************************************************* //
+    // Same as biggest_rect_in_hist(), stack keeps bins with increasing height, each with
+    // the left-most position it can extend to, so that popping does not need next_top.
+    // * rects closed by a lower bin are done, m_best is their max
+    // * rects still open are on the stack, their right edge is the current position
+    // answer() checks the open rects, cost is stack depth (~log N for random heights),
+    // no data is rescanned.
+    // ********************************************************************************* //
+    class biggest_rect_stream
+    {
+    public:
+        void reset() noexcept
+        {
+            m_stack.clear();
+            m_pos = 0;
+            m_best = 0;
+        }
+
+        void feed(std::span<const std::uint32_t> block)
+        {
+            for(const auto& x:block)
+            {
+                std::uint64_t begin = m_pos;
+                while(!m_stack.empty() && x <= m_stack.back().height)
+                {
+                    const auto& top = m_stack.back();
+                    m_best = std::max(m_best, (std::uint64_t)top.height * (m_pos - top.begin));
+                    begin = top.begin;
+                    m_stack.pop_back();
+                }
+                m_stack.push_back(bin{begin, x});
+                ++m_pos;
+            }
+        }
+
+        std::uint64_t answer() const noexcept
+        {
+            std::uint64_t ans = m_best;
+            for(const auto& x:m_stack)
+            {
+                ans = std::max(ans, (std::uint64_t)x.height * (m_pos - x.begin));
+            }
+            return ans;
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return m_pos;
+        }
+
+    private:
+        struct bin
+        {
+            std::uint64_t begin;
+            std::uint32_t height;
+        };
+
+        std::vector<bin> m_stack;
+        std::uint64_t    m_pos  = 0;
+        std::uint64_t    m_best = 0;
+    };
+}
+
 
 
 namespace alg
@@ -186,25 +346,11 @@ namespace alg
         return ans;
     }
 
-    std::uint32_t total_trapped_water(const std::vector<std::uint32_t>& vec) // No benchmark for total_trapped_water()
+    // LHS_profile is prefix max, RHS_profile is suffix max, both are scans.
+    std::uint32_t total_trapped_water(const std::vector<std::uint32_t>& vec, std::uint32_t num_threads = 1)
     {
-        std::vector<std::uint32_t> LHS_profile(vec.size());
-        std::vector<std::uint32_t> RHS_profile(vec.size());
-
-        std::uint32_t LHS_max = 0;
-        for(std::uint32_t n=0; n!=vec.size(); ++n)
-        {
-            LHS_max = std::max(LHS_max,vec[n]);
-            LHS_profile[n] = LHS_max;
-        }
-
-        std::uint32_t RHS_max = 0;
-        for(std::uint32_t n=0; n!=vec.size(); ++n)
-        {
-            std::uint32_t m = vec.size()-1-n;
-            RHS_max = std::max(RHS_max,vec[m]);
-            RHS_profile[m] = RHS_max;
-        }
+        auto LHS_profile = alg::inclusive_scan        (vec, alg::scan_max<std::uint32_t>{}, num_threads);
+        auto RHS_profile = alg::inclusive_scan_reverse(vec, alg::scan_max<std::uint32_t>{}, num_threads);
 
         std::uint32_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
@@ -316,4 +462,16 @@ namespace alg
         }
         return ans;
     }
+    std::uint32_t total_trapped_water_bmk(const std::vector<std::uint32_t>& vec)
+    {
+        std::uint32_t ans = 0;
+        for(std::uint32_t n=0; n!=vec.size(); ++n)
+        {
+            std::uint32_t LHS_max = *std::max_element(vec.begin(),   vec.begin()+n+1);
+            std::uint32_t RHS_max = *std::max_element(vec.begin()+n, vec.end());
+            ans += std::min(LHS_max, RHS_max) - vec[n];
+        }
+        return ans;
+    }
+
 }
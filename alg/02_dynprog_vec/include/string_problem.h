@@ -1,9 +1,139 @@
 #include<iostream>
 #include<string>
+#include<string_view>
+#include<span>
 #include<array>
 #include<vector>
 #include<unordered_map>
 #include<algorithm>
+#include<stdexcept>
+
+
+// ************************************************************************************ //
+// *** Linear time engines on std::string_view, no allocation, for very long text *** //
+// ************************************************************************************ //
+namespace alg
+{
+    // ********************************************************************************* //
+    // Sliding window of non-duplicated chars, fed by chunks, e.g. blocks of a log file.
+    // Window is [m_begin, m_pos) in global position. Table m_last keeps (last seen
+    // position + 1) of each byte, 0 means never seen. When the incoming char was last
+    // seen inside the window, window begin jumps right after it, no rescan is needed.
+    // ********************************************************************************* //
+    class non_duplicated_window
+    {
+    public:
+        non_duplicated_window() noexcept
+        {
+            reset();
+        }
+
+        void reset() noexcept
+        {
+            m_last.fill(0);
+            m_begin = 0;
+            m_pos = 0;
+            m_best_pos = 0;
+            m_best_length = 0;
+        }
+
+        void feed(std::string_view chunk) noexcept
+        {
+            for(unsigned char c : chunk)
+            {
+                m_begin = std::max(m_begin, m_last[c]); // branch free
+                m_last[c] = ++m_pos;
+
+                if (m_pos - m_begin > m_best_length)
+                {
+                    m_best_length = m_pos - m_begin;
+                    m_best_pos    = m_begin;
+                }
+            }
+        }
+
+        std::uint64_t length()      const noexcept { return m_pos - m_begin; } // current window
+        std::uint64_t best_pos()    const noexcept { return m_best_pos;      }
+        std::uint64_t best_length() const noexcept { return m_best_length;   }
+
+    private:
+        std::array<std::uint64_t, 256> m_last;
+        std::uint64_t m_begin;
+        std::uint64_t m_pos;
+        std::uint64_t m_best_pos;
+        std::uint64_t m_best_length;
+    };
+
+
+    struct palindrome_summary
+    {
+        std::size_t odd_pos     = 0; // longest odd  palindrome is str.substr(odd_pos,  odd_length)
+        std::size_t odd_length  = 0;
+        std::size_t even_pos    = 0; // longest even palindrome is str.substr(even_pos, even_length)
+        std::size_t even_length = 0;
+    };
+
+    // ********************************************************************************* //
+    // Manacher algorithm, O(N), outputs are written into caller's buffers :
+    //
+    // odd_radius [n] = r, s.t. str[n-r, n+r]   is the longest palindrome centred at n
+    // even_radius[n] = r, s.t. str[n-r, n+r-1] is the longest palindrome centred at n-0.5
+    //
+    // Keep [L,R] as the right-most palindrome found so far. For centre n inside [L,R],
+    // its mirror L+R-n has known radius, which is a lower bound for radius of n (capped
+    // by R), hence each char is compared only when R grows, R never decreases.
+    // ********************************************************************************* //
+    inline palindrome_summary manacher(std::string_view str,
+                                       std::span<std::uint32_t> odd_radius,
+                                       std::span<std::uint32_t> even_radius)
+    {
+        const std::int64_t N = str.size();
+        if ((std::int64_t)odd_radius.size()  < N) throw std::invalid_argument("manacher : odd_radius too small");
+        if ((std::int64_t)even_radius.size() < N) throw std::invalid_argument("manacher : even_radius too small");
+
+        palindrome_summary ans;
+        if (N > 0) ans.odd_length = 1;
+
+        // *** Odd palindrome *** //
+        for(std::int64_t n=0, L=0, R=-1; n!=N; ++n)
+        {
+            std::int64_t k = (n > R) ? 1 : std::min<std::int64_t>(odd_radius[L+R-n]+1, R-n+1);
+            while(n-k >= 0 && n+k < N && str[n-k] == str[n+k]) ++k;
+            odd_radius[n] = k-1;
+
+            if (n+k-1 > R)
+            {
+                L = n-k+1;
+                R = n+k-1;
+            }
+            if ((std::size_t)(2*k-1) > ans.odd_length)
+            {
+                ans.odd_length = 2*k-1;
+                ans.odd_pos    = n-k+1;
+            }
+        }
+
+        // *** Even palindrome *** //
+        for(std::int64_t n=0, L=0, R=-1; n!=N; ++n)
+        {
+            std::int64_t k = (n > R) ? 0 : std::min<std::int64_t>(even_radius[L+R-n+1], R-n+1);
+            while(n-k-1 >= 0 && n+k < N && str[n-k-1] == str[n+k]) ++k;
+            even_radius[n] = k;
+
+            if (n+k-1 > R)
+            {
+                L = n-k;
+                R = n+k-1;
+            }
+            if ((std::size_t)(2*k) > ans.even_length)
+            {
+                ans.even_length = 2*k;
+                ans.even_pos    = n-k;
+            }
+        }
+        return ans;
+    }
+}
 
 
 // ******************** //
@@ -12,6 +142,14 @@
 namespace alg
 {
     std::uint32_t longest_non_duplicated_substr(const std::string& str)
+    {
+        non_duplicated_window window;
+        window.feed(str);
+        return window.best_length();
+    }
+
+    // The original dynprog with hashmap, replaced by non_duplicated_window, kept for comparison
+    std::uint32_t longest_non_duplicated_substr_dynprog(const std::string& str)
     {
         if (str.size()==0) return 0;
         std::unordered_map<char, std::uint32_t> index; 
@@ -58,8 +196,11 @@ namespace alg
     //            after failing to grow parent-palindrome, like 
     //
     //            M***ABA...T...ABA***N
+    //
+    // Remark 2 : Rollback makes it O(N^2) in worst case, it is now
+    //            replaced by manacher(), and kept for comparison.
     // ************************************************************** //
-    std::uint32_t longest_odd_palindrome_substr(const std::string& str) 
+    std::uint32_t longest_odd_palindrome_substr_rollback(const std::string& str) 
     {
         std::uint32_t sub = 0;
         std::uint32_t ans = 0;
@@ -88,6 +229,20 @@ namespace alg
         }
         return 2*ans+1;
     }
+
+    std::uint32_t longest_odd_palindrome_substr(const std::string& str) 
+    {
+        std::vector<std::uint32_t> odd_radius(str.size());
+        std::vector<std::uint32_t> even_radius(str.size());
+        return std::max<std::size_t>(1, manacher(str, odd_radius, even_radius).odd_length); // 1 for empty str, same as bmk
+    }
+
+    std::uint32_t longest_even_palindrome_substr(const std::string& str) 
+    {
+        std::vector<std::uint32_t> odd_radius(str.size());
+        std::vector<std::uint32_t> even_radius(str.size());
+        return manacher(str, odd_radius, even_radius).even_length;
+    }
 }
 
 
@@ -135,6 +290,23 @@ namespace alg
         }
         return 2 * ans + 1; // length of palindrome
     }
+
+    std::uint32_t longest_even_palindrome_substr_bmk(const std::string& str) 
+    {
+        std::uint32_t ans = 0;                     // radius of palindrome
+        for(std::uint32_t n=1; n<str.size(); ++n)  // centre of palindrome, between n-1 and n
+        {
+            for(std::uint32_t r=1; n>=r && n+r-1<str.size(); ++r)
+            {
+                if (str[n-r] == str[n+r-1])
+                {
+                    ans = std::max(ans, r);
+                }
+                else break;
+            }
+        }
+        return 2 * ans; // length of palindrome
+    }
 }
 
 
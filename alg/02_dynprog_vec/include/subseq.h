@@ -6,6 +6,7 @@
 #include<map>
 #include<unordered_map>
 #include<algorithm>
+#include<flat_hash_map.h>
 
 
 // ******************** //
@@ -215,9 +216,24 @@ namespace alg
 // **************** //
 namespace alg
 {
-    std::uint32_t count_target_subseq_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    // Range of prefix sum (including empty prefix 0), used for choosing dense_map
+    inline std::pair<std::int32_t, std::int32_t> prefix_sum_range(const std::vector<std::int32_t>& vec)
+    {
+        std::int32_t cum = 0;
+        std::int32_t min = 0;
+        std::int32_t max = 0;
+        for(std::uint32_t n=0; n!=vec.size(); ++n)
+        {
+            cum += vec[n];
+            min = std::min(min, cum);
+            max = std::max(max, cum);
+        }
+        return std::make_pair(min, max);
+    }
+
+    template<typename MAP>
+    std::uint32_t count_target_subseq_sum_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        std::unordered_map<std::int32_t, std::uint32_t> hist;
         hist[0] = 1; // do not miss this
 
         std::int32_t  cum = 0;
@@ -225,22 +241,30 @@ namespace alg
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             cum += vec[n];
-            if (auto iter=hist.find(cum-target); iter!=hist.end())
+            if (auto ptr=hist.find(cum-target); ptr!=nullptr)
             {
-                ans += iter->second;
-            }
-            if (auto iter=hist.find(cum); iter!=hist.end())
-            {
-                ++iter->second;
-            }
-            else 
-            {
-                hist[cum] = 1;
+                ans += *ptr;
             }
+            ++hist[cum];
         }
         return ans;
     }
 
+    std::uint32_t count_target_subseq_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        auto [min, max] = prefix_sum_range(vec);
+        if (prefer_dense_map((std::int64_t)max - min, vec.size()+1))
+        {
+            alg::dense_map<std::int32_t, std::uint32_t> hist(min, max);
+            return count_target_subseq_sum_impl(vec, target, hist);
+        }
+        else
+        {
+            alg::flat_hash_map<std::int32_t, std::uint32_t> hist(vec.size()+1);
+            return count_target_subseq_sum_impl(vec, target, hist);
+        }
+    }
+
     std::uint32_t count_target_divisible_subseq_sum(const std::vector<std::int32_t>& vec, std::uint32_t target)
     {
         std::vector<std::uint32_t> hist(target, 0); 
@@ -430,28 +454,40 @@ namespace alg
 // *************** //
 namespace alg
 {
-    std::uint32_t longest_target_subseq_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint32_t longest_target_subseq_sum_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& index)
     {
-        std::unordered_map<std::int32_t, std::int32_t> index; 
-        index[0] = -1; // do not miss this
+        index.insert(0, -1); // do not miss this
 
         std::int32_t  cum = 0;
         std::uint32_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             cum += vec[n];
-            if (auto iter=index.find(cum-target); iter!=index.end())
-            {
-                ans = std::max(ans, n-iter->second);
-            }
-            if (auto iter=index.find(cum); iter==index.end())
+            if (auto ptr=index.find(cum-target); ptr!=nullptr)
             {
-                index[cum] = n;
+                ans = std::max(ans, n-*ptr);
             }
+            index.insert(cum, n); // keep the first index only
         }
         return ans;
     }
 
+    std::uint32_t longest_target_subseq_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        auto [min, max] = prefix_sum_range(vec);
+        if (prefer_dense_map((std::int64_t)max - min, vec.size()+1))
+        {
+            alg::dense_map<std::int32_t, std::int32_t> index(min, max, std::numeric_limits<std::int32_t>::min());
+            return longest_target_subseq_sum_impl(vec, target, index);
+        }
+        else
+        {
+            alg::flat_hash_map<std::int32_t, std::int32_t> index(vec.size()+1);
+            return longest_target_subseq_sum_impl(vec, target, index);
+        }
+    }
+
     // ************************************* //
     // *** Longest increasing subseq LIS *** //
     // ************************************* //
@@ -4,6 +4,8 @@
 #include<vector>
 #include<unordered_map>
 #include<algorithm>
+#include<flat_hash_map.h>
+#include<scan.h>
 
 // ****************************************** //
 // Main variables used for different problems 
@@ -20,16 +22,20 @@
 // ******************** //
 namespace alg
 {
-    std::int32_t max_profit(const std::vector<std::int32_t>& vec)
+    // ********************************************************************* //
+    // Buy at min price before day n, sell at day n, where ...
+    // min price before day n = exclusive prefix min scan
+    // ********************************************************************* //
+    std::int32_t max_profit(const std::vector<std::int32_t>& vec, std::uint32_t num_threads = 1)
     {
         if (vec.size()<2) return 0;
 
-        std::int32_t sub = vec[1]-vec[0];
-        std::int32_t ans = sub;
+        auto min_before = alg::exclusive_scan(vec, std::numeric_limits<std::int32_t>::max(), alg::scan_min<std::int32_t>{}, num_threads);
+
+        std::int32_t ans = vec[1]-min_before[1];
         for(std::uint32_t n=2; n!=vec.size(); ++n)
         {
-            sub = std::max(sub-vec[n-1]+vec[n], vec[n]-vec[n-1]);
-            ans = std::max(ans, sub);
+            ans = std::max(ans, vec[n]-min_before[n]);
         }
         return ans;
     }
@@ -65,58 +71,73 @@ namespace alg
 // **************** //
 namespace alg
 {
-    std::uint32_t count_target_profit(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint32_t count_target_profit_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        std::unordered_map<std::int32_t, std::uint32_t> hist;
         // unlike counting subseq sum, no need to init : hist[0] = ...
 
         std::uint32_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
-            if (auto iter=hist.find(vec[n]-target); iter!=hist.end())
+            if (auto ptr=hist.find(vec[n]-target); ptr!=nullptr)
             {
-                ans += iter->second;
-            }
-            if (auto iter=hist.find(vec[n]); iter!=hist.end()) 
-            {
-                ++iter->second;
-            } 
-            else 
-            {
-                hist[vec[n]] = 1;
+                ans += *ptr;
             }
+            ++hist[vec[n]];
         }
         return ans;
     }
 
-    std::uint32_t count_target_abs_profit(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint32_t count_target_abs_profit_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        std::unordered_map<std::int32_t, std::uint32_t> hist;
         // unlike counting subseq sum, no need to init : hist[0] = ...
         
         std::uint32_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
-            
-            if (auto iter=hist.find(vec[n]-target); iter!=hist.end())
+            if (auto ptr=hist.find(vec[n]-target); ptr!=nullptr)
             {
-                ans += iter->second;
+                ans += *ptr;
             }
-            if (auto iter=hist.find(vec[n]+target); iter!=hist.end())
+            if (auto ptr=hist.find(vec[n]+target); ptr!=nullptr)
             {
-                ans += iter->second;
-            }
-            if (auto iter=hist.find(vec[n]); iter!=hist.end()) 
-            {
-                ++iter->second;
-            } 
-            else 
-            {
-                hist[vec[n]] = 1;
+                ans += *ptr;
             }
+            ++hist[vec[n]];
         }
         return ans;
     }
+
+    std::uint32_t count_target_profit(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        auto [min, max] = value_range(vec);
+        if (prefer_dense_map((std::int64_t)max - min, vec.size()))
+        {
+            alg::dense_map<std::int32_t, std::uint32_t> hist(min, max);
+            return count_target_profit_impl(vec, target, hist);
+        }
+        else
+        {
+            alg::flat_hash_map<std::int32_t, std::uint32_t> hist(vec.size());
+            return count_target_profit_impl(vec, target, hist);
+        }
+    }
+
+    std::uint32_t count_target_abs_profit(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        auto [min, max] = value_range(vec);
+        if (prefer_dense_map((std::int64_t)max - min, vec.size()))
+        {
+            alg::dense_map<std::int32_t, std::uint32_t> hist(min, max);
+            return count_target_abs_profit_impl(vec, target, hist);
+        }
+        else
+        {
+            alg::flat_hash_map<std::int32_t, std::uint32_t> hist(vec.size());
+            return count_target_abs_profit_impl(vec, target, hist);
+        }
+    }
 }
 
 
@@ -5,6 +5,9 @@
 #include<unordered_map>
 #include<algorithm>
 #include<stdexcept>
+#include<thread>
+#include<immintrin.h>
+#include<flat_hash_map.h>
 
 
 // ******************** //
@@ -222,95 +225,447 @@ namespace alg
         else               return false;
     }
 
-    std::uint32_t count_target_2_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint32_t count_target_2_point_sum_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        if (vec.size()<2) return false;
-        std::unordered_map<std::int32_t,std::uint32_t> hist;
-
         std::uint32_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
-            if (auto iter=hist.find(target-vec[n]); iter!=hist.end()) 
+            if (auto ptr=hist.find(target-vec[n]); ptr!=nullptr) 
             {
-                ans += iter->second;
+                ans += *ptr;
             }
 
             // Cache vec[n], ensure index_in_hist < n
-            if (auto iter=hist.find(vec[n]); iter!=hist.end()) 
-            {
-                ++iter->second;
-            }
-            else
-            {
-                hist[vec[n]] = 1;
-            }
+            ++hist[vec[n]];
         }
         return ans;
     }
 
-    std::uint32_t count_target_3_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint64_t count_target_3_point_sum_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        if (vec.size()<3) return false;
-        std::unordered_map<std::int32_t,std::uint32_t> hist;
-
-        std::uint32_t ans = 0;
+        std::uint64_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             for(std::uint32_t m=n+1; m!=vec.size(); ++m)
             {
-                if (auto iter=hist.find(target-vec[n]-vec[m]); iter!=hist.end()) 
+                if (auto ptr=hist.find(target-vec[n]-vec[m]); ptr!=nullptr) 
                 {
-                    ans += iter->second;
+                    ans += *ptr;
                 }
             }
 
             // cache vec[n], not vec[m], ensure index_in_hist < n < m
-            if (auto iter=hist.find(vec[n]); iter!=hist.end()) 
-            {
-                ++iter->second;
-            }
-            else
-            {
-                hist[vec[n]] = 1; 
-            }
+            ++hist[vec[n]];
         }
         return ans;
     }
 
-    std::uint32_t count_target_4_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    template<typename MAP>
+    std::uint64_t count_target_4_point_sum_impl(const std::vector<std::int32_t>& vec, std::int32_t target, MAP& hist)
     {
-        if (vec.size()<4) return false;
-        std::unordered_map<std::int32_t,std::uint32_t> hist;
-
-        std::uint32_t ans = 0;
+        std::uint64_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             for(std::uint32_t m=n+1; m!=vec.size(); ++m)
             {
                 for(std::uint32_t k=m+1; k!=vec.size(); ++k)
                 {
-                    if (auto iter=hist.find(target-vec[n]-vec[m]-vec[k]); iter!=hist.end()) 
+                    if (auto ptr=hist.find(target-vec[n]-vec[m]-vec[k]); ptr!=nullptr) 
                     {
-                        ans += iter->second;
+                        ans += *ptr;
                     }
                 }
             }
 
             // cache vec[n], not vec[m], not vec[k], ensure index_in_hist < n < m < k
-            if (auto iter=hist.find(vec[n]); iter!=hist.end()) 
+            ++hist[vec[n]];
+        }
+        return ans;
+    }
+
+    // ***************************************************************************** //
+    // Histogram of vec[n] is kept in :
+    // * dense_map     if max-min is small, lookup outside [min,max] returns nullptr
+    // * flat_hash_map otherwise
+    // ***************************************************************************** //
+    template<typename IMPL>
+    auto count_target_k_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target, IMPL impl)
+    {
+        auto [min, max] = value_range(vec);
+        if (prefer_dense_map((std::int64_t)max - min, vec.size()))
+        {
+            alg::dense_map<std::int32_t, std::uint32_t> hist(min, max);
+            return impl(vec, target, hist);
+        }
+        else
+        {
+            alg::flat_hash_map<std::int32_t, std::uint32_t> hist(vec.size());
+            return impl(vec, target, hist);
+        }
+    }
+
+    std::uint32_t count_target_2_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        if (vec.size()<2) return false;
+        return count_target_k_point_sum(vec, target, [](const auto& vec, std::int32_t target, auto& hist)
+        {
+            return count_target_2_point_sum_impl(vec, target, hist);
+        });
+    }
+
+    std::uint64_t count_target_3_point_sum_hashmap(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        if (vec.size()<3) return false;
+        return count_target_k_point_sum(vec, target, [](const auto& vec, std::int32_t target, auto& hist)
+        {
+            return count_target_3_point_sum_impl(vec, target, hist);
+        });
+    }
+
+    std::uint64_t count_target_4_point_sum_hashmap(const std::vector<std::int32_t>& vec, std::int32_t target)
+    {
+        if (vec.size()<4) return false;
+        return count_target_k_point_sum(vec, target, [](const auto& vec, std::int32_t target, auto& hist)
+        {
+            return count_target_4_point_sum_impl(vec, target, hist);
+        });
+    }
+}
+
+
+
+// ****************************************************************************************** //
+// *** Counting - k point sum engine                                                      *** //
+// ****************************************************************************************** //
+// Above hashmap implementations look up the histogram in the innermost loop, costing O(N^2)
+// for 3-sum and O(N^3) for 4-sum. Here :
+//
+// 3-sum : if value range is small, for each m (the 2nd index), hist holds vec[n] with n < m,
+//         count is sum of hist[target-vec[m]-vec[k]] over k > m, done by AVX2 gather
+//       : otherwise sort, then for each outer index n, count pairs in (n, N) by two pointers,
+//         a run of equal values is counted at once, i.e. run0 * run1 pairs, or C(run,2)
+//         when both pointers meet in the same run, cost O(N^2) without any hashmap
+//
+// 4-sum : meet in the middle, for each k (the 3rd index), hist holds sum of pairs (n,m) 
+//         with n < m < k, then count is sum of hist[target-vec[k]-vec[l]] over l > k, 
+//         after that, pairs (n,k) are added to hist, cost O(N^2)
+//         * if range of pair sum is small, hist is an array, the lookup over l is AVX2 gather
+//         * otherwise hist is flat_hash_map keyed by 64-bit pair sum
+//
+// Array hist covers both inserted values and looked up values, so lookup needs no bound check.
+//
+// Multithread is partitioned by outer index :
+// 3-sum : cost of index n is N-n, hence contiguous blocks of equal area for array hist,
+//         interleaved index for two pointers
+// 4-sum : k is split in contiguous blocks, cost of each k is N (N-k lookups + k inserts),
+//         thread b first builds histogram of pairs whose 2nd index is in its own block,
+//         then cumulates these histograms, so that block b starts from pairs before block b
+//       : flat_hash_map hist cannot be cumulated like arrays, instead pair sums are sharded
+//         by hash, thread t runs over all k, but inserts and looks up only pair sums of
+//         shard t, hence each map holds 1/T of up to N^2/2 pair sums, with no merge, it
+//         throws std::length_error upfront if shards cannot fit flat_hash_map capacity
+// ****************************************************************************************** //
+namespace alg
+{
+    std::uint64_t count_target_3_point_sum_sorted_impl(const std::vector<std::int64_t>& sorted, 
+                                                       std::int64_t target, 
+                                                       std::uint32_t n)
+    {
+        std::uint64_t ans = 0;
+        std::int64_t  sub_target = target - sorted[n];
+        std::uint32_t lo = n+1;
+        std::uint32_t hi = sorted.size()-1;
+        while(lo < hi)
+        {
+            std::int64_t sum = sorted[lo] + sorted[hi];
+            if      (sum < sub_target) ++lo;
+            else if (sum > sub_target) --hi;
+            else if (sorted[lo] == sorted[hi]) 
             {
-                ++iter->second;
+                std::uint64_t run = hi-lo+1;
+                ans += run * (run-1) / 2;
+                break;
             }
             else
             {
-                hist[vec[n]] = 1; 
+                std::uint64_t run_lo = 1;
+                std::uint64_t run_hi = 1;
+                while(sorted[lo+1] == sorted[lo]) { ++lo; ++run_lo; } // stops at sorted[hi] != sorted[lo]
+                while(sorted[hi-1] == sorted[hi]) { --hi; ++run_hi; }
+                ans += run_lo * run_hi;
+                ++lo;
+                --hi;
             }
         }
         return ans;
     }
+
+    std::uint64_t count_target_3_point_sum_sorted(const std::vector<std::int32_t>& vec, std::int32_t target, std::uint32_t num_threads = 1)
+    {
+        if (vec.size()<3) return 0;
+
+        std::vector<std::int64_t> sorted(vec.begin(), vec.end()); // no overflow in sum
+        std::sort(sorted.begin(), sorted.end());
+
+        num_threads = std::max(1u, std::min<std::uint32_t>(num_threads, vec.size()/256));
+        std::vector<std::uint64_t> ans(num_threads, 0);
+        auto fct = [&](std::uint32_t t)
+        {
+            for(std::uint32_t n=t; n+2<sorted.size(); n+=num_threads)
+            {
+                ans[t] += count_target_3_point_sum_sorted_impl(sorted, target, n);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(fct, t);
+        fct(0);
+        for(auto& x:threads) x.join();
+
+        std::uint64_t total = 0;
+        for(const auto& x:ans) total += x;
+        return total;
+    }
 }
 
 
+namespace alg
+{
+    // Return sum of hist[offset-vec[n]] for all n, where offset-vec[n] must be inside hist
+    inline std::uint64_t sum_hist_lookup_scalar(const std::uint32_t* hist, 
+                                                const std::int32_t*  vec, 
+                                                std::uint32_t size, 
+                                                std::int32_t  offset) noexcept
+    {
+        std::uint64_t ans = 0;
+        for(std::uint32_t n=0; n!=size; ++n) ans += hist[(std::uint32_t)offset - (std::uint32_t)vec[n]]; // wraps like AVX2
+        return ans;
+    }
+
+    __attribute__((target("avx2")))
+    inline std::uint64_t sum_hist_lookup_avx2(const std::uint32_t* hist, 
+                                              const std::int32_t*  vec, 
+                                              std::uint32_t size, 
+                                              std::int32_t  offset) noexcept
+    {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        __m256i off  = _mm256_set1_epi32(offset);
+
+        std::uint32_t n = 0;
+        for(; n+8<=size; n+=8)
+        {
+            __m256i index = _mm256_sub_epi32(off, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vec+n)));
+            __m256i count = _mm256_i32gather_epi32(reinterpret_cast<const int*>(hist), index, 4);
+            acc0 = _mm256_add_epi64(acc0, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(count)));
+            acc1 = _mm256_add_epi64(acc1, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(count, 1)));
+        }
+
+        alignas(32) std::uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(acc0, acc1));
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_hist_lookup_scalar(hist, vec+n, size-n, offset);
+    }
+
+    inline std::uint64_t sum_hist_lookup(const std::uint32_t* hist, 
+                                         const std::int32_t*  vec, 
+                                         std::uint32_t size, 
+                                         std::int32_t  offset) noexcept
+    {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2) return sum_hist_lookup_avx2  (hist, vec, size, offset);
+        else      return sum_hist_lookup_scalar(hist, vec, size, offset);
+    }
+
+    template<typename F>
+    void run_k_point_sum_threads(std::uint32_t num_threads, const F& fct)
+    {
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(fct, t);
+        fct(0);
+        for(auto& x:threads) x.join();
+    }
+
+    // Value x is stored in hist[x-base], with base and size covering both values and lookups 
+    std::uint64_t count_target_3_point_sum_dense_impl(const std::vector<std::int32_t>& vec, 
+                                                      std::int32_t  target, 
+                                                      std::int64_t  base,
+                                                      std::uint64_t hist_size,
+                                                      std::uint32_t num_threads)
+    {
+        // Equal area blocks, as fraction of work before m is 1-(1-m/N)^2
+        std::uint32_t size = vec.size();
+        std::vector<std::uint32_t> bounds(num_threads+1);
+        for(std::uint32_t t=0; t<=num_threads; ++t) 
+        {
+            bounds[t] = size * (1.0 - std::sqrt(1.0 - (double)t / num_threads));
+        }
+        bounds[num_threads] = size;
+
+        std::vector<std::uint64_t> ans(num_threads, 0);
+        run_k_point_sum_threads(num_threads, [&](std::uint32_t t)
+        {
+            std::vector<std::uint32_t> hist(hist_size, 0);
+            for(std::uint32_t n=0; n!=bounds[t]; ++n) ++hist[vec[n] - base];
+            for(std::uint32_t m=bounds[t]; m!=bounds[t+1]; ++m)
+            {
+                std::int32_t offset = (std::int64_t)target - vec[m] - base;
+                ans[t] += sum_hist_lookup(hist.data(), vec.data()+m+1, size-m-1, offset);
+                ++hist[vec[m] - base];
+            }
+        });
+
+        std::uint64_t total = 0;
+        for(const auto& x:ans) total += x;
+        return total;
+    }
+
+    std::uint64_t count_target_3_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target, std::uint32_t num_threads = 1)
+    {
+        if (vec.size()<3) return 0;
+
+        auto [min, max] = value_range(vec);
+        std::int64_t base = std::min<std::int64_t>(min, (std::int64_t)target - 2LL*max);
+        std::int64_t top  = std::max<std::int64_t>(max, (std::int64_t)target - 2LL*min);
+        std::uint64_t hist_size = top - base + 1;
+
+        num_threads = std::max(1u, std::min<std::uint32_t>(num_threads, vec.size()/256));
+        if (prefer_dense_map(hist_size, vec.size()))
+        {
+            return count_target_3_point_sum_dense_impl(vec, target, base, hist_size, num_threads);
+        }
+        else
+        {
+            return count_target_3_point_sum_sorted(vec, target, num_threads);
+        }
+    }
+
+    // Pair sum s is stored in hist[s-base], with base and size covering both pair sums and lookups 
+    std::uint64_t count_target_4_point_sum_dense_impl(const std::vector<std::int32_t>& vec, 
+                                                      std::int32_t  target, 
+                                                      std::int64_t  base,
+                                                      std::uint64_t hist_size,
+                                                      std::uint32_t num_threads)
+    {
+        std::uint32_t size = vec.size();
+        std::vector<std::uint32_t> bounds(num_threads+1);
+        for(std::uint32_t t=0; t<=num_threads; ++t) bounds[t] = (std::uint64_t)size * t / num_threads;
+
+        // hists[t] ends up with pairs (n,m) where m < bounds[t]
+        std::vector<std::vector<std::uint32_t>> hists(num_threads, std::vector<std::uint32_t>(hist_size, 0));
+        auto run_threads = [num_threads](const auto& fct) { run_k_point_sum_threads(num_threads, fct); };
+        auto add_pairs = [&](std::vector<std::uint32_t>& hist, std::uint32_t m)
+        {
+            for(std::uint32_t n=0; n!=m; ++n) ++hist[(std::int64_t)vec[n] + vec[m] - base];
+        };
+
+        // Step 1 : hists[t+1] = pairs with m in block t
+        if (num_threads > 1)
+        {
+            run_threads([&](std::uint32_t t)
+            {
+                if (t+1 == num_threads) return;
+                for(std::uint32_t m=bounds[t]; m!=bounds[t+1]; ++m) add_pairs(hists[t+1], m);
+            });
+
+            // Step 2 : cumulate across blocks, each thread takes a slice of hist
+            run_threads([&](std::uint32_t t)
+            {
+                std::uint64_t begin = hist_size * t     / num_threads;
+                std::uint64_t end   = hist_size * (t+1) / num_threads;
+                for(std::uint32_t b=2; b<num_threads; ++b)
+                {
+                    for(std::uint64_t i=begin; i!=end; ++i) hists[b][i] += hists[b-1][i];
+                }
+            });
+        }
+
+        // Step 3 : count block by block
+        std::vector<std::uint64_t> ans(num_threads, 0);
+        run_threads([&](std::uint32_t t)
+        {
+            auto& hist = hists[t];
+            for(std::uint32_t k=bounds[t]; k!=bounds[t+1]; ++k)
+            {
+                std::int32_t offset = (std::int64_t)target - vec[k] - base;
+                ans[t] += sum_hist_lookup(hist.data(), vec.data()+k+1, size-k-1, offset);
+                add_pairs(hist, k);
+            }
+        });
+
+        std::uint64_t total = 0;
+        for(const auto& x:ans) total += x;
+        return total;
+    }
+
+    // Shard is taken from high 32 bits of hash, while flat_hash_map probes by low bits
+    std::uint64_t count_target_4_point_sum_sparse_impl(const std::vector<std::int32_t>& vec, 
+                                                       std::int32_t  target, 
+                                                       std::uint64_t num_keys, 
+                                                       std::uint32_t num_threads)
+    {
+        // Max load of flat_hash_map with 2^31 slots, with margin for uneven shards
+        if (num_keys / num_threads > (1ULL << 31) / 8 * 7 / 2)
+        {
+            throw std::length_error("count_target_4_point_sum : too many pair sums for flat_hash_map");
+        }
+
+        std::uint32_t size = vec.size();
+        std::vector<std::uint64_t> ans(num_threads, 0);
+        run_k_point_sum_threads(num_threads, [&](std::uint32_t t)
+        {
+            auto shard = [num_threads](std::int64_t x) -> std::uint32_t
+            {
+                return ((alg::flat_hash<std::int64_t>{}(x) >> 32) * num_threads) >> 32;
+            };
+
+            alg::flat_hash_map<std::int64_t, std::uint32_t> hist(size * 4);
+            for(std::uint32_t k=0; k!=size; ++k)
+            {
+                std::int64_t sub_target = (std::int64_t)target - vec[k];
+                for(std::uint32_t l=k+1; l!=size; ++l)
+                {
+                    std::int64_t key = sub_target - vec[l];
+                    if (shard(key) != t) continue;
+                    if (auto ptr=hist.find(key); ptr!=nullptr) ans[t] += *ptr;
+                }
+                for(std::uint32_t n=0; n!=k; ++n) 
+                {
+                    std::int64_t key = (std::int64_t)vec[n] + vec[k];
+                    if (shard(key) == t) ++hist[key];
+                }
+            }
+        });
+
+        std::uint64_t total = 0;
+        for(const auto& x:ans) total += x;
+        return total;
+    }
+
+    std::uint64_t count_target_4_point_sum(const std::vector<std::int32_t>& vec, std::int32_t target, std::uint32_t num_threads = 1)
+    {
+        if (vec.size()<4) return 0;
+
+        // Hist covers pair sums [2*min, 2*max] and lookups [target-2*max, target-2*min]
+        auto [min, max] = value_range(vec);
+        std::int64_t base = std::min<std::int64_t>(2LL*min, (std::int64_t)target - 2LL*max);
+        std::int64_t top  = std::max<std::int64_t>(2LL*max, (std::int64_t)target - 2LL*min);
+        std::uint64_t hist_size = top - base + 1;
+        std::uint64_t num_pairs = (std::uint64_t)vec.size() * (vec.size()-1) / 2;
+
+        num_threads = std::max(1u, std::min<std::uint32_t>(num_threads, vec.size()/256));
+        if (prefer_dense_map(hist_size, num_pairs))
+        {
+            return count_target_4_point_sum_dense_impl(vec, target, base, hist_size, num_threads);
+        }
+        else
+        {
+            return count_target_4_point_sum_sparse_impl(vec, target, std::min(num_pairs, hist_size), num_threads);
+        }
+    }
+}
+
 
 // ******************************************* //
 // *** Counting - benchmark implementation *** //
@@ -363,11 +718,11 @@ namespace alg
         return ans;
     }
 
-    std::uint32_t count_target_3_point_sum_bmk(const std::vector<std::int32_t>& vec, std::int32_t target)
+    std::uint64_t count_target_3_point_sum_bmk(const std::vector<std::int32_t>& vec, std::int32_t target)
     {
         if (vec.size()<3) return false;
 
-        std::uint32_t ans = 0;
+        std::uint64_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             for(std::uint32_t m=n+1; m!=vec.size(); ++m)
@@ -381,11 +736,11 @@ namespace alg
         return ans;
     }
     
-    std::uint32_t count_target_4_point_sum_bmk(const std::vector<std::int32_t>& vec, std::int32_t target)
+    std::uint64_t count_target_4_point_sum_bmk(const std::vector<std::int32_t>& vec, std::int32_t target)
     {
         if (vec.size()<4) return false;
 
-        std::uint32_t ans = 0;
+        std::uint64_t ans = 0;
         for(std::uint32_t n=0; n!=vec.size(); ++n)
         {
             for(std::uint32_t m=n+1; m!=vec.size(); ++m)
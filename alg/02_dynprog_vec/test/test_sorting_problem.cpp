@@ -13,11 +13,55 @@ void test_sorting_problem()
                  std::bind(alg::order_statistics,     _1, kth_order),       
                  std::bind(alg::order_statistics_bmk, _1, kth_order),
                  num_trial); 
+
+    benchmark<1>("order_statistics_floyd_rivest",           
+                 std::bind(gen_random_vec<std::uint32_t>, 2000, 0, 100000), 
+                 std::bind(alg::order_statistics_floyd_rivest, _1, 1500),       
+                 std::bind(alg::order_statistics_bmk,          _1, 1500),
+                 num_trial/10); 
+
+    // Sorted input is quadratic for the simple partition loop
+    auto gen_sorted_vec = [](std::uint32_t size)
+    {
+        auto vec = gen_random_vec<std::uint32_t>(size, 0, 100000);
+        std::sort(vec.begin(), vec.end());
+        return vec;
+    };
+    benchmark<1>("order_statistics (sorted input)",           
+                 std::bind(gen_sorted_vec, 20000), 
+                 std::bind(alg::order_statistics,           _1, 15000),       
+                 std::bind(alg::order_statistics_partition, _1, 15000),
+                 10); 
     
     benchmark<1>("min_number_adjacent_swap",           
                  std::bind(gen_random_swapped_order, 200),
-                 std::bind(alg::min_number_adjacent_swap,        _1),   
+                 std::bind(alg::min_number_adjacent_swap,        _1, 1),   
                  std::bind(alg::min_number_adjacent_swap_bmk_UR, _1),
                  num_trial); 
+
+    benchmark<1>("min_number_adjacent_swap_local",           
+                 std::bind(gen_random_swapped_order, 200),
+                 std::bind(alg::min_number_adjacent_swap_local,  _1),   
+                 std::bind(alg::min_number_adjacent_swap_bmk_UR, _1),
+                 num_trial); 
+
+    // Random permutation, inversions are far from the diagonal
+    auto gen_random_permutation = [](std::uint32_t size)
+    {
+        auto vec = gen_random_swapped_order(size);
+        for(std::uint32_t n=size; n>1; --n) std::swap(vec[n-1], vec[std::rand() % n]);
+        return vec;
+    };
+    benchmark<1>("min_number_adjacent_swap (permutation)",           
+                 std::bind(gen_random_permutation, 5000),
+                 std::bind(alg::min_number_adjacent_swap,        _1, 1),   
+                 std::bind(alg::min_number_adjacent_swap_bmk_UR, _1),
+                 num_trial/100); 
+
+    benchmark<1>("min_number_adjacent_swap (permutation, multithread)",           
+                 std::bind(gen_random_permutation, 1000000),
+                 std::bind(alg::min_number_adjacent_swap, _1, 4),   
+                 std::bind(alg::min_number_adjacent_swap, _1, 1),
+                 20); 
 }
   
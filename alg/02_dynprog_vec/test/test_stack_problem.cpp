@@ -2,6 +2,61 @@
 #include<utility.h>
 #include<stack_problem.h>
 
+
+// Feed the whole vector by random blocks, query after each block against the prefix
+template<typename STREAM, typename BMK>
+bool check_stream(const std::vector<std::uint32_t>& vec, BMK bmk)
+{
+    STREAM stream;
+    std::uint32_t pos = 0;
+    while(pos < vec.size())
+    {
+        std::uint32_t size = std::min<std::uint32_t>(vec.size()-pos, std::rand() % 16);
+        stream.feed(std::span<const std::uint32_t>(vec.data()+pos, size));
+        pos += size;
+
+        std::vector<std::uint32_t> prefix(vec.begin(), vec.begin()+pos);
+        if (stream.answer() != bmk(prefix)) return false;
+    }
+    stream.reset();
+    stream.feed(vec);
+    return stream.answer() == bmk(vec);
+}
+
+void test_stack_problem_stream()
+{
+    std::uint32_t num_trial = 1000;
+    std::uint32_t error0 = 0;
+    std::uint32_t error1 = 0;
+    std::uint32_t error2 = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        auto vec0 = gen_random_partial_sorted_vec<std::uint32_t>(100, 0, 200);
+        auto vec1 = gen_random_vec<std::uint32_t>(100, 0, 50);
+        auto vec2 = gen_random_vec<std::uint32_t>(100, 0, 80);
+        if (!check_stream<alg::unsorted_subseq_stream>(vec0, alg::shortest_unsorted_subseq_bmk))  ++error0;
+        if (!check_stream<alg::stroke_stream>         (vec1, alg::count_stroke_in_histogram_bmk)) ++error1;
+        if (!check_stream<alg::biggest_rect_stream>   (vec2, alg::biggest_rect_in_hist_bmk))      ++error2;
+    }
+    print_summary("unsorted_subseq_stream fed by blocks", error0, num_trial);
+    print_summary("stroke_stream fed by blocks",          error1, num_trial);
+    print_summary("biggest_rect_stream fed by blocks",    error2, num_trial);
+
+    // Throughput, feeding 4K blocks
+    std::uint32_t size = 1 << 24;
+    auto vec = gen_random_vec<std::uint32_t>(size, 0, 1000);
+    alg::biggest_rect_stream stream;
+    alg::timer timer;
+    timer.click();
+    for(std::uint32_t pos=0; pos<size; pos+=4096)
+    {
+        stream.feed(std::span<const std::uint32_t>(vec.data()+pos, 4096));
+    }
+    auto ans = stream.answer();
+    timer.click();
+    print_summary("biggest_rect_stream 16M by 4K blocks", 
+                  "time = " + std::to_string(timer.time_elapsed_in_nsec()/1000) + " us, ans = " + std::to_string(ans));
+}
   
 void test_stack_problem()
 {
@@ -27,8 +82,15 @@ void test_stack_problem()
 
     benchmark<1>("total_trapped_water",           
                  std::bind(gen_random_vec<std::uint32_t>, 50, 0, 30),
-                 std::bind(alg::total_trapped_water, _1),   
-                 std::bind(alg::total_trapped_water, _1), // no benchmark
+                 std::bind(alg::total_trapped_water,     _1, 1),   
+                 std::bind(alg::total_trapped_water_bmk, _1),
                  num_trial);  
+
+    benchmark<1>("total_trapped_water (multithread)",           
+                 std::bind(gen_random_vec<std::uint32_t>, 500000, 0, 30),
+                 std::bind(alg::total_trapped_water, _1, 4),   
+                 std::bind(alg::total_trapped_water, _1, 1),
+                 20);  
+
+    test_stack_problem_stream();
 }
-  
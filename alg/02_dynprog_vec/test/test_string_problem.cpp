@@ -1,8 +1,62 @@
 #include<iostream>
+#include<cassert>
 #include<utility.h>
 #include<string_problem.h>
 
-  
+
+bool is_palindrome(std::string_view str)
+{
+    return std::equal(str.begin(), str.begin() + str.size()/2, str.rbegin());
+}
+
+// Check positions and all radii returned by manacher()
+bool check_manacher(const std::string& str)
+{
+    std::vector<std::uint32_t> odd_radius(str.size());
+    std::vector<std::uint32_t> even_radius(str.size());
+    auto ans = alg::manacher(str, odd_radius, even_radius);
+
+    std::string_view sv(str);
+    if (ans.odd_length  != alg::longest_odd_palindrome_substr_bmk (str)) return false;
+    if (ans.even_length != alg::longest_even_palindrome_substr_bmk(str)) return false;
+    if (!is_palindrome(sv.substr(ans.odd_pos,  ans.odd_length )))        return false;
+    if (!is_palindrome(sv.substr(ans.even_pos, ans.even_length)))        return false;
+
+    for(std::uint32_t n=0; n!=str.size(); ++n)
+    {
+        std::uint32_t r = odd_radius[n];
+        if (!is_palindrome(sv.substr(n-r, 2*r+1))) return false;
+        if (n>=r+1 && n+r+1<str.size() && str[n-r-1]==str[n+r+1]) return false; // not maximal
+
+        r = even_radius[n];
+        if (!is_palindrome(sv.substr(n-r, 2*r))) return false;
+        if (n>=r+1 && n+r<str.size() && str[n-r-1]==str[n+r]) return false;     // not maximal
+    }
+    return true;
+}
+
+// Feeding by random chunks should give the same answer as feeding at once
+bool check_non_duplicated_window(const std::string& str)
+{
+    alg::non_duplicated_window window;
+    std::string_view sv(str);
+    while(!sv.empty())
+    {
+        std::uint32_t size = std::min<std::uint32_t>(sv.size(), std::rand() % 8);
+        window.feed(sv.substr(0, size));
+        sv.remove_prefix(size);
+    }
+
+    std::string_view best = std::string_view(str).substr(window.best_pos(), window.best_length());
+    std::array<bool,256> seen{};
+    for(unsigned char c : best)
+    {
+        if (seen[c]) return false;
+        seen[c] = true;
+    }
+    return window.best_length() == alg::longest_non_duplicated_substr_bmk(str);
+}
+
 void test_string_problem()
 {
     std::uint32_t num_trial = 10000;
@@ -13,12 +67,44 @@ void test_string_problem()
                  std::bind(alg::longest_non_duplicated_substr_bmk, _1),
                  num_trial); 
 
+    benchmark<1>("longest_non_duplicate_substr (dynprog)",           
+                 std::bind(gen_random_str, 20, 26), 
+                 std::bind(alg::longest_non_duplicated_substr_dynprog, _1),      
+                 std::bind(alg::longest_non_duplicated_substr_bmk,     _1),
+                 num_trial); 
+
     benchmark<1>("longest_odd_palindrome_substr",           
                  std::bind(gen_random_palindrome, 200, 5), 
                  std::bind(alg::longest_odd_palindrome_substr,     _1),
                  std::bind(alg::longest_odd_palindrome_substr_bmk, _1),
                  num_trial); 
 
+    benchmark<1>("longest_odd_palindrome_substr (rollback)",           
+                 std::bind(gen_random_palindrome, 200, 5), 
+                 std::bind(alg::longest_odd_palindrome_substr_rollback, _1),
+                 std::bind(alg::longest_odd_palindrome_substr_bmk,      _1),
+                 num_trial); 
+
+    benchmark<1>("longest_even_palindrome_substr",           
+                 std::bind(gen_random_palindrome, 200, 3), 
+                 std::bind(alg::longest_even_palindrome_substr,     _1),
+                 std::bind(alg::longest_even_palindrome_substr_bmk, _1),
+                 num_trial); 
+
+    std::uint32_t error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        if (!check_manacher(gen_random_palindrome(1 + std::rand() % 100, 1 + std::rand() % 4))) ++error;
+    }
+    print_summary("manacher radii and positions", error, num_trial);
+
+    error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        if (!check_non_duplicated_window(gen_random_str(std::rand() % 60, 1 + std::rand() % 26))) ++error;
+    }
+    print_summary("non_duplicated_window fed by chunks", error, num_trial);
+
 
     // **************************** //
     // *** For repeat and debug *** //
@@ -28,4 +114,3 @@ void test_string_problem()
     std::uint32_t ans = alg::longest_odd_palindrome_substr_optimized(str);
     std::cout << "\n[REPEAT CASE] ans = " << ans; */
 }
-  
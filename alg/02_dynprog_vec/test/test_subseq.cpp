@@ -39,6 +39,12 @@ void test_subseq_sum()
                  std::bind(alg::count_target_subseq_sum_bmk, _1, 20),  
                  num_trial); 
 
+    benchmark<1>("count_target_subseq_sum (wide range)",           
+                 std::bind(gen_random_vec<std::int32_t>, 300, -100000, +100000), 
+                 std::bind(alg::count_target_subseq_sum,     _1, 20),
+                 std::bind(alg::count_target_subseq_sum_bmk, _1, 20),  
+                 num_trial); 
+
     benchmark<1>("count_target_divisible_subseq_sum", 
                  std::bind(gen_random_vec<std::int32_t>, 30, -20, +20), 
                  std::bind(alg::count_target_divisible_subseq_sum,     _1, 8),
@@ -76,6 +82,12 @@ void test_subseq_sum()
                  std::bind(alg::longest_target_subseq_sum_bmk, _1, 20),
                  num_trial); 
 
+    benchmark<1>("longest_target_subseq_sum (wide range)", 
+                 std::bind(gen_random_vec<std::int32_t>, 300, -100000, +100000), 
+                 std::bind(alg::longest_target_subseq_sum,     _1, 20),
+                 std::bind(alg::longest_target_subseq_sum_bmk, _1, 20),
+                 num_trial); 
+
     benchmark<1>("longest_non_contiguous_increasing_subseq", 
                  std::bind(gen_random_vec<std::uint32_t>, 30, 1, 100), 
                  std::bind(alg::longest_non_contiguous_increasing_subseq,        _1),
@@ -10,9 +10,15 @@ void test_two_point_diff()
     // *** Maximization *** //
     benchmark<1>("max_profit",           
                  std::bind(gen_random_vec<std::int32_t>, 30, 100, 500), 
-                 std::bind(alg::max_profit,     _1),     
+                 std::bind(alg::max_profit,     _1, 1),     
                  std::bind(alg::max_profit_bmk, _1),
                  num_trial); 
+
+    benchmark<1>("max_profit (multithread)",           
+                 std::bind(gen_random_vec<std::int32_t>, 500000, 100, 50000), 
+                 std::bind(alg::max_profit, _1, 4),     
+                 std::bind(alg::max_profit, _1, 1),
+                 20); 
     
     // *** Counting *** //
     benchmark<1>("count_target_profit", 
@@ -36,16 +36,82 @@ void test_two_point_sum()
                  std::bind(alg::count_target_2_point_sum,     _1, 50),     
                  std::bind(alg::count_target_2_point_sum_bmk, _1, 50),         
                  num_trial); 
+
+    benchmark<1>("count_target_2_point_sum (wide range)", 
+                 std::bind(gen_random_vec<std::int32_t>, 500, -100000, +100000), 
+                 std::bind(alg::count_target_2_point_sum,     _1, 50),     
+                 std::bind(alg::count_target_2_point_sum_bmk, _1, 50),         
+                 num_trial); 
     
     benchmark<1>("count_target_3_point_sum", 
                  std::bind(gen_random_vec<std::int32_t>, 50, -40, +40),  
-                 std::bind(alg::count_target_3_point_sum,     _1, 75),     
+                 std::bind(alg::count_target_3_point_sum,     _1, 75, 1),     
+                 std::bind(alg::count_target_3_point_sum_bmk, _1, 75),         
+                 num_trial); 
+
+    benchmark<1>("count_target_3_point_sum (sorted)", 
+                 std::bind(gen_random_vec<std::int32_t>, 50, -40, +40),  
+                 std::bind(alg::count_target_3_point_sum_sorted, _1, 75, 1),     
+                 std::bind(alg::count_target_3_point_sum_bmk,    _1, 75),         
+                 num_trial); 
+
+    benchmark<1>("count_target_3_point_sum (wide range)", 
+                 std::bind(gen_random_vec<std::int32_t>, 50, -100000000, +100000000),  
+                 std::bind(alg::count_target_3_point_sum,     _1, 75, 1),     
                  std::bind(alg::count_target_3_point_sum_bmk, _1, 75),         
                  num_trial); 
 
+    benchmark<1>("count_target_3_point_sum (hashmap)", 
+                 std::bind(gen_random_vec<std::int32_t>, 50, -40, +40),  
+                 std::bind(alg::count_target_3_point_sum_hashmap, _1, 75),     
+                 std::bind(alg::count_target_3_point_sum_bmk,     _1, 75),         
+                 num_trial); 
+
     benchmark<1>("count_target_4_point_sum", 
                  std::bind(gen_random_vec<std::int32_t>, 50, -40, +40),  
-                 std::bind(alg::count_target_4_point_sum,     _1, 100),      
+                 std::bind(alg::count_target_4_point_sum,     _1, 100, 1),      
+                 std::bind(alg::count_target_4_point_sum_bmk, _1, 100),          
+                 num_trial); 
+
+    benchmark<1>("count_target_4_point_sum (hashmap)", 
+                 std::bind(gen_random_vec<std::int32_t>, 50, -40, +40),  
+                 std::bind(alg::count_target_4_point_sum_hashmap, _1, 100),      
+                 std::bind(alg::count_target_4_point_sum_bmk,     _1, 100),          
+                 num_trial); 
+
+    benchmark<1>("count_target_4_point_sum (wide range)", 
+                 std::bind(gen_random_vec<std::int32_t>, 50, -100000000, +100000000),  
+                 std::bind(alg::count_target_4_point_sum,     _1, 100, 1),      
                  std::bind(alg::count_target_4_point_sum_bmk, _1, 100),          
                  num_trial); 
+
+    benchmark<1>("count_target_3_point_sum (large, multithread)", 
+                 std::bind(gen_random_vec<std::int32_t>, 2000, -1000, +1000),  
+                 std::bind(alg::count_target_3_point_sum,         _1, 75, 4),     
+                 std::bind(alg::count_target_3_point_sum_hashmap, _1, 75),         
+                 num_trial/100); 
+
+    benchmark<1>("count_target_3_point_sum (large, sorted, multithread)", 
+                 std::bind(gen_random_vec<std::int32_t>, 2000, -1000, +1000),  
+                 std::bind(alg::count_target_3_point_sum_sorted,  _1, 75, 4),     
+                 std::bind(alg::count_target_3_point_sum_hashmap, _1, 75),         
+                 num_trial/100); 
+
+    benchmark<1>("count_target_4_point_sum (large, multithread)", 
+                 std::bind(gen_random_vec<std::int32_t>, 400, -1000, +1000),  
+                 std::bind(alg::count_target_4_point_sum,         _1, 100, 4),      
+                 std::bind(alg::count_target_4_point_sum_hashmap, _1, 100),          
+                 num_trial/100); 
+
+    benchmark<1>("count_target_4_point_sum (large, wide range, multithread)", 
+                 std::bind(gen_random_vec<std::int32_t>, 600, -1000000, +1000000),  
+                 std::bind(alg::count_target_4_point_sum,         _1, 100, 3),      
+                 std::bind(alg::count_target_4_point_sum_hashmap, _1, 100),          
+                 num_trial/100); 
+
+    benchmark<1>("count_target_4_point_sum (20K, multithread)", 
+                 std::bind(gen_random_vec<std::int32_t>, 20000, -10000, +10000),  
+                 std::bind(alg::count_target_4_point_sum, _1, 100, 4),      
+                 std::bind(alg::count_target_4_point_sum, _1, 100, 1),          
+                 2); 
 }
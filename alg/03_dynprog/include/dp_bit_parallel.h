@@ -0,0 +1,250 @@
+#pragma once
+#include<cstdint>
+#include<limits>
+#include<string>
+#include<string_view>
+#include<vector>
+#include<thread>
+#include<algorithm>
+#include<bit>
+
+
+// ************************************************************************************ //
+// *** Bit parallel LCS and edit distance *** //
+// ************************************************************************************ //
+// Instead of filling matrix of size M x N, one column of the matrix (pattern of size M)
+// is encoded as bit vectors, and advanced by one text char with O(M/64) word operations,
+// hence cost O(N x M/64), memory O(M/64).
+//
+// Pattern is preprocessed once into peq[c] = bitmask of positions i where pattern[i]==c.
+// Bit i of each word-vector refers to row i of the DP matrix, row i+1 is the next bit.
+// A multi-word vector is little endian, the carry of addition and shift goes from word w
+// to word w+1.
+//
+// LCS (Allison-Dix, Hyyro) :
+// * V has bit i cleared iff LCS row i increments at current column, LCS = popcount(~V)
+// * U = V & peq[c],  V = (V + U) | (V - U), where V - U = V & ~U as U is subset of V
+//
+// Edit distance (Myers 1999) :
+// * vertical deltas D[i][j] - D[i-1][j] in {+1,0,-1} are encoded as Pv / Mv bitmasks
+// * horizontal deltas of the last row accumulate into the score
+// * each 64-row block passes its horizontal delta of the last row to the next block
+// * with max_k, stop once score - (remaining text size) > max_k, as each column moves
+//   the score by at most 1, then return max_k+1
+// ************************************************************************************ //
+namespace alg
+{
+    class bit_pattern
+    {
+    public:
+        explicit bit_pattern(std::string_view pattern)
+            : m_size(pattern.size()),
+              m_num_words((pattern.size() + 63) / 64),
+              m_peq(256 * m_num_words, 0)
+        {
+            for(std::uint32_t i=0; i!=pattern.size(); ++i)
+            {
+                unsigned char c = pattern[i];
+                m_peq[c * m_num_words + i/64] |= 1ULL << (i%64);
+            }
+        }
+
+        const std::uint64_t* peq(unsigned char c) const noexcept
+        {
+            return &m_peq[c * m_num_words];
+        }
+
+        std::uint32_t size()      const noexcept { return m_size;      }
+        std::uint32_t num_words() const noexcept { return m_num_words; }
+
+        // Mask of the last row in the last word
+        std::uint64_t last_bit() const noexcept
+        {
+            return 1ULL << ((m_size + 63) % 64);
+        }
+
+    private:
+        std::uint32_t m_size;
+        std::uint32_t m_num_words;
+        std::vector<std::uint64_t> m_peq;
+    };
+}
+
+
+// ************************ //
+// *** LCS bit parallel *** //
+// ************************ //
+namespace alg
+{
+    inline std::uint32_t longest_common_subseq_bit_parallel(const bit_pattern& pattern, std::string_view text)
+    {
+        std::uint32_t W = pattern.num_words();
+        if (W == 0) return 0;
+
+        if (W == 1)
+        {
+            std::uint64_t V = ~0ULL;
+            for(unsigned char c : text)
+            {
+                std::uint64_t U = V & pattern.peq(c)[0];
+                V = (V + U) | (V - U);
+            }
+            std::uint64_t mask = pattern.size()==64? ~0ULL : (1ULL << pattern.size()) - 1;
+            return std::popcount(~V & mask);
+        }
+
+        std::vector<std::uint64_t> V(W, ~0ULL);
+        for(unsigned char c : text)
+        {
+            const std::uint64_t* peq = pattern.peq(c);
+            bool carry = false;
+            for(std::uint32_t w=0; w!=W; ++w)
+            {
+                std::uint64_t U = V[w] & peq[w];
+                std::uint64_t sum;
+                bool carry0 = __builtin_add_overflow(V[w], U,     &sum);
+                bool carry1 = __builtin_add_overflow(sum,  carry, &sum);
+                V[w]  = sum | (V[w] & ~U);
+                carry = carry0 || carry1;
+            }
+        }
+
+        std::uint32_t ans = 0;
+        for(std::uint32_t w=0; w!=W-1; ++w) ans += std::popcount(~V[w]);
+        std::uint64_t mask = (pattern.last_bit() << 1) - 1; // all ones if last_bit is bit 63
+        return ans + std::popcount(~V[W-1] & mask);
+    }
+
+    inline std::uint32_t longest_common_subseq_bit_parallel(std::string_view str0, std::string_view str1)
+    {
+        if (str0.size() < str1.size()) std::swap(str0, str1); // shorter one as pattern
+        return longest_common_subseq_bit_parallel(bit_pattern(str1), str0);
+    }
+}
+
+
+// ********************************** //
+// *** Edit distance bit parallel *** //
+// ********************************** //
+namespace alg
+{
+    // Advance one block of 64 rows by one text char, hin / hout = horizontal delta of the
+    // row above / the last row of this block, in {+1,0,-1}. The carry of addition is
+    // replaced by hin, as in Myers 1999 section 4.
+    inline std::int32_t myers_advance_block(std::uint64_t& Pv, std::uint64_t& Mv, std::uint64_t Eq,
+                                            std::int32_t hin, std::uint64_t out_mask) noexcept
+    {
+        std::uint64_t hin_neg = hin < 0;
+        std::uint64_t hin_pos = hin > 0;
+        std::uint64_t Xv = Eq | Mv;
+        Eq |= hin_neg;
+        std::uint64_t Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+        std::uint64_t Ph = Mv | ~(Xh | Pv);
+        std::uint64_t Mh = Pv & Xh;
+
+        std::int32_t hout = (Ph & out_mask) ? 1 : ((Mh & out_mask) ? -1 : 0);
+        Ph = (Ph << 1) | hin_pos;
+        Mh = (Mh << 1) | hin_neg;
+        Pv = Mh | ~(Xv | Ph);
+        Mv = Ph & Xv;
+        return hout;
+    }
+
+    inline std::uint32_t edit_distance_bit_parallel(const bit_pattern& pattern, std::string_view text,
+                                                    std::uint32_t max_k = std::numeric_limits<std::uint32_t>::max())
+    {
+        std::uint32_t M = pattern.size();
+        std::uint32_t N = text.size();
+        std::uint32_t exceed = max_k == std::numeric_limits<std::uint32_t>::max()? max_k : max_k+1;
+        if (std::max(M,N) - std::min(M,N) > max_k) return exceed;
+        if (M == 0) return N;
+
+        // Global distance, top row D[0][j] = j, i.e. hin = +1 for the first block
+        std::uint32_t W = pattern.num_words();
+        std::int64_t score = M;
+        if (W == 1)
+        {
+            std::uint64_t Pv = ~0ULL;
+            std::uint64_t Mv = 0;
+            for(std::uint32_t j=0; j!=N; ++j)
+            {
+                score += myers_advance_block(Pv, Mv, pattern.peq(text[j])[0], +1, pattern.last_bit());
+                if (score - (std::int64_t)(N-1-j) > (std::int64_t)max_k) return exceed;
+            }
+            return score;
+        }
+
+        std::vector<std::uint64_t> Pv(W, ~0ULL);
+        std::vector<std::uint64_t> Mv(W, 0);
+        for(std::uint32_t j=0; j!=N; ++j)
+        {
+            const std::uint64_t* peq = pattern.peq(text[j]);
+            std::int32_t h = +1;
+            for(std::uint32_t w=0; w!=W-1; ++w)
+            {
+                h = myers_advance_block(Pv[w], Mv[w], peq[w], h, 1ULL << 63);
+            }
+            score += myers_advance_block(Pv[W-1], Mv[W-1], peq[W-1], h, pattern.last_bit());
+            if (score - (std::int64_t)(N-1-j) > (std::int64_t)max_k) return exceed;
+        }
+        return score;
+    }
+
+    inline std::uint32_t edit_distance_bit_parallel(std::string_view str0, std::string_view str1,
+                                                    std::uint32_t max_k = std::numeric_limits<std::uint32_t>::max())
+    {
+        if (str0.size() < str1.size()) std::swap(str0, str1); // shorter one as pattern
+        return edit_distance_bit_parallel(bit_pattern(str1), str0, max_k);
+    }
+}
+
+
+// ***************************************** //
+// *** Batch : one pattern vs many texts *** //
+// ***************************************** //
+// Pattern bitmasks are built once and shared by all threads, texts are split into
+// contiguous chunks. With max_k, distance above max_k is reported as max_k+1.
+//
+namespace alg
+{
+    template<typename F>
+    std::vector<std::uint32_t> bit_parallel_batch(const std::vector<std::string>& texts, std::uint32_t num_threads, const F& fct)
+    {
+        std::vector<std::uint32_t> ans(texts.size());
+        num_threads = std::max(1u, std::min<std::uint32_t>(num_threads, texts.size()));
+
+        auto run = [&](std::uint32_t t)
+        {
+            std::uint64_t begin = (std::uint64_t)texts.size() * t     / num_threads;
+            std::uint64_t end   = (std::uint64_t)texts.size() * (t+1) / num_threads;
+            for(std::uint64_t n=begin; n!=end; ++n) ans[n] = fct(texts[n]);
+        };
+
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(run, t);
+        run(0);
+        for(auto& x:threads) x.join();
+        return ans;
+    }
+
+    inline std::vector<std::uint32_t> edit_distance_batch(const bit_pattern& pattern,
+                                                          const std::vector<std::string>& texts,
+                                                          std::uint32_t max_k = std::numeric_limits<std::uint32_t>::max(),
+                                                          std::uint32_t num_threads = 1)
+    {
+        return bit_parallel_batch(texts, num_threads, [&](const std::string& text)
+        {
+            return edit_distance_bit_parallel(pattern, text, max_k);
+        });
+    }
+
+    inline std::vector<std::uint32_t> longest_common_subseq_batch(const bit_pattern& pattern,
+                                                                  const std::vector<std::string>& texts,
+                                                                  std::uint32_t num_threads = 1)
+    {
+        return bit_parallel_batch(texts, num_threads, [&](const std::string& text)
+        {
+            return longest_common_subseq_bit_parallel(pattern, text);
+        });
+    }
+}
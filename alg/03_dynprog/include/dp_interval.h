@@ -0,0 +1,269 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include<thread>
+#include<barrier>
+#include<algorithm>
+#include<bit>
+
+// from alg
+#include<utility.h>
+
+
+// ************************************************************************************ //
+// *** Interval DP engine on packed triangular matrix *** //
+// ************************************************************************************ //
+// Interval DP fills mat(i,j) for 0 <= i <= j < N, where mat(i,j) depends on sub-intervals
+// only, like bool_parenthesis_iterative() and coin_game_iterative(). Scanning diagonal by
+// diagonal with alg::matrix touches one cacheline per cell, and half of N x N is unused.
+//
+// 1. triangular_matrix keeps upper triangle only, as tiles of B x B, tile (I,J) with I <= J
+//    are packed row by row, cells inside tile are row major, memory ~ N^2/2
+// 2. Tile (I,J) depends on tiles (I,J') with J' < J and (I',J) with I' > I, i.e. tiles of
+//    lower tile-diagonal J-I, hence tiles on the same tile-diagonal are independent and
+//    processed in parallel, with one barrier per tile-diagonal
+// 3. Inside tile, rows are scanned from bottom to top, cols from left to right
+//
+// Two engines :
+// 1. interval_dp       - generic, cell(i,j) returns mat(i,j), reading sub-intervals
+// 2. interval_split_dp - split recurrence, mat(i,i) = leaf(i), and
+//                        mat(i,j) = identity, then split(mat(i,j), i, k, j, mat(i,k), mat(k+1,j))
+//                        for all k in [i,j), splits are accumulated in any order,
+//                        hence split must be commutative and associative, like +, min, max
+//
+// For tile (I,J) of interval_split_dp, split k with row k+1 in tile K, where I < K < J, reads
+// finished tiles only, it is done as a tile product, one row of (K,J) is streamed per k,
+// the inner loop runs along contiguous j. Remaining splits with k+1 in tile I or tile J
+// read the tile itself, they are done cell by cell in scan order.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename T>
+    class triangular_matrix
+    {
+    public:
+        // Tile size is rounded up to power of 2
+        explicit triangular_matrix(std::uint32_t size, std::uint32_t tile_size = 64, T init = T{})
+            : m_size(size),
+              m_shift(std::countr_zero(std::bit_ceil(std::max(tile_size, 1u)))),
+              m_tile(1u << m_shift),
+              m_num_tiles((size + m_tile - 1) >> m_shift),
+              m_impl((std::uint64_t)m_num_tiles * (m_num_tiles+1) / 2 * m_tile * m_tile, init)
+        {
+        }
+
+        const T& operator()(std::uint32_t i, std::uint32_t j) const noexcept
+        {
+            return m_impl[offset(i,j)];
+        }
+
+        T& operator()(std::uint32_t i, std::uint32_t j) noexcept
+        {
+            return m_impl[offset(i,j)];
+        }
+
+        // Row i of tile (i/B, J), contiguous from col J*B to col J*B+B-1
+        const T* row(std::uint32_t i, std::uint32_t J) const noexcept
+        {
+            return &m_impl[tile_offset(i >> m_shift, J) + (std::uint64_t)(i & (m_tile-1)) * m_tile];
+        }
+
+        T* row(std::uint32_t i, std::uint32_t J) noexcept
+        {
+            return &m_impl[tile_offset(i >> m_shift, J) + (std::uint64_t)(i & (m_tile-1)) * m_tile];
+        }
+
+        std::uint32_t size()      const noexcept { return m_size;      }
+        std::uint32_t tile_size() const noexcept { return m_tile;      }
+        std::uint32_t num_tiles() const noexcept { return m_num_tiles; }
+
+    private:
+        std::uint64_t tile_offset(std::uint64_t I, std::uint64_t J) const noexcept
+        {
+            std::uint64_t index = I * m_num_tiles - I * (I-1) / 2 + (J-I); // tiles of rows before I, then J-I
+            return index * m_tile * m_tile;
+        }
+
+        std::uint64_t offset(std::uint32_t i, std::uint32_t j) const noexcept
+        {
+            return tile_offset(i >> m_shift, j >> m_shift) + (std::uint64_t)(i & (m_tile-1)) * m_tile + (j & (m_tile-1));
+        }
+
+    private:
+        std::uint32_t m_size;
+        std::uint32_t m_shift;
+        std::uint32_t m_tile;
+        std::uint32_t m_num_tiles;
+        std::vector<T> m_impl;
+    };
+}
+
+
+namespace alg
+{
+    namespace interval_detail
+    {
+        // Invoke fct(I,J) for all tiles, tile-diagonal by tile-diagonal
+        template<typename F>
+        void for_each_tile(std::uint32_t num_tiles, std::uint32_t num_threads, const F& fct)
+        {
+            num_threads = std::max(1u, std::min(num_threads, num_tiles));
+            if (num_threads == 1)
+            {
+                for(std::uint32_t D=0; D!=num_tiles; ++D)
+                {
+                    for(std::uint32_t I=0; I+D!=num_tiles; ++I) fct(I, I+D);
+                }
+                return;
+            }
+
+            std::barrier sync(num_threads);
+            auto run = [&](std::uint32_t t)
+            {
+                for(std::uint32_t D=0; D!=num_tiles; ++D)
+                {
+                    for(std::uint32_t I=t; I+D<num_tiles; I+=num_threads) fct(I, I+D);
+                    sync.arrive_and_wait();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(run, t);
+            run(0);
+            for(auto& x:threads) x.join();
+        }
+    }
+
+    template<typename T, typename F>
+    void interval_dp(triangular_matrix<T>& mat, const F& cell, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t N = mat.size();
+        std::uint32_t B = mat.tile_size();
+        interval_detail::for_each_tile(mat.num_tiles(), num_threads, [&](std::uint32_t I, std::uint32_t J)
+        {
+            std::uint32_t i_end = std::min(N, (I+1)*B);
+            std::uint32_t j_end = std::min(N, (J+1)*B);
+            for(std::uint32_t i=i_end; i--!=I*B; )
+            {
+                for(std::uint32_t j=std::max(i, J*B); j<j_end; ++j) mat(i,j) = cell(i,j);
+            }
+        });
+    }
+
+    template<typename T, typename LEAF, typename SPLIT>
+    void interval_split_dp(triangular_matrix<T>& mat, const LEAF& leaf, const T& identity,
+                           const SPLIT& split, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t N = mat.size();
+        std::uint32_t B = mat.tile_size();
+        interval_detail::for_each_tile(mat.num_tiles(), num_threads, [&](std::uint32_t I, std::uint32_t J)
+        {
+            std::uint32_t i_begin = I*B;
+            std::uint32_t j_begin = J*B;
+            std::uint32_t i_end = std::min(N, i_begin+B);
+            std::uint32_t j_end = std::min(N, j_begin+B);
+            std::uint32_t width = j_end - j_begin;
+
+            // Stage 1 : splits with k+1 in tile K, I < K < J, accumulated in place
+            for(std::uint32_t i=i_begin; i!=i_end && I!=J; ++i)
+            {
+                T* acc = mat.row(i,J);
+                std::fill(acc, acc+width, identity);
+                for(std::uint32_t r=i_end; r!=j_begin; ++r) // r = k+1
+                {
+                    const T& left = mat(i,r-1);
+                    const T* right = mat.row(r,J);
+                    for(std::uint32_t x=0; x!=width; ++x) split(acc[x], i, r-1, j_begin+x, left, right[x]);
+                }
+            }
+
+            // Stage 2 : splits with k+1 in tile I or tile J, in scan order
+            for(std::uint32_t i=i_end; i--!=i_begin; )
+            {
+                for(std::uint32_t j=std::max(i, j_begin); j<j_end; ++j)
+                {
+                    if (i == j)
+                    {
+                        mat(i,i) = leaf(i);
+                        continue;
+                    }
+
+                    T acc = I==J? identity : mat(i,j);
+                    for(std::uint32_t r=i+1; r<=std::min(j, i_end-1); ++r) split(acc, i, r-1, j, mat(i,r-1), mat(r,j));
+                    if (I != J)
+                    {
+                        for(std::uint32_t r=j_begin; r<=j; ++r) split(acc, i, r-1, j, mat(i,r-1), mat(r,j));
+                    }
+                    mat(i,j) = acc;
+                }
+            }
+        });
+    }
+}
+
+
+// ************************************************ //
+// *** Bool parenthesis and coin game on engine *** //
+// ************************************************ //
+namespace alg
+{
+    struct bool_parenthesis_count
+    {
+        std::uint32_t m_true;
+        std::uint32_t m_false;
+    };
+
+    inline std::uint32_t bool_parenthesis_interval(const std::vector<bool_symbol>& input,
+                                                   std::uint32_t num_threads = 1,
+                                                   std::uint32_t tile_size = 64)
+    {
+        std::uint32_t N = input.size();
+        if (N == 0) return 0;
+
+        triangular_matrix<bool_parenthesis_count> mat(N, tile_size);
+        interval_split_dp(mat,
+            [&](std::uint32_t n)
+            {
+                return bool_parenthesis_count{input[n].m_value, !input[n].m_value};
+            },
+            bool_parenthesis_count{0,0},
+            [&](bool_parenthesis_count& acc, std::uint32_t, std::uint32_t k, std::uint32_t,
+                const bool_parenthesis_count& lhs, const bool_parenthesis_count& rhs)
+            {
+                std::uint32_t tt = lhs.m_true  * rhs.m_true;
+                std::uint32_t ff = lhs.m_false * rhs.m_false;
+                std::uint32_t tf = lhs.m_true  * rhs.m_false + lhs.m_false * rhs.m_true;
+                if (input[k].m_logic == logic::OR)
+                {
+                    acc.m_true  += tt + tf;
+                    acc.m_false += ff;
+                }
+                else
+                {
+                    acc.m_true  += tt;
+                    acc.m_false += ff + tf;
+                }
+            },
+            num_threads);
+        return mat(0,N-1).m_true;
+    }
+
+    inline std::uint32_t coin_game_interval(const std::vector<std::uint32_t>& coins,
+                                            std::uint32_t num_threads = 1,
+                                            std::uint32_t tile_size = 64)
+    {
+        std::uint32_t N = coins.size();
+        if (N == 0) return 0;
+
+        triangular_matrix<std::uint32_t> mat(N, tile_size);
+        interval_dp(mat, [&](std::uint32_t n, std::uint32_t m) -> std::uint32_t
+        {
+            if (n == m)   return coins[n];
+            if (n+1 == m) return std::max(coins[n], coins[m]);
+            return std::max(coins[n] + std::min(mat(n+2,m), mat(n+1,m-1)),
+                            coins[m] + std::min(mat(n+1,m-1), mat(n,m-2)));
+        },
+        num_threads);
+        return mat(0,N-1);
+    }
+}
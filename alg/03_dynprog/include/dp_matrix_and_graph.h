@@ -8,10 +8,20 @@
 #include<unordered_set>
 #include<unordered_map>
 #include<optional>
+#include<vector>
+#include<thread>
+#include<barrier>
+#include<algorithm>
+#include<immintrin.h>
+#include<bit>
+#include<concepts>
+#include<stdexcept>
 
 // from alg
 #include<matrix.h>
 #include<utility.h>
+#include<flat_hash_map.h>
+#include<dp_memo.h>
 
 
 // ***************************************** //
@@ -70,6 +80,358 @@ namespace alg
 }
 
 
+// ************************************************************************************ //
+// *** State store *** //
+// ************************************************************************************ //
+// Besides std::map and std::unordered_map, euler_update and find_target accept any store
+// with find(key) returning pointer (nullptr if absent), insert(key,value) and for_each :
+//
+// 1. dense_state_store - when state space is bounded, state is mapped to [0,size) by
+//                        a perfect encoding, so that lookup is one array access
+// 2. flat_state_store  - otherwise, alg::flat_hash_map with the hand-written state hash,
+//                        mixed by murmur finalizer, as its low 7 bits are used as H2
+//
+// Set of states (like equal partition) is a store with placeholder value.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename STORE>
+    concept state_store = requires(STORE& states, const typename STORE::key_type& key, const typename STORE::mapped_type& value)
+    {
+        { states.find(key)         } -> std::same_as<typename STORE::mapped_type*>;
+        { states.insert(key,value) } -> std::same_as<bool>;
+    };
+
+    // State with 2 fields, X in [0,num_x) and Y in [0,num_y), encoded as X * num_y + Y.
+    // Offset is added to X before encoding, e.g. offset 1 maps max (as empty) to 0.
+    template<typename K, auto X, auto Y>
+    class state_encoder
+    {
+    public:
+        state_encoder(std::uint32_t num_x, std::uint32_t num_y, std::uint32_t offset_x = 0)
+            : m_num_x(num_x), m_num_y(num_y), m_offset_x(offset_x)
+        {
+        }
+
+        std::uint64_t operator()(const K& key) const noexcept
+        {
+            std::uint32_t x = key.*X + m_offset_x;
+            std::uint32_t y = key.*Y;
+            if (x >= m_num_x || y >= m_num_y) return size(); // out of range
+            return (std::uint64_t)x * m_num_y + y;
+        }
+
+        K decode(std::uint64_t code) const noexcept
+        {
+            K key{};
+            key.*X = code / m_num_y - m_offset_x;
+            key.*Y = code % m_num_y;
+            return key;
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return (std::uint64_t)m_num_x * m_num_y;
+        }
+
+    private:
+        std::uint32_t m_num_x;
+        std::uint32_t m_num_y;
+        std::uint32_t m_offset_x;
+    };
+
+    template<typename K, typename V, typename ENCODER>
+    class dense_state_store
+    {
+    public:
+        using key_type    = K;
+        using mapped_type = V;
+
+        explicit dense_state_store(const ENCODER& encoder)
+            : m_encoder(encoder),
+              m_values(encoder.size()),
+              m_present(encoder.size(), 0)
+        {
+        }
+
+    public:
+        V* find(const K& key) noexcept
+        {
+            std::uint64_t code = m_encoder(key);
+            if (code >= m_values.size() || !m_present[code]) return nullptr;
+            return &m_values[code];
+        }
+
+        const V* find(const K& key) const noexcept
+        {
+            return const_cast<dense_state_store*>(this)->find(key);
+        }
+
+        // Key outside state space throws, as encoder maps it to size()
+        V& operator[](const K& key)
+        {
+            std::uint64_t code = encode(key);
+            if (!m_present[code])
+            {
+                m_present[code] = 1;
+                m_values[code]  = V{};
+                ++m_size;
+            }
+            return m_values[code];
+        }
+
+        bool insert(const K& key, const V& value)
+        {
+            std::uint64_t code = encode(key);
+            if (m_present[code]) return false;
+            m_present[code] = 1;
+            m_values[code]  = value;
+            ++m_size;
+            return true;
+        }
+
+        template<typename F>
+        void for_each(F&& fct) const
+        {
+            for(std::uint64_t code=0; code!=m_values.size(); ++code)
+            {
+                if (m_present[code]) fct(m_encoder.decode(code), m_values[code]);
+            }
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return m_size;
+        }
+
+    private:
+        std::uint64_t encode(const K& key) const
+        {
+            std::uint64_t code = m_encoder(key);
+            if (code >= m_values.size()) throw std::out_of_range("dense_state_store : key outside state space");
+            return code;
+        }
+
+    private:
+        ENCODER                   m_encoder;
+        std::vector<V>            m_values;
+        std::vector<std::uint8_t> m_present;
+        std::uint64_t             m_size = 0;
+    };
+
+    template<typename K, typename HASH>
+    struct mixed_state_hash
+    {
+        std::uint64_t operator()(const K& key) const noexcept
+        {
+            return flat_hash<std::uint64_t>{}(HASH{}(key));
+        }
+    };
+
+    template<typename K, typename V, typename HASH>
+    using flat_state_store = flat_hash_map<K, V, mixed_state_hash<K,HASH>>;
+
+    // Dense store costs 1 byte + sizeof(V) per point of state space, whether reached or not
+    inline bool prefer_dense_store(std::uint64_t state_space_size) noexcept
+    {
+        return state_space_size <= (1ULL << 24);
+    }
+}
+
+namespace alg
+{  
+    template<typename CMP, state_store STORE>
+    bool euler_update(STORE& states, const typename STORE::key_type& key, const typename STORE::mapped_type& value)
+    {
+        if (auto* x = states.find(key))
+        {
+            if (CMP{}(value, *x))
+            {
+                *x = value;
+                return true;
+            }
+            return false;
+        }
+        return states.insert(key, value);
+    }
+
+    template<state_store STORE>
+    bool euler_update(STORE& states, const typename STORE::key_type& key)
+    {
+        return states.insert(key, typename STORE::mapped_type{});
+    }
+
+    template<state_store STORE>
+    std::optional<typename STORE::mapped_type> find_target(const STORE& states, const typename STORE::key_type& key)
+    {
+        if (auto* x = states.find(key)) return *x;
+        else return std::nullopt;
+    }
+
+    // Pointer to value, nullptr if absent, for both std maps and state stores
+    template<typename MAP>
+    auto find_state(MAP& states, const typename MAP::key_type& key)
+    {
+        if constexpr (state_store<MAP>)
+        {
+            return states.find(key);
+        }
+        else
+        {
+            auto iter = states.find(key);
+            return iter != states.end()? &iter->second : nullptr;
+        }
+    }
+
+    template<typename MAP, typename F>
+    void for_each_state(const MAP& states, F&& fct)
+    {
+        if constexpr (state_store<MAP>)
+        {
+            states.for_each(fct);
+        }
+        else
+        {
+            for(const auto& x:states) fct(x.first, x.second);
+        }
+    }
+}
+
+
+// ************************************************************************************ //
+// *** Level synchronous search *** //
+// ************************************************************************************ //
+// Replace BFS queue by frontier vector, each iteration processes one level :
+// 1. expand - each thread takes a slice of the frontier, and calls expand(s, v, emit)
+//             for each state, emit(s_next, v_next) collects candidates into thread
+//             local vector, states are read only in this phase
+// 2. relax  - candidates are relaxed by euler_update, improved states form the next
+//             frontier (in order of thread, same as the queue for single thread)
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename CMP, typename MAP, typename EXPAND>
+    void level_synchronous_search(MAP& states, 
+                                  std::vector<typename MAP::key_type> frontier, 
+                                  const EXPAND& expand, 
+                                  std::uint32_t num_threads = 1)
+    {
+        using K = typename MAP::key_type;
+        using V = typename MAP::mapped_type;
+        std::vector<std::vector<std::pair<K,V>>> candidates(std::max(1u, num_threads));
+
+        while(!frontier.empty())
+        {
+            std::uint32_t size = frontier.size();
+            std::uint32_t T = std::max(1u, std::min(num_threads, size / 256)); // small level in single thread
+            auto run = [&](std::uint32_t t)
+            {
+                auto& out = candidates[t];
+                out.clear();
+                auto emit = [&out](const K& s, const V& v) { out.emplace_back(s,v); };
+
+                std::uint32_t begin = (std::uint64_t)size * t     / T;
+                std::uint32_t end   = (std::uint64_t)size * (t+1) / T;
+                for(std::uint32_t n=begin; n!=end; ++n)
+                {
+                    V v = *find_state(states, frontier[n]);
+                    expand(frontier[n], v, emit);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for(std::uint32_t t=1; t<T; ++t) threads.emplace_back(run, t);
+            run(0);
+            for(auto& x:threads) x.join();
+
+            frontier.clear();
+            for(std::uint32_t t=0; t!=T; ++t)
+            {
+                for(const auto& [s,v] : candidates[t])
+                {
+                    if (euler_update<CMP>(states, s, v)) frontier.push_back(s);
+                }
+            }
+        }
+    }
+}
+
+
+// ************************************************************************************ //
+// *** Rolling array *** //
+// ************************************************************************************ //
+// In matrix approach, row n of mat(n,m) depends on row n-1 at m and on row n at m-w,
+// where w is weight of object n (used unlimited times). Hence one array ans[m] updated
+// in place, for n = 0,1,2,... and ascending m, replaces the matrix :
+//
+//     ans[m] = fct(n, ans[m], ans[m-w])    for m >= w
+//
+// For large capacity, [0,capacity] is split into segments, one per thread. Thread t
+// updates its segment with object n at step n+t, after thread t-1 is done with object n,
+// with one barrier per step (pipeline). Cells m-w in segment t-1 are read from its halo,
+// i.e. copy of the last w_max cells of segment t-1, taken right after object n is done,
+// double buffered, as thread t-1 moves to object n+1 meanwhile.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename T, typename F>
+    void rolling_array_update(std::vector<T>& ans, const std::vector<std::uint32_t>& weights, std::uint32_t num_threads, const F& fct)
+    {
+        std::uint32_t size  = ans.size();
+        std::uint32_t w_max = 0;
+        for(const auto& w:weights) w_max = std::max(w_max, w);
+
+        // Segment must hold w_max cells, so that m-w never reaches segment t-2
+        std::uint32_t min_segment = std::max(w_max, 1u << 16);
+        num_threads = std::max(1u, std::min(num_threads, size / min_segment));
+
+        auto update = [&](std::uint32_t n, std::uint32_t begin, std::uint32_t end, const T* halo)
+        {
+            std::uint32_t w = weights[n];
+            if (w == 0) return;
+
+            std::uint32_t m = std::max(begin, w);
+            for(; m < end && m-w < begin; ++m) ans[m] = fct(n, ans[m], halo[m-w-(begin-w_max)]);
+            for(; m < end; ++m)                ans[m] = fct(n, ans[m], ans[m-w]);
+        };
+
+        // All weights 0 is no-op, and has no halo to address
+        if (num_threads == 1 || w_max == 0)
+        {
+            for(std::uint32_t n=0; n!=weights.size(); ++n) update(n, 0, size, nullptr);
+            return;
+        }
+
+        std::vector<std::uint32_t> bounds(num_threads+1);
+        for(std::uint32_t t=0; t<=num_threads; ++t) bounds[t] = (std::uint64_t)size * t / num_threads;
+
+        std::vector<T> halos(num_threads * 2 * w_max);
+        auto halo = [&](std::uint32_t t, std::uint32_t n) { return &halos[(t*2 + n%2) * w_max]; };
+
+        std::uint32_t num_steps = weights.size() + num_threads - 1;
+        std::barrier sync(num_threads);
+        auto run = [&](std::uint32_t t)
+        {
+            for(std::uint32_t step=0; step!=num_steps; ++step)
+            {
+                if (step >= t && step-t < weights.size())
+                {
+                    std::uint32_t n = step-t;
+                    update(n, bounds[t], bounds[t+1], t>0? halo(t-1,n) : nullptr);
+                    if (t+1 < num_threads) std::copy(&ans[bounds[t+1]-w_max], &ans[bounds[t+1]], halo(t,n));
+                }
+                sync.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(run, t);
+        run(0);
+        for(auto& x:threads) x.join();
+    }
+}
+
+
 // *********************** //
 // *** Min coin change *** //
 // *********************** //
@@ -117,6 +479,37 @@ namespace alg
         }
     } 
 
+    // Subproblem is prefix of coins with given length, key = (target, length)
+    template<typename CACHE>
+    std::uint32_t min_coin_change_memoized_in_matrix_impl(const std::vector<std::uint32_t>& coins, std::uint32_t length, 
+                                                          std::uint32_t target, CACHE& cache)
+    {
+        if (length == 1)
+        {
+            if (target % coins[0] == 0) return target / coins[0];
+            else return inf<std::uint32_t>;
+        }
+        return memoize(cache, memo_key(target, length), [&]() -> std::uint32_t
+        {
+            std::uint32_t last = coins[length-1];
+            if (last > target)
+            {
+                return min_coin_change_memoized_in_matrix_impl(coins, length-1, target, cache);
+            }
+            else
+            {
+                return std::min(add(min_coin_change_memoized_in_matrix_impl(coins, length,   target-last, cache), one<std::uint32_t>),
+                                    min_coin_change_memoized_in_matrix_impl(coins, length-1, target,      cache));
+            }
+        });
+    }
+
+    std::uint32_t min_coin_change_memoized_in_matrix(const std::vector<std::uint32_t>& coins, std::uint32_t target)
+    {
+        dense_memo<std::uint32_t> cache(target+1, coins.size()+1);
+        return min_coin_change_memoized_in_matrix_impl(coins, coins.size(), target, cache);
+    }
+
     std::uint32_t min_coin_change_iterative_in_graph(const std::vector<std::uint32_t>& coins, std::uint32_t target)
     {
         std::unordered_map<std::uint32_t, std::uint32_t> graph;   // graph for region growing
@@ -189,6 +582,17 @@ namespace alg
         }
         return mat(coins.size()-1, target); 
     }
+
+    std::uint32_t min_coin_change_iterative_in_array(const std::vector<std::uint32_t>& coins, std::uint32_t target, std::uint32_t num_threads = 1)
+    {
+        std::vector<std::uint32_t> ans(target+1, inf<std::uint32_t>);
+        ans[0] = 0;
+        rolling_array_update(ans, coins, num_threads, [](std::uint32_t, std::uint32_t curr, std::uint32_t prev)
+        {
+            return std::min(curr, prev + (prev != inf<std::uint32_t>)); // branchless add(prev, one)
+        });
+        return ans[target];
+    }
 }
 
 
@@ -227,6 +631,35 @@ namespace alg
         }
     } 
 
+    template<typename CACHE>
+    std::uint32_t count_coin_change_memoized_in_matrix_impl(const std::vector<std::uint32_t>& coins, std::uint32_t length, 
+                                                            std::uint32_t target, CACHE& cache)
+    {
+        if (length == 1)
+        {
+            return target % coins[0] == 0;
+        }
+        return memoize(cache, memo_key(target, length), [&]() -> std::uint32_t
+        {
+            std::uint32_t last = coins[length-1];
+            if (last > target)
+            {
+                return count_coin_change_memoized_in_matrix_impl(coins, length-1, target, cache);
+            }
+            else
+            {
+                return count_coin_change_memoized_in_matrix_impl(coins, length,   target-last, cache) + 
+                       count_coin_change_memoized_in_matrix_impl(coins, length-1, target,      cache);
+            }
+        });
+    }
+
+    std::uint32_t count_coin_change_memoized_in_matrix(const std::vector<std::uint32_t>& coins, std::uint32_t target)
+    {
+        dense_memo<std::uint32_t> cache(target+1, coins.size()+1);
+        return count_coin_change_memoized_in_matrix_impl(coins, coins.size(), target, cache);
+    }
+
     std::uint32_t count_coin_change_iterative_in_matrix(const std::vector<std::uint32_t>& coins, std::uint32_t target)
     {
         matrix<std::uint32_t> mat(coins.size(), target+1, 0); 
@@ -263,6 +696,17 @@ namespace alg
         }
         return mat(coins.size()-1, target);
     }
+
+    std::uint32_t count_coin_change_iterative_in_array(const std::vector<std::uint32_t>& coins, std::uint32_t target, std::uint32_t num_threads = 1)
+    {
+        std::vector<std::uint32_t> ans(target+1, 0);
+        ans[0] = 1;
+        rolling_array_update(ans, coins, num_threads, [](std::uint32_t, std::uint32_t curr, std::uint32_t prev)
+        {
+            return curr + prev;
+        });
+        return ans[target];
+    }
 }
 
 
@@ -358,6 +802,26 @@ namespace alg
         }
         return ans;
     }
+
+    // Remark 2 is not needed, as ans[m] is initialized to 0 for all m, it becomes max total
+    // value with total weight not greater than m, hence ans[weight_limit] is the answer.
+    std::uint32_t knapsack_iterative_in_array(const std::vector<std::pair<std::uint32_t, std::uint32_t>>& objects, std::uint32_t weight_limit, std::uint32_t num_threads = 1)
+    {
+        std::vector<std::uint32_t> weights;
+        std::vector<std::uint32_t> values;
+        for(const auto& x:objects)
+        {
+            weights.push_back(x.first);
+            values.push_back(x.second);
+        }
+
+        std::vector<std::uint32_t> ans(weight_limit+1, 0);
+        rolling_array_update(ans, weights, num_threads, [&values](std::uint32_t n, std::uint32_t curr, std::uint32_t prev)
+        {
+            return std::max(curr, prev + values[n]);
+        });
+        return ans[weight_limit];
+    }
 }
 
 
@@ -401,43 +865,51 @@ namespace alg
 
 namespace alg
 { 
-    std::uint32_t job_schedule_iterative_in_graph(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks)
+    template<typename STORE>
+    std::uint32_t job_schedule_iterative_in_store(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks, 
+                                                  STORE& graph, std::uint32_t num_threads = 1) // value = total profit
     {
-        std::unordered_map<job_state, std::uint32_t, job_state_hash> graph; // value = total profit
         graph[{0,0}] = 0;
-        
-        std::queue<job_state> queue;    
-        queue.push({0,0});
-  
-        while(!queue.empty())
-        {
-            auto s_prev = queue.front();
-            auto v_prev = graph[queue.front()];
-            queue.pop();
-
-            // for each neighbour (Remark 3. Ensure no duplicated task. Ensure task in sequence.)
-            for(std::uint32_t n=s_prev.m_next_allowed_job; n!=tasks.size(); ++n)
+        level_synchronous_search<std::greater<std::uint32_t>>(graph, {job_state{0,0}}, 
+            [&tasks](const job_state& s_prev, std::uint32_t v_prev, auto& emit)
             {
-                std::uint32_t s = s_prev.m_total_workload + std::get<0>(tasks[n]);
-                std::uint32_t v = v_prev                  + std::get<1>(tasks[n]);
-                std::uint32_t deadline =                    std::get<2>(tasks[n]);
-                
-                if (s <= deadline && euler_update<std::greater<std::uint32_t>>(graph, job_state{s,n+1}, v)) 
+                // for each neighbour (Remark 3. Ensure no duplicated task. Ensure task in sequence.)
+                for(std::uint32_t n=s_prev.m_next_allowed_job; n!=tasks.size(); ++n)
                 {
-                    queue.push({s,n+1});
+                    std::uint32_t s = s_prev.m_total_workload + std::get<0>(tasks[n]);
+                    std::uint32_t v = v_prev                  + std::get<1>(tasks[n]);
+                    std::uint32_t deadline =                    std::get<2>(tasks[n]);
+                    
+                    if (s <= deadline) emit(job_state{s,n+1}, v);
                 }
-            }
-        }
+            }, num_threads);
   
         // Remark 2. Optimal case may not use all weight_limit
         std::uint32_t ans = 0;
-        for(const auto& x:graph)
+        for_each_state(graph, [&ans](const job_state&, std::uint32_t v)
         {
-            if (ans < x.second)
-                ans = x.second;
-        }   
+            if (ans < v)
+                ans = v;
+        });
         return ans;
     } 
+
+    // State space is bounded by hard deadline (tasks are in ascending deadline) and number of tasks
+    std::uint32_t job_schedule_iterative_in_graph(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t hard_deadline = tasks.empty()? 0 : std::get<2>(tasks.back());
+        state_encoder<job_state, &job_state::m_total_workload, &job_state::m_next_allowed_job> encoder(hard_deadline+1, tasks.size()+1);
+        if (prefer_dense_store(encoder.size()))
+        {
+            dense_state_store<job_state, std::uint32_t, decltype(encoder)> graph(encoder);
+            return job_schedule_iterative_in_store(tasks, graph, num_threads);
+        }
+        else
+        {
+            flat_state_store<job_state, std::uint32_t, job_state_hash> graph;
+            return job_schedule_iterative_in_store(tasks, graph, num_threads);
+        }
+    } 
   
     std::uint32_t job_schedule_iterative_in_matrix(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks)
     {
@@ -529,40 +1001,48 @@ namespace alg
 
 namespace alg
 { 
-    std::uint32_t equal_partition_iterative_in_graph(const std::vector<std::uint32_t>& numbers)
+    // Set of states, i.e. store with placeholder value
+    template<typename STORE>
+    std::uint32_t equal_partition_iterative_in_store(const std::vector<std::uint32_t>& numbers, STORE& graph, std::uint32_t num_threads = 1)
     {
         std::uint32_t target = find_half_of_sum(numbers);
+        euler_update(graph, partition_state{0,0});
 
-        std::unordered_set<partition_state, partition_state_hash> graph;
-        graph.insert({0,0});
-
-        std::queue<partition_state> queue; 
-        queue.push({0,0});
-
-        while(!queue.empty())
-        {
-            auto s_prev = queue.front();
-            queue.pop();
-
-            // for each neighbour
-            for(std::uint32_t n=s_prev.m_next_allowed_num; n!=numbers.size(); ++n)
+        level_synchronous_search<std::less<typename STORE::mapped_type>>(graph, {partition_state{0,0}}, 
+            [&numbers, target](const partition_state& s_prev, const auto&, auto& emit)
             {
-                std::uint32_t s = s_prev.m_sum + numbers[n];
-                if (s <= target && euler_update(graph, partition_state{s,n+1})) 
+                // for each neighbour
+                for(std::uint32_t n=s_prev.m_next_allowed_num; n!=numbers.size(); ++n)
                 {
-                    queue.push({s,n+1});
+                    std::uint32_t s = s_prev.m_sum + numbers[n];
+                    if (s <= target) emit(partition_state{s,n+1}, {});
                 }
-            }
-        }
+            }, num_threads);
   
         std::uint32_t ans = 0;
-        for(const auto& x:graph)
+        for_each_state(graph, [&ans](const partition_state& s, const auto&)
         {
-            if (ans < x.m_sum)
-                ans = x.m_sum;
-        }   
+            if (ans < s.m_sum)
+                ans = s.m_sum;
+        });
         return ans;
     } 
+
+    std::uint32_t equal_partition_iterative_in_graph(const std::vector<std::uint32_t>& numbers, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t target = find_half_of_sum(numbers);
+        state_encoder<partition_state, &partition_state::m_sum, &partition_state::m_next_allowed_num> encoder(target+1, numbers.size()+1);
+        if (prefer_dense_store(encoder.size()))
+        {
+            dense_state_store<partition_state, std::uint8_t, decltype(encoder)> graph(encoder);
+            return equal_partition_iterative_in_store(numbers, graph, num_threads);
+        }
+        else
+        {
+            flat_state_store<partition_state, std::uint8_t, partition_state_hash> graph;
+            return equal_partition_iterative_in_store(numbers, graph, num_threads);
+        }
+    } 
     
     std::uint32_t equal_partition_iterative_in_matrix(const std::vector<std::uint32_t>& numbers)
     {
@@ -607,6 +1087,136 @@ namespace alg
 }
 
 
+
+// ************************************************************************************ //
+// *** Equal partition in bitset *** //
+// ************************************************************************************ //
+// Bit m of sums is set iff some subset of numbers adds up to m, so that each number x
+// updates all states at once, with 64 states per word :
+//
+//     sums |= sums << x
+//
+// Word k takes src[k-q] << r and src[k-q-1] >> (64-r), where x = 64q + r. Words are
+// updated in descending order, so that it works in place (single thread). For multi
+// thread, words are split among threads, src and dst are swapped per number, with one
+// barrier per number. Bits above limit are cleared at the end, as they only move up.
+// ************************************************************************************ //
+namespace alg
+{
+    void bitset_shift_or_scalar(const std::uint64_t* src, std::uint64_t* dst, std::uint32_t begin, std::uint32_t end, std::uint32_t shift)
+    {
+        std::uint32_t q = shift / 64;
+        std::uint32_t r = shift % 64;
+        for(std::uint32_t k=end; k-- > begin;)
+        {
+            std::uint64_t x = src[k];
+            if (k >= q)          x |= src[k-q] << r;
+            if (k >= q+1 && r>0) x |= src[k-q-1] >> (64-r);
+            dst[k] = x;
+        }
+    }
+
+    // Blocks of 4 words are loaded before stored, hence descending order works in place
+    __attribute__((target("avx2")))
+    void bitset_shift_or_avx2(const std::uint64_t* src, std::uint64_t* dst, std::uint32_t begin, std::uint32_t end, std::uint32_t shift)
+    {
+        std::uint32_t q  = shift / 64;
+        std::uint32_t r  = shift % 64;
+        std::uint32_t lo = std::max(begin, q+1); // words with both sources
+        if (lo >= end)
+        {
+            bitset_shift_or_scalar(src, dst, begin, end, shift);
+            return;
+        }
+
+        std::uint32_t hi = end - (end-lo) % 4;
+        bitset_shift_or_scalar(src, dst, hi, end, shift);
+
+        __m128i sl = _mm_cvtsi32_si128(r);
+        __m128i sr = _mm_cvtsi32_si128(64-r); // shift count 64 gives 0
+        for(std::uint32_t k=hi; k!=lo;)
+        {
+            k -= 4;
+            __m256i x = _mm256_loadu_si256((const __m256i*)(src+k));
+            __m256i a = _mm256_loadu_si256((const __m256i*)(src+k-q));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(src+k-q-1));
+            x = _mm256_or_si256(x, _mm256_or_si256(_mm256_sll_epi64(a, sl), _mm256_srl_epi64(b, sr)));
+            _mm256_storeu_si256((__m256i*)(dst+k), x);
+        }
+        bitset_shift_or_scalar(src, dst, begin, lo, shift);
+    }
+
+    void bitset_shift_or(const std::uint64_t* src, std::uint64_t* dst, std::uint32_t begin, std::uint32_t end, std::uint32_t shift)
+    {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        if (avx2) bitset_shift_or_avx2  (src, dst, begin, end, shift);
+        else      bitset_shift_or_scalar(src, dst, begin, end, shift);
+    }
+
+    // Bit m of the returned words is set iff some subset adds up to m, for m <= limit
+    std::vector<std::uint64_t> subset_sums_bitset(const std::vector<std::uint32_t>& numbers, std::uint32_t limit, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t num_words = limit/64 + 1;
+        std::vector<std::uint64_t> sums(num_words, 0);
+        sums[0] = 1;
+
+        num_threads = std::max(1u, std::min(num_threads, num_words / (1u << 14)));
+        if (num_threads == 1)
+        {
+            for(const auto& x:numbers)
+            {
+                if (x <= limit) bitset_shift_or(sums.data(), sums.data(), 0, num_words, x);
+            }
+        }
+        else
+        {
+            std::vector<std::uint64_t> buffer(num_words);
+            std::barrier sync(num_threads);
+            auto run = [&](std::uint32_t t)
+            {
+                std::uint32_t begin = (std::uint64_t)num_words * t     / num_threads;
+                std::uint32_t end   = (std::uint64_t)num_words * (t+1) / num_threads;
+                std::uint64_t* src  = sums.data();
+                std::uint64_t* dst  = buffer.data();
+                for(const auto& x:numbers)
+                {
+                    if (x > limit) continue;
+                    bitset_shift_or(src, dst, begin, end, x);
+                    std::swap(src, dst);
+                    sync.arrive_and_wait();
+                }
+                if (src != sums.data()) std::copy(src+begin, src+end, sums.data()+begin);
+            };
+
+            std::vector<std::thread> threads;
+            for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(run, t);
+            run(0);
+            for(auto& x:threads) x.join();
+        }
+
+        if (limit % 64 != 63) sums.back() &= (2ULL << (limit % 64)) - 1;
+        return sums;
+    }
+
+    bool subset_sum_bitset(const std::vector<std::uint32_t>& numbers, std::uint32_t target, std::uint32_t num_threads = 1)
+    {
+        auto sums = subset_sums_bitset(numbers, target, num_threads);
+        return (sums[target/64] >> (target%64)) & 1;
+    }
+
+    std::uint32_t equal_partition_bitset(const std::vector<std::uint32_t>& numbers, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t target = find_half_of_sum(numbers);
+        auto sums = subset_sums_bitset(numbers, target, num_threads);
+        for(std::uint32_t k=sums.size(); k-- > 0;)
+        {
+            if (sums[k] != 0) return k*64 + 63 - std::countl_zero(sums[k]);
+        }
+        return 0;
+    }
+}
+
+
 // ******************** //
 // *** Box stacking *** //
 // ******************** //
@@ -655,52 +1265,51 @@ namespace alg
 
 namespace alg
 { 
-    std::uint32_t box_stacking_iterative_in_graph(const std::vector<box>& boxes) 
+    template<typename STORE>
+    std::uint32_t box_stacking_iterative_in_store(const std::vector<box>& boxes, STORE& graph, std::uint32_t num_threads = 1) 
     {
-        std::unordered_map<boxes_state, std::uint32_t, boxes_state_hash> graph; 
         graph[{std::numeric_limits<std::uint32_t>::max(), 0}] = 0;
 
-        std::queue<boxes_state> queue; 
-        queue.push({std::numeric_limits<std::uint32_t>::max(), 0});
-  
-        while(!queue.empty())
-        {
-            auto s_prev = queue.front();
-            auto v_prev = graph[queue.front()];
-            queue.pop();
-
-            for(std::uint32_t n=s_prev.m_last_box+1; n!=boxes.size(); ++n)
+        level_synchronous_search<std::greater<std::uint32_t>>(graph, {boxes_state{std::numeric_limits<std::uint32_t>::max(), 0}}, 
+            [&boxes](const boxes_state& s_prev, std::uint32_t v_prev, auto& emit)
             {
-                std::uint32_t prev_base_min = 0;
-                std::uint32_t prev_base_max = 0;
-                if (s_prev.m_last_box != std::numeric_limits<std::uint32_t>::max())
+                for(std::uint32_t n=s_prev.m_last_box+1; n!=boxes.size(); ++n)
                 {
-                    std::tie(prev_base_min, prev_base_max) = get_base(boxes[s_prev.m_last_box], s_prev.m_last_box_ori);
-                }
-
-                for(std::uint32_t m=0; m!=3; ++m)
-                {
-                    auto [this_base_min, this_base_max] = get_base(boxes[n], m);
-                    if (this_base_min >= prev_base_min &&
-                        this_base_max >= prev_base_max)
+                    std::uint32_t prev_base_min = 0;
+                    std::uint32_t prev_base_max = 0;
+                    if (s_prev.m_last_box != std::numeric_limits<std::uint32_t>::max())
                     {
-                        auto s = boxes_state{n,m};
-                        auto v = v_prev + get_height(boxes[n], m);
+                        std::tie(prev_base_min, prev_base_max) = get_base(boxes[s_prev.m_last_box], s_prev.m_last_box_ori);
+                    }
 
-                        if (euler_update<std::greater<std::uint32_t>>(graph, s, v)) queue.push(s); 
+                    for(std::uint32_t m=0; m!=3; ++m)
+                    {
+                        auto [this_base_min, this_base_max] = get_base(boxes[n], m);
+                        if (this_base_min >= prev_base_min &&
+                            this_base_max >= prev_base_max)
+                        {
+                            emit(boxes_state{n,m}, v_prev + get_height(boxes[n], m));
+                        }
                     }
                 }
-            }
-        }
+            }, num_threads);
       
         std::uint32_t ans = 0;
-        for(const auto& x:graph)
+        for_each_state(graph, [&ans](const boxes_state&, std::uint32_t v)
         {
-            if (ans < x.second)
-                ans = x.second;
-        }   
+            if (ans < v)
+                ans = v;
+        });
         return ans;
     } 
+
+    // Empty stack (last box = max) is encoded as 0, by offset 1
+    std::uint32_t box_stacking_iterative_in_graph(const std::vector<box>& boxes, std::uint32_t num_threads = 1) 
+    {
+        state_encoder<boxes_state, &boxes_state::m_last_box, &boxes_state::m_last_box_ori> encoder(boxes.size()+1, 3, 1);
+        dense_state_store<boxes_state, std::uint32_t, decltype(encoder)> graph(encoder);
+        return box_stacking_iterative_in_store(boxes, graph, num_threads);
+    } 
    
     // ********************************************************************************** //
     // state matrix col 0 means using x as height, (y,z) as base
@@ -808,15 +1417,14 @@ namespace alg
     // m_size_bin < m_size_objA ... or 
     // m_size_bin < m_size_objB 
     // ******************************************** //
-    std::uint32_t bin_packing_iterative_in_graph(const bin_packing_problem& prob) 
+    template<typename STORE>
+    std::uint32_t bin_packing_iterative_in_store(const bin_packing_problem& prob, STORE& graph) 
     {
         // ********************************************************************************************** //
         // push " all states that can be accommodated by 1 bin" into graph
-        // push "only states that can be accommodated by 1 bin" AND "cannot fill extra object" into queue
+        // push "only states that can be accommodated by 1 bin" AND "cannot fill extra object" into frontier
         // ********************************************************************************************** //
-        std::unordered_map<bin_state, std::uint32_t, bin_state_hash> graph; // value = total num of bin used
-        std::queue<bin_state> queue;    
-
+        std::vector<bin_state> frontier;
 
         // ********************** //
         // *** Initialization *** //
@@ -838,57 +1446,65 @@ namespace alg
                 }
                 else break; // no need to try greater m 
             }
-            if (max_m) queue.push({n,*max_m});
+            if (max_m) frontier.push_back({n,*max_m});
         }
   
-
-        // ********************** //
-        // *** Region growing *** //
-        // ********************** //
-        while(!queue.empty())
+        // ******************************************************************** //
+        // *** Region growing, level by level                               *** //
+        // *** (single thread, as links are looked up while graph updates) *** //
+        // ******************************************************************** //
+        std::vector<bin_state> next_frontier;
+        while(!frontier.empty())
         {
-            auto s_prev = queue.front();
-            auto v_prev = graph[queue.front()];
-            queue.pop();
-
-            // for each neighbour (2D scan) 
-            for(std::uint32_t n=s_prev.m_num_objA_picked; n<=prob.m_num_objA; ++n)
+            next_frontier.clear();
+            for(const auto& s_prev:frontier)
             {
-                std::optional<std::uint32_t> max_m;
-                for(std::uint32_t m=s_prev.m_num_objB_picked; m<=prob.m_num_objB; ++m)
+                auto v_prev = *find_state(graph, s_prev);
+
+                // for each neighbour (2D scan) 
+                for(std::uint32_t n=s_prev.m_num_objA_picked; n<=prob.m_num_objA; ++n)
                 {
-                    if (n == s_prev.m_num_objA_picked &&
-                        m == s_prev.m_num_objB_picked) continue; // skip itself  
+                    std::optional<std::uint32_t> max_m;
+                    for(std::uint32_t m=s_prev.m_num_objB_picked; m<=prob.m_num_objB; ++m)
+                    {
+                        if (n == s_prev.m_num_objA_picked &&
+                            m == s_prev.m_num_objB_picked) continue; // skip itself  
 
-                    std::uint32_t dn = n - s_prev.m_num_objA_picked;
-                    std::uint32_t dm = m - s_prev.m_num_objB_picked;
+                        std::uint32_t dn = n - s_prev.m_num_objA_picked;
+                        std::uint32_t dm = m - s_prev.m_num_objB_picked;
 
-                    // ***************************************** //
-                    // *** Check link between s_prev & (n,m) *** //
-                    // ***************************************** //
-                    auto iter = graph.find({dn, dm});
-                    if (iter != graph.end())
-                    {
-                        euler_update<std::less<std::uint32_t>>(graph, bin_state{n,m}, v_prev + iter->second);
-                        max_update(max_m, m);
+                        // ***************************************** //
+                        // *** Check link between s_prev & (n,m) *** //
+                        // ***************************************** //
+                        if (auto link = find_state(graph, bin_state{dn, dm}))
+                        {
+                            euler_update<std::less<std::uint32_t>>(graph, bin_state{n,m}, v_prev + *link);
+                            max_update(max_m, m);
+                        }
                     }
+                    if (max_m) next_frontier.push_back({n,*max_m});
                 }
-                if (max_m) queue.push({n,*max_m});
             }
+            frontier.swap(next_frontier);
         }
  
-
         // ************** // 
         // *** Answer *** //
         // ************** // 
-        auto iter = graph.find(bin_state{prob.m_num_objA, prob.m_num_objB});
-        if (iter != graph.end())
+        if (auto ans = find_state(graph, bin_state{prob.m_num_objA, prob.m_num_objB}))
         {
-            return iter->second;
+            return *ans;
         }
         return inf<std::uint32_t>;
     }
 
+    std::uint32_t bin_packing_iterative_in_graph(const bin_packing_problem& prob) 
+    {
+        state_encoder<bin_state, &bin_state::m_num_objA_picked, &bin_state::m_num_objB_picked> encoder(prob.m_num_objA+1, prob.m_num_objB+1);
+        dense_state_store<bin_state, std::uint32_t, decltype(encoder)> graph(encoder);
+        return bin_packing_iterative_in_store(prob, graph);
+    }
+
     // ******************************************** //
     // This implementation ables to return inf when
     // m_size_bin < m_size_objA ... or 
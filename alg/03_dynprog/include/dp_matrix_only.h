@@ -9,6 +9,7 @@
 // from alg
 #include<matrix.h>
 #include<utility.h>
+#include<dp_memo.h>
 
 
 // ***************************** //
@@ -46,6 +47,32 @@ namespace alg
         }
     }
 
+    // Subproblem is suffix pair str0[i..] and str1[j..], no string is copied
+    template<typename CACHE>
+    std::uint32_t longest_common_subseq_memoized_impl(const std::string& str0, const std::string& str1, 
+                                                      std::uint32_t i, std::uint32_t j, CACHE& cache)
+    {
+        if (i==str0.size() || j==str1.size()) return 0;
+        return memoize(cache, memo_key(i,j), [&]() -> std::uint32_t
+        {
+            if (str0[i] == str1[j]) 
+            {
+                return longest_common_subseq_memoized_impl(str0, str1, i+1, j+1, cache) + 1;
+            }
+            else
+            {
+                return std::max(longest_common_subseq_memoized_impl(str0, str1, i+1, j, cache), 
+                                longest_common_subseq_memoized_impl(str0, str1, i, j+1, cache));
+            }
+        });
+    }
+
+    std::uint32_t longest_common_subseq_memoized(const std::string& str0, const std::string& str1)
+    {
+        dense_memo<std::uint32_t> cache(str0.size()+1, str1.size()+1);
+        return longest_common_subseq_memoized_impl(str0, str1, 0, 0, cache);
+    }
+
     std::uint32_t longest_common_subseq_iterative(const std::string& str0, const std::string& str1)
     {
         alg::matrix<std::uint32_t> mat(str1.size(), str0.size(), 0);
@@ -112,6 +139,33 @@ namespace alg
         }
     }
 
+    template<typename CACHE>
+    std::uint32_t edit_distance_memoized_impl(const std::string& str0, const std::string& str1, 
+                                              std::uint32_t i, std::uint32_t j, CACHE& cache)
+    {
+        if (i==str0.size()) return str1.size()-j; 
+        if (j==str1.size()) return str0.size()-i;
+        return memoize(cache, memo_key(i,j), [&]() -> std::uint32_t
+        {
+            if (str0[i] == str1[j]) 
+            {
+                return edit_distance_memoized_impl(str0, str1, i+1, j+1, cache);
+            }
+            else
+            {
+                return std::min(edit_distance_memoized_impl(str0, str1, i+1, j,   cache) + 1, // DEL
+                       std::min(edit_distance_memoized_impl(str0, str1, i,   j+1, cache) + 1, // ADD
+                                edit_distance_memoized_impl(str0, str1, i+1, j+1, cache) + 1));
+            }
+        });
+    }
+
+    std::uint32_t edit_distance_memoized(const std::string& str0, const std::string& str1)
+    {
+        dense_memo<std::uint32_t> cache(str0.size()+1, str1.size()+1);
+        return edit_distance_memoized_impl(str0, str1, 0, 0, cache);
+    }
+
     std::uint32_t edit_distance_iterative(const std::string& str0, const std::string& str1)
     {
         alg::matrix<std::uint32_t> mat(str1.size(), str0.size(), alg::inf<std::uint32_t>);
@@ -336,6 +390,29 @@ namespace alg
         );
     }
 
+    // Subproblem is coins[offset, offset+length), key = (offset, length)
+    template<typename CACHE>
+    std::uint32_t coin_game_memoized_impl(const std::vector<std::uint32_t>& coins, 
+                                          std::uint32_t offset, std::uint32_t length, CACHE& cache) 
+    {
+        if (length == 0) return 0;
+        if (length == 1) return coins[offset];
+        return memoize(cache, memo_key(offset, length), [&]() -> std::uint32_t
+        {
+            std::uint32_t v20 = coin_game_memoized_impl(coins, offset+2, length-2, cache);
+            std::uint32_t v11 = coin_game_memoized_impl(coins, offset+1, length-2, cache);
+            std::uint32_t v02 = coin_game_memoized_impl(coins, offset,   length-2, cache);
+            return std::max(coins[offset]          + std::min(v20, v11),
+                            coins[offset+length-1] + std::min(v11, v02));
+        });
+    }
+
+    std::uint32_t coin_game_memoized(const std::vector<std::uint32_t>& coins) 
+    {
+        dense_memo<std::uint32_t> cache(coins.size()+1, coins.size()+1);
+        return coin_game_memoized_impl(coins, 0, coins.size(), cache);
+    }
+
     std::uint32_t coin_game_iterative(const std::vector<std::uint32_t>& coins) 
     {
         std::uint32_t N = coins.size();
@@ -436,3 +513,256 @@ namespace alg
     }
 }
 
+
+
+// ********************************************************* //
+// *** Piecewise linear regression with O(1) segment cost *** //
+// ********************************************************* //
+// Error of one segment is computed in O(1) from prefix sums of y, y^2 and x*y (x = index),
+// hence O(M x N^2) for exhaustive DP, instead of O(M x N^3) in piecewise_linear_equation.
+//
+// Two kinds of segment :
+// 1. segment_fit::interpolation - line through the first and the last point of segment,
+//                                 adjacent segments share one point, segment = [k,n],
+//                                 same error as piecewise_linear_equation
+// 2. segment_fit::least_squares - least squares line of segment, adjacent segments are
+//                                 disjoint, segment = [k,n)
+//
+// Both are expressed on positions p = 0, 1, ..., P (P = N-1 or N), line m covers position
+// breakpoints[m] to breakpoints[m+1], with breakpoints[0] = 0 and breakpoints[M] = P.
+//
+// dp(m,n) = min error of the first n positions with m+1 lines
+//         = min_k dp(m-1,k) + cost(k,n)     where m <= k < n
+//
+// Two methods :
+// 1. piecewise_method::exhaustive         - all k, O(M x N^2), exact
+// 2. piecewise_method::divide_and_conquer - opt(m,n) = argmin k is assumed non-decreasing
+//                                           in n, middle n is solved first, then the left
+//                                           half searches k <= opt only, O(M x N log N).
+//                                           It is exact if cost satisfies the quadrangle
+//                                           inequality, which is not guaranteed for linear
+//                                           fit, hence it may be above optimum, search of
+//                                           k is widened by slack on both sides to recover
+//                                           most of it, O(M x N x (log N + slack)). Knuth
+//                                           optimisation has the same condition, not used.
+//
+namespace alg
+{
+    enum class segment_fit : std::uint8_t
+    {
+        interpolation,
+        least_squares
+    };
+
+    enum class piecewise_method : std::uint8_t
+    {
+        exhaustive,
+        divide_and_conquer
+    };
+
+    struct piecewise_linear_result
+    {
+        double error;
+        std::vector<std::uint32_t> breakpoints; // size = num_lines + 1
+    };
+
+    // Error is invariant to offset of y, prefix sums are of y - mean, otherwise an offset like
+    // price level makes Syy and Sy^2/c nearly equal, and their difference is lost in rounding
+    class segment_cost
+    {
+    public:
+        segment_cost(const std::vector<double>& ys, segment_fit fit) 
+            : m_fit(fit), m_ys(ys), m_mean(0), m_sum_y(ys.size()+1, 0), m_sum_yy(ys.size()+1, 0), m_sum_xy(ys.size()+1, 0)
+        {
+            for(const auto& y:ys) m_mean += y;
+            m_mean /= std::max<std::size_t>(ys.size(), 1);
+
+            for(std::uint32_t n=0; n!=ys.size(); ++n)
+            {
+                double y = ys[n] - m_mean;
+                m_sum_y [n+1] = m_sum_y [n] + y;
+                m_sum_yy[n+1] = m_sum_yy[n] + y * y;
+                m_sum_xy[n+1] = m_sum_xy[n] + y * n;
+            }
+        }
+
+        // Last position
+        std::uint32_t last() const noexcept
+        {
+            return m_fit == segment_fit::interpolation? m_ys.size()-1 : m_ys.size();
+        }
+
+        // Error of line from position k to position n, where k < n, may be slightly negative
+        // by rounding for an exact line, which does no harm to the DP
+        double operator()(std::uint32_t k, std::uint32_t n) const noexcept
+        {
+            return m_fit == segment_fit::interpolation? interpolation(k,n) : least_squares(k,n);
+        }
+
+    private:
+        // Points [k,n], with u = x-k, L = n-k, s = slope, error = sum of ((y-y_k) - s*u)^2 
+        double interpolation(std::uint32_t k, std::uint32_t n) const noexcept
+        {
+            double L   = n-k;
+            double yk  = m_ys[k] - m_mean;
+            double s   = (m_ys[n] - m_ys[k]) / L;
+            double Sy  = m_sum_y [n+1] - m_sum_y [k];
+            double Syy = m_sum_yy[n+1] - m_sum_yy[k];
+            double Sxy = m_sum_xy[n+1] - m_sum_xy[k];
+
+            double A = Syy - 2 * yk * Sy + (L+1) * yk * yk;        // sum of (y-y_k)^2
+            double B = Sxy - k * Sy - yk * L * (L+1) / 2;          // sum of (y-y_k)*u
+            double C = L * (L+1) * (2*L+1) / 6;                    // sum of u^2
+            return A - 2 * s * B + s * s * C;
+        }
+
+        // Points [k,n), error = Syy - Sxy^2 / Sxx, in central moments
+        double least_squares(std::uint32_t k, std::uint32_t n) const noexcept
+        {
+            double c = n-k;
+            if (c <= 2) return 0;
+
+            double mean_x = (k + n - 1) / 2.0;
+            double Sy  = m_sum_y [n] - m_sum_y [k];
+            double Sxx = c * (c*c - 1) / 12;
+            double Sxy = (m_sum_xy[n] - m_sum_xy[k]) - mean_x * Sy;
+            double Syy = (m_sum_yy[n] - m_sum_yy[k]) - Sy * Sy / c;
+            return Syy - Sxy * Sxy / Sxx;
+        }
+
+    private:
+        segment_fit m_fit;
+        const std::vector<double>& m_ys;
+        double m_mean;
+        std::vector<double> m_sum_y;
+        std::vector<double> m_sum_yy;
+        std::vector<double> m_sum_xy;
+    };
+
+    // Fill dp(m,n) for n in [n0,n1), with k searched in [k0-slack, k1+slack] only
+    void piecewise_divide_and_conquer(const segment_cost& cost, 
+                                      const std::vector<double>& prev, 
+                                            std::vector<double>& curr, 
+                                      alg::matrix<std::uint32_t>& opt, std::uint32_t m,
+                                      std::uint32_t n0, std::uint32_t n1, 
+                                      std::uint32_t k0, std::uint32_t k1, std::uint32_t slack)
+    {
+        if (n0 >= n1) return;
+
+        std::uint32_t n = n0 + (n1-n0) / 2;
+        std::uint32_t k_begin = std::max(k0 < slack? 0 : k0-slack, m);
+        std::uint32_t k_last  = std::min(k1 + std::min(slack, n), n-1);
+        std::uint32_t best_k  = k_begin;
+        double best = std::numeric_limits<double>::max();
+        for(std::uint32_t k=k_begin; k<=k_last; ++k)
+        {
+            double err = prev[k] + cost(k,n);
+            if (err < best) 
+            {
+                best   = err;
+                best_k = k;
+            }
+        }
+        curr[n]   = best;
+        opt(m,n)  = best_k;
+        piecewise_divide_and_conquer(cost, prev, curr, opt, m, n0,  n,  k0, best_k, slack);
+        piecewise_divide_and_conquer(cost, prev, curr, opt, m, n+1, n1, best_k, k1, slack);
+    }
+
+    piecewise_linear_result piecewise_linear_regression(const std::vector<double>& ys, 
+                                                        std::uint32_t num_lines,
+                                                        segment_fit fit = segment_fit::interpolation,
+                                                        piecewise_method method = piecewise_method::exhaustive,
+                                                        std::uint32_t slack = 0)
+    {
+        if (ys.size() < 2 || num_lines == 0) return piecewise_linear_result{0, {}};
+
+        segment_cost cost(ys, fit);
+        std::uint32_t P = cost.last();
+        std::uint32_t M = std::min(num_lines, P); // more lines than positions give zero error
+
+        // Two rows of dp, opt(m,n) for backtracking
+        std::vector<double> prev(P+1, 0);
+        std::vector<double> curr(P+1, 0);
+        alg::matrix<std::uint32_t> opt(M, P+1, 0);
+
+        for(std::uint32_t n=1; n<=P; ++n)
+        {
+            prev[n] = cost(0,n);
+        }
+
+        for(std::uint32_t m=1; m!=M; ++m)
+        {
+            if (method == piecewise_method::divide_and_conquer)
+            {
+                piecewise_divide_and_conquer(cost, prev, curr, opt, m, m+1, P+1, m, P-1, slack);
+            }
+            else
+            {
+                for(std::uint32_t n=m+1; n<=P; ++n) 
+                {
+                    curr[n] = std::numeric_limits<double>::max();
+                    for(std::uint32_t k=m; k!=n; ++k)
+                    {
+                        double err = prev[k] + cost(k,n);
+                        if (err < curr[n]) 
+                        {
+                            curr[n]  = err;
+                            opt(m,n) = k;
+                        }
+                    }
+                }
+            }
+            std::swap(prev, curr);
+        }
+
+        piecewise_linear_result ans{prev[P], std::vector<std::uint32_t>(M+1)};
+        ans.breakpoints[M] = P;
+        for(std::uint32_t m=M-1; m!=0; --m)
+        {
+            ans.breakpoints[m] = opt(m, ans.breakpoints[m+1]);
+        }
+        ans.breakpoints[0] = 0;
+        return ans;
+    }
+
+    // Error of given breakpoints, by direct summation, for verification
+    double piecewise_linear_error(const std::vector<double>& ys, 
+                                  const std::vector<std::uint32_t>& breakpoints,
+                                  segment_fit fit = segment_fit::interpolation)
+    {
+        double ans = 0;
+        for(std::uint32_t m=0; m+1<breakpoints.size(); ++m)
+        {
+            std::uint32_t k = breakpoints[m];
+            std::uint32_t n = breakpoints[m+1];
+            if (fit == segment_fit::interpolation)
+            {
+                ans += sum_of_error_square(ys.begin()+k, ys.begin()+n);
+            }
+            else
+            {
+                double mean_x = 0; 
+                double mean_y = 0;
+                for(std::uint32_t i=k; i!=n; ++i) { mean_x += i; mean_y += ys[i]; }
+                mean_x /= (n-k);
+                mean_y /= (n-k);
+
+                double Sxx = 0;
+                double Sxy = 0;
+                for(std::uint32_t i=k; i!=n; ++i) 
+                {
+                    Sxx += (i-mean_x) * (i-mean_x);
+                    Sxy += (i-mean_x) * (ys[i]-mean_y);
+                }
+                double slope = Sxx > 0? Sxy / Sxx : 0;
+                for(std::uint32_t i=k; i!=n; ++i) 
+                {
+                    double err = ys[i] - mean_y - slope * (i-mean_x);
+                    ans += err * err;
+                }
+            }
+        }
+        return ans;
+    }
+}
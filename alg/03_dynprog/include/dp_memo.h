@@ -0,0 +1,236 @@
+#pragma once
+#include<cstdint>
+#include<limits>
+#include<vector>
+#include<memory>
+#include<optional>
+#include<mutex>
+#include<bit>
+
+// from alg
+#include<flat_hash_map.h>
+#include<spinlock.h>
+
+
+// ************************************************************************************ //
+// *** Memoization for recursive DP *** //
+// ************************************************************************************ //
+// Subproblem of recursive DP is a view of the input, e.g. suffix of string or range of
+// coins, hence it is identified by (offset, length) pair, packed into 64 bits key,
+// instead of copying the sub-string or sub-vector. One cache serves one input only.
+//
+// 1. dense_memo         - table indexed by offset x num_lengths + length, one slot per
+//                         subproblem, exact, no hashing, for rectangular state space,
+//                         default cache of the *_memoized entry points
+// 2. direct_mapped_memo - fixed size table, slot = hash(key) & mask, new entry evicts
+//                         old entry in the same slot, so result may be recomputed, but
+//                         never wrong, memory is bounded, opt-in via *_memoized_impl,
+//                         as a recomputed subproblem recomputes its evicted descendants
+//                         too, run time has no polynomial bound unless table is large
+// 3. flat_memo          - alg::flat_hash_map, exact, grows with number of subproblems
+//
+// Recursion depth is the longest chain of subproblems, e.g. N+M for edit distance, each
+// level is the impl plus its compute lambda, about 200 bytes of stack in -O2 and 400 in
+// -O0, hence default 8MB stack is safe for depth up to 20K, use *_iterative beyond.
+//
+// All can be shared by threads with LOCK = alg::spinlock (or std::mutex), in which case
+// the table is split into stripes, each guarded by its own lock, stripe is picked by
+// hash, or by index for dense_memo. The lock is not held during compute, as compute recurses into the same cache.
+// Two threads may compute the same subproblem concurrently, both get the same result.
+// ************************************************************************************ //
+namespace alg
+{
+    struct no_lock
+    {
+        void lock()   noexcept {}
+        void unlock() noexcept {}
+    };
+
+    inline std::uint64_t memo_key(std::uint32_t offset, std::uint32_t length) noexcept
+    {
+        return ((std::uint64_t)offset << 32) | length;
+    }
+
+    template<typename LOCK>
+    struct alignas(64) memo_stripe_lock // one cacheline per lock, avoid false sharing
+    {
+        LOCK m_lock;
+    };
+
+    template<typename V, typename LOCK = no_lock>
+    class dense_memo
+    {
+    public:
+        // Key memo_key(offset, length) must lie in [0, num_offsets) x [0, num_lengths)
+        dense_memo(std::uint64_t num_offsets, std::uint64_t num_lengths, std::uint32_t num_stripes = 64)
+            : m_num_lengths(num_lengths),
+              m_slots(num_offsets * num_lengths),
+              m_locks(std::is_same_v<LOCK, no_lock>? 1 : num_stripes)
+        {
+        }
+
+    public:
+        std::optional<V> find(std::uint64_t key)
+        {
+            std::uint64_t index = index_of(key);
+            std::lock_guard<LOCK> lock(stripe(index));
+            return m_slots[index];
+        }
+
+        void insert(std::uint64_t key, const V& value)
+        {
+            std::uint64_t index = index_of(key);
+            std::lock_guard<LOCK> lock(stripe(index));
+            m_slots[index] = value;
+        }
+
+        void clear() noexcept
+        {
+            for(auto& x:m_slots) x.reset();
+        }
+
+        std::uint64_t capacity() const noexcept
+        {
+            return m_slots.size();
+        }
+
+    private:
+        std::uint64_t index_of(std::uint64_t key) const noexcept
+        {
+            return (key >> 32) * m_num_lengths + (key & 0xFFFFFFFF);
+        }
+
+        LOCK& stripe(std::uint64_t index) noexcept
+        {
+            return m_locks[index % m_locks.size()].m_lock;
+        }
+
+    private:
+        std::uint64_t                       m_num_lengths;
+        std::vector<std::optional<V>>       m_slots;
+        std::vector<memo_stripe_lock<LOCK>> m_locks;
+    };
+
+    template<typename V, typename LOCK = no_lock>
+    class direct_mapped_memo
+    {
+    public:
+        // Capacity is rounded up to power of 2
+        explicit direct_mapped_memo(std::uint64_t capacity, std::uint32_t num_stripes = 64)
+            : m_slots(std::bit_ceil(std::max<std::uint64_t>(capacity, 1))),
+              m_mask(m_slots.size()-1),
+              m_locks(std::is_same_v<LOCK, no_lock>? 1 : num_stripes)
+        {
+            clear();
+        }
+
+    public:
+        std::optional<V> find(std::uint64_t key)
+        {
+            std::uint64_t index = flat_hash<std::uint64_t>{}(key) & m_mask;
+            std::lock_guard<LOCK> lock(stripe(index));
+            if (m_slots[index].m_key == key) return m_slots[index].m_value;
+            return std::nullopt;
+        }
+
+        void insert(std::uint64_t key, const V& value)
+        {
+            std::uint64_t index = flat_hash<std::uint64_t>{}(key) & m_mask;
+            std::lock_guard<LOCK> lock(stripe(index));
+            m_slots[index].m_key   = key;
+            m_slots[index].m_value = value;
+        }
+
+        void clear() noexcept
+        {
+            for(auto& x:m_slots) x.m_key = empty;
+        }
+
+        std::uint64_t capacity() const noexcept
+        {
+            return m_slots.size();
+        }
+
+    private:
+        static constexpr std::uint64_t empty = std::numeric_limits<std::uint64_t>::max();
+
+        struct slot
+        {
+            std::uint64_t m_key;
+            V             m_value;
+        };
+
+        LOCK& stripe(std::uint64_t index) noexcept
+        {
+            return m_locks[index % m_locks.size()].m_lock;
+        }
+
+    private:
+        std::vector<slot> m_slots;
+        std::uint64_t     m_mask;
+        std::vector<memo_stripe_lock<LOCK>> m_locks;
+    };
+
+    template<typename V, typename LOCK = no_lock>
+    class flat_memo
+    {
+    public:
+        explicit flat_memo(std::uint32_t num_stripes = 64)
+            : m_stripes(std::is_same_v<LOCK, no_lock>? 1 : num_stripes)
+        {
+        }
+
+    public:
+        std::optional<V> find(std::uint64_t key)
+        {
+            auto& s = stripe(key);
+            std::lock_guard<LOCK> lock(s.m_lock);
+            if (auto* x = s.m_map.find(key)) return *x;
+            return std::nullopt;
+        }
+
+        void insert(std::uint64_t key, const V& value)
+        {
+            auto& s = stripe(key);
+            std::lock_guard<LOCK> lock(s.m_lock);
+            s.m_map[key] = value;
+        }
+
+        void clear() noexcept
+        {
+            for(auto& s:m_stripes) s.m_map.clear();
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            std::uint64_t ans = 0;
+            for(const auto& s:m_stripes) ans += s.m_map.size();
+            return ans;
+        }
+
+    private:
+        struct alignas(64) stripe_type
+        {
+            LOCK m_lock;
+            flat_hash_map<std::uint64_t, V> m_map;
+        };
+
+        // Top bits pick stripe, as flat_hash_map uses low bits for H2 and H1
+        stripe_type& stripe(std::uint64_t key) noexcept
+        {
+            return m_stripes[(flat_hash<std::uint64_t>{}(key) >> 48) % m_stripes.size()];
+        }
+
+    private:
+        std::vector<stripe_type> m_stripes;
+    };
+
+    template<typename CACHE, typename F>
+    auto memoize(CACHE& cache, std::uint64_t key, const F& compute)
+    {
+        if (auto ans = cache.find(key)) return *ans;
+        auto ans = compute();
+        cache.insert(key, ans);
+        return ans;
+    }
+}
@@ -0,0 +1,419 @@
+#pragma once
+#include<cstdint>
+#include<string>
+#include<string_view>
+#include<vector>
+#include<atomic>
+#include<optional>
+#include<functional>
+#include<thread>
+#include<barrier>
+#include<latch>
+#include<algorithm>
+
+// from alg
+#include<threadpool.h>
+
+
+// ************************************************************************************ //
+// *** Wavefront DP engine on (N+1) x (M+1) grid *** //
+// ************************************************************************************ //
+// Cell (i,j) depends on up (i-1,j), left (i,j-1) and diag (i-1,j-1), like LCS and
+// edit distance. Row 0 and col 0 are given by boundary functions top(j) and left(i).
+// Only last row is returned, memory is O(N+M) instead of O(NM).
+//
+// 1. Grid is split into tiles of size B x B
+// 2. Tile (I,J) is ready once tile (I-1,J) and tile (I,J-1) are done, ready tiles are
+//    pushed into alg::threadpool, hence tiles are processed in dependency order
+// 3. Inside tile, cells are swept by anti-diagonals, each anti-diagonal only reads the
+//    previous two anti-diagonals, cells on the same anti-diagonal are independent, so
+//    that the inner loop can be vectorized, only 3 anti-diagonals of B are kept
+//
+// Tiles exchange data via :
+// * row_buf[j] = bottom row of the last tile done in tile-column of j
+// * col_buf[i] = right column of the last tile done in tile-row of i
+// * corner     = bottom right of tile (I-1,J-1), indexed by I-J, as it is overwritten
+//                in row_buf by tile (I,J-1) before tile (I,J) starts
+//
+// Cell function is cell(i, j, up, left, diag), where i and j are 0-based std::int64_t char
+// indices, i.e. cell (i+1,j+1) of the grid compares a[i] and b[j].
+// ************************************************************************************ //
+namespace alg
+{
+    namespace wavefront_detail
+    {
+        // Extended coordinate (R,C) in [0,h] x [0,w], row R=0 and col C=0 are inputs :
+        // top[C] for C=0..w (top[0] is corner), left[R-1] for R=1..h
+        // bottom[C-1] for C=1..w, right[R-1] for R=1..h are outputs
+        template<typename T, typename CELL>
+        __attribute__((always_inline))
+        inline void sweep_tile_body(std::uint32_t i0, std::uint32_t j0, std::uint32_t h, std::uint32_t w,
+                                    const T* top, const T* left, T* bottom, T* right, const CELL& cell)
+        {
+            std::vector<T> buf(3 * (h+1));
+            T* d2  = &buf[0];       // anti-diagonal e-2
+            T* d1  = &buf[h+1];     // anti-diagonal e-1
+            T* cur = &buf[2*(h+1)]; // anti-diagonal e
+            d1[0] = top[0];
+
+            for(std::uint32_t e=1; e<=h+w; ++e)
+            {
+                if (e <= w) cur[0] = top[e];
+                if (e <= h) cur[e] = left[e-1];
+
+                std::uint32_t lo = e > w? e-w : 1;
+                std::uint32_t hi = std::min(h, e-1);
+                for(std::int64_t R=lo; R<=hi; ++R) // signed index, so that j is affine in R
+                {
+                    cur[R] = cell((std::int64_t)i0+R-1, (std::int64_t)j0+e-R-1, d1[R-1], d1[R], d2[R-1]);
+                }
+
+                if (lo <= hi)
+                {
+                    if (hi == h)   bottom[e-h-1] = cur[h];   // C = e-h
+                    if (e > w)     right[e-w-1]  = cur[e-w]; // C = w
+                }
+
+                T* tmp = d2;
+                d2  = d1;
+                d1  = cur;
+                cur = tmp;
+            }
+        }
+
+        // Same body compiled twice, the anti-diagonal loop is vectorized with 8 lanes in AVX2
+        template<typename T, typename CELL>
+        __attribute__((target("avx2")))
+        void sweep_tile_avx2(std::uint32_t i0, std::uint32_t j0, std::uint32_t h, std::uint32_t w,
+                             const T* top, const T* left, T* bottom, T* right, const CELL& cell)
+        {
+            sweep_tile_body(i0, j0, h, w, top, left, bottom, right, cell);
+        }
+
+        template<typename T, typename CELL>
+        void sweep_tile_sse(std::uint32_t i0, std::uint32_t j0, std::uint32_t h, std::uint32_t w,
+                            const T* top, const T* left, T* bottom, T* right, const CELL& cell)
+        {
+            sweep_tile_body(i0, j0, h, w, top, left, bottom, right, cell);
+        }
+
+        template<typename T, typename CELL>
+        void sweep_tile(std::uint32_t i0, std::uint32_t j0, std::uint32_t h, std::uint32_t w,
+                        const T* top, const T* left, T* bottom, T* right, const CELL& cell)
+        {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            if (avx2) sweep_tile_avx2(i0, j0, h, w, top, left, bottom, right, cell);
+            else      sweep_tile_sse (i0, j0, h, w, top, left, bottom, right, cell);
+        }
+    }
+
+    // Serial if pool is nullptr, otherwise tiles run in pool, which caller may reuse across calls
+    template<typename T, typename TOP, typename LEFT, typename CELL>
+    std::vector<T> wavefront_last_row(std::uint32_t N, std::uint32_t M,
+                                      const TOP& top, const LEFT& left, const CELL& cell,
+                                      alg::threadpool* pool, std::uint32_t tile_size)
+    {
+        std::vector<T> row_buf(M+1);
+        std::vector<T> col_buf(N+1);
+        for(std::uint32_t j=0; j<=M; ++j) row_buf[j] = top(j);
+        for(std::uint32_t i=0; i<=N; ++i) col_buf[i] = left(i);
+        if (N == 0) return row_buf;
+        if (M == 0) return std::vector<T>{left(N)};
+
+        const std::uint32_t B  = tile_size;
+        const std::uint32_t nI = (N + B-1) / B;
+        const std::uint32_t nJ = (M + B-1) / B;
+
+        // corner of tile (I,J) is at key I-J+nJ, boundary tiles take it from top and left
+        std::vector<T> corners(nI + nJ);
+        for(std::uint32_t J=0; J!=nJ; ++J) corners[nJ-J] = top(J*B);
+        for(std::uint32_t I=1; I!=nI; ++I) corners[nJ+I] = left(I*B);
+
+        auto run_tile = [&](std::uint32_t I, std::uint32_t J)
+        {
+            std::uint32_t i0 = I*B;
+            std::uint32_t j0 = J*B;
+            std::uint32_t h  = std::min(B, N-i0);
+            std::uint32_t w  = std::min(B, M-j0);
+
+            std::vector<T> top_in(w+1);
+            top_in[0] = corners[nJ+I-J];
+            std::copy(&row_buf[j0+1], &row_buf[j0+1]+w, &top_in[1]);
+
+            // outputs are written in place, as inputs are copied or read before written
+            wavefront_detail::sweep_tile(i0, j0, h, w, top_in.data(), &col_buf[i0+1],
+                                         &row_buf[j0+1], &col_buf[i0+1], cell);
+            corners[nJ+I-J] = row_buf[j0+w]; // for tile (I+1,J+1)
+        };
+
+        if (pool == nullptr || nI * nJ == 1)
+        {
+            for(std::uint32_t I=0; I!=nI; ++I)
+                for(std::uint32_t J=0; J!=nJ; ++J) run_tile(I,J);
+        }
+        else
+        {
+            // Number of pending dependencies of each tile, tile (0,0) has none
+            std::vector<std::atomic<std::uint32_t>> deps(nI * nJ);
+            for(std::uint32_t I=0; I!=nI; ++I)
+                for(std::uint32_t J=0; J!=nJ; ++J) deps[I*nJ+J] = (I>0) + (J>0);
+
+            std::latch done(nI * nJ);
+            std::function<void(std::uint32_t,std::uint32_t)> submit = [&](std::uint32_t I, std::uint32_t J)
+            {
+                pool->add_task([&, I, J](std::uint32_t)
+                {
+                    run_tile(I,J);
+                    if (I+1 < nI && deps[(I+1)*nJ+J].fetch_sub(1) == 1) submit(I+1, J);
+                    if (J+1 < nJ && deps[I*nJ+J+1].fetch_sub(1) == 1) submit(I, J+1);
+                    done.count_down();
+                });
+            };
+            submit(0,0);
+            done.wait();
+        }
+
+        row_buf[0] = left(N);
+        return row_buf;
+    }
+
+    template<typename T, typename TOP, typename LEFT, typename CELL>
+    std::vector<T> wavefront_last_row(std::uint32_t N, std::uint32_t M,
+                                      const TOP& top, const LEFT& left, const CELL& cell,
+                                      std::uint32_t num_threads = 1, std::uint32_t tile_size = 512)
+    {
+        if (num_threads <= 1) return wavefront_last_row<T>(N, M, top, left, cell, nullptr, tile_size);
+
+        alg::threadpool pool(num_threads);
+        return wavefront_last_row<T>(N, M, top, left, cell, &pool, tile_size);
+    }
+}
+
+
+// ***************************************************** //
+// *** LCS and edit distance on wavefront DP engine *** //
+// ***************************************************** //
+namespace alg
+{
+    // Along an anti-diagonal, i increases while j decreases, str1 is read via its reversed
+    // copy, so that both strings are loaded contiguously and the sweep is vectorized.
+    inline std::vector<std::uint32_t> longest_common_subseq_last_row(std::string_view str0, std::string_view str1, std::uint32_t num_threads = 1)
+    {
+        std::string rev1(str1.rbegin(), str1.rend());
+        const char* a = str0.data();
+        const char* b = rev1.data() + rev1.size() - 1; // b[-j] == str1[j], unused if str1 is empty
+        return wavefront_last_row<std::uint32_t>(str0.size(), str1.size(),
+            [](std::uint32_t) { return 0u; },
+            [](std::uint32_t) { return 0u; },
+            [a,b](std::int64_t i, std::int64_t j, std::uint32_t up, std::uint32_t left, std::uint32_t diag)
+            {
+                return a[i]==b[-j]? diag+1 : std::max(up, left);
+            },
+            num_threads);
+    }
+
+    // Last row of edit distance matrix, i.e. ans[j] = edit distance between str0 and str1[0,j)
+    inline std::vector<std::uint32_t> edit_distance_last_row(std::string_view str0, std::string_view str1, alg::threadpool* pool)
+    {
+        std::string rev1(str1.rbegin(), str1.rend());
+        const char* a = str0.data();
+        const char* b = rev1.data() + rev1.size() - 1;
+        return wavefront_last_row<std::uint32_t>(str0.size(), str1.size(),
+            [](std::uint32_t j) { return j; },
+            [](std::uint32_t i) { return i; },
+            [a,b](std::int64_t i, std::int64_t j, std::uint32_t up, std::uint32_t left, std::uint32_t diag)
+            {
+                return a[i]==b[-j]? diag : std::min(diag, std::min(up, left)) + 1;
+            },
+            pool, 512);
+    }
+
+    inline std::vector<std::uint32_t> edit_distance_last_row(std::string_view str0, std::string_view str1, std::uint32_t num_threads = 1)
+    {
+        if (num_threads <= 1) return edit_distance_last_row(str0, str1, nullptr);
+
+        alg::threadpool pool(num_threads);
+        return edit_distance_last_row(str0, str1, &pool);
+    }
+
+    inline std::uint32_t longest_common_subseq_wavefront(std::string_view str0, std::string_view str1, std::uint32_t num_threads = 1)
+    {
+        return longest_common_subseq_last_row(str0, str1, num_threads).back();
+    }
+
+    inline std::uint32_t edit_distance_wavefront(std::string_view str0, std::string_view str1, std::uint32_t num_threads = 1)
+    {
+        return edit_distance_last_row(str0, str1, num_threads).back();
+    }
+}
+
+
+// ****************************************************************************************** //
+// *** Hirschberg alignment *** //
+// ****************************************************************************************** //
+// Return edit script that converts str0 into str1 with min number of edits :
+// 'M' = match, 'S' = substitute, 'D' = delete char of str0, 'I' = insert char of str1
+//
+// Split str0 at mid, cost of str0[0,mid) vs str1[0,j) is last row of forward DP,
+// cost of str0[mid,N) vs str1[j,M) is last row of DP on reversed strings, the argmin j
+// lies on the optimal path, then recurse on both halves. Small subproblem is solved by
+// full matrix with traceback. Time O(NM), memory O(N+M).
+// ****************************************************************************************** //
+namespace alg
+{
+    namespace wavefront_detail
+    {
+        inline void edit_script_by_matrix(std::string_view str0, std::string_view str1, std::string& ops)
+        {
+            std::uint32_t N = str0.size();
+            std::uint32_t M = str1.size();
+            std::vector<std::uint32_t> mat((N+1) * (M+1));
+            auto at = [&](std::uint32_t i, std::uint32_t j) -> std::uint32_t& { return mat[i*(M+1)+j]; };
+
+            for(std::uint32_t i=0; i<=N; ++i) at(i,0) = i;
+            for(std::uint32_t j=0; j<=M; ++j) at(0,j) = j;
+            for(std::uint32_t i=1; i<=N; ++i)
+            {
+                for(std::uint32_t j=1; j<=M; ++j)
+                {
+                    if (str0[i-1]==str1[j-1]) at(i,j) = at(i-1,j-1);
+                    else at(i,j) = std::min(at(i-1,j-1), std::min(at(i-1,j), at(i,j-1))) + 1;
+                }
+            }
+
+            std::string rev;
+            std::uint32_t i = N;
+            std::uint32_t j = M;
+            while(i > 0 || j > 0)
+            {
+                if (i > 0 && j > 0 && str0[i-1]==str1[j-1] && at(i,j) == at(i-1,j-1))
+                {
+                    rev.push_back('M'); --i; --j;
+                }
+                else if (i > 0 && j > 0 && at(i,j) == at(i-1,j-1) + 1)
+                {
+                    rev.push_back('S'); --i; --j;
+                }
+                else if (i > 0 && at(i,j) == at(i-1,j) + 1)
+                {
+                    rev.push_back('D'); --i;
+                }
+                else
+                {
+                    rev.push_back('I'); --j;
+                }
+            }
+            ops.append(rev.rbegin(), rev.rend());
+        }
+
+        inline void hirschberg(std::string_view str0, std::string_view str1, std::string& ops, alg::threadpool* pool)
+        {
+            if (str0.empty()) { ops.append(str1.size(), 'I'); return; }
+            if (str1.empty()) { ops.append(str0.size(), 'D'); return; }
+            if (str0.size() == 1 || (std::uint64_t)str0.size() * str1.size() <= (1u << 16))
+            {
+                edit_script_by_matrix(str0, str1, ops);
+                return;
+            }
+
+            std::uint32_t mid = str0.size() / 2;
+            std::string rev0(str0.rbegin(), str0.rend() - mid); // reverse of str0[mid,N)
+            std::string rev1(str1.rbegin(), str1.rend());
+            auto fwd = edit_distance_last_row(str0.substr(0, mid), str1, pool);
+            auto bwd = edit_distance_last_row(rev0,                rev1, pool);
+
+            std::uint32_t M = str1.size();
+            std::uint32_t best_j = 0;
+            for(std::uint32_t j=1; j<=M; ++j)
+            {
+                if (fwd[j] + bwd[M-j] < fwd[best_j] + bwd[M-best_j]) best_j = j;
+            }
+
+            hirschberg(str0.substr(0, mid), str1.substr(0, best_j), ops, pool);
+            hirschberg(str0.substr(mid),    str1.substr(best_j),    ops, pool);
+        }
+    }
+
+    inline std::string edit_distance_alignment(std::string_view str0, std::string_view str1, std::uint32_t num_threads = 1)
+    {
+        std::string ops;
+        ops.reserve(str0.size() + str1.size());
+
+        // One pool for all levels of recursion, instead of one per last row
+        std::optional<alg::threadpool> pool;
+        if (num_threads > 1) pool.emplace(num_threads);
+        wavefront_detail::hirschberg(str0, str1, ops, pool? &*pool : nullptr);
+        return ops;
+    }
+}
+
+
+// ****************************************************************************************** //
+// *** Coin game on diagonals *** //
+// ****************************************************************************************** //
+// In coin_game_iterative(), mat(n,n+d) depends on diagonal d-2 only :
+// mat(n+2,m), mat(n+1,m-1), mat(n,m-2), where m = n+d.
+// Hence 3 rolling diagonals (d-2, d-1, d) replace the N x N matrix, memory O(N), and
+// cells on a diagonal are independent, the inner loop is vectorizable. For multithread,
+// each long diagonal is split among threads, with one barrier per diagonal.
+// ****************************************************************************************** //
+namespace alg
+{
+    inline std::uint32_t coin_game_wavefront(const std::vector<std::uint32_t>& coins, std::uint32_t num_threads = 1)
+    {
+        std::uint32_t N = coins.size();
+        if (N == 0) return 0;
+        if (N == 1) return coins[0];
+
+        std::vector<std::uint32_t> buf(3*N, 0);
+        auto diag = [&](std::uint32_t d) { return &buf[(d%3) * N]; };
+
+        std::uint32_t* d0 = diag(0);
+        std::uint32_t* d1 = diag(1);
+        for(std::uint32_t n=0; n!=N;   ++n) d0[n] = coins[n];
+        for(std::uint32_t n=0; n!=N-1; ++n) d1[n] = std::max(coins[n], coins[n+1]);
+
+        const std::uint32_t* c = coins.data();
+        auto run = [&](std::uint32_t d, std::uint32_t begin, std::uint32_t end)
+        {
+            const std::uint32_t* prev = diag(d-2);
+            std::uint32_t* curr = diag(d);
+            for(std::uint32_t n=begin; n<end; ++n)
+            {
+                std::uint32_t mid = prev[n+1];
+                curr[n] = std::max(c[n]   + std::min(prev[n+2], mid),
+                                   c[n+d] + std::min(mid, prev[n]));
+            }
+        };
+
+        // Parallel for long diagonals only, the tail of short diagonals is single thread
+        const std::uint32_t min_per_thread = 1u << 14;
+        std::uint32_t d = 2;
+        if (num_threads > 1 && N > 2 + 2 * min_per_thread)
+        {
+            std::uint32_t last_parallel_d = N - num_threads * min_per_thread; // N-d >= threads * min
+            if (last_parallel_d > N) last_parallel_d = 2;                     // wrapped around
+            std::barrier sync(num_threads);
+
+            auto fct = [&](std::uint32_t t)
+            {
+                for(std::uint32_t dd=2; dd<last_parallel_d; ++dd)
+                {
+                    std::uint32_t size  = N-dd;
+                    std::uint32_t begin = (std::uint64_t)size * t     / num_threads;
+                    std::uint32_t end   = (std::uint64_t)size * (t+1) / num_threads;
+                    run(dd, begin, end);
+                    sync.arrive_and_wait();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(fct, t);
+            fct(0);
+            for(auto& x:threads) x.join();
+            d = std::max(2u, last_parallel_d);
+        }
+        for(; d<N; ++d) run(d, 0, N-d);
+        return diag(N-1)[0];
+    }
+}
@@ -0,0 +1,119 @@
+#include<iostream>
+#include<iomanip>
+#include<cassert>
+
+// from alg
+#include<dp_bit_parallel.h>
+#include<utility.h>
+
+
+// Row by row DP as reference, dp_matrix_only.h is not included as it is not header-only safe
+std::uint32_t longest_common_subseq_reference(const std::string& str0, const std::string& str1)
+{
+    std::vector<std::uint32_t> prev(str1.size()+1, 0);
+    std::vector<std::uint32_t> curr(str1.size()+1, 0);
+    for(std::uint32_t n=1; n<=str0.size(); ++n)
+    {
+        for(std::uint32_t m=1; m<=str1.size(); ++m)
+        {
+            if (str0[n-1]==str1[m-1]) curr[m] = prev[m-1] + 1;
+            else                      curr[m] = std::max(prev[m], curr[m-1]);
+        }
+        std::swap(prev, curr);
+    }
+    return prev[str1.size()];
+}
+
+std::uint32_t edit_distance_reference(const std::string& str0, const std::string& str1)
+{
+    std::vector<std::uint32_t> prev(str1.size()+1);
+    std::vector<std::uint32_t> curr(str1.size()+1);
+    for(std::uint32_t m=0; m<=str1.size(); ++m) prev[m] = m;
+    for(std::uint32_t n=1; n<=str0.size(); ++n)
+    {
+        curr[0] = n;
+        for(std::uint32_t m=1; m<=str1.size(); ++m)
+        {
+            if (str0[n-1]==str1[m-1]) curr[m] = prev[m-1];
+            else                      curr[m] = std::min(prev[m-1], std::min(prev[m], curr[m-1])) + 1;
+        }
+        std::swap(prev, curr);
+    }
+    return prev[str1.size()];
+}
+
+
+void test_bit_parallel_vs_matrix()
+{
+    // Pattern up to 200 chars, crossing 1, 2, 3 and 4 words, including empty string
+    std::uint32_t num_trial = 1000;
+    std::uint32_t error0 = 0;
+    std::uint32_t error1 = 0;
+    std::uint32_t error2 = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t num_alphabets = 1 + std::rand() % 8;
+        auto str0 = gen_random_str(std::rand() % 200, num_alphabets);
+        auto str1 = gen_random_str(std::rand() % 200, num_alphabets);
+
+        auto lcs  = longest_common_subseq_reference(str0, str1);
+        auto dist = edit_distance_reference(str0, str1);
+        if (alg::longest_common_subseq_bit_parallel(str0, str1) != lcs)  ++error0;
+        if (alg::edit_distance_bit_parallel(str0, str1)         != dist) ++error1;
+
+        // Distance is exact when not more than max_k, otherwise max_k+1
+        std::uint32_t max_k = std::rand() % 100;
+        std::uint32_t ans   = dist <= max_k? dist : max_k+1;
+        if (alg::edit_distance_bit_parallel(str0, str1, max_k) != ans) ++error2;
+    }
+    print_summary("longest_common_subseq - bit parallel vs row by row DP", error0, num_trial);
+    print_summary("edit_distance -------- bit parallel vs row by row DP", error1, num_trial);
+    print_summary("edit_distance -------- bit parallel with max_k", error2, num_trial);
+}
+
+void test_bit_parallel_batch()
+{
+    std::uint32_t num_texts = 1000000;
+    std::string query = gen_random_str(12, 26);
+    std::vector<std::string> texts;
+    texts.reserve(num_texts);
+    for(std::uint32_t n=0; n!=num_texts; ++n) texts.push_back(gen_random_str(4 + std::rand() % 16, 26));
+
+    alg::bit_pattern pattern(query);
+    alg::timer timer;
+    timer.click();
+    auto ans0 = alg::edit_distance_batch(pattern, texts, 3, 4);
+    timer.click();
+    auto time0 = timer.time_elapsed_in_nsec();
+
+    timer.click();
+    auto ans1 = alg::longest_common_subseq_batch(pattern, texts, 4);
+    timer.click();
+    auto time1 = timer.time_elapsed_in_nsec();
+
+    std::uint32_t error = 0;
+    for(std::uint32_t n=0; n<num_texts; n+=997)
+    {
+        auto dist = edit_distance_reference(query, texts[n]);
+        if (ans0[n] != std::min(dist, 4u)) ++error;
+        if (ans1[n] != longest_common_subseq_reference(query, texts[n])) ++error;
+    }
+    print_summary("edit_distance_batch and longest_common_subseq_batch", error, num_texts/997+1);
+    print_summary("batch of 1M texts, edit_distance(max_k=3) / LCS",
+                  "time = " + std::to_string(time0/1000) + "/" + std::to_string(time1/1000) + " us");
+
+    // Long strings, O(NM/64)
+    auto str0 = gen_random_str(20000, 4);
+    auto str1 = gen_random_str(20000, 4);
+    timer.click();
+    auto dist = alg::edit_distance_bit_parallel(str0, str1);
+    timer.click();
+    print_summary("edit_distance 20K x 20K bit parallel", 
+                  "time = " + std::to_string(timer.time_elapsed_in_nsec()/1000) + " us, dist = " + std::to_string(dist));
+}
+
+void test_dp_bit_parallel()
+{
+    test_bit_parallel_vs_matrix();
+    test_bit_parallel_batch();
+}
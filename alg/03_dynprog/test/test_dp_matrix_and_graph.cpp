@@ -2,6 +2,7 @@
 #include<iomanip>
 #include<cassert>
 #include<dp_matrix_and_graph.h>
+#include<corpus.h>
 #include<utility.h>
 
 
@@ -50,6 +51,69 @@ void test_coin_change()
                  std::bind(alg::count_coin_change_recursive_in_matrix, _1, 100),
                  std::bind(alg::count_coin_change_iterative_in_matrix, _1, 100),      
                  num_trial);
+
+    num_trial = 1000;
+    benchmark<1>("min_coin_change --------- recursive vs memoized (matrix)", 
+                 std::bind(gen_random_coins, 4, 2, 30), 
+                 std::bind(alg::min_coin_change_recursive_in_matrix, _1, 100),
+                 std::bind(alg::min_coin_change_memoized_in_matrix,  _1, 100),      
+                 num_trial);
+
+    num_trial = 100;
+    benchmark<1>("min_coin_change --------- iterative vs memoized (matrix), target 10000", 
+                 std::bind(gen_random_coins, 8, 10, 60), 
+                 std::bind(alg::min_coin_change_iterative_in_matrix, _1, 10000),
+                 std::bind(alg::min_coin_change_memoized_in_matrix,  _1, 10000),      
+                 num_trial);
+
+    num_trial = 1000;
+    benchmark<1>("count_coin_change ------- recursive vs memoized (matrix)", 
+                 std::bind(gen_random_coins, 8, 1, 30), 
+                 std::bind(alg::count_coin_change_recursive_in_matrix, _1, 100),
+                 std::bind(alg::count_coin_change_memoized_in_matrix,  _1, 100),      
+                 num_trial);
+
+    num_trial = 100;
+    benchmark<1>("count_coin_change ------- iterative vs memoized (matrix), target 10000", 
+                 std::bind(gen_random_coins, 8, 10, 60), 
+                 std::bind(alg::count_coin_change_iterative_in_matrix, _1, 10000),
+                 std::bind(alg::count_coin_change_memoized_in_matrix,  _1, 10000),      
+                 num_trial);
+
+    num_trial = 1000;
+    benchmark<1>("min_coin_change --------- matrix vs array (iterative)",
+                 std::bind(gen_random_coins, 8, 1, 60), 
+                 std::bind(alg::min_coin_change_iterative_in_matrix, _1, 600),
+                 std::bind(alg::min_coin_change_iterative_in_array,  _1, 600, 1),
+                 num_trial);
+
+    num_trial = 1000;
+    benchmark<1>("min_coin_change --------- matrix vs array (iterative) with ans=inf",
+                 std::bind(gen_random_coins, 2, 7, 19), 
+                 std::bind(alg::min_coin_change_iterative_in_matrix, _1, 173),
+                 std::bind(alg::min_coin_change_iterative_in_array,  _1, 173, 1),
+                 num_trial);
+
+    num_trial = 1000;
+    benchmark<1>("count_coin_change ------- matrix vs array (iterative)", 
+                 std::bind(gen_random_coins, 8, 1, 30), 
+                 std::bind(alg::count_coin_change_iterative_in_matrix, _1, 100),
+                 std::bind(alg::count_coin_change_iterative_in_array,  _1, 100, 1),
+                 num_trial);
+
+    // Capacity split among threads, segment is at least 64K
+    num_trial = 10;
+    benchmark<1>("min_coin_change --------- array single thread vs multithread",
+                 std::bind(gen_random_coins, 20, 1000, 60000), 
+                 std::bind(alg::min_coin_change_iterative_in_array, _1, 1000000, 1),
+                 std::bind(alg::min_coin_change_iterative_in_array, _1, 1000000, 4),
+                 num_trial);
+
+    benchmark<1>("count_coin_change ------- array single thread vs multithread",
+                 std::bind(gen_random_coins, 20, 1000, 60000), 
+                 std::bind(alg::count_coin_change_iterative_in_array, _1, 1000000, 1),
+                 std::bind(alg::count_coin_change_iterative_in_array, _1, 1000000, 4),
+                 num_trial);
 }
 
 
@@ -61,17 +125,91 @@ void test_knapsack()
                  std::bind(alg::knapsack_iterative_in_graph,  _1, 400),      
                  std::bind(alg::knapsack_iterative_in_matrix, _1, 400),
                  num_trial); 
+
+    benchmark<1>("knapack ----------------- matrix vs array (iterative)",           
+                 std::bind(gen_random_objects, 15, 10, 40, 1, 80), 
+                 std::bind(alg::knapsack_iterative_in_matrix, _1, 400),
+                 std::bind(alg::knapsack_iterative_in_array,  _1, 400, 1),
+                 num_trial); 
+
+    num_trial = 10;
+    benchmark<1>("knapack ----------------- array single thread vs multithread",           
+                 std::bind(gen_random_objects, 10, 1000, 50000, 1, 100), 
+                 std::bind(alg::knapsack_iterative_in_array, _1, 1000000, 1),
+                 std::bind(alg::knapsack_iterative_in_array, _1, 1000000, 4),
+                 num_trial); 
+
+    // All weights 0, no halo
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> zero_weights = {{0,5}, {0,7}};
+    assert(alg::knapsack_iterative_in_array(zero_weights, 1000000, 4) == alg::knapsack_iterative_in_array(zero_weights, 1000000, 1));
+
+    // Large capacity, the matrix version needs objects x capacity x 4 bytes
+    auto objects = gen_random_objects(10, 1000, 50000, 1, 100);
+    alg::timer timer;
+    timer.click();
+    auto ans = alg::knapsack_iterative_in_array(objects, 10000000, 4);
+    timer.click();
+    print_summary("knapsack array, 10 objects, capacity 10M", 
+                  "ans = " + std::to_string(ans) + ", time = " + std::to_string(timer.time_elapsed_in_nsec()/1000000) + " ms");
+}
+
+
+// Same solver on different state stores
+std::uint32_t job_schedule_in_unordered_map(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks)
+{
+    std::unordered_map<alg::job_state, std::uint32_t, alg::job_state_hash> graph;
+    return alg::job_schedule_iterative_in_store(tasks, graph);
+}
+
+std::uint32_t job_schedule_in_flat_store(const std::vector<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>>& tasks)
+{
+    alg::flat_state_store<alg::job_state, std::uint32_t, alg::job_state_hash> graph;
+    return alg::job_schedule_iterative_in_store(tasks, graph);
+}
+
+std::uint32_t equal_partition_in_flat_store(const std::vector<std::uint32_t>& numbers, std::uint32_t num_threads)
+{
+    alg::flat_state_store<alg::partition_state, std::uint8_t, alg::partition_state_hash> graph;
+    return alg::equal_partition_iterative_in_store(numbers, graph, num_threads);
 }
 
 
 void test_job_schedule()
 {
+    // Dense store rejects key outside state space
+    alg::state_encoder<alg::job_state, &alg::job_state::m_total_workload, &alg::job_state::m_next_allowed_job> encoder(10, 5);
+    alg::dense_state_store<alg::job_state, std::uint32_t, decltype(encoder)> store(encoder);
+    assert(store.insert({3,2}, 7) && !store.insert({3,2}, 8) && *store.find({3,2}) == 7);
+    std::uint32_t num_thrown = 0;
+    try { store.insert({10,0}, 1); } catch(const std::out_of_range&) { ++num_thrown; }
+    try { store[{0,5}] = 1;        } catch(const std::out_of_range&) { ++num_thrown; }
+    assert(num_thrown == 2 && store.size() == 1);
+
     std::uint32_t num_trial = 1000;
     benchmark<1>("job_schedule ------------ graph vs matrix (iterative)",           
                  std::bind(gen_random_jobs, 30, 2, 20, 2, 30, 10, 250), 
-                 std::bind(alg::job_schedule_iterative_in_graph,  _1),      
+                 std::bind(alg::job_schedule_iterative_in_graph,  _1, 1),      
                  std::bind(alg::job_schedule_iterative_in_matrix, _1),
                  num_trial); 
+
+    benchmark<1>("job_schedule ------------ unordered_map vs dense store (graph)",           
+                 std::bind(gen_random_jobs, 30, 2, 20, 2, 30, 10, 250), 
+                 std::bind(job_schedule_in_unordered_map, _1),      
+                 std::bind(alg::job_schedule_iterative_in_graph, _1, 1),
+                 num_trial); 
+
+    benchmark<1>("job_schedule ------------ unordered_map vs flat store (graph)",           
+                 std::bind(gen_random_jobs, 30, 2, 20, 2, 30, 10, 250), 
+                 std::bind(job_schedule_in_unordered_map, _1),      
+                 std::bind(job_schedule_in_flat_store, _1),
+                 num_trial); 
+
+    num_trial = 10;
+    benchmark<1>("job_schedule ------------ single thread vs multithread (graph)",           
+                 std::bind(gen_random_jobs, 60, 2, 20, 2, 30, 10, 500), 
+                 std::bind(alg::job_schedule_iterative_in_graph, _1, 1),      
+                 std::bind(alg::job_schedule_iterative_in_graph, _1, 4),
+                 num_trial); 
 }
 
 
@@ -80,20 +218,65 @@ void test_equal_partition()
     std::uint32_t num_trial = 1000;
     benchmark<1>("equal_partition --------- graph vs matrix (iterative)",           
                  std::bind(gen_random_vec<std::uint32_t>, 25, 2, 50), 
-                 std::bind(alg::equal_partition_iterative_in_graph,  _1),      
+                 std::bind(alg::equal_partition_iterative_in_graph,  _1, 1),      
+                 std::bind(alg::equal_partition_iterative_in_matrix, _1), 
+                 num_trial);  
+
+    benchmark<1>("equal_partition --------- matrix vs bitset",           
+                 std::bind(gen_random_vec<std::uint32_t>, 25, 2, 500), 
                  std::bind(alg::equal_partition_iterative_in_matrix, _1), 
+                 std::bind(alg::equal_partition_bitset, _1, 1), 
+                 num_trial);  
+
+    benchmark<1>("equal_partition --------- dense store vs flat store (graph)",           
+                 std::bind(gen_random_vec<std::uint32_t>, 25, 2, 50), 
+                 std::bind(alg::equal_partition_iterative_in_graph, _1, 1),      
+                 std::bind(equal_partition_in_flat_store, _1, 1), 
                  num_trial);  
+
+    num_trial = 10;
+    benchmark<1>("equal_partition --------- single thread vs multithread (graph)",           
+                 std::bind(gen_random_vec<std::uint32_t>, 60, 2, 200), 
+                 std::bind(alg::equal_partition_iterative_in_graph, _1, 1),      
+                 std::bind(alg::equal_partition_iterative_in_graph, _1, 4), 
+                 num_trial);  
+
+    benchmark<1>("equal_partition --------- bitset single thread vs multithread",           
+                 std::bind(gen_random_vec<std::uint32_t>, 100, 1000, 100000), 
+                 std::bind(alg::equal_partition_bitset, _1, 1), 
+                 std::bind(alg::equal_partition_bitset, _1, 4), 
+                 num_trial);  
+
+    // Sum of numbers is about 2 x 10^8, i.e. 10^8 states in 1.5M words
+    auto numbers = gen_random_vec<std::uint32_t>(200, 1, 2000000);
+    alg::timer timer;
+    timer.click();
+    auto ans = alg::equal_partition_bitset(numbers, 4);
+    timer.click();
+    assert(alg::subset_sum_bitset(numbers, ans));
+    print_summary("equal_partition bitset, 200 numbers, half sum 10^8", 
+                  "ans = " + std::to_string(ans) + ", time = " + std::to_string(timer.time_elapsed_in_nsec()/1000000) + " ms");
 }
 
 
 void test_box_stacking()
 {
     std::uint32_t num_trial = 1000;
+    auto corpus0 = alg::load_or_generate_corpus<box>("boxes", 1, num_trial, gen_random_boxes, 80,  5, 50);
+    auto corpus1 = alg::load_or_generate_corpus<box>("boxes", 1, 100,       gen_random_boxes, 100, 5, 50);
+
     benchmark<1>("box_stacking ------------ graph vs matrix (iterative)",           
-                 std::bind(gen_random_boxes, 80, 5, 50), 
-                 std::bind(alg::box_stacking_iterative_in_graph,  _1),      
+                 corpus0.reader(), 
+                 std::bind(alg::box_stacking_iterative_in_graph,  _1, 1),      
                  std::bind(alg::box_stacking_iterative_in_matrix, _1), 
                  num_trial); 
+
+    num_trial = 100;
+    benchmark<1>("box_stacking ------------ single thread vs multithread (graph)",           
+                 corpus1.reader(), 
+                 std::bind(alg::box_stacking_iterative_in_graph, _1, 1),      
+                 std::bind(alg::box_stacking_iterative_in_graph, _1, 4), 
+                 num_trial); 
 }
 
 
@@ -1,9 +1,13 @@
 #include<iostream>
 #include<iomanip>
 #include<cassert>
+#include<thread>
 
 // from alg
 #include<dp_matrix_only.h>
+#include<dp_wavefront.h>
+#include<dp_interval.h>
+#include<corpus.h>
 #include<utility.h>
 
 
@@ -17,6 +21,18 @@ void test_longest_common_subseq()
                  std::bind(alg::longest_common_subseq_recursive, _1, _2),
                  std::bind(alg::longest_common_subseq_iterative, _1, _2),      
                  num_trial);
+
+    benchmark<2>("longest_common_subseq --- recursive vs memoized",
+                 std::bind(gen_random_str, str_size, num_alphabets), 
+                 std::bind(alg::longest_common_subseq_recursive, _1, _2),
+                 std::bind(alg::longest_common_subseq_memoized,  _1, _2),      
+                 num_trial);
+
+    benchmark<2>("longest_common_subseq --- iterative (matrix) vs memoized, size 500",
+                 std::bind(gen_random_str, 500, num_alphabets), 
+                 std::bind(alg::longest_common_subseq_iterative, _1, _2),
+                 std::bind(alg::longest_common_subseq_memoized,  _1, _2),      
+                 num_trial);
 }
 
 
@@ -30,8 +46,60 @@ void test_edit_distance()
                  std::bind(alg::edit_distance_recursive, _1, _2),
                  std::bind(alg::edit_distance_iterative, _1, _2),      
                  num_trial);
+
+    benchmark<2>("edit_distance ----------- recursive vs memoized",
+                 std::bind(gen_random_str, str_size, num_alphabets), 
+                 std::bind(alg::edit_distance_recursive, _1, _2),
+                 std::bind(alg::edit_distance_memoized,  _1, _2),      
+                 num_trial);
+
+    benchmark<2>("edit_distance ----------- iterative (matrix) vs memoized, size 500",
+                 std::bind(gen_random_str, 500, num_alphabets), 
+                 std::bind(alg::edit_distance_iterative, _1, _2),
+                 std::bind(alg::edit_distance_memoized,  _1, _2),      
+                 num_trial);
 }
 
+
+// Threads solve different suffix pairs of the same strings, sharing one striped cache
+template<typename CACHE>
+void test_edit_distance_shared_memo(const std::string& name, CACHE& cache)
+{
+    std::uint32_t num_threads = 4;
+    std::uint32_t str_size    = 600;
+    auto str0 = gen_random_str(str_size, 4);
+    auto str1 = gen_random_str(str_size, 4);
+
+    std::vector<std::uint32_t> ans(num_threads);
+    std::vector<std::thread> threads;
+    for(std::uint32_t t=0; t!=num_threads; ++t)
+    {
+        threads.emplace_back([&, t]()
+        {
+            ans[t] = alg::edit_distance_memoized_impl(str0, str1, 50*t, 30*t, cache);
+        });
+    }
+    for(auto& x:threads) x.join();
+
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_threads; ++t)
+    {
+        if (ans[t] != alg::edit_distance_iterative(str0.substr(50*t), str1.substr(30*t))) ++num_error;
+    }
+    print_summary(name, num_error, num_threads);
+}
+
+void test_edit_distance_shared_memo()
+{
+    alg::direct_mapped_memo<std::uint32_t, alg::spinlock> cache0(601 * 601);
+    alg::flat_memo<std::uint32_t, std::mutex> cache1;
+    alg::dense_memo<std::uint32_t, alg::spinlock> cache2(601, 601);
+    test_edit_distance_shared_memo("edit_distance ----------- memoized, shared direct mapped table", cache0);
+    test_edit_distance_shared_memo("edit_distance ----------- memoized, shared flat hash table", cache1);
+    test_edit_distance_shared_memo("edit_distance ----------- memoized, shared dense table", cache2);
+}
+
+
 void print(const auto& tree_perms)
 {
     std::uint32_t n=0;
@@ -53,11 +121,31 @@ void test_boolean_parenthesis()
 
     std::uint32_t num_trial  = 100;
     std::uint32_t input_size = 9;
+    auto corpus0 = alg::load_or_generate_corpus<bool_symbol>("bool_expression", 1, num_trial, gen_random_bool_expression, input_size);
+    auto corpus1 = alg::load_or_generate_corpus<bool_symbol>("bool_expression", 1, 10,        gen_random_bool_expression, 200);
+
     benchmark<1>("bool_parenthesis -------- exhaustive vs iterative",
-                 std::bind(gen_random_bool_expression, input_size), 
+                 corpus0.reader(), 
                  std::bind(alg::bool_parenthesis_exhaustive, _1),      
                  std::bind(alg::bool_parenthesis_iterative,  _1),
                  num_trial); 
+
+    benchmark<1>("bool_parenthesis -------- exhaustive vs interval, tile 2",
+                 corpus0.reader(), 
+                 std::bind(alg::bool_parenthesis_exhaustive, _1),      
+                 std::bind(alg::bool_parenthesis_interval,   _1, 1, 2),
+                 num_trial); 
+
+    for(std::uint32_t num_threads : {1,4})
+    {
+        std::stringstream ss;
+        ss << "bool_parenthesis -------- iterative vs interval, size 200, threads " << num_threads;
+        benchmark<1>(ss.str(),
+                     corpus1.reader(), 
+                     std::bind(alg::bool_parenthesis_iterative, _1),      
+                     std::bind(alg::bool_parenthesis_interval,  _1, num_threads, 8),
+                     10); 
+    }
 }
 
 
@@ -70,6 +158,127 @@ void test_coin_game()
                  std::bind(alg::coin_game_recursive, _1),
                  std::bind(alg::coin_game_iterative, _1),      
                  num_trial); 
+
+    benchmark<1>("coin_game --------------- recursive vs memoized",
+                 std::bind(gen_random_vec<std::uint32_t>, input_size, 1, 20), 
+                 std::bind(alg::coin_game_recursive, _1),
+                 std::bind(alg::coin_game_memoized,  _1),      
+                 num_trial); 
+
+    benchmark<1>("coin_game --------------- iterative vs memoized, size 1000",
+                 std::bind(gen_random_vec<std::uint32_t>, 1000, 1, 20), 
+                 std::bind(alg::coin_game_iterative, _1),
+                 std::bind(alg::coin_game_memoized,  _1),      
+                 num_trial); 
+
+    for(std::uint32_t num_threads : {1,4})
+    {
+        std::stringstream ss;
+        ss << "coin_game --------------- iterative vs interval, size 1000, threads " << num_threads;
+        benchmark<1>(ss.str(),
+                     std::bind(gen_random_vec<std::uint32_t>, 1000, 1, 20), 
+                     std::bind(alg::coin_game_iterative, _1),
+                     std::bind(alg::coin_game_interval,  _1, num_threads, 16),      
+                     num_trial); 
+    }
+}
+
+
+// Small tile size, so that many tiles are scheduled in dependency order
+std::uint32_t longest_common_subseq_small_tile(const std::string& str0, const std::string& str1, std::uint32_t num_threads)
+{
+    return alg::wavefront_last_row<std::uint32_t>(str0.size(), str1.size(),
+        [](std::uint32_t) { return 0u; },
+        [](std::uint32_t) { return 0u; },
+        [&](std::int64_t i, std::int64_t j, std::uint32_t up, std::uint32_t left, std::uint32_t diag)
+        {
+            return str0[i]==str1[j]? diag+1 : std::max(up, left);
+        },
+        num_threads, 7).back();
+}
+
+std::uint32_t edit_distance_small_tile(const std::string& str0, const std::string& str1, std::uint32_t num_threads)
+{
+    return alg::wavefront_last_row<std::uint32_t>(str0.size(), str1.size(),
+        [](std::uint32_t j) { return j; },
+        [](std::uint32_t i) { return i; },
+        [&](std::int64_t i, std::int64_t j, std::uint32_t up, std::uint32_t left, std::uint32_t diag)
+        {
+            return str0[i]==str1[j]? diag : std::min(diag, std::min(up, left)) + 1;
+        },
+        num_threads, 7).back();
+}
+
+// Script must have as many edits as the distance, and convert str0 into str1
+bool is_valid_alignment(const std::string& str0, const std::string& str1, const std::string& ops, std::uint32_t distance)
+{
+    std::string out;
+    std::uint32_t i = 0;
+    std::uint32_t j = 0;
+    std::uint32_t num_edits = 0;
+    for(char op:ops)
+    {
+        if      (op == 'M') { if (str0[i] != str1[j]) return false; out.push_back(str0[i]); ++i; ++j; }
+        else if (op == 'S') { out.push_back(str1[j]); ++i; ++j; ++num_edits; }
+        else if (op == 'D') { ++i; ++num_edits; }
+        else if (op == 'I') { out.push_back(str1[j]); ++j; ++num_edits; }
+        if (i > str0.size() || j > str1.size()) return false;
+    }
+    return i == str0.size() && out == str1 && num_edits == distance;
+}
+
+void test_wavefront()
+{
+    std::uint32_t num_trial     = 100;
+    std::uint32_t str_size      = 60;
+    std::uint32_t num_alphabets = 4;
+    benchmark<2>("longest_common_subseq --- iterative (matrix) vs wavefront",
+                 std::bind(gen_random_str, str_size, num_alphabets), 
+                 std::bind(alg::longest_common_subseq_iterative, _1, _2),
+                 std::bind(longest_common_subseq_small_tile, _1, _2, 3),
+                 num_trial);
+
+    benchmark<2>("edit_distance ----------- iterative (matrix) vs wavefront",
+                 std::bind(gen_random_str, str_size, num_alphabets), 
+                 std::bind(alg::edit_distance_iterative, _1, _2),
+                 std::bind(edit_distance_small_tile, _1, _2, 3),
+                 num_trial);
+
+    benchmark<1>("coin_game --------------- iterative vs wavefront",
+                 std::bind(gen_random_vec<std::uint32_t>, 101, 1, 20), 
+                 std::bind(alg::coin_game_iterative, _1),
+                 std::bind(alg::coin_game_wavefront, _1, 1),      
+                 num_trial); 
+
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        auto str0 = gen_random_str(std::rand() % 600, num_alphabets);
+        auto str1 = gen_random_str(std::rand() % 600, num_alphabets);
+        auto ops  = alg::edit_distance_alignment(str0, str1, 1+t%3);
+        if (!is_valid_alignment(str0, str1, ops, alg::edit_distance_wavefront(str0, str1))) ++num_error;
+    }
+    print_summary("edit_distance_alignment (Hirschberg)", num_error, num_trial);
+
+    // Large input, O(N) memory, the matrix version needs 8K x 8K x 4 bytes
+    std::uint32_t size = 1 << 13;
+    auto str0 = gen_random_str(size, num_alphabets);
+    auto str1 = gen_random_str(size, num_alphabets);
+    auto coins = gen_random_vec<std::uint32_t>(size, 1, 100);
+    alg::timer timer;
+    for(std::uint32_t num_threads : {1, 4})
+    {
+        timer.click();
+        auto ans0 = alg::longest_common_subseq_wavefront(str0, str1, num_threads);
+        auto ans1 = alg::edit_distance_wavefront(str0, str1, num_threads);
+        auto ans2 = alg::coin_game_wavefront(coins, num_threads);
+        timer.click();
+
+        std::stringstream ss;
+        ss << "LCS / edit_distance / coin_game wavefront, 8K, threads " << num_threads;
+        print_summary(ss.str(), "ans = " + std::to_string(ans0) + "/" + std::to_string(ans1) + "/" + std::to_string(ans2) + 
+                                ", time = " + std::to_string(timer.time_elapsed_in_nsec()/1000000) + " ms");
+    }
 }
 
 
@@ -100,14 +309,95 @@ void test_piecewise_linear_regression(double noise_level)
 }
 
 
+void test_piecewise_linear_prefix_sum()
+{
+    std::uint32_t num_trial = 100;
+    std::uint32_t num_lines =   8;
+    std::uint32_t num_error[5] = {0,0,0,0,0};
+    std::uint32_t num_exact[2] = {0,0};
+    std::uint32_t slack = 32;
+
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        auto ys = gen_random_piecewise_linear(num_lines, 2, 20, 0.5);
+        double ans0 = alg::piecewise_linear_equation(ys, num_lines);
+        auto   ans1 = alg::piecewise_linear_regression(ys, num_lines, alg::segment_fit::interpolation, alg::piecewise_method::exhaustive);
+        auto   ans2 = alg::piecewise_linear_regression(ys, num_lines, alg::segment_fit::interpolation, alg::piecewise_method::divide_and_conquer, slack);
+        auto   ans3 = alg::piecewise_linear_regression(ys, num_lines, alg::segment_fit::least_squares,  alg::piecewise_method::exhaustive);
+        auto   ans4 = alg::piecewise_linear_regression(ys, num_lines, alg::segment_fit::least_squares,  alg::piecewise_method::divide_and_conquer, slack);
+
+        auto differ = [](double x, double y) { return std::fabs(x-y) > 1e-6 * std::max(1.0, std::fabs(x)); };
+        if (differ(ans0, ans1.error)) ++num_error[0];
+        if (differ(ans1.error, alg::piecewise_linear_error(ys, ans1.breakpoints, alg::segment_fit::interpolation))) ++num_error[1];
+        if (differ(ans3.error, alg::piecewise_linear_error(ys, ans3.breakpoints, alg::segment_fit::least_squares)))  ++num_error[2];
+        if (ans3.error > ans1.error + 1e-6) ++num_error[3]; // least squares never worse, as it has more freedom
+        if (differ(ans2.error, alg::piecewise_linear_error(ys, ans2.breakpoints, alg::segment_fit::interpolation)) ||
+            differ(ans4.error, alg::piecewise_linear_error(ys, ans4.breakpoints, alg::segment_fit::least_squares)) ||
+            ans2.error < ans1.error - 1e-6 || 
+            ans4.error < ans3.error - 1e-6) ++num_error[4];
+
+        if (!differ(ans1.error, ans2.error)) ++num_exact[0]; // divide and conquer may be above optimum
+        if (!differ(ans3.error, ans4.error)) ++num_exact[1];
+    }
+
+    print_summary("piecewise linear, prefix sum vs original",                    num_error[0], num_trial);
+    print_summary("piecewise linear, breakpoints reproduce error (interpolation)", num_error[1], num_trial);
+    print_summary("piecewise linear, breakpoints reproduce error (least squares)", num_error[2], num_trial);
+    print_summary("piecewise linear, least squares <= interpolation",             num_error[3], num_trial);
+    print_summary("piecewise linear, divide and conquer is feasible",              num_error[4], num_trial);
+
+    std::stringstream ss;
+    ss << "optimum found = " << num_exact[0] << "/" << num_exact[1] << " of " << num_trial;
+    print_summary("piecewise linear, divide and conquer vs exhaustive, slack " + std::to_string(slack), ss.str());
+
+    // Offset like prices, error and breakpoints are invariant, as prefix sums are of y - mean
+    std::uint32_t num_offset_error = 0;
+    for(auto fit : {alg::segment_fit::interpolation, alg::segment_fit::least_squares})
+    {
+        auto ys0 = gen_random_piecewise_linear(50, 1000, 3000, 0.01);
+        auto ys1 = ys0;
+        for(auto& y:ys1) y += 1e6;
+        auto ans0 = alg::piecewise_linear_regression(ys0, 50, fit, alg::piecewise_method::divide_and_conquer, slack);
+        auto ans1 = alg::piecewise_linear_regression(ys1, 50, fit, alg::piecewise_method::divide_and_conquer, slack);
+        double exact = alg::piecewise_linear_error(ys1, ans1.breakpoints, fit);
+        if (std::fabs(ans1.error - ans0.error) > 1e-3 * ans0.error) ++num_offset_error;
+        if (std::fabs(ans1.error - exact)      > 1e-3 * exact)      ++num_offset_error;
+        for(std::uint32_t n=0; n!=ans0.breakpoints.size(); ++n) // near ties may move by one
+        {
+            if (std::abs((std::int64_t)ans1.breakpoints[n] - ans0.breakpoints[n]) > 1) { ++num_offset_error; break; }
+        }
+    }
+    print_summary("piecewise linear, 10^5 points with offset 10^6 vs without", num_offset_error, 6);
+
+    // Large : 10^5 points, 50 lines
+    for(auto fit : {alg::segment_fit::interpolation, alg::segment_fit::least_squares})
+    {
+        auto ys = gen_random_piecewise_linear(50, 1000, 3000, 0.5);
+        alg::timer timer;
+        timer.click();
+        auto ans = alg::piecewise_linear_regression(ys, 50, fit, alg::piecewise_method::divide_and_conquer, slack);
+        timer.click();
+
+        std::stringstream ss;
+        ss << "piecewise linear, divide and conquer, " << ys.size() << " points, 50 lines, " 
+           << (fit == alg::segment_fit::interpolation? "interpolation" : "least squares");
+        print_summary(ss.str(), "rms = " + std::to_string(std::sqrt(ans.error / ys.size())) + 
+                                ", time = " + std::to_string(timer.time_elapsed_in_nsec()/1000000) + " ms");
+    }
+}
+
+
 void test_dp_matrix_only()
 {
     test_longest_common_subseq();
     test_edit_distance();
+    test_edit_distance_shared_memo();
     test_boolean_parenthesis();
     test_coin_game();
+    test_wavefront();
     test_piecewise_linear_regression(0.1);
     test_piecewise_linear_regression(0.5);
     test_piecewise_linear_regression(1.0);
     test_piecewise_linear_regression(5.0);
+    test_piecewise_linear_prefix_sum();
 }
@@ -0,0 +1,408 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<cstdlib>
+#include<string>
+#include<vector>
+#include<span>
+#include<atomic>
+#include<thread>
+#include<functional>
+#include<fstream>
+#include<sstream>
+#include<filesystem>
+#include<ranges>
+#include<stdexcept>
+#include<type_traits>
+#include<utility>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+// from alg
+#include<matrix_mmap.h>
+#include<prng.h>
+#include<utility.h>
+
+
+// ************************************************************************************ //
+// *** Deterministic test corpus *** //
+// ************************************************************************************ //
+// A corpus is num_records inputs of a test, each record is a variable length array of T,
+// made by a nullary generator, such as std::bind(gen_random_boxes, 80, 5, 50).
+//
+// Determinism : before record n is generated, the thread local random_gen() of utility.h
+// is reseeded with corpus_seed(seed, n), hence record n depends on (seed, n) only, but not
+// on number of threads, nor on which thread generates it. Records are sharded in blocks of
+// corpus_shard_size, threads take shards from an atomic counter, and shards are concatenated
+// in order.
+//
+// File format, native endian :
+// * corpus_header of 64 bytes, with magic, dtype, element size, seed, number of records and
+//   fingerprint of generator
+// * offsets of num_records + 1 uint64, record n is data[offsets[n], offsets[n+1])
+// * zero padding up to data offset, which is multiple of 64
+// * raw data of T
+//
+// load_or_generate_corpus takes generator function and its arguments, rather than a bound
+// generator, so that cache key is made of the same arguments : file name is name of function
+// followed by arguments, seed, number of records and fingerprint, which hashes the name with
+// corpus_generator_version. Valid cached file with same fingerprint is mapped, else corpus is
+// generated in parallel, saved to temporary file and renamed, so that concurrent runs never
+// see a partial file. Bump corpus_generator_version when generators in utility.h or engines in
+// prng.h change their output.
+// ************************************************************************************ //
+namespace alg
+{
+    inline std::uint64_t corpus_seed(std::uint64_t seed, std::uint64_t index) noexcept
+    {
+        splitmix64 sm(seed);
+        sm.advance(index);
+        return sm();
+    }
+
+    struct corpus_header
+    {
+        static constexpr char          magic[8] = {'A','L','G','C','O','R','P','\0'};
+        static constexpr std::uint32_t version  = 2;
+
+        char          m_magic[8];
+        std::uint32_t m_version;
+        mapped_dtype  m_dtype;
+        std::uint32_t m_elem_size;
+        std::uint32_t m_reserved;
+        std::uint64_t m_seed;
+        std::uint64_t m_num_records;
+        std::uint64_t m_data_offset;
+        std::uint64_t m_data_size; // number of T
+        std::uint64_t m_fingerprint;
+    };
+    static_assert(sizeof(corpus_header) == 64);
+    static_assert(std::is_trivially_copyable_v<corpus_header>);
+
+    template<typename T>
+    struct corpus
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        std::span<const T> operator[](std::uint64_t n) const noexcept
+        {
+            return std::span<const T>(m_data.data() + m_offsets[n], m_offsets[n+1] - m_offsets[n]);
+        }
+
+        std::uint64_t size() const noexcept
+        {
+            return m_offsets.size() - 1;
+        }
+
+        std::uint64_t              m_seed = 0;
+        std::vector<std::uint64_t> m_offsets = {0};
+        std::vector<T>             m_data;
+    };
+}
+
+
+// ****************** //
+// *** Generation *** //
+// ****************** //
+namespace alg
+{
+    inline constexpr std::uint64_t corpus_shard_size = 64;
+
+    // GEN is nullary, returns contiguous range of T, e.g. std::vector<T>
+    template<typename T, typename GEN>
+    corpus<T> generate_corpus(std::uint64_t seed, std::uint64_t num_records, const GEN& gen,
+                              std::uint32_t num_threads = std::thread::hardware_concurrency())
+    {
+        using record_type = std::invoke_result_t<const GEN&>;
+        static_assert(std::ranges::contiguous_range<record_type>);
+        static_assert(std::is_same_v<std::ranges::range_value_t<record_type>, T>);
+
+        struct shard
+        {
+            std::vector<std::uint64_t> m_sizes;
+            std::vector<T>             m_data;
+        };
+        std::uint64_t num_shards = (num_records + corpus_shard_size - 1) / corpus_shard_size;
+        std::vector<shard> shards(num_shards);
+        std::atomic<std::uint64_t> next_shard{0};
+
+        auto thread_fct = [&]()
+        {
+            // Thread may be caller, restore its stream afterwards
+            auto saved = random_gen();
+            for(std::uint64_t s = next_shard.fetch_add(1); s < num_shards; s = next_shard.fetch_add(1))
+            {
+                std::uint64_t n1 = std::min(num_records, (s+1) * corpus_shard_size);
+                for(std::uint64_t n = s * corpus_shard_size; n != n1; ++n)
+                {
+                    set_random_seed(corpus_seed(seed, n));
+                    auto record = gen();
+                    shards[s].m_sizes.push_back(std::ranges::size(record));
+                    shards[s].m_data.insert(shards[s].m_data.end(), std::ranges::begin(record), std::ranges::end(record));
+                }
+            }
+            random_gen() = saved;
+        };
+
+        num_threads = std::max<std::uint32_t>(1, std::min<std::uint64_t>(num_threads, num_shards));
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=1; t<num_threads; ++t) threads.emplace_back(thread_fct);
+        thread_fct();
+        for(auto& x:threads) x.join();
+
+        corpus<T> ans;
+        ans.m_seed = seed;
+        ans.m_offsets.reserve(num_records + 1);
+        for(const auto& x:shards)
+        {
+            for(auto size : x.m_sizes) ans.m_offsets.push_back(ans.m_offsets.back() + size);
+        }
+        ans.m_data.reserve(ans.m_offsets.back());
+        for(auto& x:shards)
+        {
+            ans.m_data.insert(ans.m_data.end(), x.m_data.begin(), x.m_data.end());
+            std::vector<T>().swap(x.m_data);
+        }
+        return ans;
+    }
+
+    // Write to temporary then rename, rename is atomic in same file system
+    template<typename T>
+    void save_corpus(const std::string& path, const corpus<T>& cor, std::uint64_t fingerprint = 0)
+    {
+        corpus_header header{};
+        std::memcpy(header.m_magic, corpus_header::magic, sizeof(corpus_header::magic));
+        header.m_version     = corpus_header::version;
+        header.m_dtype       = dtype_of<T>();
+        header.m_elem_size   = sizeof(T);
+        header.m_seed        = cor.m_seed;
+        header.m_num_records = cor.size();
+        header.m_data_offset = (sizeof(corpus_header) + cor.m_offsets.size() * sizeof(std::uint64_t) + 63) / 64 * 64;
+        header.m_data_size   = cor.m_data.size();
+        header.m_fingerprint = fingerprint;
+
+        std::string temp = path + ".tmp" + std::to_string(::getpid());
+        {
+            std::ofstream ofs(temp, std::ios::binary | std::ios::trunc);
+            if (!ofs) throw std::runtime_error("save_corpus : cannot open " + temp);
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            ofs.write(reinterpret_cast<const char*>(cor.m_offsets.data()), cor.m_offsets.size() * sizeof(std::uint64_t));
+            std::string padding(header.m_data_offset - sizeof(header) - cor.m_offsets.size() * sizeof(std::uint64_t), '\0');
+            ofs.write(padding.data(), padding.size());
+            ofs.write(reinterpret_cast<const char*>(cor.m_data.data()), cor.m_data.size() * sizeof(T));
+            if (!ofs) throw std::runtime_error("save_corpus : cannot write " + temp);
+        }
+        std::filesystem::rename(temp, path);
+    }
+}
+
+
+// ********************* //
+// *** Mapped corpus *** //
+// ********************* //
+namespace alg
+{
+    template<typename T> class corpus_reader;
+
+    template<typename T>
+    class mapped_corpus
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        explicit mapped_corpus(const std::string& path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("mapped_corpus : cannot open " + path);
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || (std::uint64_t)st.st_size < sizeof(corpus_header))
+            {
+                ::close(fd);
+                throw std::runtime_error("mapped_corpus : file too small " + path);
+            }
+
+            m_map_bytes = st.st_size;
+            m_map = ::mmap(nullptr, m_map_bytes, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (m_map == MAP_FAILED)
+            {
+                m_map = nullptr;
+                throw std::runtime_error("mapped_corpus : mmap failed " + path);
+            }
+
+            std::memcpy(&m_header, m_map, sizeof(corpus_header));
+            m_offsets = reinterpret_cast<const std::uint64_t*>(static_cast<const char*>(m_map) + sizeof(corpus_header));
+            m_data    = reinterpret_cast<const T*>(static_cast<const char*>(m_map) + m_header.m_data_offset);
+            if (!is_valid())
+            {
+                unmap();
+                throw std::runtime_error("mapped_corpus : invalid header or dtype " + path);
+            }
+        }
+
+        ~mapped_corpus()
+        {
+            unmap();
+        }
+
+        mapped_corpus(const mapped_corpus&) = delete;
+        mapped_corpus& operator=(const mapped_corpus&) = delete;
+
+        mapped_corpus(mapped_corpus&& rhs) noexcept
+            : m_map(std::exchange(rhs.m_map, nullptr)),
+              m_map_bytes(std::exchange(rhs.m_map_bytes, 0)),
+              m_offsets(std::exchange(rhs.m_offsets, nullptr)),
+              m_data(std::exchange(rhs.m_data, nullptr)),
+              m_header(rhs.m_header)
+        {
+        }
+
+    public:
+        std::span<const T> operator[](std::uint64_t n) const noexcept
+        {
+            return std::span<const T>(m_data + m_offsets[n], m_offsets[n+1] - m_offsets[n]);
+        }
+
+        std::uint64_t size() const noexcept { return m_header.m_num_records; }
+        std::uint64_t seed() const noexcept { return m_header.m_seed;        }
+        std::uint64_t fingerprint() const noexcept { return m_header.m_fingerprint; }
+        const corpus_header& header() const noexcept { return m_header; }
+
+        // Nullary generator for benchmark() in utility.h, corpus must outlive reader
+        corpus_reader<T> reader() const
+        {
+            return corpus_reader<T>(*this);
+        }
+
+    private:
+        bool is_valid() const noexcept
+        {
+            if (std::memcmp(m_header.m_magic, corpus_header::magic, sizeof(corpus_header::magic)) != 0) return false;
+            if (m_header.m_version   != corpus_header::version) return false;
+            if (m_header.m_dtype     != dtype_of<T>())          return false;
+            if (m_header.m_elem_size != sizeof(T))              return false;
+            if (m_header.m_num_records == 0)                    return false;
+            if (m_header.m_num_records >= m_map_bytes / sizeof(std::uint64_t)) return false;
+
+            std::uint64_t offsets_end = sizeof(corpus_header) + (m_header.m_num_records + 1) * sizeof(std::uint64_t);
+            if (m_header.m_data_offset < offsets_end || m_header.m_data_offset % alignof(T) != 0) return false;
+            if (m_header.m_data_offset + m_header.m_data_size * sizeof(T) > m_map_bytes)        return false;
+
+            // Offsets are checked once, so that operator[] never reads out of file
+            if (m_offsets[0] != 0 || m_offsets[m_header.m_num_records] != m_header.m_data_size) return false;
+            for(std::uint64_t n=0; n!=m_header.m_num_records; ++n)
+            {
+                if (m_offsets[n] > m_offsets[n+1]) return false;
+            }
+            return true;
+        }
+
+        void unmap() noexcept
+        {
+            if (m_map) ::munmap(m_map, m_map_bytes);
+            m_map = nullptr;
+        }
+
+    private:
+        void*                m_map       = nullptr;
+        std::uint64_t        m_map_bytes = 0;
+        const std::uint64_t* m_offsets   = nullptr;
+        const T*             m_data      = nullptr;
+        corpus_header        m_header    = {};
+    };
+
+    // Copies records in turn, wraps around, operator() is const as benchmark() takes
+    // generator by const reference
+    template<typename T>
+    class corpus_reader
+    {
+    public:
+        explicit corpus_reader(const mapped_corpus<T>& cor) : m_corpus(cor)
+        {
+        }
+
+        std::vector<T> operator()() const
+        {
+            auto record = m_corpus[m_next];
+            m_next = (m_next + 1) % m_corpus.size();
+            return std::vector<T>(record.begin(), record.end());
+        }
+
+    private:
+        const mapped_corpus<T>& m_corpus;
+        mutable std::uint64_t   m_next = 0;
+    };
+}
+
+
+// ******************** //
+// *** Corpus cache *** //
+// ******************** //
+namespace alg
+{
+    // Environment variable ALG_CORPUS_DIR overrides default
+    inline std::filesystem::path corpus_cache_dir()
+    {
+        const char* dir = std::getenv("ALG_CORPUS_DIR");
+        std::filesystem::path ans = dir? std::filesystem::path(dir) : std::filesystem::temp_directory_path() / "alg_corpus";
+        std::filesystem::create_directories(ans);
+        return ans;
+    }
+
+    inline constexpr std::uint64_t corpus_generator_version = 1;
+
+    // Name followed by arguments, e.g. "boxes_80_5_50"
+    template<typename... ARGS>
+    std::string corpus_name(const std::string& name, const ARGS&... args)
+    {
+        std::ostringstream ss;
+        ss << name;
+        ((ss << "_" << args), ...);
+        return ss.str();
+    }
+
+    // FNV-1a
+    inline std::uint64_t corpus_fingerprint(const std::string& full_name) noexcept
+    {
+        std::uint64_t ans = 0xcbf29ce484222325ULL ^ corpus_generator_version;
+        for(unsigned char c : full_name) ans = (ans ^ c) * 0x100000001b3ULL;
+        return ans;
+    }
+
+    inline std::string corpus_path(const std::string& full_name, std::uint64_t seed, std::uint64_t num_records)
+    {
+        std::ostringstream ss;
+        ss << full_name << "_" << seed << "_" << num_records << "_" << std::hex << corpus_fingerprint(full_name) << ".bin";
+        return (corpus_cache_dir() / ss.str()).string();
+    }
+
+    // Record is fct(args...), e.g. load_or_generate_corpus<box>("boxes", seed, 1000, gen_random_boxes, 80, 5, 50)
+    template<typename T, typename FCT, typename... ARGS>
+    mapped_corpus<T> load_or_generate_corpus(const std::string& name, std::uint64_t seed, std::uint64_t num_records,
+                                             const FCT& fct, const ARGS&... args)
+    {
+        if (num_records == 0) throw std::invalid_argument("load_or_generate_corpus : no record");
+
+        std::string full_name = corpus_name(name, args...);
+        std::uint64_t fingerprint = corpus_fingerprint(full_name);
+        std::string path = corpus_path(full_name, seed, num_records);
+        if (std::filesystem::exists(path))
+        {
+            try
+            {
+                mapped_corpus<T> ans(path);
+                if (ans.seed() == seed && ans.size() == num_records && ans.fingerprint() == fingerprint) return ans;
+            }
+            catch(const std::runtime_error&)
+            {
+                // corrupted or older version, regenerate
+            }
+        }
+        auto gen = [&]() { return std::invoke(fct, args...); };
+        save_corpus(path, generate_corpus<T>(seed, num_records, gen), fingerprint);
+        return mapped_corpus<T>(path);
+    }
+}
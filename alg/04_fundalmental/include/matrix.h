@@ -2,7 +2,14 @@
 #include<iostream>
 #include<iomanip>
 #include<cstdint>
+#include<cstddef>
+#include<limits>
+#include<numeric>
+#include<new>
 #include<vector>
+#include<string>
+#include<type_traits>
+#include<utility>
 
 
 namespace alg
@@ -24,7 +31,19 @@ namespace alg
 
 namespace alg
 {
-    template<typename T>
+    enum class matrix_layout : std::uint8_t
+    {
+        row_major,
+        col_major,
+        tiled
+    };
+
+    template<typename T, matrix_layout LAYOUT = matrix_layout::row_major>
+    class matrix_view;
+
+    // STORAGE is std::vector<T> by default, or any contiguous container with operator[],
+    // data() and size(), such as mapped_storage<T> in matrix_mmap.h, which is move only
+    template<typename T, typename STORAGE = std::vector<T>>
     class matrix
     {
     public:
@@ -32,7 +51,7 @@ namespace alg
                std::uint32_t size_x)
                : m_size_y(size_y), 
                  m_size_x(size_x),
-                 m_impl(size_y * size_x)
+                 m_impl((std::uint64_t)size_y * size_x)
         {
         }
 
@@ -41,18 +60,28 @@ namespace alg
                T init)
                : m_size_y(size_y), 
                  m_size_x(size_x),
-                 m_impl(size_y * size_x, init)
+                 m_impl((std::uint64_t)size_y * size_x, init)
+        {
+        }
+
+        // Adopt storage of size_y x size_x elements, row major
+        matrix(std::uint32_t size_y, 
+               std::uint32_t size_x,
+               STORAGE&& storage)
+               : m_size_y(size_y), 
+                 m_size_x(size_x),
+                 m_impl(std::move(storage))
         {
         }
 
         const T& operator()(std::uint32_t y, std::uint32_t x) const noexcept
         {
-            return m_impl[y * m_size_x + x];
+            return m_impl[(std::uint64_t)y * m_size_x + x];
         }
 
         T& operator()(std::uint32_t y, std::uint32_t x) 
         {
-            return m_impl[y * m_size_x + x];
+            return m_impl[(std::uint64_t)y * m_size_x + x];
         }
 
         const std::uint32_t size_y() const noexcept
@@ -64,6 +93,13 @@ namespace alg
         {
             return m_size_x;
         }
+
+        T*       data()       noexcept { return m_impl.data(); }
+        const T* data() const noexcept { return m_impl.data(); }
+
+        // Zero copy, row major with stride = size_x
+        matrix_view<T>       view()       noexcept;
+        matrix_view<const T> view() const noexcept;
         
         bool set_row(std::uint32_t y, const std::vector<T>& vec)
         {
@@ -105,17 +141,298 @@ namespace alg
             }
         }
 
+        const STORAGE& storage() const noexcept { return m_impl; }
+        STORAGE&       storage()       noexcept { return m_impl; }
+
     private:
         std::uint32_t  m_size_y;
         std::uint32_t  m_size_x;
-        std::vector<T> m_impl;        
+        STORAGE        m_impl;        
     };
 }
 
 
+// ************************************************************************************ //
+// *** Aligned matrix and matrix view *** //
+// ************************************************************************************ //
+// aligned_matrix has the same interface as alg::matrix, so DP code can switch by type :
+// * data is 64 bytes aligned, by aligned_allocator
+// * leading dimension (stride) is padded, so that each row (row major) or each col (col
+//   major) starts at cacheline boundary, padding is not part of the matrix
+// * tiled layout stores B x B tiles row by row, each tile is row major, B = 64/sizeof(T),
+//   hence each row of tile is one cacheline, both row and col scans touch B cachelines
+//   per B x B cells, instead of B x B cachelines for col scan of row major
+//
+// matrix_view is non-owning, it points to data of aligned_matrix, alg::matrix or external
+// buffer, with its own size and stride, submatrix() returns view without copy, view of
+// const T is read only. For row and col major, transposed() swaps layout, without copy.
+// ************************************************************************************ //
 namespace alg
 {
-    template<typename T>
+    template<typename T, std::size_t ALIGN = 64>
+    struct aligned_allocator
+    {
+        using value_type = T;
+
+        template<typename U>
+        struct rebind
+        {
+            using other = aligned_allocator<U, ALIGN>;
+        };
+
+        aligned_allocator() noexcept = default;
+
+        template<typename U>
+        aligned_allocator(const aligned_allocator<U, ALIGN>&) noexcept
+        {
+        }
+
+        T* allocate(std::size_t n)
+        {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(ALIGN)));
+        }
+
+        void deallocate(T* p, std::size_t) noexcept
+        {
+            ::operator delete(p, std::align_val_t(ALIGN));
+        }
+
+        template<typename U>
+        bool operator==(const aligned_allocator<U, ALIGN>&) const noexcept { return true; }
+    };
+
+    namespace matrix_detail
+    {
+        inline constexpr std::uint32_t cacheline = 64;
+
+        // Elements per stride unit, such that stride x sizeof(T) is multiple of cacheline
+        template<typename T>
+        inline constexpr std::uint32_t stride_unit = cacheline / std::gcd<std::uint32_t>(cacheline, sizeof(T));
+
+        // Edge of tile
+        template<typename T>
+        inline constexpr std::uint32_t tile_edge = sizeof(T) >= cacheline? 1 : cacheline / sizeof(T);
+
+        inline std::uint32_t round_up(std::uint32_t n, std::uint32_t unit) noexcept
+        {
+            return (n + unit - 1) / unit * unit;
+        }
+
+        // For tiled, stride = num of tiles in a row of tiles, offset of submatrix is kept, as
+        // tile boundary cannot be moved
+        template<typename T, matrix_layout LAYOUT>
+        inline std::uint64_t index(std::uint32_t y, std::uint32_t x, std::uint32_t stride) noexcept
+        {
+            if constexpr (LAYOUT == matrix_layout::row_major)
+            {
+                return (std::uint64_t)y * stride + x;
+            }
+            else if constexpr (LAYOUT == matrix_layout::col_major)
+            {
+                return (std::uint64_t)x * stride + y;
+            }
+            else
+            {
+                constexpr std::uint32_t B = tile_edge<T>;
+                std::uint64_t tile = (std::uint64_t)(y / B) * stride + (x / B);
+                return tile * B * B + (y % B) * B + (x % B);
+            }
+        }
+
+        template<typename VIEW>
+        void debug(const VIEW& mat, const std::string& name)
+        {
+            std::cout << "\nmatrix " << name;
+            for(std::uint32_t y=0; y!=mat.size_y(); ++y)
+            {
+                std::cout << "\n";
+                for(std::uint32_t x=0; x!=mat.size_x(); ++x) std::cout << mat(y,x) << " ";
+            }
+        }
+    }
+
+    template<typename T, matrix_layout LAYOUT>
+    class matrix_view
+    {
+    public:
+        using value_type = std::remove_const_t<T>;
+
+        matrix_view(T* data, std::uint32_t size_y, std::uint32_t size_x, std::uint32_t stride,
+                    std::uint32_t offset_y = 0, std::uint32_t offset_x = 0) noexcept
+            : m_data(data), m_size_y(size_y), m_size_x(size_x), m_stride(stride),
+              m_offset_y(offset_y), m_offset_x(offset_x)
+        {
+        }
+
+        // View of T converts to view of const T
+        operator matrix_view<const T, LAYOUT>() const noexcept
+        {
+            return matrix_view<const T, LAYOUT>(m_data, m_size_y, m_size_x, m_stride, m_offset_y, m_offset_x);
+        }
+
+        T& operator()(std::uint32_t y, std::uint32_t x) const noexcept
+        {
+            return m_data[matrix_detail::index<value_type, LAYOUT>(y + m_offset_y, x + m_offset_x, m_stride)];
+        }
+
+        std::uint32_t size_y() const noexcept { return m_size_y; }
+        std::uint32_t size_x() const noexcept { return m_size_x; }
+        std::uint32_t stride() const noexcept { return m_stride; }
+        T*            data()   const noexcept { return m_data;   }
+
+        // Row y is contiguous for row major only
+        T* row(std::uint32_t y) const noexcept requires (LAYOUT == matrix_layout::row_major)
+        {
+            return m_data + (std::uint64_t)y * m_stride;
+        }
+
+        matrix_view submatrix(std::uint32_t y, std::uint32_t x, std::uint32_t size_y, std::uint32_t size_x) const noexcept
+        {
+            if constexpr (LAYOUT == matrix_layout::tiled)
+            {
+                return matrix_view(m_data, size_y, size_x, m_stride, m_offset_y + y, m_offset_x + x);
+            }
+            else
+            {
+                return matrix_view(&operator()(y,x), size_y, size_x, m_stride);
+            }
+        }
+
+        auto transposed() const noexcept requires (LAYOUT != matrix_layout::tiled)
+        {
+            constexpr matrix_layout other = LAYOUT == matrix_layout::row_major? matrix_layout::col_major : matrix_layout::row_major;
+            return matrix_view<T, other>(m_data, m_size_x, m_size_y, m_stride);
+        }
+
+        void debug(const std::string& name) const
+        {
+            matrix_detail::debug(*this, name);
+        }
+
+    private:
+        T* m_data;
+        std::uint32_t m_size_y;
+        std::uint32_t m_size_x;
+        std::uint32_t m_stride;
+        std::uint32_t m_offset_y;
+        std::uint32_t m_offset_x;
+    };
+
+    template<typename T, typename STORAGE>
+    matrix_view<T> matrix<T, STORAGE>::view() noexcept
+    {
+        return matrix_view<T>(m_impl.data(), m_size_y, m_size_x, m_size_x);
+    }
+
+    template<typename T, typename STORAGE>
+    matrix_view<const T> matrix<T, STORAGE>::view() const noexcept
+    {
+        return matrix_view<const T>(m_impl.data(), m_size_y, m_size_x, m_size_x);
+    }
+
+    template<typename T, matrix_layout LAYOUT = matrix_layout::row_major>
+    class aligned_matrix
+    {
+    public:
+        aligned_matrix(std::uint32_t size_y, std::uint32_t size_x, T init = T{})
+            : m_size_y(size_y),
+              m_size_x(size_x),
+              m_stride(stride_of(size_y, size_x)),
+              m_impl(capacity_of(size_y, size_x, m_stride), init)
+        {
+        }
+
+        // Deep copy from alg::matrix
+        template<typename STORAGE>
+        explicit aligned_matrix(const matrix<T, STORAGE>& mat) : aligned_matrix(mat.size_y(), mat.size_x())
+        {
+            for(std::uint32_t y=0; y!=m_size_y; ++y)
+            {
+                for(std::uint32_t x=0; x!=m_size_x; ++x) operator()(y,x) = mat(y,x);
+            }
+        }
+
+        const T& operator()(std::uint32_t y, std::uint32_t x) const noexcept
+        {
+            return m_impl[matrix_detail::index<T, LAYOUT>(y, x, m_stride)];
+        }
+
+        T& operator()(std::uint32_t y, std::uint32_t x) noexcept
+        {
+            return m_impl[matrix_detail::index<T, LAYOUT>(y, x, m_stride)];
+        }
+
+        std::uint32_t size_y() const noexcept { return m_size_y; }
+        std::uint32_t size_x() const noexcept { return m_size_x; }
+        std::uint32_t stride() const noexcept { return m_stride; }
+        T*       data()       noexcept { return m_impl.data(); }
+        const T* data() const noexcept { return m_impl.data(); }
+
+        // Num of elements allocated, including padding
+        std::uint64_t capacity() const noexcept { return m_impl.size(); }
+
+        matrix_view<T, LAYOUT>       view()       noexcept { return matrix_view<T, LAYOUT>      (m_impl.data(), m_size_y, m_size_x, m_stride); }
+        matrix_view<const T, LAYOUT> view() const noexcept { return matrix_view<const T, LAYOUT>(m_impl.data(), m_size_y, m_size_x, m_stride); }
+
+        matrix_view<T, LAYOUT> submatrix(std::uint32_t y, std::uint32_t x, std::uint32_t size_y, std::uint32_t size_x) noexcept
+        {
+            return view().submatrix(y, x, size_y, size_x);
+        }
+
+        matrix_view<const T, LAYOUT> submatrix(std::uint32_t y, std::uint32_t x, std::uint32_t size_y, std::uint32_t size_x) const noexcept
+        {
+            return view().submatrix(y, x, size_y, size_x);
+        }
+
+        bool set_row(std::uint32_t y, const std::vector<T>& vec)
+        {
+            if (y          >= m_size_y) return false;
+            if (vec.size() != m_size_x) return false;
+
+            for(std::uint32_t x=0; x!=vec.size(); ++x)
+            {
+                operator()(y,x) = vec[x];
+            }
+            return true;
+        }
+
+        void debug(const std::string& name) const
+        {
+            matrix_detail::debug(*this, name);
+        }
+
+    private:
+        static std::uint32_t stride_of(std::uint32_t size_y, std::uint32_t size_x) noexcept
+        {
+            if constexpr (LAYOUT == matrix_layout::row_major) return matrix_detail::round_up(size_x, matrix_detail::stride_unit<T>);
+            if constexpr (LAYOUT == matrix_layout::col_major) return matrix_detail::round_up(size_y, matrix_detail::stride_unit<T>);
+            if constexpr (LAYOUT == matrix_layout::tiled)     return (size_x + matrix_detail::tile_edge<T> - 1) / matrix_detail::tile_edge<T>;
+        }
+
+        static std::uint64_t capacity_of(std::uint32_t size_y, std::uint32_t size_x, std::uint32_t stride) noexcept
+        {
+            if constexpr (LAYOUT == matrix_layout::row_major) return (std::uint64_t)size_y * stride;
+            if constexpr (LAYOUT == matrix_layout::col_major) return (std::uint64_t)size_x * stride;
+            if constexpr (LAYOUT == matrix_layout::tiled)
+            {
+                constexpr std::uint32_t B = matrix_detail::tile_edge<T>;
+                return (std::uint64_t)(size_y + B - 1) / B * stride * B * B;
+            }
+        }
+
+    private:
+        std::uint32_t m_size_y;
+        std::uint32_t m_size_x;
+        std::uint32_t m_stride;
+        std::vector<T, aligned_allocator<T>> m_impl;
+    };
+}
+
+
+namespace alg
+{
+    // STORAGE is the same as alg::matrix
+    template<typename T, typename STORAGE = std::vector<T>>
     class tensor
     {
     public:
@@ -125,7 +442,7 @@ namespace alg
                : m_size_z(size_z), 
                  m_size_y(size_y), 
                  m_size_x(size_x),
-                 m_impl(size_z * size_y * size_x)
+                 m_impl((std::uint64_t)size_z * size_y * size_x)
         {
         }
 
@@ -136,18 +453,30 @@ namespace alg
                : m_size_y(size_y), 
                  m_size_z(size_z), 
                  m_size_x(size_x),
-                 m_impl(size_z * size_y * size_x, init)
+                 m_impl((std::uint64_t)size_z * size_y * size_x, init)
+        {
+        }
+
+        // Adopt storage of size_z x size_y x size_x elements
+        tensor(std::uint32_t size_z, 
+               std::uint32_t size_y, 
+               std::uint32_t size_x,
+               STORAGE&& storage)
+               : m_size_z(size_z), 
+                 m_size_y(size_y), 
+                 m_size_x(size_x),
+                 m_impl(std::move(storage))
         {
         }
 
         const T& operator()(std::uint32_t z, std::uint32_t y, std::uint32_t x) const noexcept
         {
-            return m_impl[z * m_size_y * m_size_x + y * m_size_x + x];
+            return m_impl[((std::uint64_t)z * m_size_y + y) * m_size_x + x];
         }
 
         T& operator()(std::uint32_t z, std::uint32_t y, std::uint32_t x) 
         {
-            return m_impl[z * m_size_y * m_size_x + y * m_size_x + x];
+            return m_impl[((std::uint64_t)z * m_size_y + y) * m_size_x + x];
         }
 
         const std::uint32_t size_z() const noexcept
@@ -164,6 +493,20 @@ namespace alg
         {
             return m_size_x;
         }
+
+        T*       data()       noexcept { return m_impl.data(); }
+        const T* data() const noexcept { return m_impl.data(); }
+
+        // Slice z as row major matrix, no copy
+        matrix_view<T> view(std::uint32_t z) noexcept
+        {
+            return matrix_view<T>(m_impl.data() + (std::uint64_t)z * m_size_y * m_size_x, m_size_y, m_size_x, m_size_x);
+        }
+
+        matrix_view<const T> view(std::uint32_t z) const noexcept
+        {
+            return matrix_view<const T>(m_impl.data() + (std::uint64_t)z * m_size_y * m_size_x, m_size_y, m_size_x, m_size_x);
+        }
         
         void debug(const std::string& name, bool print_half = false) const noexcept
         {
@@ -190,10 +533,13 @@ namespace alg
             }
         }
 
+        const STORAGE& storage() const noexcept { return m_impl; }
+        STORAGE&       storage()       noexcept { return m_impl; }
+
     private:
         std::uint32_t  m_size_z;
         std::uint32_t  m_size_y;
         std::uint32_t  m_size_x;
-        std::vector<T> m_impl;        
+        STORAGE        m_impl;        
     };
 }
@@ -0,0 +1,594 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include<atomic>
+#include<optional>
+#include<latch>
+#include<algorithm>
+#include<type_traits>
+#include<immintrin.h>
+
+// from alg
+#include<matrix.h>
+#include<threadpool.h>
+
+
+// ************************************************************************************ //
+// *** Matrix kernels : GEMM, GEMV, transpose, fused map / reduce *** //
+// ************************************************************************************ //
+// GEMM C = A x B follows Goto's blocking, A is M x K, B is K x N, C is M x N :
+//
+// for jc in N step NC                   B(pc,jc) block of KC x NC packed once, stays in L3
+//   for pc in K step KC
+//     for ic in M step MC               A(ic,pc) block of MC x KC packed, stays in L2
+//       for jr in NC step NR            B panel of KC x NR stays in L1
+//         for ir in MC step MR          microkernel : C(MR x NR) += A panel x B panel
+//
+// 1. Packing copies A as MR-row panels, Ap[k*MR+i], and B as NR-col panels, Bp[k*NR+j],
+//    both zero padded, hence microkernel reads contiguous memory and A, B may be any
+//    layout (row major, col major, tiled, transposed view), C must be row major
+// 2. Microkernel keeps MR x NR of C in registers, each k does NR/lanes loads of B,
+//    MR broadcasts of A and MR x NR/lanes FMA, edge tiles go through a local buffer
+//    * AVX-512 : MR = 12, NR = 2 zmm, 24 accumulators out of 32 registers
+//    * AVX2    : MR = 6,  NR = 2 ymm, 12 accumulators out of 16 registers
+//    * scalar  : MR = 4,  NR = 4, for integral T or CPU without AVX2
+// 3. SIMD is selected at runtime by __builtin_cpu_supports, as the build has no -march,
+//    kernels are compiled with target attribute. FMA intrinsics are explicit, since
+//    -std=c++20 disables fp-contract, compiler never fuses a*b+c itself.
+// 4. With num_threads > 1 and large size, ic blocks are shared by threads of alg::threadpool,
+//    each thread packs its own A block, B block is shared, one latch per (jc,pc).
+//
+// Transpose is cache-oblivious, split the longer side into halves until block fits L1.
+// GEMV is y = A x v, with row major A, one dot product per row.
+// Map / reduce is element-wise and fused, out(y,x) = map(a(y,x), b(y,x)), with reduce
+// no temporary matrix is created, partial sums break the dependency chain.
+// ************************************************************************************ //
+namespace alg
+{
+    namespace kernel_detail
+    {
+        enum class isa : std::uint8_t
+        {
+            scalar,
+            avx2,
+            avx512
+        };
+
+        inline isa detect_isa() noexcept
+        {
+            static const isa ans = __builtin_cpu_supports("avx512f")? isa::avx512 :
+                                   __builtin_cpu_supports("avx2") &&
+                                   __builtin_cpu_supports("fma")?     isa::avx2 : isa::scalar;
+            return ans;
+        }
+
+        template<typename T>
+        inline constexpr bool is_simd = std::is_same_v<T,float> || std::is_same_v<T,double>;
+
+        // ****************************************** //
+        // *** Wrappers of intrinsics, per ISA, T *** //
+        // ****************************************** //
+        // Wrappers must carry the same target as its caller, otherwise always_inline fails.
+        template<typename T> struct avx2_ops;
+        template<typename T> struct avx512_ops;
+
+        template<> struct avx2_ops<double>
+        {
+            using vec = __m256d;
+            static constexpr std::uint32_t lanes = 4;
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec zero()                           { return _mm256_setzero_pd(); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec load(const double* p)            { return _mm256_loadu_pd(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec broadcast(const double* p)       { return _mm256_broadcast_sd(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec fma(vec a, vec b, vec c)         { return _mm256_fmadd_pd(a,b,c); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec add(vec a, vec b)                { return _mm256_add_pd(a,b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline void store(double* p, vec a)         { _mm256_storeu_pd(p,a); }
+        };
+
+        template<> struct avx2_ops<float>
+        {
+            using vec = __m256;
+            static constexpr std::uint32_t lanes = 8;
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec zero()                           { return _mm256_setzero_ps(); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec load(const float* p)             { return _mm256_loadu_ps(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec broadcast(const float* p)        { return _mm256_broadcast_ss(p); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec fma(vec a, vec b, vec c)         { return _mm256_fmadd_ps(a,b,c); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline vec add(vec a, vec b)                { return _mm256_add_ps(a,b); }
+            [[gnu::target("avx2,fma"), gnu::always_inline]] static inline void store(float* p, vec a)          { _mm256_storeu_ps(p,a); }
+        };
+
+        template<> struct avx512_ops<double>
+        {
+            using vec = __m512d;
+            static constexpr std::uint32_t lanes = 8;
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec zero()                            { return _mm512_setzero_pd(); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec load(const double* p)             { return _mm512_loadu_pd(p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec broadcast(const double* p)        { return _mm512_set1_pd(*p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec fma(vec a, vec b, vec c)          { return _mm512_fmadd_pd(a,b,c); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec add(vec a, vec b)                 { return _mm512_add_pd(a,b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline void store(double* p, vec a)          { _mm512_storeu_pd(p,a); }
+        };
+
+        template<> struct avx512_ops<float>
+        {
+            using vec = __m512;
+            static constexpr std::uint32_t lanes = 16;
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec zero()                            { return _mm512_setzero_ps(); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec load(const float* p)              { return _mm512_loadu_ps(p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec broadcast(const float* p)         { return _mm512_set1_ps(*p); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec fma(vec a, vec b, vec c)          { return _mm512_fmadd_ps(a,b,c); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline vec add(vec a, vec b)                 { return _mm512_add_ps(a,b); }
+            [[gnu::target("avx512f"), gnu::always_inline]] static inline void store(float* p, vec a)           { _mm512_storeu_ps(p,a); }
+        };
+
+        // ******************** //
+        // *** Microkernels *** //
+        // ******************** //
+        // C[MR x NR] += Ap[kc x MR]^T x Bp[kc x NR], C is row major with stride ldc.
+        // Both SIMD versions share the same body, but need their own target attribute.
+        template<typename T, std::uint32_t MR, std::uint32_t NR>
+        void microkernel_scalar(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+        {
+            T acc[MR][NR] = {};
+            for(std::uint32_t k=0; k!=kc; ++k, Ap+=MR, Bp+=NR)
+            {
+                for(std::uint32_t i=0; i!=MR; ++i)
+                {
+                    for(std::uint32_t j=0; j!=NR; ++j) acc[i][j] += Ap[i] * Bp[j];
+                }
+            }
+            for(std::uint32_t i=0; i!=MR; ++i)
+            {
+                for(std::uint32_t j=0; j!=NR; ++j) C[i*ldc+j] += acc[i][j];
+            }
+        }
+
+        template<typename T, std::uint32_t MR, std::uint32_t NRV>
+        [[gnu::target("avx2,fma")]]
+        void microkernel_avx2(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+        {
+            using ops = avx2_ops<T>;
+            constexpr std::uint32_t NR = NRV * ops::lanes;
+
+            typename ops::vec acc[MR][NRV];
+            #pragma GCC unroll 16
+            for(std::uint32_t i=0; i!=MR; ++i)
+            {
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v) acc[i][v] = ops::zero();
+            }
+            for(std::uint32_t k=0; k!=kc; ++k, Ap+=MR, Bp+=NR)
+            {
+                typename ops::vec b[NRV];
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v) b[v] = ops::load(Bp + v*ops::lanes);
+                #pragma GCC unroll 16
+                for(std::uint32_t i=0; i!=MR; ++i)
+                {
+                    typename ops::vec a = ops::broadcast(Ap+i);
+                    #pragma GCC unroll 4
+                    for(std::uint32_t v=0; v!=NRV; ++v) acc[i][v] = ops::fma(a, b[v], acc[i][v]);
+                }
+            }
+            #pragma GCC unroll 16
+            for(std::uint32_t i=0; i!=MR; ++i)
+            {
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v)
+                {
+                    T* c = C + i*ldc + v*ops::lanes;
+                    ops::store(c, ops::add(ops::load(c), acc[i][v]));
+                }
+            }
+        }
+
+        template<typename T, std::uint32_t MR, std::uint32_t NRV>
+        [[gnu::target("avx512f")]]
+        void microkernel_avx512(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+        {
+            using ops = avx512_ops<T>;
+            constexpr std::uint32_t NR = NRV * ops::lanes;
+
+            typename ops::vec acc[MR][NRV];
+            #pragma GCC unroll 16
+            for(std::uint32_t i=0; i!=MR; ++i)
+            {
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v) acc[i][v] = ops::zero();
+            }
+            for(std::uint32_t k=0; k!=kc; ++k, Ap+=MR, Bp+=NR)
+            {
+                typename ops::vec b[NRV];
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v) b[v] = ops::load(Bp + v*ops::lanes);
+                #pragma GCC unroll 16
+                for(std::uint32_t i=0; i!=MR; ++i)
+                {
+                    typename ops::vec a = ops::broadcast(Ap+i);
+                    #pragma GCC unroll 4
+                    for(std::uint32_t v=0; v!=NRV; ++v) acc[i][v] = ops::fma(a, b[v], acc[i][v]);
+                }
+            }
+            #pragma GCC unroll 16
+            for(std::uint32_t i=0; i!=MR; ++i)
+            {
+                #pragma GCC unroll 4
+                for(std::uint32_t v=0; v!=NRV; ++v)
+                {
+                    T* c = C + i*ldc + v*ops::lanes;
+                    ops::store(c, ops::add(ops::load(c), acc[i][v]));
+                }
+            }
+        }
+
+        // Dot product of contiguous arrays, 4 independent accumulators
+        template<typename T>
+        [[gnu::target("avx2,fma")]]
+        T dot_avx2(std::uint32_t n, const T* a, const T* b) noexcept
+        {
+            using ops = avx2_ops<T>;
+            constexpr std::uint32_t L = ops::lanes;
+            typename ops::vec acc0 = ops::zero(), acc1 = ops::zero(), acc2 = ops::zero(), acc3 = ops::zero();
+            std::uint32_t k = 0;
+            for(; k+4*L<=n; k+=4*L)
+            {
+                acc0 = ops::fma(ops::load(a+k),     ops::load(b+k),     acc0);
+                acc1 = ops::fma(ops::load(a+k+L),   ops::load(b+k+L),   acc1);
+                acc2 = ops::fma(ops::load(a+k+2*L), ops::load(b+k+2*L), acc2);
+                acc3 = ops::fma(ops::load(a+k+3*L), ops::load(b+k+3*L), acc3);
+            }
+            alignas(64) T temp[L];
+            ops::store(temp, ops::add(ops::add(acc0, acc1), ops::add(acc2, acc3)));
+            T ans = 0;
+            for(std::uint32_t l=0; l!=L; ++l) ans += temp[l];
+            for(; k!=n; ++k) ans += a[k] * b[k];
+            return ans;
+        }
+
+        template<typename T>
+        [[gnu::target("avx512f")]]
+        T dot_avx512(std::uint32_t n, const T* a, const T* b) noexcept
+        {
+            using ops = avx512_ops<T>;
+            constexpr std::uint32_t L = ops::lanes;
+            typename ops::vec acc0 = ops::zero(), acc1 = ops::zero(), acc2 = ops::zero(), acc3 = ops::zero();
+            std::uint32_t k = 0;
+            for(; k+4*L<=n; k+=4*L)
+            {
+                acc0 = ops::fma(ops::load(a+k),     ops::load(b+k),     acc0);
+                acc1 = ops::fma(ops::load(a+k+L),   ops::load(b+k+L),   acc1);
+                acc2 = ops::fma(ops::load(a+k+2*L), ops::load(b+k+2*L), acc2);
+                acc3 = ops::fma(ops::load(a+k+3*L), ops::load(b+k+3*L), acc3);
+            }
+            alignas(64) T temp[L];
+            ops::store(temp, ops::add(ops::add(acc0, acc1), ops::add(acc2, acc3)));
+            T ans = 0;
+            for(std::uint32_t l=0; l!=L; ++l) ans += temp[l];
+            for(; k!=n; ++k) ans += a[k] * b[k];
+            return ans;
+        }
+
+        template<typename T>
+        T dot_scalar(std::uint32_t n, const T* a, const T* b) noexcept
+        {
+            T acc[4] = {};
+            std::uint32_t k = 0;
+            for(; k+4<=n; k+=4)
+            {
+                for(std::uint32_t l=0; l!=4; ++l) acc[l] += a[k+l] * b[k+l];
+            }
+            for(; k!=n; ++k) acc[0] += a[k] * b[k];
+            return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        }
+
+        // *************************************** //
+        // *** Kernel = microkernel + its shape *** //
+        // *************************************** //
+        template<typename T>
+        struct scalar_kernel
+        {
+            static constexpr std::uint32_t MR = 4;
+            static constexpr std::uint32_t NR = 4;
+            static void run(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+            {
+                microkernel_scalar<T,MR,NR>(kc, Ap, Bp, C, ldc);
+            }
+        };
+
+        template<typename T>
+        struct avx2_kernel
+        {
+            static constexpr std::uint32_t MR = 6;
+            static constexpr std::uint32_t NR = 2 * avx2_ops<T>::lanes;
+            static void run(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+            {
+                microkernel_avx2<T,MR,2>(kc, Ap, Bp, C, ldc);
+            }
+        };
+
+        template<typename T>
+        struct avx512_kernel
+        {
+            static constexpr std::uint32_t MR = 12;
+            static constexpr std::uint32_t NR = 2 * avx512_ops<T>::lanes;
+            static void run(std::uint32_t kc, const T* Ap, const T* Bp, T* C, std::uint64_t ldc) noexcept
+            {
+                microkernel_avx512<T,MR,2>(kc, Ap, Bp, C, ldc);
+            }
+        };
+
+        // **************************** //
+        // *** Packing, Goto blocks *** //
+        // **************************** //
+        inline constexpr std::uint32_t KC = 256;
+        inline constexpr std::uint32_t MC_panels = 16;  // MC = MR x 16
+        inline constexpr std::uint32_t NC_panels = 128; // NC = NR x 128
+        inline constexpr std::uint64_t parallel_threshold = 128ULL * 128 * 128;
+
+        template<typename T>
+        using buffer = std::vector<T, aligned_allocator<T>>;
+
+        template<std::uint32_t MR, typename VIEW, typename T>
+        void pack_A(const VIEW& A, std::uint32_t ic, std::uint32_t pc, std::uint32_t mc, std::uint32_t kc, T* Ap) noexcept
+        {
+            for(std::uint32_t ir=0; ir<mc; ir+=MR)
+            {
+                std::uint32_t rows = std::min(MR, mc-ir);
+                for(std::uint32_t k=0; k!=kc; ++k, Ap+=MR)
+                {
+                    for(std::uint32_t i=0; i!=rows; ++i) Ap[i] = A(ic+ir+i, pc+k);
+                    for(std::uint32_t i=rows; i!=MR; ++i) Ap[i] = T{};
+                }
+            }
+        }
+
+        template<std::uint32_t NR, typename VIEW, typename T>
+        void pack_B(const VIEW& B, std::uint32_t pc, std::uint32_t jc, std::uint32_t kc, std::uint32_t nc, T* Bp) noexcept
+        {
+            for(std::uint32_t jr=0; jr<nc; jr+=NR)
+            {
+                std::uint32_t cols = std::min(NR, nc-jr);
+                for(std::uint32_t k=0; k!=kc; ++k, Bp+=NR)
+                {
+                    for(std::uint32_t j=0; j!=cols; ++j) Bp[j] = B(pc+k, jc+jr+j);
+                    for(std::uint32_t j=cols; j!=NR; ++j) Bp[j] = T{};
+                }
+            }
+        }
+
+        // C(ic:ic+mc, jc:jc+nc) += packed A block x packed B block
+        template<typename KERNEL, typename T>
+        void macro_kernel(const T* Ap, const T* Bp, const matrix_view<T>& C,
+                          std::uint32_t ic, std::uint32_t jc, std::uint32_t mc, std::uint32_t nc, std::uint32_t kc) noexcept
+        {
+            constexpr std::uint32_t MR = KERNEL::MR;
+            constexpr std::uint32_t NR = KERNEL::NR;
+            for(std::uint32_t jr=0; jr<nc; jr+=NR)
+            {
+                for(std::uint32_t ir=0; ir<mc; ir+=MR)
+                {
+                    const T* Ap_panel = Ap + (std::uint64_t)ir * kc;
+                    const T* Bp_panel = Bp + (std::uint64_t)jr * kc;
+                    if (ir+MR <= mc && jr+NR <= nc)
+                    {
+                        KERNEL::run(kc, Ap_panel, Bp_panel, &C(ic+ir, jc+jr), C.stride());
+                    }
+                    else
+                    {
+                        alignas(64) T temp[MR*NR] = {};
+                        KERNEL::run(kc, Ap_panel, Bp_panel, temp, NR);
+                        std::uint32_t rows = std::min(MR, mc-ir);
+                        std::uint32_t cols = std::min(NR, nc-jr);
+                        for(std::uint32_t i=0; i!=rows; ++i)
+                        {
+                            for(std::uint32_t j=0; j!=cols; ++j) C(ic+ir+i, jc+jr+j) += temp[i*NR+j];
+                        }
+                    }
+                }
+            }
+        }
+
+        template<typename KERNEL, typename VIEW_A, typename VIEW_B, typename T>
+        void gemm_blocked(const VIEW_A& A, const VIEW_B& B, const matrix_view<T>& C, std::uint32_t num_threads)
+        {
+            constexpr std::uint32_t MR = KERNEL::MR;
+            constexpr std::uint32_t NR = KERNEL::NR;
+            constexpr std::uint32_t MC = MR * MC_panels;
+            constexpr std::uint32_t NC = NR * NC_panels;
+
+            std::uint32_t M = C.size_y();
+            std::uint32_t N = C.size_x();
+            std::uint32_t K = A.size_x();
+            std::uint32_t num_blocks = (M + MC - 1) / MC;
+            if ((std::uint64_t)M * N * K < parallel_threshold) num_threads = 1;
+            num_threads = std::max(1u, std::min(num_threads, num_blocks));
+
+            // Buffers no larger than the problem, as vector zero-fills them
+            std::uint64_t kc_max = std::min(KC, K);
+            buffer<T> Bp(kc_max * std::min(NC, (N + NR - 1) / NR * NR));
+            std::vector<buffer<T>> Ap(num_threads, buffer<T>(kc_max * std::min(MC, (M + MR - 1) / MR * MR)));
+            std::optional<threadpool> pool;
+            if (num_threads > 1) pool.emplace(num_threads-1);
+
+            for(std::uint32_t jc=0; jc<N; jc+=NC)
+            {
+                std::uint32_t nc = std::min(NC, N-jc);
+                for(std::uint32_t pc=0; pc<K; pc+=KC)
+                {
+                    std::uint32_t kc = std::min(KC, K-pc);
+                    pack_B<NR>(B, pc, jc, kc, nc, Bp.data());
+
+                    auto run = [&](std::uint32_t t)
+                    {
+                        for(std::uint32_t b=t; b<num_blocks; b+=num_threads)
+                        {
+                            std::uint32_t ic = b * MC;
+                            std::uint32_t mc = std::min(MC, M-ic);
+                            pack_A<MR>(A, ic, pc, mc, kc, Ap[t].data());
+                            macro_kernel<KERNEL>(Ap[t].data(), Bp.data(), C, ic, jc, mc, nc, kc);
+                        }
+                    };
+
+                    if (num_threads == 1)
+                    {
+                        run(0);
+                        continue;
+                    }
+
+                    std::latch done(num_threads-1);
+                    for(std::uint32_t t=1; t!=num_threads; ++t)
+                    {
+                        pool->add_task([&run, &done, t](std::uint32_t)
+                        {
+                            run(t);
+                            done.count_down();
+                        });
+                    }
+                    run(0);
+                    done.wait();
+                }
+            }
+        }
+    }
+}
+
+
+// ************ //
+// *** GEMM *** //
+// ************ //
+namespace alg
+{
+    // C = A x B, where A is M x K, B is K x N, C is M x N, A and B are views in any layout
+    template<typename VIEW_A, typename VIEW_B, typename T>
+    void gemm(const VIEW_A& A, const VIEW_B& B, const matrix_view<T>& C, std::uint32_t num_threads = 1)
+    {
+        for(std::uint32_t y=0; y!=C.size_y(); ++y)
+        {
+            std::fill(C.row(y), C.row(y) + C.size_x(), T{});
+        }
+        if (A.size_x() == 0) return;
+
+        using namespace kernel_detail;
+        if constexpr (is_simd<T>)
+        {
+            switch(detect_isa())
+            {
+                case isa::avx512: gemm_blocked<avx512_kernel<T>>(A, B, C, num_threads); return;
+                case isa::avx2:   gemm_blocked<avx2_kernel<T>>  (A, B, C, num_threads); return;
+                default: break;
+            }
+        }
+        gemm_blocked<scalar_kernel<T>>(A, B, C, num_threads);
+    }
+
+    template<typename T, typename STORAGE_A, typename STORAGE_B>
+    matrix<T> gemm(const matrix<T, STORAGE_A>& A, const matrix<T, STORAGE_B>& B, std::uint32_t num_threads = 1)
+    {
+        matrix<T> C(A.size_y(), B.size_x());
+        gemm(A.view(), B.view(), C.view(), num_threads);
+        return C;
+    }
+
+    // C[z] = A[z] x B[z] for each z
+    template<typename T, typename STORAGE_A, typename STORAGE_B, typename STORAGE_C>
+    void gemm_batched(const tensor<T, STORAGE_A>& A, const tensor<T, STORAGE_B>& B, tensor<T, STORAGE_C>& C, std::uint32_t num_threads = 1)
+    {
+        for(std::uint32_t z=0; z!=C.size_z(); ++z)
+        {
+            gemm(A.view(z), B.view(z), C.view(z), num_threads);
+        }
+    }
+}
+
+
+// ******************************************** //
+// *** GEMV, transpose, fused map and reduce *** //
+// ******************************************** //
+namespace alg
+{
+    // y = A x v
+    template<typename U, typename T = std::remove_const_t<U>>
+    void gemv(const matrix_view<U>& A, const T* v, T* y) noexcept
+    {
+        using namespace kernel_detail;
+        auto dot = dot_scalar<T>;
+        if constexpr (is_simd<T>)
+        {
+            if      (detect_isa() == isa::avx512) dot = dot_avx512<T>;
+            else if (detect_isa() == isa::avx2)   dot = dot_avx2<T>;
+        }
+        for(std::uint32_t i=0; i!=A.size_y(); ++i) y[i] = dot(A.size_x(), A.row(i), v);
+    }
+
+    template<typename T, typename STORAGE>
+    std::vector<T> gemv(const matrix<T, STORAGE>& A, const std::vector<T>& v)
+    {
+        std::vector<T> y(A.size_y());
+        gemv(A.view(), v.data(), y.data());
+        return y;
+    }
+
+    // dst(x,y) = src(y,x), dst is size_x x size_y of src
+    template<typename VIEW_SRC, typename VIEW_DST>
+    void transpose(const VIEW_SRC& src, const VIEW_DST& dst) noexcept
+    {
+        constexpr std::uint32_t base = 32;
+        std::uint32_t sy = src.size_y();
+        std::uint32_t sx = src.size_x();
+        if (sy <= base && sx <= base)
+        {
+            for(std::uint32_t y=0; y!=sy; ++y)
+            {
+                for(std::uint32_t x=0; x!=sx; ++x) dst(x,y) = src(y,x);
+            }
+        }
+        else if (sy >= sx)
+        {
+            std::uint32_t h = sy/2;
+            transpose(src.submatrix(0, 0, h,    sx), dst.submatrix(0, 0, sx, h));
+            transpose(src.submatrix(h, 0, sy-h, sx), dst.submatrix(0, h, sx, sy-h));
+        }
+        else
+        {
+            std::uint32_t h = sx/2;
+            transpose(src.submatrix(0, 0, sy, h),    dst.submatrix(0, 0, h,    sy));
+            transpose(src.submatrix(0, h, sy, sx-h), dst.submatrix(h, 0, sx-h, sy));
+        }
+    }
+
+    template<typename T, typename STORAGE>
+    matrix<T> transpose(const matrix<T, STORAGE>& src)
+    {
+        matrix<T> dst(src.size_x(), src.size_y());
+        transpose(src.view(), dst.view());
+        return dst;
+    }
+
+    // out(y,x) = fct(a(y,x), b(y,x)), out may alias a or b
+    template<typename VIEW_OUT, typename VIEW_A, typename VIEW_B, typename F>
+    void map(const VIEW_OUT& out, const VIEW_A& a, const VIEW_B& b, const F& fct)
+    {
+        for(std::uint32_t y=0; y!=out.size_y(); ++y)
+        {
+            for(std::uint32_t x=0; x!=out.size_x(); ++x) out(y,x) = fct(a(y,x), b(y,x));
+        }
+    }
+
+    // reduce(... reduce(identity, map(a(0,0), b(0,0))) ...), reduce must be associative and
+    // commutative, identity must be identity of reduce, as each partial sum starts with it
+    template<typename VIEW_A, typename VIEW_B, typename R, typename MAP, typename REDUCE>
+    R map_reduce(const VIEW_A& a, const VIEW_B& b, R identity, const MAP& map, const REDUCE& reduce)
+    {
+        constexpr std::uint32_t P = 4;
+        R partial[P] = {identity, identity, identity, identity};
+        for(std::uint32_t y=0; y!=a.size_y(); ++y)
+        {
+            std::uint32_t x = 0;
+            for(; x+P<=a.size_x(); x+=P)
+            {
+                for(std::uint32_t p=0; p!=P; ++p) partial[p] = reduce(partial[p], map(a(y,x+p), b(y,x+p)));
+            }
+            for(; x!=a.size_x(); ++x) partial[0] = reduce(partial[0], map(a(y,x), b(y,x)));
+        }
+        return reduce(reduce(partial[0], partial[1]), reduce(partial[2], partial[3]));
+    }
+}
@@ -0,0 +1,348 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<string>
+#include<fstream>
+#include<stdexcept>
+#include<type_traits>
+#include<utility>
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+// from alg
+#include<matrix.h>
+
+
+// ************************************************************************************ //
+// *** Memory mapped matrix and tensor *** //
+// ************************************************************************************ //
+// File format, self describing, native endian :
+// * mapped_header of 64 bytes, with magic, dtype, element size, rank, layout, dims,
+//   stride, alignment, offset and bytes of data
+// * zero padding up to offset, which is multiple of alignment (page by default)
+// * raw data, exactly as in memory, including padding of aligned_matrix
+//
+// mapped_storage<T> maps the whole file, and exposes data as contiguous T, it is used as
+// STORAGE of alg::matrix and alg::tensor, or as matrix_view of any layout. Opening costs
+// one mmap, no copy, pages are faulted in on first touch, unless populated.
+//
+// mapped_access :
+// 1. read_only     - PROT_READ, MAP_SHARED, writing to data is segfault
+// 2. copy_on_write - PROT_READ | PROT_WRITE, MAP_PRIVATE, written page is copied, file and
+//                    other mappings of the file never see the change
+// 3. write_through - PROT_READ | PROT_WRITE, MAP_SHARED, change goes to file, sync() to flush
+//
+// mapped_options :
+// * m_populate   - MAP_POPULATE, read-ahead all pages in mmap, no page fault later
+// * m_advice     - madvise, sequential / random / will_need, for kernel read-ahead
+// * m_huge_pages - madvise MADV_HUGEPAGE, best effort, for tmpfs or private written pages
+//                  (needs transparent huge page enabled), fewer TLB misses
+// ************************************************************************************ //
+namespace alg
+{
+    enum class mapped_dtype : std::uint32_t
+    {
+        opaque, // other trivially copyable T, checked by element size only
+        int8,   int16,  int32,  int64,
+        uint8,  uint16, uint32, uint64,
+        float32,
+        float64
+    };
+
+    template<typename T>
+    constexpr mapped_dtype dtype_of() noexcept
+    {
+        if constexpr (std::is_same_v<T, std::int8_t>)   return mapped_dtype::int8;
+        if constexpr (std::is_same_v<T, std::int16_t>)  return mapped_dtype::int16;
+        if constexpr (std::is_same_v<T, std::int32_t>)  return mapped_dtype::int32;
+        if constexpr (std::is_same_v<T, std::int64_t>)  return mapped_dtype::int64;
+        if constexpr (std::is_same_v<T, std::uint8_t>)  return mapped_dtype::uint8;
+        if constexpr (std::is_same_v<T, std::uint16_t>) return mapped_dtype::uint16;
+        if constexpr (std::is_same_v<T, std::uint32_t>) return mapped_dtype::uint32;
+        if constexpr (std::is_same_v<T, std::uint64_t>) return mapped_dtype::uint64;
+        if constexpr (std::is_same_v<T, float>)         return mapped_dtype::float32;
+        if constexpr (std::is_same_v<T, double>)        return mapped_dtype::float64;
+        return mapped_dtype::opaque;
+    }
+
+    struct mapped_header
+    {
+        static constexpr char          magic[8] = {'A','L','G','M','M','A','P','\0'};
+        static constexpr std::uint32_t version  = 1;
+
+        char          m_magic[8];
+        std::uint32_t m_version;
+        mapped_dtype  m_dtype;
+        std::uint32_t m_elem_size;
+        std::uint32_t m_rank;      // 2 for matrix, 3 for tensor
+        matrix_layout m_layout;
+        std::uint8_t  m_reserved[3];
+        std::uint32_t m_dims[3];   // z, y, x, with z = 1 for matrix
+        std::uint32_t m_stride;    // same as matrix_view::stride
+        std::uint32_t m_alignment;
+        std::uint64_t m_offset;
+        std::uint64_t m_bytes;
+    };
+    static_assert(sizeof(mapped_header) == 64);
+    static_assert(std::is_trivially_copyable_v<mapped_header>);
+
+    enum class mapped_access : std::uint8_t
+    {
+        read_only,
+        copy_on_write,
+        write_through
+    };
+
+    enum class mapped_advice : std::uint8_t
+    {
+        normal,
+        sequential,
+        random,
+        will_need
+    };
+
+    struct mapped_options
+    {
+        mapped_access m_access     = mapped_access::read_only;
+        bool          m_populate   = false;
+        mapped_advice m_advice     = mapped_advice::normal;
+        bool          m_huge_pages = false;
+    };
+}
+
+
+// ********************** //
+// *** Mapped storage *** //
+// ********************** //
+namespace alg
+{
+    template<typename T>
+    class mapped_storage
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        using value_type = T;
+
+        mapped_storage(const std::string& path, const mapped_options& options = {})
+        {
+            bool writable = options.m_access == mapped_access::write_through;
+            int fd = ::open(path.c_str(), writable? O_RDWR : O_RDONLY);
+            if (fd < 0) throw std::runtime_error("mapped_storage : cannot open " + path);
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || (std::uint64_t)st.st_size < sizeof(mapped_header))
+            {
+                ::close(fd);
+                throw std::runtime_error("mapped_storage : file too small " + path);
+            }
+
+            int prot  = options.m_access == mapped_access::read_only? PROT_READ : PROT_READ | PROT_WRITE;
+            int flags = options.m_access == mapped_access::copy_on_write? MAP_PRIVATE : MAP_SHARED;
+            if (options.m_populate) flags |= MAP_POPULATE;
+
+            m_map_bytes = st.st_size;
+            m_map = ::mmap(nullptr, m_map_bytes, prot, flags, fd, 0);
+            ::close(fd); // mapping keeps file alive
+            if (m_map == MAP_FAILED)
+            {
+                m_map = nullptr;
+                throw std::runtime_error("mapped_storage : mmap failed " + path);
+            }
+
+            std::memcpy(&m_header, m_map, sizeof(mapped_header));
+            if (!is_valid())
+            {
+                unmap();
+                throw std::runtime_error("mapped_storage : invalid header or dtype " + path);
+            }
+            m_data = reinterpret_cast<T*>(static_cast<char*>(m_map) + m_header.m_offset);
+            m_size = m_header.m_bytes / sizeof(T);
+
+            // Hints are best effort, failure is not an error
+            if (options.m_advice == mapped_advice::sequential) ::madvise(m_map, m_map_bytes, MADV_SEQUENTIAL);
+            if (options.m_advice == mapped_advice::random)     ::madvise(m_map, m_map_bytes, MADV_RANDOM);
+            if (options.m_advice == mapped_advice::will_need)  ::madvise(m_map, m_map_bytes, MADV_WILLNEED);
+            if (options.m_huge_pages)                          ::madvise(m_map, m_map_bytes, MADV_HUGEPAGE);
+        }
+
+        ~mapped_storage()
+        {
+            unmap();
+        }
+
+        mapped_storage(const mapped_storage&) = delete;
+        mapped_storage& operator=(const mapped_storage&) = delete;
+
+        mapped_storage(mapped_storage&& rhs) noexcept
+            : m_map(std::exchange(rhs.m_map, nullptr)),
+              m_map_bytes(std::exchange(rhs.m_map_bytes, 0)),
+              m_data(std::exchange(rhs.m_data, nullptr)),
+              m_size(std::exchange(rhs.m_size, 0)),
+              m_header(rhs.m_header)
+        {
+        }
+
+        mapped_storage& operator=(mapped_storage&& rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                unmap();
+                m_map       = std::exchange(rhs.m_map, nullptr);
+                m_map_bytes = std::exchange(rhs.m_map_bytes, 0);
+                m_data      = std::exchange(rhs.m_data, nullptr);
+                m_size      = std::exchange(rhs.m_size, 0);
+                m_header    = rhs.m_header;
+            }
+            return *this;
+        }
+
+    public:
+        const T& operator[](std::uint64_t n) const noexcept { return m_data[n]; }
+        T&       operator[](std::uint64_t n)       noexcept { return m_data[n]; }
+
+        const T* data()  const noexcept { return m_data;          }
+        T*       data()        noexcept { return m_data;          }
+        const T* begin() const noexcept { return m_data;          }
+        const T* end()   const noexcept { return m_data + m_size; }
+        std::uint64_t size() const noexcept { return m_size; }
+        const mapped_header& header() const noexcept { return m_header; }
+
+        // View of z-th matrix in file, in layout of file
+        template<matrix_layout LAYOUT>
+        matrix_view<T, LAYOUT> view(std::uint32_t z = 0)
+        {
+            if (m_header.m_layout != LAYOUT) throw std::runtime_error("mapped_storage : layout mismatch");
+            std::uint64_t offset = (std::uint64_t)z * (m_size / m_header.m_dims[0]);
+            return matrix_view<T, LAYOUT>(m_data + offset, m_header.m_dims[1], m_header.m_dims[2], m_header.m_stride);
+        }
+
+        // Flush write_through mapping to file
+        bool sync() noexcept
+        {
+            return ::msync(m_map, m_map_bytes, MS_SYNC) == 0;
+        }
+
+    private:
+        bool is_valid() const noexcept
+        {
+            if (std::memcmp(m_header.m_magic, mapped_header::magic, sizeof(mapped_header::magic)) != 0) return false;
+            if (m_header.m_version   != mapped_header::version) return false;
+            if (m_header.m_dtype     != dtype_of<T>())          return false;
+            if (m_header.m_elem_size != sizeof(T))              return false;
+            if (m_header.m_dims[0]   == 0)                      return false;
+            if (m_header.m_offset    <  sizeof(mapped_header))  return false;
+            if (m_header.m_offset % alignof(T) != 0)            return false;
+            return m_header.m_offset + m_header.m_bytes <= m_map_bytes;
+        }
+
+        void unmap() noexcept
+        {
+            if (m_map) ::munmap(m_map, m_map_bytes);
+            m_map = nullptr;
+        }
+
+    private:
+        void*         m_map       = nullptr;
+        std::uint64_t m_map_bytes = 0;
+        T*            m_data      = nullptr;
+        std::uint64_t m_size      = 0;
+        mapped_header m_header    = {};
+    };
+}
+
+
+// ********************** //
+// *** Save and open *** //
+// ********************** //
+// Alignment of data offset is page size by default, so that data starts at page boundary.
+//
+namespace alg
+{
+    namespace mapped_detail
+    {
+        template<typename T>
+        void save(const std::string& path, const T* data, std::uint64_t size, std::uint32_t rank, matrix_layout layout,
+                  std::uint32_t size_z, std::uint32_t size_y, std::uint32_t size_x, std::uint32_t stride, std::uint32_t alignment)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (alignment < alignof(T) || (alignment & (alignment-1)) != 0)
+            {
+                throw std::invalid_argument("save_mapped : alignment must be power of 2");
+            }
+
+            mapped_header header{};
+            std::memcpy(header.m_magic, mapped_header::magic, sizeof(mapped_header::magic));
+            header.m_version   = mapped_header::version;
+            header.m_dtype     = dtype_of<T>();
+            header.m_elem_size = sizeof(T);
+            header.m_rank      = rank;
+            header.m_layout    = layout;
+            header.m_dims[0]   = size_z;
+            header.m_dims[1]   = size_y;
+            header.m_dims[2]   = size_x;
+            header.m_stride    = stride;
+            header.m_alignment = alignment;
+            header.m_offset    = (sizeof(mapped_header) + alignment - 1) / alignment * alignment;
+            header.m_bytes     = size * sizeof(T);
+
+            std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+            if (!ofs) throw std::runtime_error("save_mapped : cannot open " + path);
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            std::string padding(header.m_offset - sizeof(header), '\0');
+            ofs.write(padding.data(), padding.size());
+            ofs.write(reinterpret_cast<const char*>(data), header.m_bytes);
+            if (!ofs) throw std::runtime_error("save_mapped : cannot write " + path);
+        }
+    }
+
+    template<typename T, typename STORAGE>
+    void save_mapped(const std::string& path, const matrix<T, STORAGE>& mat, std::uint32_t alignment = 4096)
+    {
+        mapped_detail::save(path, mat.data(), (std::uint64_t)mat.size_y() * mat.size_x(), 2, matrix_layout::row_major,
+                            1, mat.size_y(), mat.size_x(), mat.size_x(), alignment);
+    }
+
+    template<typename T, matrix_layout LAYOUT>
+    void save_mapped(const std::string& path, const aligned_matrix<T, LAYOUT>& mat, std::uint32_t alignment = 4096)
+    {
+        mapped_detail::save(path, mat.data(), mat.capacity(), 2, LAYOUT,
+                            1, mat.size_y(), mat.size_x(), mat.stride(), alignment);
+    }
+
+    template<typename T, typename STORAGE>
+    void save_mapped(const std::string& path, const tensor<T, STORAGE>& ten, std::uint32_t alignment = 4096)
+    {
+        mapped_detail::save(path, ten.data(), (std::uint64_t)ten.size_z() * ten.size_y() * ten.size_x(), 3, matrix_layout::row_major,
+                            ten.size_z(), ten.size_y(), ten.size_x(), ten.size_x(), alignment);
+    }
+
+    // File must be saved from alg::matrix, i.e. row major without padding
+    template<typename T>
+    matrix<T, mapped_storage<T>> open_mapped_matrix(const std::string& path, const mapped_options& options = {})
+    {
+        mapped_storage<T> storage(path, options);
+        const auto& h = storage.header();
+        if (h.m_rank != 2 || h.m_layout != matrix_layout::row_major || h.m_stride != h.m_dims[2] ||
+            storage.size() != (std::uint64_t)h.m_dims[1] * h.m_dims[2])
+        {
+            throw std::runtime_error("open_mapped_matrix : not a row major matrix " + path);
+        }
+        return matrix<T, mapped_storage<T>>(h.m_dims[1], h.m_dims[2], std::move(storage));
+    }
+
+    template<typename T>
+    tensor<T, mapped_storage<T>> open_mapped_tensor(const std::string& path, const mapped_options& options = {})
+    {
+        mapped_storage<T> storage(path, options);
+        const auto& h = storage.header();
+        if (h.m_rank != 3 || h.m_layout != matrix_layout::row_major || h.m_stride != h.m_dims[2] ||
+            storage.size() != (std::uint64_t)h.m_dims[0] * h.m_dims[1] * h.m_dims[2])
+        {
+            throw std::runtime_error("open_mapped_tensor : not a row major tensor " + path);
+        }
+        return tensor<T, mapped_storage<T>>(h.m_dims[0], h.m_dims[1], h.m_dims[2], std::move(storage));
+    }
+}
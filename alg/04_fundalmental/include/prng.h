@@ -1,15 +1,430 @@
 #pragma once
 #include <concepts>
 #include <random>
+#include <span>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+#include <immintrin.h>
+
+
+// ************************************************************************************ //
+// *** Pseudo random number generators *** //
+// ************************************************************************************ //
+// Engines, all are UniformRandomBitGenerator of 64 bits, usable with std distributions :
+// 1. splitmix64     - 64 bits state, weak alone, used to expand seeds into states
+// 2. xoshiro256ss   - 256 bits state, xoshiro256** by Blackman & Vigna, fastest,
+//                     jump() = 2^128 steps, long_jump() = 2^192 steps
+// 3. pcg64          - 128 bits LCG + XSL-RR output by O'Neill, advance(n) in O(log n),
+//                     2^63 streams selected by odd increment
+// 4. xoshiro256ss_x8 - 8 lanes of xoshiro256**, lane k is jumped k times from seed,
+//                     fill() generates 8 numbers per step with AVX2, scalar if no AVX2,
+//                     both produce identical sequence
+//
+// Independent streams for threads :
+// * split() returns a generator of current stream, and moves this generator to a stream
+//   that never overlaps, i.e. jump() for xoshiro, new increment for pcg
+//
+// Bounded integer in [0, range) by Lemire's nearly divisionless method : high 64 bits of
+// x * range, modulo is computed only when low 64 bits < range, which is rare, rejection
+// when low 64 bits < 2^64 % range makes it unbiased.
+//
+// Double in [0, 1) by top 53 bits * 2^-53.
+// ************************************************************************************ //
+namespace alg
+{
+    inline constexpr std::uint64_t rotl64(std::uint64_t x, int k) noexcept
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    class splitmix64
+    {
+    public:
+        using result_type = std::uint64_t;
+        static constexpr result_type min() noexcept { return 0; }
+        static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+        explicit splitmix64(std::uint64_t seed = 0) noexcept : m_state(seed)
+        {
+        }
+
+        inline result_type operator()() noexcept
+        {
+            std::uint64_t z = (m_state += gamma);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        void advance(std::uint64_t n) noexcept
+        {
+            m_state += n * gamma;
+        }
+
+        splitmix64 split() noexcept
+        {
+            return splitmix64((*this)());
+        }
+
+    private:
+        static constexpr std::uint64_t gamma = 0x9e3779b97f4a7c15ULL;
+        std::uint64_t m_state;
+    };
+
+    class xoshiro256ss
+    {
+    public:
+        using result_type = std::uint64_t;
+        static constexpr result_type min() noexcept { return 0; }
+        static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+        explicit xoshiro256ss(std::uint64_t seed = 0) noexcept
+        {
+            splitmix64 seeder(seed);
+            for(auto& x:m_s) x = seeder();
+        }
+
+        explicit xoshiro256ss(std::span<const std::uint64_t, 4> state) noexcept
+        {
+            std::copy(state.begin(), state.end(), m_s);
+        }
+
+        inline result_type operator()() noexcept
+        {
+            const std::uint64_t ans = rotl64(m_s[1] * 5, 7) * 9;
+            const std::uint64_t t = m_s[1] << 17;
+            m_s[2] ^= m_s[0];
+            m_s[3] ^= m_s[1];
+            m_s[1] ^= m_s[2];
+            m_s[0] ^= m_s[3];
+            m_s[2] ^= t;
+            m_s[3] = rotl64(m_s[3], 45);
+            return ans;
+        }
+
+        void jump() noexcept
+        {
+            static constexpr std::uint64_t poly[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+            apply(poly);
+        }
+
+        void long_jump() noexcept
+        {
+            static constexpr std::uint64_t poly[] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+            apply(poly);
+        }
+
+        xoshiro256ss split() noexcept
+        {
+            xoshiro256ss ans = *this;
+            jump();
+            return ans;
+        }
+
+        std::span<const std::uint64_t, 4> state() const noexcept
+        {
+            return std::span<const std::uint64_t, 4>(m_s, 4);
+        }
+
+    private:
+        void apply(const std::uint64_t (&poly)[4]) noexcept
+        {
+            std::uint64_t s[4] = {0, 0, 0, 0};
+            for(std::uint64_t p : poly)
+            {
+                for(int b=0; b!=64; ++b)
+                {
+                    if (p & (1ULL << b))
+                    {
+                        for(int n=0; n!=4; ++n) s[n] ^= m_s[n];
+                    }
+                    (*this)();
+                }
+            }
+            std::copy(s, s+4, m_s);
+        }
+
+    private:
+        std::uint64_t m_s[4];
+    };
+
+    class pcg64
+    {
+    public:
+        using result_type = std::uint64_t;
+        static constexpr result_type min() noexcept { return 0; }
+        static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+        // Seed and stream are expanded to 128 bits by splitmix64
+        explicit pcg64(std::uint64_t seed = 0, std::uint64_t stream = 0) noexcept
+        {
+            splitmix64 seed_mix(seed);
+            splitmix64 stream_mix(stream);
+            unsigned __int128 init_state = ((unsigned __int128)seed_mix()   << 64) | seed_mix();
+            unsigned __int128 init_seq   = ((unsigned __int128)stream_mix() << 64) | stream_mix();
+            set(init_state, init_seq);
+        }
+
+        // As pcg_setseq_128_srandom_r in reference implementation
+        void set(unsigned __int128 init_state, unsigned __int128 init_seq) noexcept
+        {
+            m_state = 0;
+            m_inc = (init_seq << 1) | 1;
+            step();
+            m_state += init_state;
+            step();
+        }
+
+        inline result_type operator()() noexcept
+        {
+            step();
+            const std::uint64_t hi = static_cast<std::uint64_t>(m_state >> 64);
+            const std::uint64_t lo = static_cast<std::uint64_t>(m_state);
+            const int rot = static_cast<int>(hi >> 58);
+            const std::uint64_t x = hi ^ lo;
+            return (x >> rot) | (x << ((64 - rot) & 63));
+        }
+
+        // Jump ahead by n steps in O(log n), by Brown's method
+        void advance(unsigned __int128 n) noexcept
+        {
+            unsigned __int128 acc_mult = 1;
+            unsigned __int128 acc_plus = 0;
+            unsigned __int128 cur_mult = multiplier();
+            unsigned __int128 cur_plus = m_inc;
+            while(n > 0)
+            {
+                if (n & 1)
+                {
+                    acc_mult *= cur_mult;
+                    acc_plus = acc_plus * cur_mult + cur_plus;
+                }
+                cur_plus = (cur_mult + 1) * cur_plus;
+                cur_mult *= cur_mult;
+                n >>= 1;
+            }
+            m_state = acc_mult * m_state + acc_plus;
+        }
+
+        void jump() noexcept
+        {
+            advance((unsigned __int128)1 << 64);
+        }
+
+        // Current stream is returned, this moves to a new stream (increment)
+        pcg64 split() noexcept
+        {
+            pcg64 ans = *this;
+            unsigned __int128 init_state = ((unsigned __int128)(*this)() << 64) | (*this)();
+            unsigned __int128 init_seq   = ((unsigned __int128)(*this)() << 64) | (*this)();
+            set(init_state, init_seq);
+            return ans;
+        }
+
+        unsigned __int128 state() const noexcept { return m_state; }
+        unsigned __int128 increment() const noexcept { return m_inc; }
+
+    private:
+        static constexpr unsigned __int128 multiplier() noexcept
+        {
+            return ((unsigned __int128)0x2360ed051fc65da4ULL << 64) | 0x4385df649fccf645ULL;
+        }
+
+        inline void step() noexcept
+        {
+            m_state = m_state * multiplier() + m_inc;
+        }
+
+    private:
+        unsigned __int128 m_state;
+        unsigned __int128 m_inc;
+    };
+}
+
+namespace alg
+{
+    // [0, range), range > 0
+    template<typename ENGINE>
+    inline std::uint64_t uniform_bounded(ENGINE& engine, std::uint64_t range) noexcept
+    {
+        unsigned __int128 m = (unsigned __int128)engine() * range;
+        std::uint64_t low = static_cast<std::uint64_t>(m);
+        if (low < range) [[unlikely]]
+        {
+            const std::uint64_t threshold = (0 - range) % range;
+            while(low < threshold)
+            {
+                m = (unsigned __int128)engine() * range;
+                low = static_cast<std::uint64_t>(m);
+            }
+        }
+        return static_cast<std::uint64_t>(m >> 64);
+    }
+
+    // [0, 1)
+    template<std::floating_point T>
+    inline T to_unit_interval(std::uint64_t x) noexcept
+    {
+        return static_cast<T>((x >> 11) * 0x1.0p-53);
+    }
+}
+
+namespace alg
+{
+    class xoshiro256ss_x8
+    {
+    public:
+        using result_type = std::uint64_t;
+        static constexpr result_type min() noexcept { return 0; }
+        static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+        static constexpr std::uint32_t lanes = 8;
+
+        explicit xoshiro256ss_x8(std::uint64_t seed = 0) noexcept : xoshiro256ss_x8(xoshiro256ss(seed))
+        {
+        }
+
+        explicit xoshiro256ss_x8(xoshiro256ss base) noexcept
+        {
+            for(std::uint32_t k=0; k!=lanes; ++k)
+            {
+                for(std::uint32_t n=0; n!=4; ++n) m_s[n][k] = base.state()[n];
+                base.jump();
+            }
+        }
+
+        // Interleaved sequence, as lane 0, 1, ..., 7 of step 0, then of step 1, ...
+        inline result_type operator()() noexcept
+        {
+            if (m_pos == lanes)
+            {
+                next_blocks(m_buffer, 1);
+                m_pos = 0;
+            }
+            return m_buffer[m_pos++];
+        }
+
+        // Same sequence as operator()
+        void fill(std::span<std::uint64_t> out) noexcept
+        {
+            std::uint64_t* ptr = out.data();
+            std::uint64_t* end = out.data() + out.size();
+            while(m_pos != lanes && ptr != end) *ptr++ = m_buffer[m_pos++];
+
+            std::uint64_t num_blocks = (end - ptr) / lanes;
+            next_blocks(ptr, num_blocks);
+            ptr += num_blocks * lanes;
+
+            while(ptr != end) *ptr++ = (*this)();
+        }
+
+        // Returns current, this moves 2^192 steps ahead in every lane
+        xoshiro256ss_x8 split() noexcept
+        {
+            xoshiro256ss_x8 ans = *this;
+            for(std::uint32_t k=0; k!=lanes; ++k)
+            {
+                xoshiro256ss lane = get_lane(k);
+                lane.long_jump();
+                set_lane(k, lane);
+            }
+            m_pos = lanes;
+            return ans;
+        }
+
+    private:
+        void next_blocks(std::uint64_t* out, std::uint64_t num_blocks) noexcept
+        {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            if (avx2) next_blocks_avx2  (out, num_blocks);
+            else      next_blocks_scalar(out, num_blocks);
+        }
+
+        void next_blocks_scalar(std::uint64_t* out, std::uint64_t num_blocks) noexcept
+        {
+            for(std::uint64_t b=0; b!=num_blocks; ++b)
+            {
+                for(std::uint32_t k=0; k!=lanes; ++k)
+                {
+                    out[b * lanes + k] = rotl64(m_s[1][k] * 5, 7) * 9;
+                    const std::uint64_t t = m_s[1][k] << 17;
+                    m_s[2][k] ^= m_s[0][k];
+                    m_s[3][k] ^= m_s[1][k];
+                    m_s[1][k] ^= m_s[2][k];
+                    m_s[0][k] ^= m_s[3][k];
+                    m_s[2][k] ^= t;
+                    m_s[3][k] = rotl64(m_s[3][k], 45);
+                }
+            }
+        }
+
+        // No 64 bits multiply in AVX2, x * 5 = (x << 2) + x, x * 9 = (x << 3) + x
+        [[gnu::target("avx2")]]
+        void next_blocks_avx2(std::uint64_t* out, std::uint64_t num_blocks) noexcept
+        {
+            __m256i s[4][2];
+            for(std::uint32_t n=0; n!=4; ++n)
+            {
+                s[n][0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_s[n][0]));
+                s[n][1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_s[n][4]));
+            }
+
+            for(std::uint64_t b=0; b!=num_blocks; ++b)
+            {
+                for(std::uint32_t h=0; h!=2; ++h)
+                {
+                    __m256i x5 = _mm256_add_epi64(_mm256_slli_epi64(s[1][h], 2), s[1][h]);
+                    __m256i r  = _mm256_or_si256 (_mm256_slli_epi64(x5, 7), _mm256_srli_epi64(x5, 57));
+                    __m256i x9 = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + b * lanes + h * 4), x9);
+
+                    __m256i t = _mm256_slli_epi64(s[1][h], 17);
+                    s[2][h] = _mm256_xor_si256(s[2][h], s[0][h]);
+                    s[3][h] = _mm256_xor_si256(s[3][h], s[1][h]);
+                    s[1][h] = _mm256_xor_si256(s[1][h], s[2][h]);
+                    s[0][h] = _mm256_xor_si256(s[0][h], s[3][h]);
+                    s[2][h] = _mm256_xor_si256(s[2][h], t);
+                    s[3][h] = _mm256_or_si256 (_mm256_slli_epi64(s[3][h], 45), _mm256_srli_epi64(s[3][h], 19));
+                }
+            }
+
+            for(std::uint32_t n=0; n!=4; ++n)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&m_s[n][0]), s[n][0]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(&m_s[n][4]), s[n][1]);
+            }
+        }
+
+        xoshiro256ss get_lane(std::uint32_t k) const noexcept
+        {
+            const std::uint64_t s[4] = { m_s[0][k], m_s[1][k], m_s[2][k], m_s[3][k] };
+            return xoshiro256ss(std::span<const std::uint64_t, 4>(s));
+        }
+
+        void set_lane(std::uint32_t k, const xoshiro256ss& lane) noexcept
+        {
+            for(std::uint32_t n=0; n!=4; ++n) m_s[n][k] = lane.state()[n];
+        }
+
+    private:
+        alignas(32) std::uint64_t m_s[4][lanes];
+        alignas(32) std::uint64_t m_buffer[lanes];
+        std::uint32_t m_pos = lanes;
+    };
+}
 
 namespace alg 
 {
+    template<typename ENGINE = xoshiro256ss>
     class pseudo_rand_num_gen
     {
     public:
-        explicit pseudo_rand_num_gen(std::uint64_t seed) : m_seed(seed)
+        explicit pseudo_rand_num_gen(std::uint64_t seed) : m_engine(seed)
+        {
+        }
+
+        explicit pseudo_rand_num_gen(const ENGINE& engine) : m_engine(engine)
         {
-            m_engine.seed(m_seed);
         }
 
         inline auto next() 
@@ -17,30 +432,101 @@ namespace alg
             return m_engine(); 
         }
 
-        std::size_t next_uniform(std::size_t size)
+        std::size_t next_uniform(std::size_t size) // [0, size)
         {
-            std::uniform_int_distribution<std::size_t> distribution(std::size_t{ 0 }, size - 1);
-            return distribution(m_engine);
+            return uniform_bounded(m_engine, size);
         }
 
         template<std::integral T>
         T next_uniform(T min, T max) // min max inclusive
         {
             if (min > max) [[unlikely]] { std::swap(min, max); }
-            std::uniform_int_distribution<T> distribution(min, max);
-            return distribution(m_engine);
+            return map(min, max, m_engine());
         }
 
         template<std::floating_point T>
         T next_uniform(T min, T max)
         {
             if (min > max) [[unlikely]] { std::swap(min, max); }
-            std::uniform_real_distribution<T> distribution(min, max);
-            return distribution(m_engine);
+            return min + (max - min) * to_unit_interval<T>(m_engine());
+        }
+
+    public:
+        // Bulk, uses engine's fill() if there is, e.g. AVX2 in xoshiro256ss_x8
+        void fill(std::span<std::uint64_t> out)
+        {
+            if constexpr (requires { m_engine.fill(out); }) m_engine.fill(out);
+            else for(auto& x:out) x = m_engine();
+        }
+
+        template<std::integral T>
+        void fill(std::span<T> out, T min, T max) // min max inclusive
+        {
+            if (min > max) [[unlikely]] { std::swap(min, max); }
+            fill_chunks(out, [&](std::uint64_t x) { return map(min, max, x); });
+        }
+
+        template<std::floating_point T>
+        void fill(std::span<T> out, T min, T max)
+        {
+            if (min > max) [[unlikely]] { std::swap(min, max); }
+            fill_chunks(out, [&](std::uint64_t x) { return min + (max - min) * to_unit_interval<T>(x); });
+        }
+
+    public:
+        // Independent stream for another thread
+        pseudo_rand_num_gen split()
+        {
+            return pseudo_rand_num_gen(m_engine.split());
+        }
+
+        ENGINE& engine() noexcept
+        {
+            return m_engine;
         }
 
     private:
-        std::uint64_t m_seed;
-        std::mt19937_64 m_engine; // Standard 64-bit Mersenne Twister
+        // Lemire on raw x, rejection draws from engine
+        template<std::integral T>
+        T map(T min, T max, std::uint64_t x)
+        {
+            const std::uint64_t range = static_cast<std::uint64_t>(max) - static_cast<std::uint64_t>(min) + 1;
+            if constexpr (sizeof(T) < 8)
+            {
+                if (range == (1ULL << (8 * sizeof(T)))) return static_cast<T>(x); // full range
+            }
+            if (range == 0) return static_cast<T>(x); // full range
+
+            unsigned __int128 m = (unsigned __int128)x * range;
+            std::uint64_t low = static_cast<std::uint64_t>(m);
+            if (low < range) [[unlikely]]
+            {
+                const std::uint64_t threshold = (0 - range) % range;
+                while(low < threshold)
+                {
+                    m = (unsigned __int128)m_engine() * range;
+                    low = static_cast<std::uint64_t>(m);
+                }
+            }
+            return static_cast<T>(static_cast<std::uint64_t>(min) + static_cast<std::uint64_t>(m >> 64));
+        }
+
+        template<typename T, typename F>
+        void fill_chunks(std::span<T> out, F&& fct)
+        {
+            std::uint64_t raw[256];
+            for(std::uint64_t n=0; n<out.size(); n+=256)
+            {
+                std::uint64_t size = std::min<std::uint64_t>(256, out.size() - n);
+                fill(std::span<std::uint64_t>(raw, size));
+                for(std::uint64_t m=0; m!=size; ++m) out[n+m] = fct(raw[m]);
+            }
+        }
+
+    private:
+        ENGINE m_engine;
     };
+
+    // Integer seed picks default engine, instead of deducing ENGINE = int
+    template<std::integral T> pseudo_rand_num_gen(T) -> pseudo_rand_num_gen<>;
 }
\ No newline at end of file
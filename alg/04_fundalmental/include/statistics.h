@@ -2,7 +2,12 @@
 #include<sstream>
 #include<iomanip>
 #include<cmath>
-#include<set>
+#include<cstdint>
+#include<vector>
+#include<algorithm>
+#include<numbers>
+#include<bit>
+#include<optional>
 
 
 namespace alg
@@ -26,6 +31,373 @@ namespace alg
     };
 }
 
+
+// ************************************************************************************ //
+// *** Percentile backends *** //
+// ************************************************************************************ //
+// Percentile r refers to sample of rank floor((count-1) x r) in ascending order.
+//
+// 1. exact_percentile - keeps all samples in vector, sorted by finalize(), exact
+// 2. hdr_histogram    - HdrHistogram, buckets of power of 2, each split into sub-buckets
+//                       linearly, such that value is kept with given significant digits,
+//                       i.e. relative error <= 10^-digits, memory is fixed on construction,
+//                       add is one index computation and one increment, += adds counters.
+//                       Values are rounded to integer in [0, highest], larger is clamped.
+// 3. t_digest         - merging t-digest (Dunning), samples are buffered, when buffer is
+//                       full or on finalize(), buffer and centroids are sorted and merged,
+//                       with centroid size bounded by scale function k(q) = delta/2pi x
+//                       asin(2q-1), hence tails are kept finer than median. Memory is fixed,
+//                       add is amortised O(log buffer size), += merges centroids.
+//
+// Backend interface : add(x, n), finalize(), get_percentile(r), operator+=, clear().
+// Queries are const and do not modify backend, so they may run concurrently. Call finalize()
+// after last add, otherwise each query sorts or merges a temporary copy of pending samples.
+// ************************************************************************************ //
+namespace alg
+{
+    template<typename T>
+    class exact_percentile
+    {
+    public:
+        void add(const T& x, std::uint64_t n = 1)
+        {
+            values.insert(values.end(), n, x);
+            sorted = false;
+        }
+
+        void finalize()
+        {
+            if (!sorted) std::sort(values.begin(), values.end());
+            sorted = true;
+        }
+
+        T get_percentile(double r) const
+        {
+            if (values.empty()) return T{};
+            std::uint64_t rank = (std::uint64_t)((values.size()-1) * r);
+            if (sorted) return values[rank];
+
+            auto tmp = values;
+            std::nth_element(tmp.begin(), tmp.begin() + rank, tmp.end());
+            return tmp[rank];
+        }
+
+        exact_percentile& operator+=(const exact_percentile& rhs)
+        {
+            values.insert(values.end(), rhs.values.begin(), rhs.values.end());
+            sorted = false;
+            return *this;
+        }
+
+        void clear() noexcept
+        {
+            values.clear();
+            sorted = true;
+        }
+
+    private:
+        std::vector<T> values;
+        bool sorted = true;
+    };
+
+    template<typename T>
+    class hdr_histogram
+    {
+    public:
+        // Default covers 1 hour in nanoseconds, with 3 significant digits, ~300KB
+        explicit hdr_histogram(std::uint32_t significant_digits = 3, std::uint64_t highest = 3600ULL * 1000000000ULL)
+            : highest(std::max<std::uint64_t>(highest, 2))
+        {
+            significant_digits = std::clamp(significant_digits, 1u, 5u);
+            std::uint64_t single_unit = 2;
+            for(std::uint32_t n=0; n!=significant_digits; ++n) single_unit *= 10;
+
+            sub_bucket_half_magnitude = std::bit_width(single_unit - 1) - 1;   // ceil(log2) - 1
+            sub_bucket_half_count     = 1ULL << sub_bucket_half_magnitude;
+            sub_bucket_mask           = (sub_bucket_half_count << 1) - 1;
+
+            // Num of buckets to cover highest, bucket b covers [0, sub_bucket_count << b)
+            std::uint32_t num_buckets = 1;
+            while(num_buckets < 64 - sub_bucket_half_magnitude &&
+                  ((sub_bucket_half_count << 1) << (num_buckets-1)) <= this->highest) ++num_buckets;
+            counts.assign((std::uint64_t)(num_buckets + 1) * sub_bucket_half_count, 0);
+        }
+
+        void add(const T& x, std::uint64_t n = 1) noexcept
+        {
+            counts[index_of(to_value(x))] += n;
+        }
+
+        void finalize() noexcept
+        {
+        }
+
+        T get_percentile(double r) const noexcept
+        {
+            std::uint64_t total = 0;
+            for(auto c : counts) total += c;
+            if (total == 0) return T{};
+
+            std::uint64_t rank = (std::uint64_t)((total-1) * r);
+            std::uint64_t cum  = 0;
+            for(std::uint64_t n=0; n!=counts.size(); ++n)
+            {
+                cum += counts[n];
+                if (cum > rank) return static_cast<T>(value_of(n));
+            }
+            return static_cast<T>(highest);
+        }
+
+        // Requires same configuration
+        hdr_histogram& operator+=(const hdr_histogram& rhs) noexcept
+        {
+            for(std::uint64_t n=0; n!=counts.size() && n!=rhs.counts.size(); ++n) counts[n] += rhs.counts[n];
+            return *this;
+        }
+
+        void clear() noexcept
+        {
+            std::fill(counts.begin(), counts.end(), 0);
+        }
+
+        std::uint64_t memory() const noexcept
+        {
+            return counts.size() * sizeof(std::uint64_t);
+        }
+
+    public:
+        // Bucketing only, for recorders keeping their own counters
+        std::uint64_t num_counts() const noexcept
+        {
+            return counts.size();
+        }
+
+        std::uint64_t to_index(const T& x) const noexcept
+        {
+            return index_of(to_value(x));
+        }
+
+        // Lowest value of index n
+        std::uint64_t value_of(std::uint64_t n) const noexcept
+        {
+            std::int64_t  bucket     = (std::int64_t)(n >> sub_bucket_half_magnitude) - 1;
+            std::uint64_t sub_bucket = (n & (sub_bucket_half_count-1)) + sub_bucket_half_count;
+            if (bucket < 0)
+            {
+                sub_bucket -= sub_bucket_half_count;
+                bucket = 0;
+            }
+            return sub_bucket << bucket;
+        }
+
+    private:
+        std::uint64_t to_value(const T& x) const noexcept
+        {
+            if (!(x > T{})) return 0; // negative and NaN
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                if (x >= (T)highest) return highest;
+                return (std::uint64_t)std::llround(x);
+            }
+            else
+            {
+                return std::min<std::uint64_t>(x, highest);
+            }
+        }
+
+        std::uint64_t index_of(std::uint64_t v) const noexcept
+        {
+            std::uint32_t bucket = std::bit_width(v | sub_bucket_mask) - (sub_bucket_half_magnitude + 1);
+            std::uint64_t sub_bucket = v >> bucket;
+            return ((std::uint64_t)(bucket + 1) << sub_bucket_half_magnitude) + sub_bucket - sub_bucket_half_count;
+        }
+
+    private:
+        std::uint64_t highest;
+        std::uint32_t sub_bucket_half_magnitude;
+        std::uint64_t sub_bucket_half_count;
+        std::uint64_t sub_bucket_mask;
+        std::vector<std::uint64_t> counts;
+    };
+
+    template<typename T>
+    class t_digest
+    {
+    public:
+        explicit t_digest(double compression = 200, std::uint32_t buffer_size = 0)
+            : delta(std::max(compression, 10.0)),
+              capacity(buffer_size > 0? buffer_size : (std::uint32_t)(5 * delta))
+        {
+            centroids.reserve(2 * delta + 8);
+            buffer.reserve(capacity + 2 * delta + 8);
+        }
+
+        void add(const T& x, std::uint64_t n = 1)
+        {
+            buffer.push_back({(double)x, (double)n});
+            if (buffer.size() >= capacity) compress();
+        }
+
+        void finalize()
+        {
+            compress();
+        }
+
+        T get_percentile(double r) const
+        {
+            if (!buffer.empty())
+            {
+                auto tmp = *this;
+                tmp.compress();
+                return tmp.get_percentile(r);
+            }
+            if (centroids.empty()) return T{};
+            if (centroids.size() == 1) return cast(centroids[0].mean);
+
+            // Centroid n is centred at cumulative weight before n + weight/2
+            double target = r * total;
+            double cum = centroids[0].weight / 2;
+            if (target <= cum) return cast(interpolate(min, centroids[0].mean, target / cum));
+            for(std::uint64_t n=0; n+1!=centroids.size(); ++n)
+            {
+                double next = cum + (centroids[n].weight + centroids[n+1].weight) / 2;
+                if (target <= next) return cast(interpolate(centroids[n].mean, centroids[n+1].mean, (target-cum) / (next-cum)));
+                cum = next;
+            }
+            double tail = total - cum;
+            return cast(interpolate(centroids.back().mean, max, tail > 0? (target-cum) / tail : 1));
+        }
+
+        // Pending samples of rhs are merged as they are, rhs is not compressed
+        t_digest& operator+=(const t_digest& rhs)
+        {
+            if (this == &rhs)
+            {
+                auto tmp = rhs;
+                return *this += tmp;
+            }
+            if (rhs.centroids.empty() && rhs.buffer.empty()) return *this;
+            for(const auto* vec : {&rhs.centroids, &rhs.buffer})
+            {
+                for(const auto& c : *vec)
+                {
+                    buffer.push_back(c);
+                    if (buffer.size() >= capacity) compress();
+                }
+            }
+            compress();
+            if (rhs.total > 0)
+            {
+                min = std::min(min, rhs.min);
+                max = std::max(max, rhs.max);
+            }
+            return *this;
+        }
+
+        void clear() noexcept
+        {
+            centroids.clear();
+            buffer.clear();
+            total = 0;
+        }
+
+        std::uint64_t num_centroids() const
+        {
+            if (!buffer.empty())
+            {
+                auto tmp = *this;
+                tmp.compress();
+                return tmp.centroids.size();
+            }
+            return centroids.size();
+        }
+
+    private:
+        struct centroid
+        {
+            double mean;
+            double weight;
+        };
+
+        double k_of(double q) const noexcept
+        {
+            return delta / (2 * std::numbers::pi) * std::asin(2 * q - 1);
+        }
+
+        double q_of(double k) const noexcept
+        {
+            if (k >= delta / 4) return 1;
+            return (std::sin(k * 2 * std::numbers::pi / delta) + 1) / 2;
+        }
+
+        static double interpolate(double x0, double x1, double t) noexcept
+        {
+            return x0 + (x1 - x0) * std::clamp(t, 0.0, 1.0);
+        }
+
+        static T cast(double x) noexcept
+        {
+            if constexpr (std::is_integral_v<T>) return static_cast<T>(std::llround(x));
+            else return static_cast<T>(x);
+        }
+
+        // Merge buffer into centroids, buffer is reused for sorting, no allocation
+        void compress()
+        {
+            if (buffer.empty()) return;
+            if (total == 0) min = max = buffer[0].mean;
+            for(const auto& c : buffer)
+            {
+                min = std::min(min, c.mean);
+                max = std::max(max, c.mean);
+                total += c.weight;
+            }
+            buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+            std::sort(buffer.begin(), buffer.end(), [](const auto& lhs, const auto& rhs) { return lhs.mean < rhs.mean; });
+
+            centroids.clear();
+            centroid current = buffer[0];
+            double cum = 0;
+            double q_limit = q_of(k_of(0) + 1);
+            for(std::uint64_t n=1; n!=buffer.size(); ++n)
+            {
+                if ((cum + current.weight + buffer[n].weight) / total <= q_limit)
+                {
+                    current.weight += buffer[n].weight;
+                    current.mean   += (buffer[n].mean - current.mean) * buffer[n].weight / current.weight;
+                }
+                else
+                {
+                    centroids.push_back(current);
+                    cum += current.weight;
+                    q_limit = q_of(k_of(cum / total) + 1);
+                    current = buffer[n];
+                }
+            }
+            centroids.push_back(current);
+            buffer.clear();
+        }
+
+    private:
+        double delta;
+        std::uint32_t capacity;
+        std::vector<centroid> centroids;
+        std::vector<centroid> buffer;
+        double total = 0;
+        double min = 0;
+        double max = 0;
+    };
+}
+
+
+// ************************************************************************************ //
+// *** Statistics *** //
+// ************************************************************************************ //
+// Mean and variance are updated by Welford, merged by Chan et al, instead of sum of
+// squares, which loses precision by cancellation in sum_sq/count - mean^2, and overflows
+// for integral T. Percentiles are delegated to backend. Reports get_string() and get_str()
+// take one finalized copy of backend for all percentiles, unless finalize() was called.
+// ************************************************************************************ //
 namespace alg
 {
     template<typename T> 
@@ -34,26 +406,43 @@ namespace alg
                           divisible<T>;
 
 
-    template<statistical T>
+    template<statistical T, typename PERCENTILE = exact_percentile<T>>
     class statistics
     {
     public:
-        statistics() : count(0), sum{0}, sum_sq{0}, values{}
+        statistics() : count(0), mean(0), m2(0), percentile{}
+        {
+        }
+        explicit statistics(const PERCENTILE& backend) : count(0), mean(0), m2(0), percentile(backend)
         {
         }
         ~statistics() = default;
-        statistics(const statistics<T>&) = default;
-        statistics(statistics<T>&&) = default;
-        statistics& operator=(const statistics<T>&) = default;
-        statistics& operator=(statistics<T>&&) = default;
+        statistics(const statistics&) = default;
+        statistics(statistics&&) = default;
+        statistics& operator=(const statistics&) = default;
+        statistics& operator=(statistics&&) = default;
 
     public:
         void add(const T& x)
         {
             ++count;
-            sum += x;
-            sum_sq += x*x;
-            values.insert(x);
+            double delta = (double)x - mean;
+            mean += delta / count;
+            m2   += delta * ((double)x - mean);
+            percentile.add(x);
+            finalized = false;
+        }
+
+        // Add n samples of the same value x
+        void add(const T& x, std::uint64_t n)
+        {
+            if (n == 0) return;
+            count += n;
+            double delta = (double)x - mean;
+            mean += delta * n / count;
+            m2   += delta * ((double)x - mean) * n;
+            percentile.add(x, n);
+            finalized = false;
         }
 
         auto get_count() const
@@ -64,33 +453,49 @@ namespace alg
         T get_mean() const
         {
             if (count==0) return 0;
-            return sum/count;
+            return static_cast<T>(mean);
         }
 
         T get_stddev() const
         {
             if (count==0) return 0;
-            return std::sqrt(sum_sq/count - (sum/count)*(sum/count));
+            return static_cast<T>(std::sqrt(m2/count));
         }
 
-        T get_percentile(double r) const
+        // Sort or merge pending samples of backend, before concurrent or repeated queries
+        void finalize()
         {
-            std::uint32_t N = (values.size()-1) * r;
+            percentile.finalize();
+            finalized = true;
+        }
 
-            auto iter = values.begin();
-            for(std::uint32_t n=0; n!=N; ++n) ++iter;
-            return *iter; 
+        T get_percentile(double r) const
+        {
+            return percentile.get_percentile(r);
         }
 
         statistics& operator+=(const statistics& rhs)
         {
-            count  += rhs.count;
-            sum    += rhs.sum;
-            sum_sq += rhs.sum_sq;
-            values.insert(rhs.values.begin(), rhs.values.end());
+            if (rhs.count == 0) return *this;
+            std::uint64_t n = count + rhs.count;
+            double delta = rhs.mean - mean;
+            mean += delta * rhs.count / n;
+            m2   += rhs.m2 + delta * delta * ((double)count * rhs.count / n);
+            count = n;
+            percentile += rhs.percentile;
+            finalized = false;
             return *this;
         }
 
+        void clear()
+        {
+            count = 0;
+            mean  = 0;
+            m2    = 0;
+            percentile.clear();
+            finalized = true;
+        }
+
     public:
         std::string get_string() const 
         {
@@ -98,12 +503,14 @@ namespace alg
             ss << "\ncount   : " << get_count();
             if (get_count() > 0)
             {
+                std::optional<PERCENTILE> copy;
+                const auto& backend = finalized_backend(copy);
                 ss << "\naverage = " << get_mean();
                 ss << "\nstd dev = " << get_stddev();
                 ss << "\npercent = ";
                 for(auto x : {0.001, 0.01, 0.05, 0.10, 0.25, 0.50, 0.75, 0.90, 0.95, 0.99, 0.999})
                 {
-                    ss << x*100 << "% " << get_percentile(x) << "| ";
+                    ss << x*100 << "% " << backend.get_percentile(x) << "| ";
                 }
             }
             return ss.str();
@@ -115,18 +522,36 @@ namespace alg
             ss << "|";
             if (get_count() > 0)
             {
+                std::optional<PERCENTILE> copy;
+                const auto& backend = finalized_backend(copy);
                 for(auto x : {0.001, 0.01, 0.10, 0.25, 0.50, 0.75, 0.90, 0.99, 0.999})
                 {
-                    ss << x*100 << "% " << get_percentile(x) << "| ";
+                    ss << x*100 << "% " << backend.get_percentile(x) << "| ";
                 }
             }
             return ss.str();
         }
 
     private:
-        std::uint32_t count;
-        T sum;
-        T sum_sq;
-        std::multiset<T> values;
+        const PERCENTILE& finalized_backend(std::optional<PERCENTILE>& copy) const
+        {
+            if (finalized) return percentile;
+            copy.emplace(percentile);
+            copy->finalize();
+            return *copy;
+        }
+
+    private:
+        std::uint64_t count;
+        double mean;
+        double m2;
+        PERCENTILE percentile;
+        bool finalized = true;
     };
+
+    template<statistical T>
+    using hdr_statistics = statistics<T, hdr_histogram<T>>;
+
+    template<statistical T>
+    using t_digest_statistics = statistics<T, t_digest<T>>;
 }
@@ -2,7 +2,44 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <cpuid.h>
 
+
+// ************************************************************************************ //
+// *** TSC clock *** //
+// ************************************************************************************ //
+// Reading TSC :
+// * rdtsc()       is not serialized, cpu may execute it earlier / later than nearby code
+// * rdtsc_start() is lfence + rdtsc + lfence, earlier code retires before, later code
+//                 starts after, use it at the beginning of a measurement
+// * rdtsc_stop()  is rdtscp + lfence, rdtscp waits for earlier code, lfence keeps later
+//                 code out, use it at the end of a measurement, falls back to lfence +
+//                 rdtsc + lfence if cpu has no RDTSCP (CPUID 0x80000001 EDX bit 27)
+// * rdtscp() and rdtscp_stop() execute RDTSCP unconditionally, check tsc_info::m_rdtscp
+//
+// TSC is only usable as a clock if it is invariant, i.e. constant rate across P-states
+// and C-states, which is reported by CPUID 0x80000007 EDX bit 8, see tsc_info. Otherwise
+// rdstc_timer falls back to CLOCK_MONOTONIC_RAW : its *_cycles() return raw nanosec and
+// conversion is identity, see is_tsc_clock(). Free functions rdtsc() etc always read TSC.
+//
+// Calibration against CLOCK_MONOTONIC_RAW :
+// * initial rate is taken from CPUID 0x15 / 0x16 if available, else measured over 10ms
+// * each sample reads the raw clock bracketed by two TSC reads, best of 5 brackets
+// * recalibrate() measures how far current conversion has drifted from the raw clock
+//   (reported as drift_ppm) and slews rate so that the error is absorbed over the next
+//   interval
+//
+// Conversion is fixed point, ns = ns_base + ((tsc - tsc_base) * mult) >> 32, parameters
+// are published by a seqlock, readers on any thread never block nor write shared memory,
+// only recalibrate() (one thread) writes.
+//
+// New rate takes effect at a switch point 100us ahead, before which the previous segment
+// is kept, hence readers never see a TSC value converted by both old and new rate, and
+// conversion is continuous and monotonic (unless the writer is preempted for > 100us).
+// ************************************************************************************ //
 namespace alg
 {
     inline std::uint64_t rdtsc() noexcept
@@ -12,6 +49,83 @@ namespace alg
         __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
         return (static_cast<std::uint64_t>(high) << 32) | low;
     }
+
+    // aux is IA32_TSC_AUX, which Linux sets to (numa node << 12) | cpu
+    inline std::uint64_t rdtscp(std::uint32_t& aux) noexcept
+    {
+        std::uint32_t low;
+        std::uint32_t high;
+        __asm__ volatile("rdtscp" : "=a"(low), "=d"(high), "=c"(aux));
+        return (static_cast<std::uint64_t>(high) << 32) | low;
+    }
+
+    inline std::uint64_t rdtsc_start() noexcept
+    {
+        std::uint32_t low;
+        std::uint32_t high;
+        __asm__ volatile("lfence\n\trdtsc\n\tlfence" : "=a"(low), "=d"(high) :: "memory");
+        return (static_cast<std::uint64_t>(high) << 32) | low;
+    }
+
+    inline std::uint64_t rdtscp_stop() noexcept
+    {
+        std::uint32_t low;
+        std::uint32_t high;
+        __asm__ volatile("rdtscp\n\tlfence" : "=a"(low), "=d"(high) :: "rcx", "memory");
+        return (static_cast<std::uint64_t>(high) << 32) | low;
+    }
+}
+
+namespace alg
+{
+    struct tsc_info
+    {
+        bool          m_invariant = false;
+        bool          m_rdtscp    = false;
+        std::uint64_t m_cpuid_hz  = 0;   // 0 if CPUID does not enumerate TSC frequency
+    };
+
+    inline tsc_info detect_tsc() noexcept
+    {
+        tsc_info ans;
+        std::uint32_t eax, ebx, ecx, edx;
+
+        std::uint32_t max_ext = __get_cpuid_max(0x80000000, nullptr);
+        if (max_ext >= 0x80000007 && __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        {
+            ans.m_invariant = (edx >> 8) & 1;
+        }
+        if (max_ext >= 0x80000001 && __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx))
+        {
+            ans.m_rdtscp = (edx >> 27) & 1;
+        }
+
+        // Leaf 0x15 : TSC = crystal * ebx / eax, crystal in ecx may be 0,
+        // in which case it is derived from base frequency in leaf 0x16
+        std::uint32_t max_std = __get_cpuid_max(0, nullptr);
+        if (max_std >= 0x15 && __get_cpuid(0x15, &eax, &ebx, &ecx, &edx) && eax != 0 && ebx != 0)
+        {
+            std::uint32_t den = eax;
+            std::uint32_t num = ebx;
+            if (ecx != 0)
+            {
+                ans.m_cpuid_hz = static_cast<std::uint64_t>(ecx) * num / den;
+            }
+            else if (max_std >= 0x16 && __get_cpuid(0x16, &eax, &ebx, &ecx, &edx) && eax != 0)
+            {
+                ans.m_cpuid_hz = static_cast<std::uint64_t>(eax) * 1000000;
+            }
+        }
+        return ans;
+    }
+
+    // Initialised before main, hence a constant on hot path, RDTSCP is SIGILL if unsupported
+    inline const bool has_rdtscp = detect_tsc().m_rdtscp;
+
+    inline std::uint64_t rdtsc_stop() noexcept
+    {
+        return has_rdtscp? rdtscp_stop() : rdtsc_start();
+    }
 }
 
 namespace alg
@@ -19,71 +133,287 @@ namespace alg
     class rdstc_timer
     {
     public:
-        using clock = std::chrono::steady_clock;
+        // Idempotent, conversions call it on first use
+        static void init()
+        {
+            std::call_once(init_flag_, []()
+            {
+                info_ = detect_tsc();
 
-        // Call once at startup (logger thread)
-        static void init() noexcept
+                sample s0 = take_sample();
+                std::uint64_t mult;
+                if (!tsc_clock_)
+                {
+                    mult = 1ULL << 32;
+                }
+                else if (info_.m_cpuid_hz > 0)
+                {
+                    mult = (static_cast<unsigned __int128>(1000000000) << 32) / info_.m_cpuid_hz;
+                }
+                else
+                {
+                    sample s1;
+                    do
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                        s1 = take_sample();
+                    }
+                    while(s1.m_raw_ns - s0.m_raw_ns < 10000000);
+                    mult = (static_cast<unsigned __int128>(s1.m_raw_ns - s0.m_raw_ns) << 32) / (s1.m_tsc - s0.m_tsc);
+                    s0 = s1;
+                }
+                ns_per_cycle_.store(static_cast<double>(mult) / 4294967296.0, std::memory_order_relaxed);
+                segment seg{s0.m_tsc, s0.m_raw_ns, mult};
+                publish(seg, seg, s0.m_wall_offset);
+                last_ = s0;
+            });
+        }
+
+        static const tsc_info& info()
+        {
+            init();
+            return info_;
+        }
+
+        // False if TSC is not invariant, cycles are then nanosec of CLOCK_MONOTONIC_RAW
+        static bool is_tsc_clock() noexcept
         {
-            last_cycles_ = rdtsc();
-            last_time_   = clock::now();
+            return tsc_clock_;
         }
 
         // Hot path
         static inline std::uint64_t now_cycles() noexcept
         {
-            return rdtsc();
+            return tsc_clock_? rdtsc() : raw_ns();
         }
 
-        // Logger / background thread
-        static inline std::chrono::nanoseconds
-        to_nanoseconds(std::uint64_t cycles) noexcept
+        static inline std::uint64_t start_cycles() noexcept
         {
-            const double ns_per_cycle =
-                ns_per_cycle_.load(std::memory_order_relaxed);
+            return tsc_clock_? rdtsc_start() : raw_ns();
+        }
 
+        static inline std::uint64_t stop_cycles() noexcept
+        {
+            return tsc_clock_? rdtsc_stop() : raw_ns();
+        }
+
+        // Any thread, duration of a number of cycles
+        static inline std::chrono::nanoseconds
+        to_nanoseconds(std::uint64_t cycles)
+        {
+            const params p = load();
             return std::chrono::nanoseconds(
-                static_cast<std::uint64_t>(cycles * ns_per_cycle)
+                static_cast<std::uint64_t>((static_cast<unsigned __int128>(cycles) * p.m_current.m_mult) >> 32)
             );
         }
 
-        // Call periodically (logger thread)
-        static void recalibrate() noexcept
+        // Any thread, TSC to CLOCK_MONOTONIC_RAW in nanosec
+        static inline std::int64_t to_raw_ns(std::uint64_t tsc)
         {
-            const auto now_time   = clock::now();
-            const auto now_cycles = rdtsc();
+            return convert(load(), tsc);
+        }
 
-            const auto dt_ns =
-                std::chrono::duration_cast<std::chrono::nanoseconds>(
-                    now_time - last_time_
-                ).count();
+        // Any thread, TSC to CLOCK_REALTIME in nanosec since epoch
+        static inline std::int64_t to_wall_ns(std::uint64_t tsc)
+        {
+            const params p = load();
+            return convert(p, tsc) + p.m_wall_offset;
+        }
 
-            const std::uint64_t dt_cycles =
-                now_cycles - last_cycles_;
+        static inline std::chrono::system_clock::time_point to_time_point(std::uint64_t tsc)
+        {
+            return std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(to_wall_ns(tsc)))
+            );
+        }
+
+        // Measured rate of last calibration
+        static double ns_per_cycle()
+        {
+            init();
+            return ns_per_cycle_.load(std::memory_order_relaxed);
+        }
 
-            // Guard against very small intervals
-            if (dt_cycles > 0 && dt_ns > 0)
+        // Error of conversion against raw clock, found by last recalibrate(), over its interval
+        static double drift_ppm() noexcept
+        {
+            return drift_ppm_.load(std::memory_order_relaxed);
+        }
+
+        // Call periodically from one thread only, e.g. once per second
+        static void recalibrate()
+        {
+            init();
+            const sample s = take_sample();
+            const params p = load();
+
+            // Raw clock needs no rate, only wall offset may change
+            if (!tsc_clock_)
             {
-                const double new_ns_per_cycle =
-                    static_cast<double>(dt_ns) /
-                    static_cast<double>(dt_cycles);
-
-                ns_per_cycle_.store(
-                    new_ns_per_cycle,
-                    std::memory_order_relaxed
-                );
+                publish(p.m_previous, p.m_current, s.m_wall_offset);
+                last_ = s;
+                return;
             }
 
-            last_time_   = now_time;
-            last_cycles_ = now_cycles;
+            const std::int64_t dt_ns     = s.m_raw_ns - last_.m_raw_ns;
+            const std::int64_t dt_cycles = static_cast<std::int64_t>(s.m_tsc - last_.m_tsc);
+
+            // Guard against very small intervals, and against last switch point not yet reached
+            if (dt_cycles < 1000 || dt_ns < 1000) return;
+            if (static_cast<std::int64_t>(s.m_tsc - p.m_current.m_tsc_base) < 0) return;
+
+            const std::int64_t predicted = convert(p, s.m_tsc);
+            const std::int64_t error     = predicted - s.m_raw_ns;
+            drift_ppm_   .store(static_cast<double>(error) * 1e6 / dt_ns, std::memory_order_relaxed);
+            ns_per_cycle_.store(static_cast<double>(dt_ns) / dt_cycles,   std::memory_order_relaxed);
+
+            // New rate meets raw clock after another dt_ns
+            std::int64_t target = dt_ns - error;
+            if (target < dt_ns / 2) target = dt_ns / 2;
+            const std::uint64_t mult = (static_cast<unsigned __int128>(target) << 32) / static_cast<std::uint64_t>(dt_cycles);
+
+            // Switch from current segment to new segment 100us ahead, where both agree
+            const std::uint64_t margin     = (static_cast<unsigned __int128>(100000) << 32) / p.m_current.m_mult;
+            const std::uint64_t switch_tsc = rdtsc() + margin;
+            publish(p.m_current, segment{switch_tsc, convert(p, switch_tsc), mult}, s.m_wall_offset);
+            last_ = s;
         }
 
     private:
-        static inline std::atomic<double> ns_per_cycle_ { 0.0 };
+        struct sample
+        {
+            std::uint64_t m_tsc;
+            std::int64_t  m_raw_ns;
+            std::int64_t  m_wall_offset; // realtime - raw
+        };
 
-        static inline std::uint64_t last_cycles_;
-        static inline clock::time_point last_time_;
-    };
-}
+        struct segment
+        {
+            std::uint64_t m_tsc_base;
+            std::int64_t  m_ns_base;
+            std::uint64_t m_mult;
+        };
+
+        struct params
+        {
+            segment      m_previous;    // for tsc before m_current.m_tsc_base
+            segment      m_current;
+            std::int64_t m_wall_offset;
+        };
+
+        static std::int64_t to_ns(const timespec& ts) noexcept
+        {
+            return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        static std::uint64_t raw_ns() noexcept
+        {
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return to_ns(ts);
+        }
+
+        // Raw clock read in the middle of the tightest of 5 TSC brackets
+        static sample take_sample() noexcept
+        {
+            sample ans{};
+            std::uint64_t best = ~0ULL;
+            for(int n=0; n!=5; ++n)
+            {
+                timespec raw;
+                timespec wall;
+                const std::uint64_t t0 = start_cycles();
+                clock_gettime(CLOCK_MONOTONIC_RAW, &raw);
+                const std::uint64_t t1 = stop_cycles();
+                clock_gettime(CLOCK_REALTIME, &wall);
+
+                if (t1 - t0 < best)
+                {
+                    best = t1 - t0;
+                    ans.m_tsc         = t0 + (t1 - t0) / 2;
+                    ans.m_raw_ns      = to_ns(raw);
+                    ans.m_wall_offset = to_ns(wall) - to_ns(raw);
+                }
+            }
+            return ans;
+        }
+
+        static inline std::int64_t convert(const params& p, std::uint64_t tsc) noexcept
+        {
+            const segment& seg = static_cast<std::int64_t>(tsc - p.m_current.m_tsc_base) < 0? p.m_previous : p.m_current;
+            const std::int64_t delta = static_cast<std::int64_t>(tsc - seg.m_tsc_base);
+            return seg.m_ns_base + static_cast<std::int64_t>((static_cast<__int128>(delta) * seg.m_mult) >> 32);
+        }
+
+        // Seqlock reader, retries while writer is publishing
+        static inline params load()
+        {
+            if (seq_.load(std::memory_order_acquire) == 0) init();
+
+            params p;
+            std::uint64_t s0;
+            std::uint64_t s1;
+            do
+            {
+                s0 = seq_.load(std::memory_order_acquire);
+                load(p.m_previous, previous_);
+                load(p.m_current,  current_);
+                p.m_wall_offset = wall_offset_.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                s1 = seq_.load(std::memory_order_relaxed);
+            }
+            while(s0 != s1 || (s0 & 1));
+            return p;
+        }
+
+        // Seqlock writer, one writer only
+        static void publish(const segment& previous, const segment& current, std::int64_t wall_offset) noexcept
+        {
+            const std::uint64_t s = seq_.load(std::memory_order_relaxed);
+            seq_.store(s + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            store(previous_, previous);
+            store(current_,  current);
+            wall_offset_.store(wall_offset, std::memory_order_relaxed);
+            seq_.store(s + 2, std::memory_order_release);
+        }
+
+    private:
+        struct atomic_segment
+        {
+            std::atomic<std::uint64_t> m_tsc_base;
+            std::atomic<std::int64_t>  m_ns_base;
+            std::atomic<std::uint64_t> m_mult;
+        };
 
+        static inline void load(segment& seg, const atomic_segment& src) noexcept
+        {
+            seg.m_tsc_base = src.m_tsc_base.load(std::memory_order_relaxed);
+            seg.m_ns_base  = src.m_ns_base .load(std::memory_order_relaxed);
+            seg.m_mult     = src.m_mult    .load(std::memory_order_relaxed);
+        }
 
+        static inline void store(atomic_segment& dst, const segment& seg) noexcept
+        {
+            dst.m_tsc_base.store(seg.m_tsc_base, std::memory_order_relaxed);
+            dst.m_ns_base .store(seg.m_ns_base,  std::memory_order_relaxed);
+            dst.m_mult    .store(seg.m_mult,     std::memory_order_relaxed);
+        }
 
+    private:
+        static inline std::once_flag init_flag_;
+        static inline tsc_info info_;
+        static inline const bool tsc_clock_ = detect_tsc().m_invariant;
+
+        static inline std::atomic<std::uint64_t> seq_ { 0 };
+        static inline atomic_segment previous_;
+        static inline atomic_segment current_;
+        static inline std::atomic<std::int64_t>  wall_offset_ { 0 };
+
+        static inline std::atomic<double> ns_per_cycle_ { 0.0 };
+        static inline std::atomic<double> drift_ppm_ { 0.0 };
+
+        // Writer only
+        static inline sample last_;
+    };
+}
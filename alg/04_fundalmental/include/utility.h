@@ -7,6 +7,7 @@
 #include<functional>
 
 #include<matrix.h>
+#include<prng.h>
 #include<statistics.h>
 #include<timer.h>
 
@@ -16,6 +17,43 @@ using namespace std::placeholders;
 // ************************* //
 // *** Random generators *** //
 // ************************* //
+// Each thread has its own generator, hence no lock as in std::rand(). Every thread starts
+// from stream 0 of default seed, so data does not depend on scheduling, thread that needs
+// distinct data picks its own stream with set_random_stream(k), e.g. k = thread index.
+inline constexpr std::uint64_t default_random_seed = 0x5eed;
+
+inline alg::pseudo_rand_num_gen<>& random_gen()
+{
+    thread_local alg::pseudo_rand_num_gen<> gen(default_random_seed);
+    return gen;
+}
+
+// Stream k is seed jumped k times, i.e. 2^128 numbers apart, for this thread
+inline void set_random_seed(std::uint64_t seed, std::uint64_t stream = 0)
+{
+    alg::xoshiro256ss engine(seed);
+    for(; stream!=0; --stream) engine.jump();
+    random_gen() = alg::pseudo_rand_num_gen<>(engine);
+}
+
+inline void set_random_stream(std::uint64_t stream)
+{
+    set_random_seed(default_random_seed, stream);
+}
+
+// Same range as std::rand(), i.e. non negative 31 bits
+inline int random_int()
+{
+    return static_cast<int>(random_gen().next() >> 33);
+}
+
+// [min, max), same as min + std::rand() % (max-min), but unbiased
+template<typename T>
+T random_in(T min, T max)
+{
+    return min + static_cast<T>(random_gen().next_uniform(static_cast<std::uint64_t>(max - min)));
+}
+
 inline std::string gen_random_str(std::uint32_t size, std::uint32_t alphabet_set) // 1-26
 {
     std::uint32_t alphabet_set_size = 26;
@@ -27,7 +65,7 @@ inline std::string gen_random_str(std::uint32_t size, std::uint32_t alphabet_set
     std::string ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        char c = 'a' + std::rand() % alphabet_set_size;
+        char c = 'a' + random_in(0U, alphabet_set_size);
         ans.push_back(c);
     }
     return ans;
@@ -53,8 +91,8 @@ inline std::string gen_random_palindrome(std::uint32_t size, std::uint32_t alpha
     auto str = gen_random_str(size, alphabet_set);
     for(std::uint32_t n=0; n!=num_image; ++n)
     {
-        std::uint32_t centre = rand() % str.size();
-        std::uint32_t radius = rand() % max_radius + 1;
+        std::uint32_t centre = random_in<std::uint32_t>(0, str.size());
+        std::uint32_t radius = random_in(0U, max_radius) + 1;
         gen_mirror_image(str, centre, radius);
     }
     return str;
@@ -65,7 +103,7 @@ inline std::vector<bool> gen_random_bool_vec(std::uint32_t size)
     std::vector<bool> ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        ans.push_back(std::rand()%2==0? true : false);
+        ans.push_back(random_int()%2==0? true : false);
     }
     return ans;
 }
@@ -76,7 +114,7 @@ std::vector<T> gen_random_vec(std::uint32_t size, T min, T max)
     std::vector<T> ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        T x = min + std::rand() % (max-min);
+        T x = random_in(min, max);
         ans.push_back(x);
     }
     return ans;
@@ -95,12 +133,12 @@ std::vector<T> gen_random_partial_sorted_vec(std::uint32_t size, T min, T max)
 {
     auto ans = gen_random_sorted_vec(size, min, max);
 
-    std::uint32_t N0 =        rand() % (size/2);
-    std::uint32_t N1 = size - rand() % (size/2);
+    std::uint32_t N0 =        random_in(0U, size/2);
+    std::uint32_t N1 = size - random_in(0U, size/2);
     for(std::uint32_t t=0; t!=N1-N0; ++t)
     {
-        std::uint32_t n0 = rand() & (N1-N0) + N0; 
-        std::uint32_t n1 = rand() & (N1-N0) + N0; 
+        std::uint32_t n0 = N0 + random_in(0U, N1-N0);
+        std::uint32_t n1 = N0 + random_in(0U, N1-N0);
         std::swap(ans[n0], ans[n1]);
     }
     return ans;
@@ -113,7 +151,7 @@ inline std::vector<std::uint32_t> gen_random_mono_increase_vec(std::uint32_t siz
     std::uint32_t x = 0;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        x += min_delta + rand() % (max_delta - min_delta);
+        x += random_in(min_delta, max_delta);
         ans.push_back(x);
     }
     return ans;
@@ -127,7 +165,7 @@ alg::matrix<T> gen_random_mat(std::uint32_t size_y, std::uint32_t size_x, T min,
     {
         for(std::uint32_t x=0; x!=size_x; ++x)
         {
-            ans(y,x) = min + std::rand() % (max-min);
+            ans(y,x) = random_in(min, max);
         }
     }
     return ans;
@@ -144,7 +182,7 @@ inline std::vector<std::uint32_t> gen_random_swapped_order(std::uint32_t size)
 
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        std::uint32_t x = rand()%3;
+        std::uint32_t x = random_in(0U, 3U);
         if (x==1 && n>=1)
         {
             std::swap(ans[n], ans[n-1]);
@@ -173,8 +211,8 @@ inline auto gen_random_objects(std::uint32_t size,
     std::vector<std::pair<std::uint32_t,std::uint32_t>> ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        std::uint32_t w = min_weight + rand()% (max_weight - min_weight);
-        std::uint32_t v = min_value  + rand()% (max_value  - min_value);
+        std::uint32_t w = random_in(min_weight, max_weight);
+        std::uint32_t v = random_in(min_value,  max_value);
         ans.push_back(std::make_pair(w,v));
     }
     return ans;
@@ -193,8 +231,8 @@ inline auto gen_random_jobs(std::uint32_t size,
     std::vector<std::tuple<std::uint32_t,std::uint32_t,std::uint32_t>> ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        std::uint32_t w = min_workload + rand()% (max_workload - min_workload);
-        std::uint32_t p = min_profit   + rand()% (max_profit   - min_profit);
+        std::uint32_t w = random_in(min_workload, max_workload);
+        std::uint32_t p = random_in(min_profit,   max_profit);
         std::uint32_t d = deadlines[n];
         ans.push_back(std::make_tuple(w,p,d));
     }
@@ -215,9 +253,9 @@ inline auto gen_random_boxes(std::uint32_t size,
     std::vector<box> ans;
     for(std::uint32_t n=0; n!=size; ++n)
     {
-        std::uint32_t x = side_min + rand() % (side_max-side_min);
-        std::uint32_t y = side_min + rand() % (side_max-side_min);
-        std::uint32_t z = side_min + rand() % (side_max-side_min);
+        std::uint32_t x = random_in(side_min, side_max);
+        std::uint32_t y = random_in(side_min, side_max);
+        std::uint32_t z = random_in(side_min, side_max);
         std::uint32_t min = std::min(std::min(x, y), z);
         std::uint32_t max = std::max(std::max(x, y), z);
         std::uint32_t mid = x + y + z - min - max;
@@ -244,11 +282,11 @@ inline auto gen_random_bins(std::uint32_t num_obj_min,
                             std::uint32_t size_bin_max)
 {
     bin_packing_problem ans;
-    ans.m_num_objA  =  num_obj_min + rand() % ( num_obj_max -  num_obj_min);
-    ans.m_num_objB  =  num_obj_min + rand() % ( num_obj_max -  num_obj_min);
-    ans.m_size_objA = size_obj_min + rand() % (size_obj_max - size_obj_min);
-    ans.m_size_objB = size_obj_min + rand() % (size_obj_max - size_obj_min);
-    ans.m_size_bin  = size_bin_min + rand() % (size_bin_max - size_bin_min);
+    ans.m_num_objA  = random_in( num_obj_min,  num_obj_max);
+    ans.m_num_objB  = random_in( num_obj_min,  num_obj_max);
+    ans.m_size_objA = random_in(size_obj_min, size_obj_max);
+    ans.m_size_objB = random_in(size_obj_min, size_obj_max);
+    ans.m_size_bin  = random_in(size_bin_min, size_bin_max);
     return ans;
 }
 
@@ -277,8 +315,8 @@ inline auto gen_random_bool_expression(std::uint32_t size)
     for(std::uint32_t n=0; n!=size; ++n)
     {
         bool_symbol x;
-        x.m_value = (rand()%2==0);
-        x.m_logic = (rand()%2==0? logic::OR : logic::AND);
+        x.m_value = (random_int()%2==0);
+        x.m_logic = (random_int()%2==0? logic::OR : logic::AND);
         ans.push_back(x);
     }
     return ans;
@@ -293,12 +331,12 @@ inline auto gen_random_piecewise_linear(std::uint32_t num_lines, std::uint32_t n
     for(std::uint32_t m=0; m!=num_lines; ++m)
     {
         y0 = y1;
-        y1 = (rand() % 2000) / 100.0 - 10.0;
+        y1 = random_in(0, 2000) / 100.0 - 10.0;
 
-        std::uint32_t num_data = num_data_min + rand() % (num_data_max - num_data_min);
+        std::uint32_t num_data = random_in(num_data_min, num_data_max);
         for(std::uint32_t n=0; n!=num_data; ++n)
         {
-            double e = ((rand() % 2000) / 1000.0 - 1.0) * noise_level;
+            double e = (random_in(0, 2000) / 1000.0 - 1.0) * noise_level;
             double y = y0 + (y1-y0) * ((double)n / (double)num_data) + e;
             ans.push_back(y);
         }
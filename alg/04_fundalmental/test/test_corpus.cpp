@@ -0,0 +1,151 @@
+#include<iostream>
+#include<cassert>
+#include<filesystem>
+#include<corpus.h>
+#include<timer.h>
+#include<utility.h>
+
+
+void test_corpus_determinism()
+{
+    // Serial reference, reseeded per record
+    std::uint64_t seed = 2024;
+    std::uint32_t num_records = 1000;
+    auto gen = std::bind(gen_random_vec<std::uint32_t>, _1, 0, 1000);
+    auto gen_var = [&]() { return gen(random_in(0U, 50U)); }; // variable size, including empty
+
+    std::vector<std::vector<std::uint32_t>> expected;
+    for(std::uint32_t n=0; n!=num_records; ++n)
+    {
+        set_random_seed(alg::corpus_seed(seed, n));
+        expected.push_back(gen_var());
+    }
+
+    // Same for any number of threads, caller's stream is untouched
+    std::uint32_t num_error = 0;
+    for(std::uint32_t num_threads : {1,2,3,8})
+    {
+        set_random_seed(7);
+        auto x0 = random_int();
+        set_random_seed(7);
+        auto cor = alg::generate_corpus<std::uint32_t>(seed, num_records, gen_var, num_threads);
+        if (random_int() != x0) ++num_error;
+
+        if (cor.size() != num_records) { ++num_error; continue; }
+        for(std::uint32_t n=0; n!=num_records; ++n)
+        {
+            if (!std::ranges::equal(cor[n], expected[n])) ++num_error;
+        }
+    }
+
+    auto cor = alg::generate_corpus<std::uint32_t>(seed+1, num_records, gen_var);
+    if (std::ranges::equal(cor[0], expected[0]) && !expected[0].empty()) ++num_error;
+    print_summary("corpus, deterministic for any number of threads", num_error, num_records * 4);
+}
+
+void test_corpus_cache()
+{
+    std::string name = "test_corpus_boxes_" + std::to_string(::getpid());
+    std::uint64_t seed = 99;
+    std::uint32_t num_records = 500;
+    std::atomic<std::uint32_t> num_calls{0};
+    auto gen = [&]() { ++num_calls; return gen_random_boxes(20, 5, 50); };
+
+    std::uint32_t num_error = 0;
+    {
+        auto cor0 = alg::load_or_generate_corpus<box>(name, seed, num_records, gen);
+        auto cor1 = alg::load_or_generate_corpus<box>(name, seed, num_records, gen); // from cache
+        if (num_calls != num_records) ++num_error;
+        if (cor0.size() != num_records || cor1.size() != num_records) ++num_error;
+
+        auto ref = alg::generate_corpus<box>(seed, num_records, std::bind(gen_random_boxes, 20, 5, 50));
+        for(std::uint32_t n=0; n!=num_records; ++n)
+        {
+            if (cor1[n].size() != 20 || std::memcmp(cor1[n].data(), ref[n].data(), 20 * sizeof(box)) != 0) ++num_error;
+        }
+
+        // Reader feeds benchmark(), in record order, wraps around
+        auto reader = cor1.reader();
+        for(std::uint32_t n=0; n!=num_records + 1; ++n)
+        {
+            auto vec = reader();
+            if (std::memcmp(vec.data(), cor1[n % num_records].data(), 20 * sizeof(box)) != 0) ++num_error;
+        }
+    }
+
+    // Corrupted file is regenerated
+    std::string path = alg::corpus_path(name, seed, num_records);
+    {
+        std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+        fs.seekp(sizeof(alg::corpus_header) + 8);
+        std::uint64_t bad = ~0ULL;
+        fs.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+    }
+    bool thrown = false;
+    try { alg::mapped_corpus<box> cor(path); } catch(const std::runtime_error&) { thrown = true; }
+    if (!thrown) ++num_error;
+
+    num_calls = 0;
+    auto cor2 = alg::load_or_generate_corpus<box>(name, seed, num_records, gen);
+    if (num_calls != num_records || cor2.size() != num_records) ++num_error;
+
+    // Different arguments are different files
+    num_calls = 0;
+    auto gen_size = [&](std::uint32_t size) { ++num_calls; return gen_random_boxes(size, 5, 50); };
+    auto cor3 = alg::load_or_generate_corpus<box>(name, seed, num_records, gen_size, 21);
+    auto cor4 = alg::load_or_generate_corpus<box>(name, seed, num_records, gen_size, 22);
+    if (num_calls != num_records * 2 || cor3[0].size() != 21 || cor4[0].size() != 22) ++num_error;
+    if (cor3.fingerprint() == cor4.fingerprint() || cor3.fingerprint() != alg::corpus_fingerprint(name + "_21")) ++num_error;
+    std::filesystem::remove(alg::corpus_path(name + "_21", seed, num_records));
+    std::filesystem::remove(alg::corpus_path(name + "_22", seed, num_records));
+
+    // Wrong type is rejected
+    thrown = false;
+    try { alg::mapped_corpus<std::uint32_t> cor(path); } catch(const std::runtime_error&) { thrown = true; }
+    if (!thrown) ++num_error;
+
+    std::filesystem::remove(path);
+    print_summary("corpus, cache and reload", num_error, num_records * 2);
+}
+
+void benchmark_corpus()
+{
+    // Same input as test_sorting
+    std::uint64_t seed = 1;
+    std::uint32_t num_records = 10000;
+    auto gen = std::bind(gen_random_vec<std::uint32_t>, 200, 0, 200);
+    std::string name = "benchmark_corpus_" + std::to_string(::getpid());
+
+    alg::timer timer;
+    timer.click();
+    std::uint64_t sum0 = 0;
+    for(std::uint32_t n=0; n!=num_records; ++n) sum0 += gen()[n % 200];
+    timer.click();
+    auto t_serial = timer.time_elapsed_in_nsec() / 1000;
+
+    timer.click();
+    auto cor0 = alg::generate_corpus<std::uint32_t>(seed, num_records, gen);
+    timer.click();
+    auto t_parallel = timer.time_elapsed_in_nsec() / 1000;
+
+    alg::load_or_generate_corpus<std::uint32_t>(name, seed, num_records, gen_random_vec<std::uint32_t>, 200, 0, 200);
+    timer.click();
+    auto cor1 = alg::load_or_generate_corpus<std::uint32_t>(name, seed, num_records, gen_random_vec<std::uint32_t>, 200, 0, 200);
+    std::uint64_t sum1 = 0;
+    for(std::uint32_t n=0; n!=num_records; ++n) sum1 += cor1[n][n % 200];
+    timer.click();
+    auto t_mapped = timer.time_elapsed_in_nsec() / 1000;
+
+    assert(cor0.size() == cor1.size() && sum0 > 0 && sum1 > 0);
+    std::filesystem::remove(alg::corpus_path(alg::corpus_name(name, 200, 0, 200), seed, num_records));
+    print_summary("corpus benchmark, 10000 x 200", "serial = " + std::to_string(t_serial) + " us, parallel (threads " +
+                                                   std::to_string(std::thread::hardware_concurrency()) + ") = " + std::to_string(t_parallel) +
+                                                   " us, mapped = " + std::to_string(t_mapped) + " us");
+}
+
+void test_corpus()
+{
+    test_corpus_determinism();
+    test_corpus_cache();
+    benchmark_corpus();
+}
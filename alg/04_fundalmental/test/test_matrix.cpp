@@ -0,0 +1,96 @@
+#include<iostream>
+#include<cassert>
+#include<matrix.h>
+#include<utility.h>
+
+
+template<typename T, alg::matrix_layout LAYOUT>
+void test_aligned_matrix_layout(const std::string& name)
+{
+    std::uint32_t num_trial = 50;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t size_y = 1 + rand() % 70;
+        std::uint32_t size_x = 1 + rand() % 70;
+        alg::matrix<T> mat0(size_y, size_x);
+        for(std::uint32_t y=0; y!=size_y; ++y)
+        {
+            for(std::uint32_t x=0; x!=size_x; ++x) mat0(y,x) = rand() % 100;
+        }
+        alg::aligned_matrix<T, LAYOUT> mat1(mat0);
+
+        // Data and each row (row major) or each col (col major) start at cacheline
+        if ((std::uint64_t)mat1.data() % 64 != 0) ++num_error;
+        if (LAYOUT != alg::matrix_layout::tiled && mat1.stride() * sizeof(T) % 64 != 0) ++num_error;
+
+        for(std::uint32_t y=0; y!=size_y; ++y)
+        {
+            for(std::uint32_t x=0; x!=size_x; ++x) if (mat0(y,x) != mat1(y,x)) ++num_error;
+        }
+
+        // Write via submatrix, read via matrix and via nested submatrix
+        std::uint32_t y0 = rand() % size_y;
+        std::uint32_t x0 = rand() % size_x;
+        std::uint32_t sy = 1 + rand() % (size_y - y0);
+        std::uint32_t sx = 1 + rand() % (size_x - x0);
+        auto sub = mat1.submatrix(y0, x0, sy, sx);
+        for(std::uint32_t y=0; y!=sy; ++y)
+        {
+            for(std::uint32_t x=0; x!=sx; ++x) sub(y,x) = mat0(y0+y, x0+x) + 1;
+        }
+        for(std::uint32_t y=0; y!=size_y; ++y)
+        {
+            for(std::uint32_t x=0; x!=size_x; ++x) 
+            {
+                bool inside = y >= y0 && y < y0+sy && x >= x0 && x < x0+sx;
+                if (mat1(y,x) != mat0(y,x) + (inside? 1 : 0)) ++num_error;
+            }
+        }
+
+        alg::matrix_view<const T, LAYOUT> sub_of_sub = sub.submatrix(sy/2, sx/2, sy - sy/2, sx - sx/2);
+        for(std::uint32_t y=0; y!=sub_of_sub.size_y(); ++y)
+        {
+            for(std::uint32_t x=0; x!=sub_of_sub.size_x(); ++x) 
+            {
+                if (sub_of_sub(y,x) != mat1(y0+sy/2+y, x0+sx/2+x)) ++num_error;
+            }
+        }
+
+        // Transposed view shares data
+        if constexpr (LAYOUT != alg::matrix_layout::tiled)
+        {
+            auto tr = mat1.view().transposed();
+            for(std::uint32_t y=0; y!=size_y; ++y)
+            {
+                for(std::uint32_t x=0; x!=size_x; ++x) if (&tr(x,y) != &mat1(y,x)) ++num_error;
+            }
+        }
+    }
+    print_summary("aligned matrix, " + name, num_error, num_trial);
+}
+
+void test_matrix_view_of_matrix()
+{
+    auto mat = gen_random_mat<std::uint32_t>(20, 30, 0, 100);
+    auto sub = mat.view().submatrix(5, 7, 10, 10);
+    sub(2,3) = 12345;
+    assert(mat(7,10) == 12345);
+    assert(sub.row(2) == &mat(7,7));
+
+    const auto& cmat = mat;
+    alg::matrix_view<const std::uint32_t> csub = cmat.view().submatrix(7, 10, 1, 1);
+    assert(csub(0,0) == 12345);
+    print_summary("matrix view of alg::matrix", "succeeded");
+}
+
+void test_matrix()
+{
+    test_aligned_matrix_layout<std::uint32_t, alg::matrix_layout::row_major>("row major, uint32");
+    test_aligned_matrix_layout<std::uint32_t, alg::matrix_layout::col_major>("col major, uint32");
+    test_aligned_matrix_layout<std::uint32_t, alg::matrix_layout::tiled>    ("tiled, uint32");
+    test_aligned_matrix_layout<double,        alg::matrix_layout::row_major>("row major, double");
+    test_aligned_matrix_layout<double,        alg::matrix_layout::tiled>    ("tiled, double");
+    test_aligned_matrix_layout<std::uint8_t,  alg::matrix_layout::col_major>("col major, uint8");
+    test_matrix_view_of_matrix();
+}
@@ -0,0 +1,190 @@
+#include<iostream>
+#include<cassert>
+#include<cmath>
+#include<matrix_kernel.h>
+#include<timer.h>
+#include<utility.h>
+
+
+template<typename T>
+alg::matrix<T> gen_random_real_mat(std::uint32_t size_y, std::uint32_t size_x)
+{
+    alg::matrix<T> mat(size_y, size_x);
+    for(std::uint32_t y=0; y!=size_y; ++y)
+    {
+        for(std::uint32_t x=0; x!=size_x; ++x)
+        {
+            if constexpr (std::is_integral_v<T>) mat(y,x) = (T)(rand() % 21) - 10;
+            else mat(y,x) = (T)(rand() % 2001 - 1000) / 1000;
+        }
+    }
+    return mat;
+}
+
+template<typename VIEW_A, typename VIEW_B, typename T>
+void gemm_naive(const VIEW_A& A, const VIEW_B& B, const alg::matrix_view<T>& C)
+{
+    for(std::uint32_t i=0; i!=C.size_y(); ++i)
+    {
+        for(std::uint32_t j=0; j!=C.size_x(); ++j)
+        {
+            T sum = 0;
+            for(std::uint32_t k=0; k!=A.size_x(); ++k) sum += A(i,k) * B(k,j);
+            C(i,j) = sum;
+        }
+    }
+}
+
+template<typename T>
+bool is_close(T x, T y, std::uint32_t K)
+{
+    if constexpr (std::is_integral_v<T>) return x == y;
+    else return std::fabs(x - y) <= (T)1e-4 * K * (std::is_same_v<T,float>? 100 : 1);
+}
+
+template<typename T>
+void test_gemm(const std::string& name)
+{
+    std::uint32_t num_trial = 100;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t M = 1 + rand() % 150;
+        std::uint32_t N = 1 + rand() % 150;
+        std::uint32_t K = 1 + rand() % 300;
+        std::uint32_t num_threads = 1 + t % 3;
+
+        // Row major A, and col major A as transposed view of K x M
+        auto A  = gen_random_real_mat<T>(M, K);
+        auto At = alg::transpose(A);
+        auto B  = gen_random_real_mat<T>(K, N);
+        alg::matrix<T> C0(M, N);
+        alg::matrix<T> C1(M, N);
+        alg::matrix<T> C2(M, N);
+        gemm_naive(A.view(), B.view(), C0.view());
+        alg::gemm(A.view(), B.view(), C1.view(), num_threads);
+        alg::gemm(At.view().transposed(), B.view(), C2.view(), num_threads);
+
+        for(std::uint32_t i=0; i!=M; ++i)
+        {
+            for(std::uint32_t j=0; j!=N; ++j)
+            {
+                if (!is_close(C0(i,j), C1(i,j), K)) ++num_error;
+                if (!is_close(C0(i,j), C2(i,j), K)) ++num_error;
+            }
+        }
+    }
+    print_summary("gemm, " + name, num_error, num_trial);
+}
+
+void test_gemm_batched()
+{
+    std::uint32_t Z = 3, M = 37, N = 45, K = 29;
+    alg::tensor<double> A(Z, M, K);
+    alg::tensor<double> B(Z, K, N);
+    alg::tensor<double> C(Z, M, N);
+    for(std::uint32_t z=0; z!=Z; ++z)
+    {
+        for(std::uint32_t y=0; y!=M; ++y) for(std::uint32_t x=0; x!=K; ++x) A(z,y,x) = rand() % 10;
+        for(std::uint32_t y=0; y!=K; ++y) for(std::uint32_t x=0; x!=N; ++x) B(z,y,x) = rand() % 10;
+    }
+    alg::gemm_batched(A, B, C);
+
+    std::uint32_t num_error = 0;
+    for(std::uint32_t z=0; z!=Z; ++z)
+    {
+        alg::matrix<double> C0(M, N);
+        gemm_naive(A.view(z), B.view(z), C0.view());
+        for(std::uint32_t y=0; y!=M; ++y) for(std::uint32_t x=0; x!=N; ++x) if (C0(y,x) != C(z,y,x)) ++num_error;
+    }
+    print_summary("gemm batched on tensor", num_error, Z);
+}
+
+void test_gemv_transpose_map_reduce()
+{
+    std::uint32_t num_trial = 100;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t M = 1 + rand() % 200;
+        std::uint32_t N = 1 + rand() % 200;
+        auto A = gen_random_real_mat<double>(M, N);
+        auto B = gen_random_real_mat<double>(M, N);
+
+        // GEMV
+        std::vector<double> v(N);
+        for(auto& x:v) x = (double)(rand() % 100) / 10;
+        auto y = alg::gemv(A, v);
+        for(std::uint32_t i=0; i!=M; ++i)
+        {
+            double sum = 0;
+            for(std::uint32_t j=0; j!=N; ++j) sum += A(i,j) * v[j];
+            if (!is_close(sum, y[i], N)) ++num_error;
+        }
+
+        // Transpose, into tiled layout too
+        auto At = alg::transpose(A);
+        alg::aligned_matrix<double, alg::matrix_layout::tiled> Att(N, M);
+        alg::transpose(A.view(), Att.view());
+        for(std::uint32_t i=0; i!=M; ++i)
+        {
+            for(std::uint32_t j=0; j!=N; ++j) if (At(j,i) != A(i,j) || Att(j,i) != A(i,j)) ++num_error;
+        }
+
+        // Fused map / reduce vs two passes
+        alg::matrix<double> D(M, N);
+        alg::map(D.view(), A.view(), B.view(), [](double a, double b) { return a - b; });
+        double sum_sq0 = 0;
+        for(std::uint32_t i=0; i!=M; ++i)
+        {
+            for(std::uint32_t j=0; j!=N; ++j) sum_sq0 += D(i,j) * D(i,j);
+        }
+        double sum_sq1 = alg::map_reduce(A.view(), B.view(), 0.0,
+                                         [](double a, double b) { return (a-b)*(a-b); },
+                                         [](double x, double y) { return x+y; });
+        if (!is_close(sum_sq0, sum_sq1, M*N)) ++num_error;
+    }
+    print_summary("gemv, transpose, map-reduce", num_error, num_trial);
+}
+
+// GFLOP/s of naive loop (up to size 512, as it takes minutes beyond) and blocked gemm
+template<typename T>
+void benchmark_gemm(const std::string& name, std::uint32_t max_size, std::uint32_t num_threads = 1)
+{
+    for(std::uint32_t N=64; N<=max_size; N*=2)
+    {
+        auto A = gen_random_real_mat<T>(N, N);
+        auto B = gen_random_real_mat<T>(N, N);
+        alg::matrix<T> C0(N, N);
+        alg::matrix<T> C1(N, N);
+        double flop = 2.0 * N * N * N;
+
+        alg::timer timer;
+        std::string naive = "n/a";
+        if (N <= 512)
+        {
+            timer.click();
+            gemm_naive(A.view(), B.view(), C0.view());
+            timer.click();
+            naive = std::to_string(flop / std::max<std::uint64_t>(timer.time_elapsed_in_nsec(), 1)).substr(0,5);
+        }
+        timer.click();
+        alg::gemm(A.view(), B.view(), C1.view(), num_threads);
+        timer.click();
+        std::string blocked = std::to_string(flop / std::max<std::uint64_t>(timer.time_elapsed_in_nsec(), 1)).substr(0,5);
+
+        print_summary("gemm benchmark, " + name + ", size " + std::to_string(N),
+                      "GFLOP/s naive = " + naive + ", blocked = " + blocked);
+    }
+}
+
+void test_matrix_kernel()
+{
+    test_gemm<double>("double");
+    test_gemm<float>("float");
+    test_gemm<std::int64_t>("int64, scalar kernel");
+    test_gemm_batched();
+    test_gemv_transpose_map_reduce();
+    benchmark_gemm<double>("double", 1024);
+    benchmark_gemm<float>("float", 1024);
+}
@@ -0,0 +1,156 @@
+#include<iostream>
+#include<cassert>
+#include<filesystem>
+#include<matrix_mmap.h>
+#include<matrix_kernel.h>
+#include<timer.h>
+#include<utility.h>
+
+
+namespace
+{
+    std::string temp_path(const std::string& name)
+    {
+        return (std::filesystem::temp_directory_path() / ("alg_mmap_" + name)).string();
+    }
+}
+
+void test_mapped_matrix_round_trip()
+{
+    std::uint32_t num_trial = 20;
+    std::uint32_t num_error = 0;
+    std::string path = temp_path("matrix.bin");
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t size_y = 1 + rand() % 100;
+        std::uint32_t size_x = 1 + rand() % 100;
+        auto mat0 = gen_random_mat<std::uint32_t>(size_y, size_x, 0, 1000);
+        alg::save_mapped(path, mat0, t%2 == 0? 4096 : 64);
+
+        alg::mapped_options options;
+        options.m_populate = t%3 == 0;
+        options.m_advice   = t%2 == 0? alg::mapped_advice::sequential : alg::mapped_advice::random;
+        const auto mat1 = alg::open_mapped_matrix<std::uint32_t>(path, options);
+        if (mat1.size_y() != size_y || mat1.size_x() != size_x) { ++num_error; continue; }
+        if ((std::uint64_t)mat1.data() % mat1.storage().header().m_alignment != 0) ++num_error;
+        for(std::uint32_t y=0; y!=size_y; ++y)
+        {
+            for(std::uint32_t x=0; x!=size_x; ++x) if (mat0(y,x) != mat1(y,x)) ++num_error;
+        }
+    }
+    std::filesystem::remove(path);
+    print_summary("mapped matrix, save and open", num_error, num_trial);
+}
+
+void test_mapped_matrix_access()
+{
+    std::string path = temp_path("access.bin");
+    auto mat0 = gen_random_mat<std::int64_t>(30, 40, -100, 100);
+    alg::save_mapped(path, mat0);
+
+    // Copy on write, file unchanged
+    {
+        alg::mapped_options options;
+        options.m_access     = alg::mapped_access::copy_on_write;
+        options.m_huge_pages = true;
+        auto mat1 = alg::open_mapped_matrix<std::int64_t>(path, options);
+        mat1(3,4) = 12345;
+        assert(mat1(3,4) == 12345);
+    }
+    assert(alg::open_mapped_matrix<std::int64_t>(path)(3,4) == mat0(3,4));
+
+    // Write through, file changed
+    {
+        alg::mapped_options options;
+        options.m_access = alg::mapped_access::write_through;
+        auto mat1 = alg::open_mapped_matrix<std::int64_t>(path, options);
+        mat1(3,4) = 12345;
+        bool synced = mat1.storage().sync();
+        assert(synced);
+    }
+    assert(alg::open_mapped_matrix<std::int64_t>(path)(3,4) == 12345);
+
+    // Wrong dtype, wrong rank
+    bool thrown = false;
+    try { alg::open_mapped_matrix<double>(path); } catch(const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+    thrown = false;
+    try { alg::open_mapped_tensor<std::int64_t>(path); } catch(const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    std::filesystem::remove(path);
+    print_summary("mapped matrix, copy on write, write through", "succeeded");
+}
+
+void test_mapped_tensor_and_layout()
+{
+    std::uint32_t num_error = 0;
+    std::string path = temp_path("tensor.bin");
+
+    alg::tensor<float> ten0(4, 17, 23);
+    for(std::uint32_t z=0; z!=4; ++z)
+        for(std::uint32_t y=0; y!=17; ++y)
+            for(std::uint32_t x=0; x!=23; ++x) ten0(z,y,x) = rand() % 1000;
+    alg::save_mapped(path, ten0);
+    const auto ten1 = alg::open_mapped_tensor<float>(path);
+    for(std::uint32_t z=0; z!=4; ++z)
+        for(std::uint32_t y=0; y!=17; ++y)
+            for(std::uint32_t x=0; x!=23; ++x) if (ten0(z,y,x) != ten1(z,y,x)) ++num_error;
+
+    // Tiled aligned matrix keeps its padding and layout
+    alg::aligned_matrix<double, alg::matrix_layout::tiled> mat0(37, 21);
+    for(std::uint32_t y=0; y!=37; ++y)
+        for(std::uint32_t x=0; x!=21; ++x) mat0(y,x) = y * 100 + x;
+    alg::save_mapped(path, mat0);
+    alg::mapped_storage<double> storage(path);
+    auto view = storage.view<alg::matrix_layout::tiled>();
+    for(std::uint32_t y=0; y!=37; ++y)
+        for(std::uint32_t x=0; x!=21; ++x) if (view(y,x) != mat0(y,x)) ++num_error;
+
+    std::filesystem::remove(path);
+    print_summary("mapped tensor, mapped tiled matrix", num_error, 4*17*23 + 37*21);
+}
+
+// Matrix kernels take mapped matrix as is
+void test_mapped_matrix_kernel()
+{
+    std::uint32_t N = 1024;
+    std::string path = temp_path("kernel.bin");
+    alg::matrix<double> A(N, N);
+    for(std::uint32_t y=0; y!=N; ++y)
+        for(std::uint32_t x=0; x!=N; ++x) A(y,x) = (double)(rand() % 100) / 10;
+    alg::save_mapped(path, A);
+
+    alg::timer timer;
+    timer.click();
+    std::ifstream ifs(path, std::ios::binary);
+    alg::matrix<double> A0(N, N);
+    ifs.seekg(4096);
+    ifs.read(reinterpret_cast<char*>(A0.data()), (std::uint64_t)N * N * sizeof(double));
+    timer.click();
+    std::uint64_t time_read = timer.time_elapsed_in_nsec();
+
+    timer.click();
+    auto A1 = alg::open_mapped_matrix<double>(path);
+    timer.click();
+    std::uint64_t time_open = timer.time_elapsed_in_nsec();
+
+    auto C0 = alg::gemm(A0, A0);
+    auto C1 = alg::gemm(A1, A1);
+    auto T1 = alg::transpose(A1);
+    std::uint32_t num_error = 0;
+    for(std::uint32_t y=0; y!=N; ++y)
+        for(std::uint32_t x=0; x!=N; ++x) if (C0(y,x) != C1(y,x) || T1(x,y) != A0(y,x)) ++num_error;
+
+    std::filesystem::remove(path);
+    print_summary("mapped matrix, gemm and transpose", num_error, N*N);
+    print_summary("mapped matrix, 8MB", "read = " + std::to_string(time_read/1000) + " us, open = " + std::to_string(time_open/1000) + " us");
+}
+
+void test_matrix_mmap()
+{
+    test_mapped_matrix_round_trip();
+    test_mapped_matrix_access();
+    test_mapped_tensor_and_layout();
+    test_mapped_matrix_kernel();
+}
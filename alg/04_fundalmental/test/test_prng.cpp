@@ -0,0 +1,210 @@
+#include<iostream>
+#include<cassert>
+#include<cmath>
+#include<thread>
+#include<prng.h>
+#include<timer.h>
+#include<utility.h>
+
+
+void test_prng_engines()
+{
+    // Reference outputs, of reference algorithms, with seeds expanded by splitmix64
+    alg::splitmix64 sm(1234567);
+    assert(sm() ==  6457827717110365317ULL);
+    assert(sm() ==  3203168211198807973ULL);
+    assert(sm() ==  9817491932198370423ULL);
+
+    alg::xoshiro256ss xo(12345);
+    assert(xo() == 13720838825685603483ULL);
+    assert(xo() ==  2398916695208396998ULL);
+    assert(xo() == 17770384849984869256ULL);
+
+    alg::pcg64 pcg(12345, 678);
+    assert(pcg() ==  2591686870358522054ULL);
+    assert(pcg() == 16616658449402138371ULL);
+    assert(pcg() ==  4334048800134992824ULL);
+
+    // Jump commutes with step, advance(n) equals n steps
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=100; ++t)
+    {
+        alg::xoshiro256ss xo0(t);
+        alg::xoshiro256ss xo1(t);
+        xo0.jump(); xo0();
+        xo1(); xo1.jump();
+        if (xo0() != xo1()) ++num_error;
+
+        alg::pcg64 pcg0(t, t);
+        alg::pcg64 pcg1(t, t);
+        pcg0.advance(t * 7);
+        for(std::uint32_t n=0; n!=t*7; ++n) pcg1();
+        if (pcg0() != pcg1()) ++num_error;
+
+        pcg0.advance(1000000000000ULL);
+        pcg1.advance(999999999999ULL);
+        pcg1();
+        if (pcg0() != pcg1()) ++num_error;
+    }
+    print_summary("prng, reference outputs, jump and advance", num_error, 100);
+}
+
+void test_prng_x8()
+{
+    // Lane k of x8 is xoshiro256ss jumped k times
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=20; ++t)
+    {
+        alg::xoshiro256ss base(t);
+        std::vector<alg::xoshiro256ss> lanes;
+        for(std::uint32_t k=0; k!=8; ++k) { lanes.push_back(base); base.jump(); }
+
+        std::vector<std::uint64_t> expected(1000 * 8);
+        for(std::uint32_t n=0; n!=expected.size(); ++n) expected[n] = lanes[n%8]();
+
+        // Mix of fill (multiple of 8 or not) and operator()
+        alg::xoshiro256ss_x8 x8(t);
+        std::vector<std::uint64_t> actual(expected.size());
+        std::uint32_t n = 0;
+        while(n != actual.size())
+        {
+            std::uint32_t size = std::min<std::uint32_t>(random_in(0, 100), actual.size() - n);
+            if (size % 3 == 0) { for(std::uint32_t m=0; m!=size; ++m) actual[n+m] = x8(); }
+            else x8.fill(std::span<std::uint64_t>(actual.data() + n, size));
+            n += size;
+        }
+        if (actual != expected) ++num_error;
+    }
+    print_summary("prng, xoshiro256ss_x8 against 8 scalar lanes", num_error, 20);
+}
+
+void test_prng_bounded()
+{
+    alg::pseudo_rand_num_gen gen(123);
+
+    // Uniform
+    std::uint32_t num_samples = 600000;
+    std::vector<std::uint32_t> counts(6, 0);
+    for(std::uint32_t n=0; n!=num_samples; ++n) ++counts[gen.next_uniform(6)];
+    for(auto x:counts) assert(std::fabs((double)x / num_samples - 1.0/6) < 0.005);
+
+    // Range, inclusive, signed, full range, narrow types
+    std::uint32_t num_error = 0;
+    for(std::uint32_t n=0; n!=100000; ++n)
+    {
+        auto x0 = gen.next_uniform<std::int64_t>(-5, 5);
+        auto x1 = gen.next_uniform<std::uint8_t>(0, 255);
+        auto x2 = gen.next_uniform<double>(-1.0, 1.0);
+        if (x0 < -5 || x0 > 5) ++num_error;
+        if (x2 < -1.0 || x2 >= 1.0) ++num_error;
+        (void)x1;
+    }
+
+    std::vector<std::int16_t> vec0(10001);
+    std::vector<double> vec1(10001);
+    alg::pseudo_rand_num_gen<alg::xoshiro256ss_x8> gen8(456);
+    gen8.fill(std::span<std::int16_t>(vec0), std::int16_t(-300), std::int16_t(300));
+    gen8.fill(std::span<double>(vec1), 10.0, 20.0);
+    for(auto x:vec0) if (x < -300 || x > 300)  ++num_error;
+    for(auto x:vec1) if (x < 10.0 || x >= 20.0) ++num_error;
+    if (*std::min_element(vec0.begin(), vec0.end()) != -300 || *std::max_element(vec0.begin(), vec0.end()) != 300) ++num_error;
+    print_summary("prng, bounded integer and double", num_error, 100000 + 20002);
+}
+
+void test_prng_streams()
+{
+    // Reproducible per thread
+    set_random_seed(42);
+    auto vec0 = gen_random_vec<std::uint32_t>(1000, 0, 1000000);
+    set_random_seed(42);
+    auto vec1 = gen_random_vec<std::uint32_t>(1000, 0, 1000000);
+    assert(vec0 == vec1);
+
+    std::vector<std::uint32_t> vec2;
+    std::thread thread([&]() { set_random_seed(42); vec2 = gen_random_vec<std::uint32_t>(1000, 0, 1000000); });
+    thread.join();
+    assert(vec0 == vec2);
+
+    // New thread starts from stream 0, explicit stream k does not depend on order of threads
+    std::vector<std::vector<std::uint32_t>> vecs(4);
+    std::vector<std::thread> threads;
+    for(std::uint32_t k=0; k!=4; ++k)
+    {
+        threads.emplace_back([&vecs, k]()
+        {
+            if (k != 0) set_random_stream(k);
+            vecs[k] = gen_random_vec<std::uint32_t>(1000, 0, 1000000);
+        });
+    }
+    for(auto& x:threads) x.join();
+    for(std::uint32_t k=0; k!=4; ++k)
+    {
+        set_random_stream(k);
+        assert(gen_random_vec<std::uint32_t>(1000, 0, 1000000) == vecs[k]);
+        if (k != 0) assert(vecs[k] != vecs[k-1]);
+    }
+
+    // Split streams do not overlap within 2^128 steps, check first outputs differ
+    alg::pseudo_rand_num_gen gen(7);
+    auto gen0 = gen.split();
+    auto gen1 = gen.split();
+    assert(gen0.next() != gen1.next());
+
+    alg::pcg64 pcg(7, 0);
+    auto pcg0 = pcg.split();
+    assert(pcg0.increment() != pcg.increment());
+    print_summary("prng, per thread streams and split", "succeeded");
+}
+
+template<typename F>
+std::uint64_t picosec_per_number(std::uint32_t num_numbers, F&& fct)
+{
+    alg::timer timer;
+    timer.click();
+    fct();
+    timer.click();
+    return timer.time_elapsed_in_nsec() * 1000 / num_numbers;
+}
+
+void benchmark_prng()
+{
+    // Buffer fits in L1, timing is generation rather than memory bandwidth
+    std::uint32_t R = 5000;
+    std::uint32_t N = R * 2048;
+    std::vector<std::uint64_t> out(2048);
+    auto to_str = [](std::uint64_t ps) { return std::to_string(ps / 1000) + "." + std::to_string(ps % 1000 / 100); };
+
+    std::mt19937_64 mt(1);
+    alg::splitmix64 sm(1);
+    alg::xoshiro256ss xo(1);
+    alg::pcg64 pcg(1);
+    alg::xoshiro256ss_x8 x8(1);
+    auto ps_rand = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:out) x = std::rand(); });
+    auto ps_mt   = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:out) x = mt();  });
+    auto ps_sm   = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:out) x = sm();  });
+    auto ps_xo   = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:out) x = xo();  });
+    auto ps_pcg  = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:out) x = pcg(); });
+    auto ps_x8   = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) x8.fill(out); });
+    print_summary("prng benchmark, 64 bits", "rand = " + to_str(ps_rand) + ", mt19937_64 = " + to_str(ps_mt) +
+                                             ", splitmix64 = " + to_str(ps_sm) + ", xoshiro256ss = " + to_str(ps_xo) +
+                                             ", pcg64 = " + to_str(ps_pcg) + ", x8 fill = " + to_str(ps_x8) + " ns");
+
+    std::vector<std::uint32_t> bounded(2048);
+    alg::pseudo_rand_num_gen gen(1);
+    alg::pseudo_rand_num_gen<alg::xoshiro256ss_x8> gen8(1);
+    auto ps_mod  = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:bounded) x = std::rand() % 1000; });
+    auto ps_dist = picosec_per_number(N, [&]() { std::uniform_int_distribution<std::uint32_t> dist(0, 999); for(std::uint32_t r=0; r!=R; ++r) for(auto& x:bounded) x = dist(mt); });
+    auto ps_lem  = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) for(auto& x:bounded) x = gen.next_uniform(1000); });
+    auto ps_fill = picosec_per_number(N, [&]() { for(std::uint32_t r=0; r!=R; ++r) gen8.fill(std::span<std::uint32_t>(bounded), 0U, 999U); });
+    print_summary("prng benchmark, [0, 1000)", "rand % = " + to_str(ps_mod) + ", mt19937_64 + distribution = " + to_str(ps_dist) +
+                                               ", lemire = " + to_str(ps_lem) + ", x8 fill = " + to_str(ps_fill) + " ns");
+}
+
+void test_prng()
+{
+    test_prng_engines();
+    test_prng_x8();
+    test_prng_bounded();
+    test_prng_streams();
+    benchmark_prng();
+}
@@ -0,0 +1,142 @@
+#include<iostream>
+#include<cassert>
+#include<cmath>
+#include<random>
+#include<statistics.h>
+#include<timer.h>
+#include<utility.h>
+
+
+namespace
+{
+    // Latency-like, log normal, median ~ 1000
+    std::vector<std::uint64_t> gen_random_latency(std::uint32_t size, std::uint32_t seed)
+    {
+        std::mt19937_64 engine(seed);
+        std::lognormal_distribution<double> dist(std::log(1000.0), 1.0);
+        std::vector<std::uint64_t> ans(size);
+        for(auto& x:ans) x = 1 + (std::uint64_t)dist(engine);
+        return ans;
+    }
+
+    // Fraction of samples below x, in sorted samples
+    double rank_of(const std::vector<std::uint64_t>& sorted, std::uint64_t x)
+    {
+        return (double)(std::lower_bound(sorted.begin(), sorted.end(), x) - sorted.begin()) / sorted.size();
+    }
+}
+
+template<typename STAT>
+void test_statistics_backend(const std::string& name, STAT stat0, double max_error, bool relative)
+{
+    std::uint32_t num_trial = 20;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        // Two halves merged by += vs exact on all
+        auto samples = gen_random_latency(100000, t);
+        STAT stat1 = stat0;
+        STAT stat2 = stat0;
+        alg::statistics<std::uint64_t> exact;
+        for(std::uint32_t n=0; n!=samples.size(); ++n)
+        {
+            if (n%2 == 0) stat1.add(samples[n]);
+            else          stat2.add(samples[n]);
+            exact.add(samples[n]);
+        }
+        stat1 += stat2;
+
+        if (stat1.get_count() != exact.get_count()) ++num_error;
+        if (std::fabs((double)stat1.get_mean()   - (double)exact.get_mean())   > 1) ++num_error;
+        if (std::fabs((double)stat1.get_stddev() - (double)exact.get_stddev()) > 1) ++num_error;
+
+        stat1.finalize();
+        exact.finalize();
+
+        std::sort(samples.begin(), samples.end());
+        for(auto r : {0.001, 0.01, 0.10, 0.25, 0.50, 0.75, 0.90, 0.99, 0.999})
+        {
+            double x0 = exact.get_percentile(r);
+            double x1 = stat1.get_percentile(r);
+            double error = relative? std::fabs(x1-x0) / x0 : std::fabs(rank_of(samples, x1) - r);
+            if (error > max_error) ++num_error;
+        }
+    }
+    print_summary("statistics, " + name, num_error, num_trial);
+}
+
+void test_statistics_welford()
+{
+    // Large offset, small spread, sum of squares cancels catastrophically
+    alg::statistics<double> stat;
+    for(std::uint32_t n=0; n!=1000000; ++n) stat.add(1e9 + (n%2 == 0? 1 : -1));
+    assert(std::fabs(stat.get_mean() - 1e9) < 1e-6);
+    assert(std::fabs(stat.get_stddev() - 1) < 1e-6);
+
+    // Merge of empty and non empty
+    alg::statistics<double> empty;
+    empty += stat;
+    assert(empty.get_count() == stat.get_count());
+    assert(std::fabs(empty.get_stddev() - 1) < 1e-6);
+    print_summary("statistics, welford", "succeeded");
+}
+
+template<typename STAT>
+void test_statistics_finalize(const std::string& name, STAT stat)
+{
+    // Fewer samples than t-digest buffer, query before finalize works on a copy
+    auto samples = gen_random_latency(123, 7);
+    for(auto x:samples) stat.add(x);
+
+    std::vector<std::uint64_t> pending;
+    for(auto r : {0.0, 0.10, 0.50, 0.90, 1.0}) pending.push_back(stat.get_percentile(r));
+    const STAT copy = stat;
+    copy.get_percentile(0.5);
+
+    stat.finalize();
+    std::uint32_t num_error = 0;
+    std::uint32_t n = 0;
+    for(auto r : {0.0, 0.10, 0.50, 0.90, 1.0})
+    {
+        if (stat.get_percentile(r) != pending[n] || copy.get_percentile(r) != pending[n]) ++num_error;
+        ++n;
+    }
+    print_summary("statistics, " + name + ", query before and after finalize", num_error, 5);
+}
+
+template<typename STAT>
+void benchmark_statistics_backend(const std::string& name, STAT stat, const std::vector<std::uint64_t>& samples)
+{
+    alg::timer timer;
+    timer.click();
+    for(auto x:samples) stat.add(x);
+    timer.click();
+    std::uint64_t time_add = timer.time_elapsed_in_nsec();
+
+    STAT copy = stat;
+    timer.click();
+    stat += copy;
+    stat.finalize();
+    auto report = stat.get_str();
+    timer.click();
+    std::uint64_t time_merge = timer.time_elapsed_in_nsec();
+
+    print_summary("statistics benchmark, " + name,
+                  "add = " + std::to_string(time_add / samples.size()) + " ns, " +
+                  "merge + report = " + std::to_string(time_merge / 1000) + " us");
+}
+
+void test_statistics()
+{
+    test_statistics_welford();
+    test_statistics_backend("hdr histogram, 3 digits", alg::hdr_statistics<std::uint64_t>(), 1e-3, true);
+    test_statistics_backend("hdr histogram, 2 digits", alg::hdr_statistics<std::uint64_t>(alg::hdr_histogram<std::uint64_t>(2, 1000000000)), 1e-2, true);
+    test_statistics_backend("t-digest",                alg::t_digest_statistics<std::uint64_t>(), 2e-3, false);
+    test_statistics_finalize("exact",    alg::statistics<std::uint64_t>());
+    test_statistics_finalize("t-digest", alg::t_digest_statistics<std::uint64_t>());
+
+    auto samples = gen_random_latency(10000000, 123);
+    benchmark_statistics_backend("exact",         alg::statistics<std::uint64_t>(),          samples);
+    benchmark_statistics_backend("hdr histogram", alg::hdr_statistics<std::uint64_t>(),      samples);
+    benchmark_statistics_backend("t-digest",      alg::t_digest_statistics<std::uint64_t>(), samples);
+}
@@ -0,0 +1,153 @@
+#include<iostream>
+#include<cassert>
+#include<cmath>
+#include<thread>
+#include<vector>
+#include<timer_rdtsc.h>
+#include<utility.h>
+
+
+namespace
+{
+    std::int64_t now_raw_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return (std::int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    std::int64_t now_wall_ns()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (std::int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    // Picosec to nanosec with 1 decimal place
+    std::string to_str(std::uint64_t ps)
+    {
+        return std::to_string(ps / 1000) + "." + std::to_string(ps % 1000 / 100);
+    }
+}
+
+void test_timer_rdtsc_accuracy()
+{
+    const auto& info = alg::rdstc_timer::info();
+    print_summary("rdtsc timer, cpuid", std::string("invariant = ") + (info.m_invariant? "yes" : "no") +
+                                        ", rdtscp = " + (info.m_rdtscp? "yes" : "no") +
+                                        ", clock = " + (alg::rdstc_timer::is_tsc_clock()? "tsc" : "raw") +
+                                        ", cpuid frequency = " + std::to_string(info.m_cpuid_hz / 1000000) + " MHz");
+
+    std::uint32_t num_trial = 10;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        // Duration of 20ms sleep, within 0.5%
+        std::int64_t  raw0 = now_raw_ns();
+        std::uint64_t tsc0 = alg::rdstc_timer::start_cycles();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::uint64_t tsc1 = alg::rdstc_timer::stop_cycles();
+        std::int64_t  raw1 = now_raw_ns();
+        std::int64_t  dt   = alg::rdstc_timer::to_nanoseconds(tsc1 - tsc0).count();
+        if (std::fabs((double)dt - (raw1 - raw0)) > 0.005 * (raw1 - raw0)) ++num_error;
+
+        // Timepoint, within 100us after recalibration
+        alg::rdstc_timer::recalibrate();
+        std::uint64_t tsc = alg::rdstc_timer::now_cycles();
+        std::int64_t  raw = now_raw_ns();
+        std::int64_t wall = now_wall_ns();
+        if (std::abs(alg::rdstc_timer::to_raw_ns(tsc)  - raw)  > 100000) ++num_error;
+        if (std::abs(alg::rdstc_timer::to_wall_ns(tsc) - wall) > 100000) ++num_error;
+    }
+    print_summary("rdtsc timer, against CLOCK_MONOTONIC_RAW", num_error, num_trial);
+    print_summary("rdtsc timer, calibration", "ns per cycle = " + std::to_string(alg::rdstc_timer::ns_per_cycle()) +
+                                              ", drift = " + std::to_string(alg::rdstc_timer::drift_ppm()) + " ppm");
+}
+
+// Readers convert while one thread recalibrates, conversion never goes backward
+void test_timer_rdtsc_stop()
+{
+    // Stop reads after start, with or without RDTSCP
+    std::uint32_t num_trial = 1000;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint64_t tsc0 = alg::rdtsc_start();
+        std::uint64_t tsc1 = alg::rdtsc_stop();
+        if (tsc1 < tsc0) ++num_error;
+        if (alg::has_rdtscp)
+        {
+            std::uint64_t tsc2 = alg::rdtscp_stop();
+            if (tsc2 < tsc1) ++num_error;
+        }
+    }
+    if (alg::has_rdtscp != alg::rdstc_timer::info().m_rdtscp) ++num_error;
+    print_summary("rdtsc timer, stop after start", num_error, num_trial);
+}
+
+void test_timer_rdtsc_monotonic()
+{
+    std::uint32_t num_readers = 3;
+    std::atomic<bool> done(false);
+    std::atomic<std::uint32_t> num_error(0);
+
+    std::vector<std::thread> readers;
+    for(std::uint32_t n=0; n!=num_readers; ++n)
+    {
+        readers.push_back(std::thread([&]()
+        {
+            std::int64_t last = 0;
+            while(!done.load())
+            {
+                std::int64_t ns = alg::rdstc_timer::to_raw_ns(alg::rdstc_timer::start_cycles());
+                if (ns < last) num_error.fetch_add(1);
+                last = ns;
+            }
+        }));
+    }
+
+    for(std::uint32_t n=0; n!=50; ++n)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        alg::rdstc_timer::recalibrate();
+    }
+    done.store(true);
+    for(auto& x:readers) x.join();
+    print_summary("rdtsc timer, monotonic across recalibration", num_error.load(), 50);
+}
+
+template<typename F>
+std::uint64_t picosec_per_call(F&& fct, std::uint32_t num_calls)
+{
+    std::uint64_t tsc0 = alg::rdstc_timer::start_cycles();
+    for(std::uint32_t n=0; n!=num_calls; ++n) fct();
+    std::uint64_t tsc1 = alg::rdstc_timer::stop_cycles();
+    return alg::rdstc_timer::to_nanoseconds(tsc1 - tsc0).count() * 1000 / num_calls; // in picosec
+}
+
+void benchmark_timer_rdtsc()
+{
+    std::uint32_t num_calls = 1000000;
+    volatile std::uint64_t sink = 0;
+    auto ps_rdtsc  = picosec_per_call([&](){ sink = alg::rdtsc();       }, num_calls);
+    auto ps_start  = picosec_per_call([&](){ sink = alg::rdtsc_start(); }, num_calls);
+    auto ps_stop   = picosec_per_call([&](){ sink = alg::rdtsc_stop();  }, num_calls);
+    auto ps_wall   = picosec_per_call([&](){ sink = alg::rdstc_timer::to_wall_ns(alg::rdtsc()); }, num_calls);
+    auto ps_raw    = picosec_per_call([&](){ sink = now_raw_ns(); }, num_calls);
+    auto ps_steady = picosec_per_call([&](){ sink = std::chrono::steady_clock::now().time_since_epoch().count(); }, num_calls);
+
+    print_summary("rdtsc timer benchmark, tsc", "rdtsc = "  + to_str(ps_rdtsc) + " ns, " +
+                                                "start = "  + to_str(ps_start) + " ns, " +
+                                                "stop = "   + to_str(ps_stop) + " ns, " +
+                                                "rdtsc + to_wall_ns = " + to_str(ps_wall) + " ns");
+    print_summary("rdtsc timer benchmark, os", "clock_gettime(RAW) = " + to_str(ps_raw) + " ns, " +
+                                               "steady_clock = " + to_str(ps_steady) + " ns");
+}
+
+void test_timer_rdtsc()
+{
+    test_timer_rdtsc_accuracy();
+    test_timer_rdtsc_stop();
+    test_timer_rdtsc_monotonic();
+    benchmark_timer_rdtsc();
+}
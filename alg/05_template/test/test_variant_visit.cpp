@@ -1,5 +1,6 @@
 #include<cassert>
 #include<memory>
+#include<variant>
 #include<utility.h>
 
 
@@ -0,0 +1,166 @@
+#pragma once
+#include<cstdint>
+#include<vector>
+#include<memory>
+#include<atomic>
+#include<thread>
+#include<chrono>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<sstream>
+
+// *** alg *** //
+#include<statistics.h>
+
+
+// ************************************************************************************ //
+// *** Latency recorder *** //
+// ************************************************************************************ //
+// Each writer thread owns one slot, i.e. its own counters of an HDR histogram, the slot
+// is cacheline aligned and padded, hence writers never share a cacheline.
+//
+// Hot path record(thread_id, ns) :
+// * bucket index is computed by hdr_histogram::to_index()
+// * one counter is incremented by relaxed load + relaxed store, not fetch_add, as there
+//   is only one writer per counter, hence no lock prefix and no shared atomic
+//
+// Snapshot (by one reader, the background thread) :
+// * reads all counters with relaxed load, counters only go up, hence each read is a
+//   valid count, slightly stale at most
+// * reader never writes to slots, reset is logical, interval = current - previous,
+//   where previous is the last snapshot kept by reader, cumulative = current
+// * merged histograms of all threads are passed to callback, as alg::hdr_statistics, with
+//   each bucket taken as weighted sample of its lowest value
+//
+// Background thread snapshots once per period, and once more on stop().
+// ************************************************************************************ //
+namespace alg
+{
+    struct latency_snapshot
+    {
+        std::uint64_t m_index;      // 0, 1, 2, ...
+        hdr_statistics<std::uint64_t> m_interval;
+        hdr_statistics<std::uint64_t> m_cumulative;
+
+        std::string get_str() const
+        {
+            std::stringstream ss;
+            ss << "snapshot " << m_index
+               << ", interval count = "   << m_interval.get_count()   << " " << m_interval.get_str()
+               << ", cumulative count = " << m_cumulative.get_count() << " " << m_cumulative.get_str();
+            return ss.str();
+        }
+    };
+
+    class latency_recorder
+    {
+    public:
+        using callback_type = std::function<void(const latency_snapshot&)>;
+
+        explicit latency_recorder(std::uint32_t num_threads,
+                                  const hdr_histogram<std::uint64_t>& config = hdr_histogram<std::uint64_t>(3, 60ULL * 1000000000ULL))
+            : m_config(config),
+              m_num_counts(config.num_counts()),
+              m_stride((m_num_counts + counts_per_line - 1) / counts_per_line),
+              m_num_threads(num_threads),
+              m_lines(new cacheline[m_stride * num_threads]),
+              m_previous(m_num_counts * num_threads, 0)
+        {
+        }
+
+        ~latency_recorder()
+        {
+            stop();
+        }
+
+        latency_recorder(const latency_recorder&) = delete;
+        latency_recorder& operator=(const latency_recorder&) = delete;
+
+    public:
+        // Hot path, one writer per thread_id
+        void record(std::uint32_t thread_id, std::uint64_t nanosec) noexcept
+        {
+            std::uint64_t n = m_config.to_index(nanosec);
+            auto& counter = m_lines[thread_id * m_stride + n / counts_per_line].m_counts[n % counts_per_line];
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        // One reader only, i.e. either background thread or caller without background thread
+        latency_snapshot snapshot()
+        {
+            // Merge threads by bucket, then feed buckets into statistics as weighted samples
+            std::vector<std::uint64_t> interval(m_num_counts, 0);
+            std::vector<std::uint64_t> cumulative(m_num_counts, 0);
+            for(std::uint64_t t=0; t!=m_num_threads; ++t)
+            {
+                const cacheline* lines = &m_lines[t * m_stride];
+                std::uint64_t* previous = &m_previous[t * m_num_counts];
+                for(std::uint64_t n=0; n!=m_num_counts; ++n)
+                {
+                    std::uint64_t current = lines[n / counts_per_line].m_counts[n % counts_per_line].load(std::memory_order_relaxed);
+                    cumulative[n] += current;
+                    interval[n]   += current - previous[n];
+                    previous[n] = current;
+                }
+            }
+
+            latency_snapshot ans{m_num_snapshots++, hdr_statistics<std::uint64_t>(m_config), hdr_statistics<std::uint64_t>(m_config)};
+            for(std::uint64_t n=0; n!=m_num_counts; ++n)
+            {
+                if (interval[n]   > 0) ans.m_interval  .add(m_config.value_of(n), interval[n]);
+                if (cumulative[n] > 0) ans.m_cumulative.add(m_config.value_of(n), cumulative[n]);
+            }
+            ans.m_interval.finalize();
+            ans.m_cumulative.finalize();
+            return ans;
+        }
+
+        void start(std::chrono::nanoseconds period, const callback_type& callback)
+        {
+            stop();
+            m_run = true;
+            m_thread = std::thread([this, period, callback]()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                while(m_run)
+                {
+                    m_condvar.wait_for(lock, period, [this]() { return !m_run; });
+                    callback(snapshot());
+                }
+            });
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_run = false;
+            }
+            m_condvar.notify_all();
+            if (m_thread.joinable()) m_thread.join();
+        }
+
+    private:
+        static constexpr std::uint64_t counts_per_line = 64 / sizeof(std::uint64_t);
+
+        struct alignas(64) cacheline
+        {
+            std::atomic<std::uint64_t> m_counts[counts_per_line] = {};
+        };
+
+    private:
+        hdr_histogram<std::uint64_t> m_config; // bucketing only, never recorded into
+        std::uint64_t m_num_counts;
+        std::uint64_t m_stride;                // cachelines per slot
+        std::uint64_t m_num_threads;
+        std::unique_ptr<cacheline[]> m_lines;
+        std::vector<std::uint64_t> m_previous;
+        std::uint64_t m_num_snapshots = 0;
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_condvar;
+        bool m_run = false;
+    };
+}
@@ -7,6 +7,7 @@
 #include<thread.h>
 #include<synchronization.h>
 #include<statistics.h>
+#include<latency_recorder.h>
 #include<utility.h>
 
 
@@ -50,10 +51,11 @@ public:
         m_ptr->mark_start_time();
     }
 
-    inline void operator()(std::uint32_t thread_id)
+    inline std::uint64_t operator()(std::uint32_t thread_id)
     {
         m_ptr->mark_stop_time();
         m_ptr->mark_done(thread_id);
+        return m_ptr->nanosec_elapsed();
     }
 
 private:
@@ -80,6 +82,7 @@ std::string task_check(std::uint32_t num_consumers, const std::vector<task_outpu
         ss << "consumer_" << n << " = " << task_counts[n] << ", ";
     }
     ss << "total_task = " << std::accumulate(task_counts.begin(), task_counts.end(), 0) << ", ";
+    stat.finalize();
     ss << "time = "  << stat.get_str();
     return ss.str();
 }
@@ -91,6 +94,8 @@ std::string task_check(std::uint32_t num_consumers, const std::vector<task_outpu
 //
 //            producer          consumer
 // task_spec ----------> queue ----------> task_output
+//                                    |
+//                                    +--> latency_recorder (per consumer slot, snapshot every 100ms)
 //
 namespace alg
 {
@@ -107,6 +112,15 @@ namespace alg
         std::atomic<std::uint32_t> consumers_ready(0);
         std::stop_source source;
 
+        latency_recorder recorder(num_consumers);
+        std::uint64_t num_snapshots = 0;
+        std::uint64_t num_interval_tasks = 0; // sum of interval counts, should match total
+        recorder.start(std::chrono::milliseconds(100), [&](const latency_snapshot& snapshot)
+        {
+            ++num_snapshots;
+            num_interval_tasks += snapshot.m_interval.get_count();
+        });
+
 
         // ***************** //
         // *** Consumers *** //
@@ -128,14 +142,14 @@ namespace alg
                     consumers_ready.fetch_add(1);
                     if (queue.pop(task))
                     {
-                        task(consumer_id);
+                        recorder.record(consumer_id, task(consumer_id));
                     } 
                 }
 
                 // *** Step 2 : Loop until queue is clear *** //
                 while(queue.pop(task))
                 {
-                    task(consumer_id);
+                    recorder.record(consumer_id, task(consumer_id));
                 } 
             }, n));
         }
@@ -174,12 +188,17 @@ namespace alg
         for(auto& x:producers) x.join();
         source.request_stop();
         for(auto& x:consumers) x.join();    
+        recorder.stop();
 
         
         // **************** //
         // *** Checking *** //
         // **************** //
         std::string comment = task_check(num_consumers, task_outputs);
+        auto cumulative = recorder.snapshot().m_cumulative;
+        assert(cumulative.get_count() == task_outputs.size());
+        assert(num_interval_tasks     == task_outputs.size());
         print_summary(test_name, "succeeded, " + comment);
+        print_summary(test_name, "recorder, snapshots = " + std::to_string(num_snapshots) + ", time = " + cumulative.get_str());
     }
 }
@@ -6,6 +6,7 @@
 #include<thread>
 #include<mutex>
 #include<condition_variable>
+#include<trace.h>
 
 
 namespace alg
@@ -72,6 +73,7 @@ namespace alg
                     }
                     if (task) 
                     {
+                        ALG_TRACE_SCOPE("threadpool::task");
                         (*task)(thread_id);
                     }
                 }
@@ -86,6 +88,7 @@ namespace alg
                     }
                     if (task) 
                     {
+                        ALG_TRACE_SCOPE("threadpool::task");
                         (*task)(thread_id);
                     }
                 }
@@ -6,6 +6,7 @@
 #include<thread>
 #include<mutex>
 #include<condition_variable>
+#include<trace.h>
 
 
 namespace alg
@@ -71,6 +72,7 @@ namespace alg
                         } 
                         task = pop_task_without_checking();
                     }
+                    ALG_TRACE_SCOPE("threadpool_j::task");
                     task(thread_id);
                 }
 
@@ -84,6 +86,7 @@ namespace alg
                     }
                     if (task) 
                     {
+                        ALG_TRACE_SCOPE("threadpool_j::task");
                         (*task)(thread_id);
                     }
                 }
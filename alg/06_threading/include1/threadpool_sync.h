@@ -3,6 +3,7 @@
 #include<lockfree_queue.h>
 #include<synchronization.h>
 #include<thread.h>
+#include<trace.h>
 
 
 // ************************************* //
@@ -128,6 +129,7 @@ namespace alg
                 auto task = m_task_queue.pop();
                 if (task)
                 {
+                    ALG_TRACE_SCOPE("threadpool_sync::task");
                     (*task)(thread_id);
                 }
             }
@@ -138,6 +140,7 @@ namespace alg
                 auto task = m_task_queue.pop();
                 if (task)
                 {
+                    ALG_TRACE_SCOPE("threadpool_sync::task");
                     (*task)(thread_id);
                 }
             }
@@ -0,0 +1,586 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<string>
+#include<vector>
+#include<map>
+#include<unordered_map>
+#include<memory>
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<chrono>
+#include<fstream>
+#include<ostream>
+#include<algorithm>
+#include<stdexcept>
+
+// *** alg *** //
+#include<timer_rdtsc.h>
+#include<char_seq.h>
+
+
+// ************************************************************************************ //
+// *** Scoped tracing *** //
+// ************************************************************************************ //
+// ALG_TRACE_SCOPE("name") records rdstc_timer::now_cycles(), i.e. rdtsc() if TSC is
+// invariant, at construction and destruction of a scope object, as one trace_record into
+// the ring of current thread. It is compiled out to nothing unless ALG_TRACE is defined
+// (cmake -DALG_TRACE=ON), define it for all translation units or none, as instrumented
+// headers are otherwise ODR violated.
+//
+// Name ID is interned once per distinct name, by the static member of trace_name<chars...>
+// which is initialised before main, hot path reads it as a constant, no lookup, no guard.
+//
+// trace_buffer is a SPSC ring per thread, writer is the owning thread, reader is the
+// drainer, record is dropped (and counted) if ring is full, hot path never blocks. Ring
+// of an exited thread is reused by the next new thread, so number of rings is bounded by
+// max number of threads alive at once, thread id in trace is the id of the ring.
+// Hot path = 2 x rdtsc + 1 thread local load + 16 bytes store + 1 release store.
+//
+// trace_drainer drains all rings periodically into a binary file :
+// * header  : magic "ALGTRACE", version, ns per cycle, base tsc, base wall time in ns
+// * chunk 1 : names, u32 kind, u32 name id, u32 length, chars
+// * chunk 2 : records, u32 kind, u32 thread id, u32 count, trace_record x count
+// names of records are always written before the records.
+//
+// trace_decoder reads the file offline, and writes Chrome trace JSON (chrome://tracing,
+// Perfetto) or folded stacks with self time (flamegraph.pl, speedscope).
+// ************************************************************************************ //
+namespace alg
+{
+    struct trace_record
+    {
+        std::uint64_t m_begin;      // tsc
+        std::uint32_t m_cycles;     // saturated at 2^32-1
+        std::uint32_t m_name_id;
+    };
+    static_assert(sizeof(trace_record) == 16);
+
+    class trace_buffer
+    {
+    public:
+        static constexpr std::uint64_t capacity = 1 << 14;
+        static constexpr std::uint64_t mask = capacity - 1;
+
+        explicit trace_buffer(std::uint32_t thread_id) : m_thread_id(thread_id), m_records(new trace_record[capacity])
+        {
+        }
+
+        trace_buffer(const trace_buffer&) = delete;
+        trace_buffer& operator=(const trace_buffer&) = delete;
+
+    public:
+        // Writer only
+        inline bool push(const trace_record& record) noexcept
+        {
+            std::uint64_t head = m_head.load(std::memory_order_relaxed);
+            if (head - m_cached_tail == capacity)
+            {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head - m_cached_tail == capacity)
+                {
+                    m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            m_records[head & mask] = record;
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Reader only, fct(const trace_record*, count) is invoked on contiguous spans
+        template<typename F>
+        std::uint64_t pop_all(F&& fct)
+        {
+            std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+            std::uint64_t head = m_head.load(std::memory_order_acquire);
+            if (head == tail) return 0;
+
+            std::uint64_t first = tail & mask;
+            std::uint64_t count = head - tail;
+            std::uint64_t span  = std::min(count, capacity - first);
+            fct(&m_records[first], span);
+            if (span < count) fct(&m_records[0], count - span);
+            m_tail.store(head, std::memory_order_release);
+            return count;
+        }
+
+        std::uint32_t thread_id() const noexcept
+        {
+            return m_thread_id;
+        }
+
+        std::uint64_t num_dropped() const noexcept
+        {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+        // Writer only, on thread exit
+        void release() noexcept
+        {
+            m_released.store(true, std::memory_order_release);
+        }
+
+        // New writer takes over head and cached tail of the exited writer
+        bool try_acquire() noexcept
+        {
+            bool expected = true;
+            return m_released.compare_exchange_strong(expected, false, std::memory_order_acquire);
+        }
+
+    private:
+        // Writer cacheline
+        alignas(64) std::atomic<std::uint64_t> m_head{0};
+        std::uint64_t m_cached_tail = 0;
+        std::atomic<std::uint64_t> m_dropped{0};
+
+        // Reader cacheline
+        alignas(64) std::atomic<std::uint64_t> m_tail{0};
+
+        // Read only, except on change of writer
+        alignas(64) const std::uint32_t m_thread_id;
+        std::unique_ptr<trace_record[]> m_records;
+        std::atomic<bool> m_released{false};
+    };
+}
+
+namespace alg
+{
+    // Buffers outlive their threads, so that records of exited threads are still drained,
+    // and are recycled, records left in a reused ring are kept, and drained in order
+    class trace_registry
+    {
+    public:
+        static trace_registry& instance()
+        {
+            static trace_registry registry;
+            return registry;
+        }
+
+        std::uint32_t intern(const char* name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto iter = m_ids.find(name);
+            if (iter != m_ids.end()) return iter->second;
+
+            std::uint32_t id = m_names.size();
+            m_names.push_back(name);
+            m_ids.emplace(name, id);
+            return id;
+        }
+
+        trace_buffer* attach()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(const auto& x:m_buffers)
+            {
+                if (x->try_acquire()) return x.get();
+            }
+            m_buffers.push_back(std::make_unique<trace_buffer>(m_buffers.size()));
+            return m_buffers.back().get();
+        }
+
+        std::vector<std::string> names(std::uint32_t from) const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (from >= m_names.size()) return {};
+            return std::vector<std::string>(m_names.begin() + from, m_names.end());
+        }
+
+        std::vector<trace_buffer*> buffers() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::vector<trace_buffer*> ans;
+            for(const auto& x:m_buffers) ans.push_back(x.get());
+            return ans;
+        }
+
+    private:
+        trace_registry() = default;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<std::string> m_names;
+        std::unordered_map<std::string, std::uint32_t> m_ids;
+        std::vector<std::unique_ptr<trace_buffer>> m_buffers;
+    };
+
+    // Constant initialised, hence no TLS wrapper on hot path
+    inline thread_local trace_buffer* this_thread_trace_buffer = nullptr;
+    inline thread_local bool this_thread_trace_exited = false;
+
+    // Releases ring on thread exit, touched on attach only, scopes closed after it are dropped
+    struct trace_buffer_owner
+    {
+        ~trace_buffer_owner()
+        {
+            this_thread_trace_exited = true;
+            if (this_thread_trace_buffer != nullptr) this_thread_trace_buffer->release();
+            this_thread_trace_buffer = nullptr;
+        }
+    };
+    inline thread_local trace_buffer_owner this_thread_trace_buffer_owner;
+
+    template<char... chars>
+    struct trace_name
+    {
+        static inline const std::uint32_t id = trace_registry::instance().intern(char_sequence<chars...>::name);
+    };
+
+    template<char... chars>
+    inline std::uint32_t trace_name_id(char_sequence<chars...>) noexcept
+    {
+        return trace_name<chars...>::id;
+    }
+
+    class trace_scope
+    {
+    public:
+        explicit trace_scope(std::uint32_t name_id) noexcept : m_name_id(name_id), m_begin(rdstc_timer::now_cycles())
+        {
+        }
+
+        ~trace_scope()
+        {
+            std::uint64_t cycles = rdstc_timer::now_cycles() - m_begin;
+            trace_buffer* buffer = this_thread_trace_buffer;
+            if (buffer == nullptr) [[unlikely]]
+            {
+                if (this_thread_trace_exited) return;
+                static_cast<void>(this_thread_trace_buffer_owner); // registers its destructor
+                buffer = trace_registry::instance().attach();
+                this_thread_trace_buffer = buffer;
+            }
+            buffer->push(trace_record{m_begin, cycles > 0xFFFFFFFF? 0xFFFFFFFF : static_cast<std::uint32_t>(cycles), m_name_id});
+        }
+
+        trace_scope(const trace_scope&) = delete;
+        trace_scope& operator=(const trace_scope&) = delete;
+
+    private:
+        std::uint32_t m_name_id;
+        std::uint64_t m_begin;
+    };
+}
+
+#define ALG_TRACE_CONCAT_IMPL(x, y) x##y
+#define ALG_TRACE_CONCAT(x, y) ALG_TRACE_CONCAT_IMPL(x, y)
+
+#ifdef ALG_TRACE
+#define ALG_TRACE_SCOPE(name)                                                                 \
+    ::alg::trace_scope ALG_TRACE_CONCAT(alg_trace_scope_, __LINE__)(::alg::trace_name_id(    \
+        []() { using ::alg::operator""_char_seq; return name##_char_seq; }()))
+#else
+#define ALG_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+
+namespace alg
+{
+    namespace trace_detail
+    {
+        constexpr char magic[8] = {'A','L','G','T','R','A','C','E'};
+        constexpr std::uint32_t version = 1;
+        constexpr std::uint32_t chunk_names = 1;
+        constexpr std::uint32_t chunk_records = 2;
+
+        struct header
+        {
+            char          m_magic[8];
+            std::uint32_t m_version;
+            std::uint32_t m_reserved;
+            double        m_ns_per_cycle;
+            std::uint64_t m_base_tsc;
+            std::int64_t  m_base_wall_ns;
+        };
+        static_assert(sizeof(header) == 40);
+
+        template<typename T>
+        void write(std::ofstream& ofs, const T& x)
+        {
+            ofs.write(reinterpret_cast<const char*>(&x), sizeof(T));
+        }
+
+        template<typename T>
+        bool read(std::ifstream& ifs, T& x)
+        {
+            return static_cast<bool>(ifs.read(reinterpret_cast<char*>(&x), sizeof(T)));
+        }
+    }
+
+    class trace_drainer
+    {
+    public:
+        explicit trace_drainer(const std::string& path, std::chrono::milliseconds period = std::chrono::milliseconds(10))
+            : m_ofs(path, std::ios::binary | std::ios::trunc)
+        {
+            if (!m_ofs) throw std::runtime_error("trace_drainer : cannot open " + path);
+
+            trace_detail::header h{};
+            std::memcpy(h.m_magic, trace_detail::magic, sizeof(h.m_magic));
+            h.m_version      = trace_detail::version;
+            h.m_base_tsc     = rdstc_timer::now_cycles();
+            h.m_base_wall_ns = rdstc_timer::to_wall_ns(h.m_base_tsc);
+            h.m_ns_per_cycle = rdstc_timer::ns_per_cycle();
+            trace_detail::write(m_ofs, h);
+
+            m_run = true;
+            m_thread = std::thread([this, period]()
+            {
+                std::unique_lock<std::mutex> lock(m_run_mutex);
+                while(m_run)
+                {
+                    m_condvar.wait_for(lock, period, [this]() { return !m_run; });
+                    drain();
+                }
+            });
+        }
+
+        ~trace_drainer()
+        {
+            stop();
+        }
+
+        trace_drainer(const trace_drainer&) = delete;
+        trace_drainer& operator=(const trace_drainer&) = delete;
+
+    public:
+        // Called by background thread every period, may also be called by any thread
+        void drain()
+        {
+            std::lock_guard<std::mutex> lock(m_drain_mutex);
+            if (!m_ofs.is_open()) return;
+
+            // Records first, names after, as names are interned before records are pushed
+            m_chunk.clear();
+            std::vector<std::pair<std::uint32_t, std::uint64_t>> chunks; // thread id, count
+            for(auto* buffer : trace_registry::instance().buffers())
+            {
+                std::uint64_t count = buffer->pop_all([this](const trace_record* records, std::uint64_t n)
+                {
+                    m_chunk.insert(m_chunk.end(), records, records + n);
+                });
+                if (count > 0) chunks.emplace_back(buffer->thread_id(), count);
+            }
+
+            auto names = trace_registry::instance().names(m_num_names);
+            for(const auto& name : names)
+            {
+                trace_detail::write(m_ofs, trace_detail::chunk_names);
+                trace_detail::write(m_ofs, m_num_names++);
+                trace_detail::write(m_ofs, static_cast<std::uint32_t>(name.size()));
+                m_ofs.write(name.data(), name.size());
+            }
+
+            const trace_record* records = m_chunk.data();
+            for(const auto& [thread_id, count] : chunks)
+            {
+                trace_detail::write(m_ofs, trace_detail::chunk_records);
+                trace_detail::write(m_ofs, thread_id);
+                trace_detail::write(m_ofs, static_cast<std::uint32_t>(count));
+                m_ofs.write(reinterpret_cast<const char*>(records), count * sizeof(trace_record));
+                records += count;
+            }
+            m_num_records += m_chunk.size();
+        }
+
+        // Final drain, then file is closed
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_run_mutex);
+                m_run = false;
+            }
+            m_condvar.notify_all();
+            if (m_thread.joinable()) m_thread.join();
+
+            std::lock_guard<std::mutex> lock(m_drain_mutex);
+            if (m_ofs.is_open()) m_ofs.close();
+        }
+
+        std::uint64_t num_records() const
+        {
+            std::lock_guard<std::mutex> lock(m_drain_mutex);
+            return m_num_records;
+        }
+
+        static std::uint64_t num_dropped()
+        {
+            std::uint64_t ans = 0;
+            for(auto* buffer : trace_registry::instance().buffers()) ans += buffer->num_dropped();
+            return ans;
+        }
+
+    private:
+        std::ofstream m_ofs;
+        std::vector<trace_record> m_chunk;
+        std::uint32_t m_num_names = 0;
+        std::uint64_t m_num_records = 0;
+        mutable std::mutex m_drain_mutex;
+
+        std::thread m_thread;
+        std::mutex m_run_mutex;
+        std::condition_variable m_condvar;
+        bool m_run = false;
+    };
+}
+
+namespace alg
+{
+    struct trace_event
+    {
+        std::uint32_t m_thread_id;
+        std::uint32_t m_name_id;
+        std::uint64_t m_begin_ns;       // since drainer started
+        std::uint64_t m_duration_ns;
+    };
+
+    class trace_decoder
+    {
+    public:
+        explicit trace_decoder(const std::string& path)
+        {
+            std::ifstream ifs(path, std::ios::binary);
+            if (!ifs) throw std::runtime_error("trace_decoder : cannot open " + path);
+
+            trace_detail::header h;
+            if (!trace_detail::read(ifs, h) || std::memcmp(h.m_magic, trace_detail::magic, sizeof(h.m_magic)) != 0)
+                throw std::runtime_error("trace_decoder : not a trace file " + path);
+            if (h.m_version != trace_detail::version)
+                throw std::runtime_error("trace_decoder : unsupported version " + std::to_string(h.m_version));
+            m_base_wall_ns = h.m_base_wall_ns;
+
+            std::uint32_t kind;
+            while(trace_detail::read(ifs, kind))
+            {
+                std::uint32_t id;
+                std::uint32_t size;
+                if (!trace_detail::read(ifs, id) || !trace_detail::read(ifs, size))
+                    throw std::runtime_error("trace_decoder : truncated chunk");
+
+                if (kind == trace_detail::chunk_names)
+                {
+                    std::string name(size, '\0');
+                    if (!ifs.read(name.data(), size)) throw std::runtime_error("trace_decoder : truncated name");
+                    if (m_names.size() <= id) m_names.resize(id + 1);
+                    m_names[id] = std::move(name);
+                }
+                else if (kind == trace_detail::chunk_records)
+                {
+                    std::vector<trace_record> records(size);
+                    if (!ifs.read(reinterpret_cast<char*>(records.data()), size * sizeof(trace_record)))
+                        throw std::runtime_error("trace_decoder : truncated records");
+                    for(const auto& r : records)
+                    {
+                        std::int64_t begin = static_cast<std::int64_t>(r.m_begin - h.m_base_tsc);
+                        m_events.push_back(trace_event{id, r.m_name_id,
+                                                       static_cast<std::uint64_t>(std::max(0.0, begin * h.m_ns_per_cycle)),
+                                                       static_cast<std::uint64_t>(r.m_cycles * h.m_ns_per_cycle)});
+                    }
+                }
+                else throw std::runtime_error("trace_decoder : unknown chunk " + std::to_string(kind));
+            }
+
+            // Sort by thread, then begin, parent before child if same begin
+            std::sort(m_events.begin(), m_events.end(), [](const trace_event& lhs, const trace_event& rhs)
+            {
+                if (lhs.m_thread_id != rhs.m_thread_id) return lhs.m_thread_id < rhs.m_thread_id;
+                if (lhs.m_begin_ns  != rhs.m_begin_ns)  return lhs.m_begin_ns  < rhs.m_begin_ns;
+                return lhs.m_duration_ns > rhs.m_duration_ns;
+            });
+        }
+
+    public:
+        const std::vector<trace_event>& events() const noexcept
+        {
+            return m_events;
+        }
+
+        const std::string& name(std::uint32_t name_id) const
+        {
+            return m_names.at(name_id);
+        }
+
+        std::int64_t base_wall_ns() const noexcept
+        {
+            return m_base_wall_ns;
+        }
+
+        // Complete events ("ph":"X") in microseconds, for chrome://tracing or Perfetto
+        void write_chrome_json(std::ostream& os) const
+        {
+            os << "{\"traceEvents\":[";
+            for(std::uint64_t n=0; n!=m_events.size(); ++n)
+            {
+                const auto& e = m_events[n];
+                os << (n == 0? "\n" : ",\n")
+                   << "{\"name\":\"" << escape(name(e.m_name_id)) << "\",\"ph\":\"X\",\"pid\":0"
+                   << ",\"tid\":"  << e.m_thread_id
+                   << ",\"ts\":"   << e.m_begin_ns / 1000 << "." << digits3(e.m_begin_ns % 1000)
+                   << ",\"dur\":"  << e.m_duration_ns / 1000 << "." << digits3(e.m_duration_ns % 1000) << "}";
+            }
+            os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+        }
+
+        // One line per stack "thread_n;outer;inner self_ns", nesting is inferred from time
+        std::map<std::string, std::uint64_t> folded() const
+        {
+            struct frame
+            {
+                std::uint64_t m_end_ns;
+                std::string   m_path;
+            };
+
+            std::map<std::string, std::uint64_t> ans;
+            std::vector<frame> stack;
+            for(std::uint64_t n=0; n!=m_events.size(); ++n)
+            {
+                const auto& e = m_events[n];
+                if (n == 0 || e.m_thread_id != m_events[n-1].m_thread_id) stack.clear();
+
+                std::uint64_t end_ns = e.m_begin_ns + e.m_duration_ns;
+                while(!stack.empty() && stack.back().m_end_ns <= e.m_begin_ns) stack.pop_back();
+
+                std::string path = (stack.empty()? "thread_" + std::to_string(e.m_thread_id) : stack.back().m_path) + ";" + name(e.m_name_id);
+                ans[path] += e.m_duration_ns;
+                if (!stack.empty())
+                {
+                    auto& parent = ans[stack.back().m_path];
+                    parent -= std::min(parent, e.m_duration_ns);
+                }
+                stack.push_back(frame{end_ns, std::move(path)});
+            }
+            return ans;
+        }
+
+        void write_folded(std::ostream& os) const
+        {
+            for(const auto& [path, self_ns] : folded()) os << path << " " << self_ns << "\n";
+        }
+
+    private:
+        static std::string escape(const std::string& str)
+        {
+            std::string ans;
+            for(char c : str)
+            {
+                if (c == '"' || c == '\\') ans.push_back('\\');
+                ans.push_back(c);
+            }
+            return ans;
+        }
+
+        static std::string digits3(std::uint64_t x)
+        {
+            std::string ans = std::to_string(x);
+            return std::string(3 - ans.size(), '0') + ans;
+        }
+
+    private:
+        std::vector<std::string> m_names;
+        std::vector<trace_event> m_events;
+        std::int64_t m_base_wall_ns = 0;
+    };
+}
@@ -0,0 +1,93 @@
+#include<iostream>
+#include<cassert>
+#include<cmath>
+#include<thread>
+#include<latency_recorder.h>
+#include<timer.h>
+#include<utility.h>
+
+
+void test_latency_recorder_exact()
+{
+    std::uint32_t num_threads = 4;
+    std::uint32_t num_samples = 100000; // per thread
+    alg::latency_recorder recorder(num_threads);
+
+    // Thread t records (t+1) * 1000 + n%1000, no thread shares a value
+    std::vector<std::thread> threads;
+    for(std::uint32_t t=0; t!=num_threads; ++t)
+    {
+        threads.push_back(std::thread([&](std::uint32_t thread_id)
+        {
+            for(std::uint32_t n=0; n!=num_samples; ++n) recorder.record(thread_id, (thread_id+1) * 1000 + n%1000);
+        }, t));
+    }
+    for(auto& x:threads) x.join();
+
+    auto snapshot0 = recorder.snapshot();
+    assert(snapshot0.m_index == 0);
+    assert(snapshot0.m_interval  .get_count() == num_threads * num_samples);
+    assert(snapshot0.m_cumulative.get_count() == num_threads * num_samples);
+    assert(std::fabs((double)snapshot0.m_cumulative.get_mean() - 2999.5) < 5); // bucket lowest value, 3 digits
+    assert(snapshot0.m_cumulative.get_percentile(0.0) == 1000);
+    assert(snapshot0.m_cumulative.get_percentile(1.0) >= 4995);
+
+    // Interval only covers samples since last snapshot
+    for(std::uint32_t n=0; n!=500; ++n) recorder.record(0, 777);
+    auto snapshot1 = recorder.snapshot();
+    assert(snapshot1.m_index == 1);
+    assert(snapshot1.m_interval  .get_count() == 500);
+    assert(snapshot1.m_interval  .get_mean() == 777);
+    assert(snapshot1.m_cumulative.get_count() == num_threads * num_samples + 500);
+
+    auto snapshot2 = recorder.snapshot();
+    assert(snapshot2.m_interval  .get_count() == 0);
+    assert(snapshot2.m_cumulative.get_count() == num_threads * num_samples + 500);
+    print_summary("latency recorder, interval and cumulative", "succeeded");
+}
+
+void test_latency_recorder_background()
+{
+    std::uint32_t num_threads = 3;
+    std::uint32_t num_samples = 1000000; // per thread
+    alg::latency_recorder recorder(num_threads);
+
+    std::uint64_t num_snapshots = 0;
+    std::uint64_t num_interval_samples = 0;
+    std::uint64_t last_cumulative = 0;
+    std::uint32_t num_error = 0;
+    recorder.start(std::chrono::milliseconds(5), [&](const alg::latency_snapshot& snapshot)
+    {
+        if (snapshot.m_index != num_snapshots) ++num_error;
+        if (snapshot.m_cumulative.get_count() != last_cumulative + snapshot.m_interval.get_count()) ++num_error;
+        ++num_snapshots;
+        num_interval_samples += snapshot.m_interval.get_count();
+        last_cumulative = snapshot.m_cumulative.get_count();
+    });
+
+    alg::timer timer;
+    timer.click();
+    std::vector<std::thread> threads;
+    for(std::uint32_t t=0; t!=num_threads; ++t)
+    {
+        threads.push_back(std::thread([&](std::uint32_t thread_id)
+        {
+            for(std::uint32_t n=0; n!=num_samples; ++n) recorder.record(thread_id, 100 + n%100000);
+        }, t));
+    }
+    for(auto& x:threads) x.join();
+    timer.click();
+    recorder.stop();
+
+    if (num_interval_samples != num_threads * num_samples) ++num_error;
+    if (last_cumulative      != num_threads * num_samples) ++num_error;
+    print_summary("latency recorder, background snapshot", num_error, num_snapshots);
+    print_summary("latency recorder, record", std::to_string(timer.time_elapsed_in_nsec() / (num_threads * num_samples)) + " ns per record, " +
+                                              std::to_string(num_snapshots) + " snapshots");
+}
+
+void test_latency_recorder()
+{
+    test_latency_recorder_exact();
+    test_latency_recorder_background();
+}
@@ -65,6 +65,7 @@ namespace test
         }
 
         consumer.join();
+        stat.finalize();
         print_summary(test_name, "succeeded, percentile = " + stat.get_str());
     }
 }
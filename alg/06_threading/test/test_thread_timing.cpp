@@ -18,6 +18,7 @@ void timer_resolution()
         timer.click(); 
         stat.add(timer.time_elapsed_in_nsec());
     }
+    stat.finalize();
     print_summary("time thread - resolution   ", "succeeded, percentile = " + stat.get_str());
 }
 
@@ -39,6 +40,7 @@ void time_thread_creation()
         t.join();
         stat.add(timer.time_elapsed_in_nsec());
     }
+    stat.finalize();
     print_summary("time thread - thread create", "succeeded, percentile = " + stat.get_str());
 }
 
@@ -60,6 +62,7 @@ void time_thread_creation_by_async_call()
 
         stat.add(future.get()); // thread join inside
     }
+    stat.finalize();
     print_summary("time thread - async call   ", "succeeded, percentile = " + stat.get_str());
 }
 
@@ -100,6 +103,7 @@ void time_thread_affinity()
     std::stringstream ss1;
     for(const auto&x : core_pre_affinity)  ss0 << x << " ";
     for(const auto&x : core_post_affinity) ss1 << x << " ";
+    stat.finalize();
     print_summary("time thread - set affinity ", "succeeded, percentile = " + stat.get_str());
     print_summary("time thread - set affinity ", "core used  pre  affinity = [" + ss0.str() + "]");
     print_summary("time thread - set affinity ", "core used  post affinity = [" + ss1.str() + "]");
@@ -123,6 +127,7 @@ void time_thread_priority()
 
         t.join();
     }
+    stat.finalize();
     print_summary("time thread - set priority ", "succeeded, percentile = " + stat.get_str());
 }
 
@@ -146,6 +151,8 @@ void time_mutex_lock_and_unlock()
         timer.click();
         stat1.add(timer.time_elapsed_in_nsec());
     }
+    stat0.finalize();
+    stat1.finalize();
     print_summary("time thread - mutex   lock ", "succeeded, percentile = " + stat0.get_str());
     print_summary("time thread - mutex unlock ", "succeeded, percentile = " + stat1.get_str());
 }
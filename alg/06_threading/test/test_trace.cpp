@@ -0,0 +1,176 @@
+#ifndef ALG_TRACE
+#define ALG_TRACE
+#endif
+
+#include<iostream>
+#include<cassert>
+#include<sstream>
+#include<filesystem>
+#include<thread>
+#include<latch>
+#include<trace.h>
+#include<timer.h>
+#include<utility.h>
+
+
+namespace
+{
+    std::string temp_path(const std::string& name)
+    {
+        return (std::filesystem::temp_directory_path() / ("alg_trace_" + name)).string();
+    }
+
+    void busy_wait(std::uint64_t nanosec)
+    {
+        std::uint64_t tsc = alg::rdstc_timer::now_cycles();
+        while(alg::rdstc_timer::to_nanoseconds(alg::rdstc_timer::now_cycles() - tsc).count() < (std::int64_t)nanosec);
+    }
+
+    void traced_task(std::uint32_t num_inner)
+    {
+        ALG_TRACE_SCOPE("task");
+        busy_wait(2000);
+        for(std::uint32_t n=0; n!=num_inner; ++n)
+        {
+            ALG_TRACE_SCOPE("task::inner");
+            busy_wait(1000);
+        }
+    }
+}
+
+void test_trace_decode()
+{
+    std::string path = temp_path("decode.bin");
+    std::uint32_t num_threads = 3;
+    std::uint32_t num_tasks = 100; // per thread
+    std::uint64_t num_dropped = alg::trace_drainer::num_dropped();
+    {
+        alg::trace_drainer drainer(path, std::chrono::milliseconds(1));
+        std::latch alive(num_threads); // keep threads alive till all are done, so that no ring is reused
+        std::vector<std::thread> threads;
+        for(std::uint32_t t=0; t!=num_threads; ++t)
+        {
+            threads.push_back(std::thread([&]()
+            {
+                for(std::uint32_t n=0; n!=num_tasks; ++n) traced_task(3);
+                alive.arrive_and_wait();
+            }));
+        }
+        for(auto& x:threads) x.join();
+        drainer.stop();
+        assert(drainer.num_records() >= num_threads * num_tasks * 4);
+        assert(alg::trace_drainer::num_dropped() == num_dropped);
+    }
+
+    // Other scopes may be recorded if whole build is traced
+    alg::trace_decoder decoder(path);
+    std::uint32_t num_error = 0;
+    std::uint32_t num_events = 0;
+    for(const auto& e : decoder.events())
+    {
+        if (decoder.name(e.m_name_id) == "task")        { ++num_events; if (e.m_duration_ns < 5000) ++num_error; }
+        if (decoder.name(e.m_name_id) == "task::inner") { ++num_events; if (e.m_duration_ns < 1000) ++num_error; }
+    }
+    if (num_events != num_threads * num_tasks * 4) ++num_error;
+
+    // Inner scopes nest under task, self time of task excludes inner
+    std::uint32_t num_outer = 0;
+    std::uint32_t num_inner = 0;
+    for(const auto& [path, self_ns] : decoder.folded())
+    {
+        if (path.ends_with(";task"))             { ++num_outer; if (self_ns < num_tasks * 2000) ++num_error; }
+        if (path.ends_with(";task;task::inner")) { ++num_inner; if (self_ns < num_tasks * 3000) ++num_error; }
+    }
+    if (num_outer != num_threads || num_inner != num_threads) ++num_error;
+
+    std::stringstream json;
+    decoder.write_chrome_json(json);
+    std::string str = json.str();
+    if (!str.starts_with("{\"traceEvents\":[")) ++num_error;
+    if (str.find("\"name\":\"task::inner\",\"ph\":\"X\"") == std::string::npos) ++num_error;
+
+    std::filesystem::remove(path);
+    print_summary("trace, drain and decode", num_error, num_threads * num_tasks * 4);
+}
+
+void test_trace_recycle()
+{
+    // Rings of exited threads are reused, records of all threads are drained
+    std::string path = temp_path("recycle.bin");
+    std::uint32_t num_rounds = 50;
+    std::uint32_t num_threads = 4; // alive at once
+    std::uint64_t num_buffers = alg::trace_registry::instance().buffers().size();
+    std::uint64_t num_records = 0;
+    {
+        alg::trace_drainer drainer(path, std::chrono::milliseconds(1));
+        for(std::uint32_t r=0; r!=num_rounds; ++r)
+        {
+            std::vector<std::thread> threads;
+            for(std::uint32_t t=0; t!=num_threads; ++t) threads.push_back(std::thread([]() { ALG_TRACE_SCOPE("recycle"); }));
+            for(auto& x:threads) x.join();
+        }
+        drainer.stop();
+        num_records = drainer.num_records();
+    }
+
+    std::uint32_t num_error = 0;
+    if (alg::trace_registry::instance().buffers().size() > num_buffers + num_threads) ++num_error;
+    if (num_records < num_rounds * num_threads) ++num_error;
+    std::filesystem::remove(path);
+    print_summary("trace, rings of exited threads are reused", num_error, 2);
+}
+
+void test_trace_corrupted()
+{
+    std::string path = temp_path("corrupted.bin");
+    std::ofstream(path, std::ios::binary) << "not a trace file, not a trace file, not a trace file";
+    bool thrown = false;
+    try { alg::trace_decoder decoder(path); } catch(const std::runtime_error&) { thrown = true; }
+    assert(thrown);
+    std::filesystem::remove(path);
+    print_summary("trace, decode corrupted file", "succeeded");
+}
+
+void benchmark_trace()
+{
+    std::string path = temp_path("benchmark.bin");
+    alg::trace_drainer drainer(path, std::chrono::seconds(10));
+
+    // Ring is never full, drain is not timed
+    std::uint32_t num_batches = 100;
+    std::uint32_t batch_size = alg::trace_buffer::capacity / 2;
+    std::uint64_t cycles = 0;
+    for(std::uint32_t m=0; m!=num_batches; ++m)
+    {
+        std::uint64_t tsc0 = alg::rdstc_timer::start_cycles();
+        for(std::uint32_t n=0; n!=batch_size; ++n)
+        {
+            ALG_TRACE_SCOPE("benchmark");
+        }
+        std::uint64_t tsc1 = alg::rdstc_timer::stop_cycles();
+        cycles += tsc1 - tsc0;
+        drainer.drain();
+    }
+
+    std::uint64_t tsc0 = alg::rdstc_timer::start_cycles();
+    for(std::uint32_t n=0; n!=100; ++n) alg::rdstc_timer::now_cycles();
+    std::uint64_t tsc1 = alg::rdstc_timer::stop_cycles();
+
+    drainer.stop();
+    std::uint64_t file_size = std::filesystem::file_size(path);
+    std::filesystem::remove(path);
+
+    std::uint64_t num_scopes = (std::uint64_t)num_batches * batch_size;
+    std::uint64_t ps = alg::rdstc_timer::to_nanoseconds(cycles).count() * 1000 / num_scopes;
+    print_summary("trace benchmark", std::to_string(ps / 1000) + "." + std::to_string(ps % 1000 / 100) + " ns per scope, " +
+                                     std::to_string(alg::rdstc_timer::to_nanoseconds(tsc1 - tsc0).count() / 100) + " ns per now_cycles, " +
+                                     std::to_string(file_size / num_scopes) + " bytes per scope");
+}
+
+void test_trace()
+{
+    test_trace_decode();
+    test_trace_recycle();
+    test_trace_corrupted();
+    benchmark_trace();
+}
@@ -3,6 +3,7 @@
 #include<iterator>
 #include<algorithm>
 #include<matrix.h>
+#include<inversion.h>
 
 
 // ***************************************************************************************************************** //
@@ -261,6 +262,14 @@ namespace alpha
         return count;
     }
 
+    // For each middle element, num_larger_on_LHS and num_smaller_on_RHS are found by fenwick tree,
+    // count is exact in 128 bits, as C(N,3) exceeds 64 bits from size 4.7M (strictly decreasing),
+    // while 32 bits siblings wrap from size 2.6K
+    unsigned __int128 count_decreasing_triplet_fenwick(const std::vector<std::uint32_t>& vec) // O(N logN)
+    {
+        return alg::count_decreasing_triplets(vec);
+    }
+
     std::uint32_t count_decreasing_triplet_exhaustive(const std::vector<std::uint32_t>& vec) // O(N^3)
     {
         if (vec.size() < 3) return 0;
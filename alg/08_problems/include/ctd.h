@@ -2,6 +2,10 @@
 #include<numeric>   // for std::iota
 #include<vector>
 #include<algorithm> // for std::next_permutation
+#include<limits>
+#include<queue>
+#include<thread>
+#include<bit>
 
 #include<matrix.h>
 #include<sorting.h>
@@ -17,8 +21,8 @@ namespace ctd
         L2R, DOWN, R2L, UP
     };
 
-    template<typename T>
-    void linear_tranverse(const alg::matrix<T>& mat, 
+    template<typename T, typename STORAGE>
+    void linear_tranverse(const alg::matrix<T, STORAGE>& mat, 
                           std::uint32_t y, 
                           std::uint32_t x, 
                           direction dir,
@@ -31,8 +35,8 @@ namespace ctd
         if (dir == direction::UP)    for(std::uint32_t n=0; n!=sz; ++n) ans.push_back(mat(y-n, x));
     }
 
-    template<typename T> 
-    std::vector<T> spiral_traverse(const alg::matrix<T>& mat)
+    template<typename T, typename STORAGE> 
+    std::vector<T> spiral_traverse(const alg::matrix<T, STORAGE>& mat)
     {
         std::uint32_t co_y = 0;
         std::uint32_t co_x = 0;
@@ -191,6 +195,210 @@ namespace ctd
             ++oiter;
         }
     }
+
+
+
+    // ************************************************************************************ //
+    // *** Loser tree *** //
+    // ************************************************************************************ //
+    // Tournament tree with K' = bit_ceil(K) leaves, internal node keeps the loser of the
+    // match between its two subtrees, the overall winner is kept aside. After winner is
+    // output, its source advances, the new head replays matches from its leaf to root only,
+    // comparing with one loser per level, i.e. log K comparisons per element, without any
+    // sibling lookup as in binary heap. Exhausted source loses to all, equal heads are won
+    // by smaller source index, hence merge is stable.
+    //
+    // Node keeps the loser with its head value, so that replay reads the path only, without
+    // dereferencing iterators, the winner is carried in registers with selects, not branches.
+    // ************************************************************************************ //
+    template<typename ITER, typename CMP>
+    class loser_tree
+    {
+    public:
+        using value_t = typename std::iterator_traits<ITER>::value_type;
+
+        explicit loser_tree(const std::vector<std::pair<ITER,ITER>>& ranges) 
+            : m_ranges(ranges),
+              m_size(std::bit_ceil(std::max<std::uint32_t>(ranges.size(), 1))),
+              m_tree(m_size)
+        {
+            // Winners of all subtrees, bottom up
+            std::vector<player> winners(2 * m_size);
+            for(std::uint32_t k=0; k!=m_size; ++k) winners[m_size+k] = head(k);
+            for(std::uint32_t node=m_size-1; node!=0; --node)
+            {
+                const player& lhs = winners[2*node];
+                const player& rhs = winners[2*node+1];
+                bool lhs_wins = less(lhs, rhs);
+                winners[node] = lhs_wins? lhs : rhs;
+                m_tree [node] = lhs_wins? rhs : lhs;
+            }
+            m_winner = winners[1];
+        }
+
+        bool empty() const noexcept
+        {
+            return m_winner.m_done;
+        }
+
+        const value_t& top() const noexcept
+        {
+            return m_winner.m_key;
+        }
+
+        void pop()
+        {
+            ++m_ranges[m_winner.m_source].first;
+            player w = head(m_winner.m_source);
+
+            for(std::uint32_t node=(m_size+w.m_source)/2; node!=0; node/=2)
+            {
+                player l = m_tree[node];
+                bool swap = less(l, w);
+                m_tree[node].m_key    = swap? w.m_key    : l.m_key;
+                m_tree[node].m_source = swap? w.m_source : l.m_source;
+                m_tree[node].m_done   = swap? w.m_done   : l.m_done;
+                w.m_key    = swap? l.m_key    : w.m_key;
+                w.m_source = swap? l.m_source : w.m_source;
+                w.m_done   = swap? l.m_done   : w.m_done;
+            }
+            m_winner = w;
+        }
+
+    private:
+        struct player
+        {
+            value_t       m_key;
+            std::uint32_t m_source;
+            std::uint32_t m_done;
+        };
+
+        player head(std::uint32_t k) const
+        {
+            if (k >= m_ranges.size() || m_ranges[k].first == m_ranges[k].second) return player{value_t{}, k, 1};
+            return player{*m_ranges[k].first, k, 0};
+        }
+
+        // Order by (done, key, source), evaluated without branches, as the outcome is unpredictable
+        static bool less(const player& a, const player& b)
+        {
+            bool lt = CMP{}(a.m_key, b.m_key);
+            bool gt = CMP{}(b.m_key, a.m_key);
+            return (a.m_done < b.m_done) | ((a.m_done == b.m_done) & (lt | (!gt & (a.m_source < b.m_source))));
+        }
+
+    private:
+        std::vector<std::pair<ITER,ITER>> m_ranges;
+        std::uint32_t m_size;
+        std::vector<player> m_tree; // m_tree[0] is unused, node keeps the loser with its key
+        player m_winner;
+    };
+
+    template<typename ITER, typename OITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void K_merge_loser_tree(const std::vector<std::pair<ITER,ITER>>& ranges, OITER oiter)
+    {
+        if (ranges.size() == 0) return;
+
+        loser_tree<ITER, CMP> tree(ranges);
+        while(!tree.empty())
+        {
+            *oiter = tree.top();
+            ++oiter;
+            tree.pop();
+        }
+    }
+
+
+    // ************************************************************************************ //
+    // *** Parallel K merge *** //
+    // ************************************************************************************ //
+    // Output is split into P slices of equal size, slice p starts at rank r = N x p / P. 
+    // Co-ranking finds split[k] in each range, such that sum of split[k] = r and elements
+    // before splits precede elements after splits, in order (value, source index), same
+    // as loser tree. Then slice p merges [split_p[k], split_p+1[k]) of all ranges, slices
+    // are independent, each thread writes to its own part of the output.
+    //
+    // Co-ranking keeps an interval [lo,hi] containing split[k] of each range. The middle
+    // element x of the widest interval is ranked, rank(x) = number of elements preceding
+    // x in all ranges, by binary search inside each interval :
+    // * rank(x) <  r : x and its predecessors are before split, raise lo of all ranges
+    // * rank(x) >= r : x and its successors are after split, lower hi of all ranges
+    // until all intervals are empty. Counts are searched inside [lo,hi] only, clamped count
+    // still lies between true count and split[k], hence the decision is unchanged.
+    // ITER and OITER must be random access.
+    // ************************************************************************************ //
+    template<typename ITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    std::vector<std::uint64_t> K_merge_co_rank(const std::vector<std::pair<ITER,ITER>>& ranges, std::uint64_t r)
+    {
+        std::uint32_t K = ranges.size();
+        std::vector<std::uint64_t> lo(K, 0);
+        std::vector<std::uint64_t> hi(K);
+        std::vector<std::uint64_t> count(K); // number of elements preceding x in range k
+        for(std::uint32_t k=0; k!=K; ++k) hi[k] = ranges[k].second - ranges[k].first;
+
+        while(true)
+        {
+            std::uint32_t j = 0;
+            for(std::uint32_t k=1; k<K; ++k) 
+            {
+                if (hi[k]-lo[k] > hi[j]-lo[j]) j = k;
+            }
+            if (K == 0 || hi[j] == lo[j]) return lo;
+
+            std::uint64_t m = lo[j] + (hi[j]-lo[j]) / 2;
+            const auto& x = *(ranges[j].first + m);
+
+            std::uint64_t rank = 0;
+            for(std::uint32_t k=0; k!=K; ++k)
+            {
+                auto first = ranges[k].first + lo[k];
+                auto last  = ranges[k].first + hi[k];
+                if      (k < j) count[k] = std::upper_bound(first, last, x, CMP{}) - ranges[k].first; 
+                else if (k > j) count[k] = std::lower_bound(first, last, x, CMP{}) - ranges[k].first; 
+                else            count[k] = m;
+                rank += count[k];
+            }
+
+            if (rank < r)
+            {
+                for(std::uint32_t k=0; k!=K; ++k) lo[k] = std::max(lo[k], count[k]);
+                lo[j] = m+1;
+            }
+            else
+            {
+                for(std::uint32_t k=0; k!=K; ++k) hi[k] = std::min(hi[k], count[k]);
+                hi[j] = m;
+            }
+        }
+    }
+
+    template<typename ITER, typename OITER, typename CMP = std::less<typename std::iterator_traits<ITER>::value_type>>
+    void K_merge_parallel(const std::vector<std::pair<ITER,ITER>>& ranges, OITER oiter, std::uint32_t num_threads)
+    {
+        std::uint64_t N = 0;
+        for(const auto& range:ranges) N += range.second - range.first;
+        num_threads = std::max<std::uint64_t>(1, std::min<std::uint64_t>(num_threads, N / 4096));
+
+        auto run = [&](std::uint32_t p)
+        {
+            std::uint64_t r0 = N * p     / num_threads;
+            std::uint64_t r1 = N * (p+1) / num_threads;
+            auto split0 = K_merge_co_rank<ITER,CMP>(ranges, r0);
+            auto split1 = K_merge_co_rank<ITER,CMP>(ranges, r1);
+
+            std::vector<std::pair<ITER,ITER>> slice(ranges.size());
+            for(std::uint32_t k=0; k!=ranges.size(); ++k)
+            {
+                slice[k] = std::make_pair(ranges[k].first + split0[k], ranges[k].first + split1[k]);
+            }
+            K_merge_loser_tree<ITER, OITER, CMP>(slice, oiter + r0);
+        };
+
+        std::vector<std::thread> threads;
+        for(std::uint32_t p=1; p<num_threads; ++p) threads.emplace_back(run, p);
+        run(0);
+        for(auto& x:threads) x.join();
+    }
 }
 
 
@@ -204,8 +412,9 @@ namespace ctd
 // Find a task assignment to minimize total cost :
 // * method 1 : exhaustive iteration    O(N!)
 // * method 2 : exhaustive recursion    O(N!)  much slower than iteration (as there are duplications)
-// * method 3 : Hungarian               O(N^3) non-doable from scratch
-// * method 4 : simulated annealing     O(N)   non-optimal
+// * method 3 : Hungarian               O(N^3) shortest augmenting path, Jonker-Volgenant style
+// * method 4 : sparse augmentation     O(N x E log E) Dijkstra on given edges only
+// * method 5 : simulated annealing     O(N)   non-optimal
 //
 // The output "ans" is a vector, such that :
 // * ans[n] = task assigned to agent n
@@ -286,3 +495,234 @@ namespace ctd
         return min_cost;
     }
 }
+
+
+// ************************************************************************************ //
+// Method 3 and 4 add agents one by one, each agent finds the shortest augmenting path
+// in reduced cost c(n,m) - u[n] - v[m], which is non negative, and zero for assigned
+// pairs. Along the path, assigned tasks are passed to the next agent, until a free task
+// is reached. Potentials u and v are then updated, so that reduced costs remain non
+// negative, hence the partial assignment is always optimal for agents added so far.
+//
+// 1. Hungarian          - dense matrix, one agent costs O(N x M), scanning contiguous
+//                         rows of alg::matrix, rectangular matrix with more agents than
+//                         tasks is transposed, agents without task get no_task
+// 2. Sparse augmentation - agent n is only allowed to take tasks in edges[n], Dijkstra
+//                         with binary heap visits reachable tasks only, for large and
+//                         sparse cost matrix, agent that cannot be augmented gets no_task
+// ************************************************************************************ //
+namespace ctd
+{
+    inline constexpr std::uint32_t no_task = std::numeric_limits<std::uint32_t>::max();
+
+    struct assignment_result
+    {
+        std::uint64_t m_cost;
+        std::vector<std::uint32_t> m_assignment; // task of agent n, or no_task
+    };
+
+    struct assignment_edge
+    {
+        std::uint32_t m_task;
+        std::uint32_t m_cost;
+    };
+
+    // Requires N <= M, cost_mat may be any storage, e.g. memory mapped
+    template<typename STORAGE>
+    assignment_result assignment_by_hungarian_impl(const alg::matrix<std::uint32_t, STORAGE>& cost_mat)
+    {
+        std::uint32_t N = cost_mat.size_y();
+        std::uint32_t M = cost_mat.size_x();
+        const std::int64_t inf = std::numeric_limits<std::int64_t>::max();
+
+        // 1-based, task 0 is virtual root of path, owner[m] = agent of task m, 0 = free
+        std::vector<std::int64_t>  u(N+1, 0);
+        std::vector<std::int64_t>  v(M+1, 0);
+        std::vector<std::uint32_t> owner(M+1, 0);
+        std::vector<std::uint32_t> prev(M+1, 0);  // previous task on path
+        std::vector<std::int64_t>  min_v(M+1);
+        std::vector<char>          used(M+1);
+
+        for(std::uint32_t n=1; n<=N; ++n)
+        {
+            owner[0] = n;
+            std::uint32_t m0 = 0;
+            std::fill(min_v.begin(), min_v.end(), inf);
+            std::fill(used.begin(),  used.end(),  0);
+
+            // Dijkstra on tasks, until free task is reached
+            do
+            {
+                used[m0] = 1;
+                std::uint32_t n0 = owner[m0];
+                std::uint32_t m1 = 0;
+                std::int64_t delta = inf;
+                const std::uint32_t* row = &cost_mat(n0-1, 0);
+                for(std::uint32_t m=1; m<=M; ++m)
+                {
+                    if (used[m]) continue;
+                    std::int64_t reduced = (std::int64_t)row[m-1] - u[n0] - v[m];
+                    if (reduced < min_v[m]) 
+                    {
+                        min_v[m] = reduced;
+                        prev[m]  = m0;
+                    }
+                    if (min_v[m] < delta) 
+                    {
+                        delta = min_v[m];
+                        m1 = m;
+                    }
+                }
+                for(std::uint32_t m=0; m<=M; ++m)
+                {
+                    if (used[m]) 
+                    {
+                        u[owner[m]] += delta;
+                        v[m]        -= delta;
+                    }
+                    else min_v[m] -= delta;
+                }
+                m0 = m1;
+            } 
+            while(owner[m0] != 0);
+
+            // Pass tasks along the path
+            do
+            {
+                std::uint32_t m1 = prev[m0];
+                owner[m0] = owner[m1];
+                m0 = m1;
+            } 
+            while(m0 != 0);
+        }
+
+        assignment_result ans{0, std::vector<std::uint32_t>(N, no_task)};
+        for(std::uint32_t m=1; m<=M; ++m)
+        {
+            if (owner[m] != 0) 
+            {
+                ans.m_assignment[owner[m]-1] = m-1;
+                ans.m_cost += cost_mat(owner[m]-1, m-1);
+            }
+        }
+        return ans;
+    }
+
+    template<typename STORAGE>
+    assignment_result assignment_by_hungarian(const alg::matrix<std::uint32_t, STORAGE>& cost_mat)
+    {
+        if (cost_mat.size_y() <= cost_mat.size_x()) return assignment_by_hungarian_impl(cost_mat);
+
+        alg::matrix<std::uint32_t> transposed(cost_mat.size_x(), cost_mat.size_y());
+        for(std::uint32_t y=0; y!=cost_mat.size_y(); ++y)
+        {
+            for(std::uint32_t x=0; x!=cost_mat.size_x(); ++x) transposed(x,y) = cost_mat(y,x);
+        }
+
+        auto tmp = assignment_by_hungarian_impl(transposed);
+        assignment_result ans{tmp.m_cost, std::vector<std::uint32_t>(cost_mat.size_y(), no_task)};
+        for(std::uint32_t m=0; m!=tmp.m_assignment.size(); ++m)
+        {
+            ans.m_assignment[tmp.m_assignment[m]] = m;
+        }
+        return ans;
+    }
+
+    assignment_result assignment_by_sparse_augmentation(const std::vector<std::vector<assignment_edge>>& edges, std::uint32_t num_tasks)
+    {
+        std::uint32_t N = edges.size();
+        std::uint32_t M = num_tasks;
+        const std::int64_t inf = std::numeric_limits<std::int64_t>::max();
+
+        std::vector<std::int64_t>  v(M, 0);
+        std::vector<std::uint32_t> owner(M, no_task);
+        std::vector<std::uint32_t> task(N, no_task);
+        std::vector<std::uint32_t> task_cost(N, 0);
+
+        // Per search, reset for visited tasks only
+        std::vector<std::int64_t>  dist(M, inf);
+        std::vector<std::uint32_t> prev(M, no_task); // agent reaching the task
+        std::vector<std::uint32_t> prev_cost(M, 0);  // cost of that edge
+        std::vector<char>          done(M, 0);
+        std::vector<std::uint32_t> visited;
+        std::vector<std::uint32_t> finished;
+
+        using item = std::pair<std::int64_t, std::uint32_t>;
+        std::priority_queue<item, std::vector<item>, std::greater<item>> heap;
+
+        for(std::uint32_t s=0; s!=N; ++s)
+        {
+            // Reduced cost from agent n with label L, where u[n] = cost of its task - v[task]
+            auto relax = [&](std::uint32_t n, std::int64_t label, std::int64_t u)
+            {
+                for(const auto& e:edges[n])
+                {
+                    std::int64_t d = label + (std::int64_t)e.m_cost - u - v[e.m_task];
+                    if (d < dist[e.m_task])
+                    {
+                        if (dist[e.m_task] == inf) visited.push_back(e.m_task);
+                        dist[e.m_task] = d;
+                        prev[e.m_task] = n;
+                        prev_cost[e.m_task] = e.m_cost;
+                        heap.emplace(d, e.m_task);
+                    }
+                }
+            };
+
+            relax(s, 0, 0);
+            std::uint32_t free_task = no_task;
+            while(!heap.empty())
+            {
+                auto [d, m] = heap.top();
+                heap.pop();
+                if (done[m] || d != dist[m]) continue;
+                done[m] = 1;
+                finished.push_back(m);
+
+                if (owner[m] == no_task) 
+                {
+                    free_task = m;
+                    break;
+                }
+                std::uint32_t n = owner[m];
+                relax(n, d, (std::int64_t)task_cost[n] - v[m]);
+            }
+
+            if (free_task != no_task)
+            {
+                // Finished tasks are closer than free task, shift their potential
+                std::int64_t D = dist[free_task];
+                for(auto m:finished) v[m] -= D - dist[m];
+
+                // Pass tasks along the path
+                std::uint32_t m = free_task;
+                while(true)
+                {
+                    std::uint32_t n = prev[m];
+                    std::uint32_t next_m = task[n];
+                    owner[m] = n;
+                    task[n]  = m;
+                    task_cost[n] = prev_cost[m];
+                    if (n == s) break;
+                    m = next_m;
+                }
+            }
+
+            for(auto m:visited) 
+            {
+                dist[m] = inf;
+                done[m] = 0;
+            }
+            visited.clear();
+            finished.clear();
+            while(!heap.empty()) heap.pop();
+        }
+
+        assignment_result ans{0, std::move(task)};
+        for(std::uint32_t n=0; n!=N; ++n)
+        {
+            if (ans.m_assignment[n] != no_task) ans.m_cost += task_cost[n];
+        }
+        return ans;
+    }
+}
@@ -1,9 +1,25 @@
 #include<iostream>
 #include<iomanip>
+#include<cassert>
 #include<alpha.h>
 #include<utility.h>
 
 
+// Same as count_decreasing_triplet_heuristic, in 64 bits, reference for large size
+std::uint64_t count_decreasing_triplet_quadratic(const std::vector<std::uint32_t>& vec)
+{
+    std::uint64_t count = 0;
+    for(std::uint32_t n=0; n<vec.size(); ++n)
+    {
+        std::uint64_t lhs = 0;
+        std::uint64_t rhs = 0;
+        for(std::uint32_t m=0; m!=n; ++m)          if (vec[m] > vec[n]) ++lhs;
+        for(std::uint32_t m=n+1; m<vec.size(); ++m) if (vec[m] < vec[n]) ++rhs;
+        count += lhs * rhs;
+    }
+    return count;
+}
+
 void test_alpha()
 {
     // Question 4
@@ -59,6 +75,28 @@ void test_alpha()
                      std::bind(alpha::count_decreasing_triplet_heuristic,  _1),     
                      std::bind(alpha::count_decreasing_triplet_exhaustive, _1),
                      num_trial); 
+
+        benchmark<1>("alpha : count_decreasing_triplet (fenwick)",           
+                     std::bind(gen_random_vec<std::uint32_t>, 80, 0, 100), 
+                     [](const auto& vec) -> std::uint64_t { return alpha::count_decreasing_triplet_fenwick(vec); },
+                     [](const auto& vec) -> std::uint64_t { return alpha::count_decreasing_triplet_exhaustive(vec); },
+                     num_trial); 
+
+        // Count exceeds 32 bits
+        benchmark<1>("alpha : count_decreasing_triplet (fenwick), large",           
+                     std::bind(gen_random_vec<std::uint32_t>, 6000, 0, 1000000), 
+                     [](const auto& vec) -> std::uint64_t { return alpha::count_decreasing_triplet_fenwick(vec); },
+                     std::bind(count_decreasing_triplet_quadratic, _1),
+                     num_trial/80); 
+
+        // Count exceeds 64 bits, strictly decreasing has C(N,3) triplets
+        std::uint32_t size = 5000000;
+        std::vector<std::uint32_t> vec(size);
+        for(std::uint32_t n=0; n!=size; ++n) vec[n] = size - n;
+        unsigned __int128 ans = (unsigned __int128)size * (size-1) * (size-2) / 6;
+        assert((ans >> 64) != 0);
+        assert(alpha::count_decreasing_triplet_fenwick(vec) == ans);
+        print_summary("alpha : count_decreasing_triplet (fenwick), 5M, beyond 64 bits", "succeeded");
     }
     // Question 1
     {
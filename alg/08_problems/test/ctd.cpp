@@ -110,12 +110,163 @@ void test_ctd_K_merge()
         ctd::K_merge_all_at_once(data_ranges, std::back_inserter(ans1)); 
         ctd::K_merge_all_in_one (data_ranges, std::back_inserter(ans2)); 
 
+        std::vector<std::uint32_t> ans3;
+        std::vector<std::uint32_t> ans4(ans2.size());
+        ctd::K_merge_loser_tree (data_ranges, std::back_inserter(ans3)); 
+        ctd::K_merge_parallel   (data_ranges, ans4.begin(), 4); 
+
         assert(ans0 == ans2);
         assert(ans1 == ans2);
+        assert(ans3 == ans2);
+        assert(ans4 == ans2);
+
+        // Elements before co-rank splits are the smallest r elements
+        std::uint32_t r = rand() % (ans2.size()+1);
+        auto split = ctd::K_merge_co_rank(data_ranges, r);
+        std::vector<std::uint32_t> head;
+        for(std::uint32_t k=0; k!=K; ++k) head.insert(head.end(), data[k].begin(), data[k].begin() + split[k]);
+        std::sort(head.begin(), head.end());
+        assert(std::equal(head.begin(), head.end(), ans2.begin(), ans2.begin() + r) && head.size() == r);
     }
     print_summary("ctd : K merge", "succeeded");
 }
 
+void test_ctd_K_merge_large()
+{
+    // Hundreds of sorted streams, with many duplicates
+    std::uint32_t K    = 400;
+    std::uint32_t size = 10000;
+    std::vector<std::vector<std::uint32_t>> data;
+    std::vector<std::pair<std::vector<std::uint32_t>::iterator,
+                          std::vector<std::uint32_t>::iterator>> data_ranges;
+    for(std::uint32_t k=0; k!=K; ++k)
+    {
+        data.push_back(gen_random_sorted_vec<std::uint32_t>(size / 2 + rand() % size, 0, 1000000));
+    }
+    for(auto& x:data) data_ranges.push_back(std::make_pair(x.begin(), x.end()));
+
+    std::vector<std::uint32_t> ans0;
+    std::vector<std::uint32_t> ans1;
+    alg::timer timer;
+    timer.click();
+    ctd::K_merge_all_in_one(data_ranges, std::back_inserter(ans0)); 
+    timer.click();
+    std::uint64_t time0 = timer.time_elapsed_in_nsec();
+    ctd::K_merge_loser_tree(data_ranges, std::back_inserter(ans1)); 
+    timer.click();
+    std::uint64_t time1 = timer.time_elapsed_in_nsec();
+    
+    std::stringstream ss;
+    ss << (ans0 == ans1? "succeeded" : "failed") << ", time = " << time0/1000000 << "/" << time1/1000000 << " ms";
+    print_summary("ctd : K merge, all in one / loser tree, " + std::to_string(ans0.size()) + " items", ss.str());
+
+    for(std::uint32_t num_threads : {1,2,4})
+    {
+        std::vector<std::uint32_t> ans2(ans0.size());
+        timer.click();
+        ctd::K_merge_parallel(data_ranges, ans2.begin(), num_threads); 
+        timer.click();
+
+        std::stringstream ss;
+        ss << (ans0 == ans2? "succeeded" : "failed") << ", time = " << timer.time_elapsed_in_nsec()/1000000 << " ms";
+        print_summary("ctd : K merge, parallel, threads " + std::to_string(num_threads), ss.str());
+    }
+}
+
+
+std::uint32_t assignment_cost_by_hungarian(const alg::matrix<std::uint32_t>& cost_mat)
+{
+    return ctd::assignment_by_hungarian(cost_mat).m_cost;
+}
+
+std::vector<std::vector<ctd::assignment_edge>> to_edges(const alg::matrix<std::uint32_t>& cost_mat)
+{
+    std::vector<std::vector<ctd::assignment_edge>> edges(cost_mat.size_y());
+    for(std::uint32_t y=0; y!=cost_mat.size_y(); ++y)
+    {
+        for(std::uint32_t x=0; x!=cost_mat.size_x(); ++x) edges[y].push_back({x, cost_mat(y,x)});
+    }
+    return edges;
+}
+
+std::uint32_t assignment_cost_by_sparse_augmentation(const alg::matrix<std::uint32_t>& cost_mat)
+{
+    return ctd::assignment_by_sparse_augmentation(to_edges(cost_mat), cost_mat.size_x()).m_cost;
+}
+
+// Each agent gets a distinct task, or no_task when there are more agents than tasks
+bool is_valid_assignment(const ctd::assignment_result& ans, 
+                         const std::vector<std::vector<ctd::assignment_edge>>& edges, std::uint32_t num_tasks)
+{
+    std::vector<bool> taken(num_tasks, false);
+    std::uint64_t cost = 0;
+    std::uint32_t num_assigned = 0;
+    for(std::uint32_t n=0; n!=ans.m_assignment.size(); ++n)
+    {
+        std::uint32_t m = ans.m_assignment[n];
+        if (m == ctd::no_task) continue;
+        if (m >= num_tasks || taken[m]) return false;
+        taken[m] = true;
+        ++num_assigned;
+
+        auto iter = std::find_if(edges[n].begin(), edges[n].end(), [m](const auto& e) { return e.m_task == m; });
+        if (iter == edges[n].end()) return false;
+        cost += iter->m_cost;
+    }
+    return cost == ans.m_cost && num_assigned == std::min<std::uint32_t>(edges.size(), num_tasks);
+}
+
+void test_ctd_assignment_problem_large()
+{
+    std::uint32_t num_trial = 100;
+    std::uint32_t num_error = 0;
+    for(std::uint32_t t=0; t!=num_trial; ++t)
+    {
+        std::uint32_t size_y = 1 + rand() % 60;
+        std::uint32_t size_x = 1 + rand() % 60;
+        auto cost_mat = gen_random_mat<std::uint32_t>(size_y, size_x, 0, 1000);
+        auto edges    = to_edges(cost_mat);
+        auto ans0 = ctd::assignment_by_hungarian(cost_mat);
+        if (!is_valid_assignment(ans0, edges, size_x)) ++num_error;
+
+        // Sparse requires N <= M, so that every agent is assigned
+        if (size_y <= size_x)
+        {
+            auto ans1 = ctd::assignment_by_sparse_augmentation(edges, size_x);
+            if (!is_valid_assignment(ans1, edges, size_x) || ans0.m_cost != ans1.m_cost) ++num_error;
+        }
+    }
+    print_summary("ctd : assignment problem, rectangular, hungarian vs sparse", num_error, num_trial);
+
+    // Desk-to-order routing, N in thousands, each agent is allowed to take 32 tasks
+    std::uint32_t N = 2000;
+    auto cost_mat = gen_random_mat<std::uint32_t>(N, N, 0, 100000);
+    std::vector<std::vector<ctd::assignment_edge>> edges(N);
+    for(std::uint32_t n=0; n!=N; ++n)
+    {
+        edges[n].push_back({n, cost_mat(n,n)}); // feasible
+        for(std::uint32_t k=0; k!=31; ++k) 
+        {
+            std::uint32_t m = rand() % N;
+            if (m != n) edges[n].push_back({m, cost_mat(n,m)});
+        }
+    }
+
+    alg::timer timer;
+    timer.click();
+    auto ans0 = ctd::assignment_by_hungarian(cost_mat);
+    timer.click();
+    std::uint64_t time0 = timer.time_elapsed_in_nsec();
+    auto ans1 = ctd::assignment_by_sparse_augmentation(edges, N);
+    timer.click();
+    std::uint64_t time1 = timer.time_elapsed_in_nsec();
+    
+    bool valid = is_valid_assignment(ans0, to_edges(cost_mat), N) && 
+                 is_valid_assignment(ans1, edges, N) && ans0.m_cost <= ans1.m_cost;
+    print_summary("ctd : assignment problem, hungarian dense / sparse, N = 2000", 
+                  std::string(valid? "succeeded" : "failed") + 
+                  ", time = " + std::to_string(time0/1000000) + "/" + std::to_string(time1/1000000) + " ms");
+}
 
 void test_ctd_assignment_problem()
 {
@@ -129,6 +280,18 @@ void test_ctd_assignment_problem()
                  std::bind(ctd::assignment_by_exhaustive_iteration, _1),     
                  std::bind(ctd::assignment_by_exhaustive_recursive, _1),
                  num_trial); 
+
+    benchmark<1>("ctd : assignment problem, exhaustive vs hungarian",           
+                 std::bind(gen_random_mat<std::uint32_t>, size, size, min, max), 
+                 std::bind(ctd::assignment_by_exhaustive_iteration, _1),     
+                 std::bind(assignment_cost_by_hungarian, _1),
+                 num_trial); 
+
+    benchmark<1>("ctd : assignment problem, hungarian vs sparse, size 100",           
+                 std::bind(gen_random_mat<std::uint32_t>, 100, 100, min, max), 
+                 std::bind(assignment_cost_by_hungarian, _1),     
+                 std::bind(assignment_cost_by_sparse_augmentation, _1),
+                 num_trial); 
 }
 
 
@@ -136,6 +299,8 @@ void test_ctd()
 {
     test_ctd_spiral_traverse();
     test_ctd_K_merge();
+    test_ctd_K_merge_large();
     test_ctd_assignment_problem();
+    test_ctd_assignment_problem_large();
 }
 
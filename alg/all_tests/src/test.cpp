@@ -9,6 +9,10 @@ void test_tree();
 void test_tree_variant();
 void test_tree_dual();
 void test_sorting();
+void test_flat_hash_map();
+void test_scan();
+void test_selection();
+void test_inversion();
 
 // *** 02_dynprog_vec *** //
 void test_two_point_sum();
@@ -21,6 +25,7 @@ void test_sorting_problem();
 // *** 03_dynprog *** //
 void test_dp_matrix_and_graph();
 void test_dp_matrix_only();
+void test_dp_bit_parallel();
 
 // *** 04_fundalmental *** //
 void test_cast();
@@ -31,6 +36,10 @@ void test_deduce_rvalue();
 void test_deduce_type();
 void test_exception();
 void test_literal();
+void test_matrix();
+void test_matrix_kernel();
+void test_matrix_mmap();
+void test_statistics();
 void test_memory_alignment();
 void test_memory_allocator();
 void test_memory_deleter();
@@ -40,10 +49,13 @@ void test_memory_shared_ptr();
 void test_memory_unique_ptr();
 void test_optional();
 void test_polymophism();
+void test_prng();
+void test_corpus();
 void test_std_alg();
 void test_std_container();
 void test_std_layout();
 void test_timer();
+void test_timer_rdtsc();
   
 // *** 05_template *** //
 void test_array();
@@ -81,6 +93,8 @@ void test_promise_future();
 
 // *** 06_threading (mpmcq & threadpool) *** //
 void test_mpmcq();
+void test_latency_recorder();
+void test_trace();
 void test_threadpool();
 
 // *** 07_cpp20 *** //
@@ -120,6 +134,10 @@ int main()
     test_tree_variant();
     test_tree_dual();
     test_sorting();
+    test_flat_hash_map();
+    test_scan();
+    test_selection();
+    test_inversion();
   
     banner("02_dynprog_vec");
     test_two_point_sum();
@@ -132,6 +150,7 @@ int main()
     banner("03_dynprog");
     test_dp_matrix_only();  
     test_dp_matrix_and_graph();
+    test_dp_bit_parallel();
   
     banner("04_fundalmental");
     test_cast();
@@ -142,6 +161,10 @@ int main()
     test_deduce_type();
     test_exception();
     test_literal();
+    test_matrix();
+    test_matrix_kernel();
+    test_matrix_mmap();
+    test_statistics();
     test_memory_alignment();
     test_memory_allocator();
     test_memory_deleter();
@@ -151,10 +174,13 @@ int main()
     test_memory_unique_ptr();
     test_optional();
     test_polymophism();
+    test_prng();
+    test_corpus();
     test_std_alg();
     test_std_container();
     test_std_layout();
     test_timer();
+    test_timer_rdtsc();
   
     banner("05_template");
     test_array();
@@ -192,6 +218,8 @@ int main()
   
     banner("06_threading - mpmcq & threadpool");
     test_mpmcq();
+    test_latency_recorder();
+    test_trace();
     test_threadpool();
   
     banner("07_cpp20");  